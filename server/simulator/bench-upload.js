@@ -0,0 +1,109 @@
+/**
+ * Comparación de subida: una lectura por solicitud contra lotes, con una
+ * conexión nueva por solicitud (HTTPClient.end() cerrando el socket) o con
+ * la conexión persistente de shared/uplink.h. Levanta el servidor sustituto
+ * y sube las mismas lecturas de cada forma.
+ *
+ *   READINGS=100 LATENCY_MS=100 HANDSHAKE_MS=400 BATCH=100 node bench-upload.js
+ */
+
+const http = require('http');
+const { createStandinServer } = require('./standin-server');
+
+const READINGS = parseInt(process.env.READINGS) || 100;
+const LATENCY_MS = parseInt(process.env.LATENCY_MS ?? 100);
+const HANDSHAKE_MS = parseInt(process.env.HANDSHAKE_MS ?? 400);   // TLS en el ESP32-S3
+const BATCH = parseInt(process.env.BATCH) || 100;     // SERVER_BATCH_MAX del firmware
+
+// Columnas del lote, en el orden de server_client.cpp
+const COLUMNS = ['packetId', 'ageSec', 'tempAire', 'humAire', 'tempSuelo',
+    'vwcSuelo', 'ecSuelo', 'par', 'vBat', 'batPercent', 'soil'];
+
+function makeReadings(count) {
+    const list = [];
+    for (let i = 0; i < count; i++) {
+        list.push({
+            packetId: 1000 + i,
+            ageSec: (count - 1 - i) * 60,
+            tempAire: +(15 + Math.sin(i / 10) * 5).toFixed(2),
+            humAire: +(60 + Math.cos(i / 7) * 10).toFixed(2),
+            tempSuelo: +(12 + Math.sin(i / 30)).toFixed(2),
+            vwcSuelo: +(30 - i * 0.01).toFixed(2),
+            ecSuelo: +(250 + (i % 5)).toFixed(1),
+            par: i % 3 === 0 ? null : +(800 + i).toFixed(1),
+            vBat: +(3.9 - i * 0.001).toFixed(3),
+            batPercent: 80,
+            soil: [['1', 10, 31.2, 12.1, 251.0]]
+        });
+    }
+    return list;
+}
+
+function post(port, path, body, agent) {
+    return new Promise((resolve, reject) => {
+        const req = http.request({
+            port, path, method: 'POST', agent,
+            headers: {
+                'Content-Type': 'application/json',
+                'Content-Length': Buffer.byteLength(body),
+                'X-API-Key': 'bench'
+            }
+        }, res => {
+            res.resume();
+            res.on('end', () => (res.statusCode === 200 ? resolve() : reject(new Error(`HTTP ${res.statusCode}`))));
+        });
+        req.on('error', reject);
+        req.end(body);
+    });
+}
+
+async function run(port, label, bodies, path, keepAlive) {
+    const agent = keepAlive ? new http.Agent({ keepAlive: true, maxSockets: 1 }) : false;
+    const t0 = process.hrtime.bigint();
+    let bytes = 0;
+    for (const body of bodies) {
+        bytes += Buffer.byteLength(body);
+        await post(port, path, body, agent);
+    }
+    const ms = Number(process.hrtime.bigint() - t0) / 1e6;
+    if (agent) agent.destroy();
+    console.log(`${label.padEnd(24)} ${String(bodies.length).padStart(4)} solicitudes  ` +
+        `${String(bytes).padStart(7)} B  ${ms.toFixed(0).padStart(6)} ms  ` +
+        `${(ms / READINGS).toFixed(1).padStart(6)} ms/lectura  ` +
+        `${(READINGS / (ms / 1000)).toFixed(1).padStart(7)} lecturas/s`);
+    return ms;
+}
+
+async function main() {
+    const server = createStandinServer({ latencyMs: LATENCY_MS, handshakeMs: HANDSHAKE_MS });
+    await new Promise(r => server.listen(0, r));
+    const { port } = server.address();
+    const list = makeReadings(READINGS);
+
+    console.log(`${READINGS} lecturas, demora ${LATENCY_MS} ms por solicitud + ${HANDSHAKE_MS} ms ` +
+        `por conexión nueva, lotes de ${BATCH}\n`);
+
+    const single = list.map(r => {
+        const { ageSec, soil, ...rest } = r;
+        const probes = soil.map(([addr, depth, vwc, temp, ec]) => ({ addr, depth, vwc, temp, ec }));
+        return JSON.stringify({ ...rest, soil: probes, timestamp: new Date().toISOString() });
+    });
+    const batches = [];
+    for (let i = 0; i < list.length; i += BATCH) {
+        const rows = list.slice(i, i + BATCH).map(r => COLUMNS.map(c => r[c]));
+        batches.push(JSON.stringify({ columns: COLUMNS, rows }));
+    }
+
+    const a = await run(port, 'una por POST', single, '/api/data/ingest', false);
+    await run(port, 'una por POST, keep-alive', single, '/api/data/ingest', true);
+    const b = await run(port, 'por lotes', batches, '/api/data/batch', false);
+    await run(port, 'por lotes, keep-alive', batches, '/api/data/batch', true);
+    console.log(`\nLotes contra una por POST: ${(a / b).toFixed(1)}x`);
+    server.closeAllConnections();
+    server.close();
+}
+
+main().catch(err => {
+    console.error(err);
+    process.exit(1);
+});
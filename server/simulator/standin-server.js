@@ -0,0 +1,147 @@
+/**
+ * Servidor sustituto (sin dependencias)
+ * Implementa /api/data/ingest, /api/data/batch y /api/data/backfill en
+ * memoria, con una demora fija por solicitud (latencia de la red) y otra en
+ * la primera solicitud de cada conexión (handshake TLS). Sirve para probar
+ * el firmware de los nodos (con una URL http://) o el simulador sin SQLite
+ * ni Express. Mantiene las conexiones abiertas 75 s, como el servidor real.
+ *
+ *   PORT=3000 LATENCY_MS=100 HANDSHAKE_MS=400 MODE=ok node standin-server.js
+ *
+ * GET /stats devuelve las solicitudes, conexiones, bytes y lecturas.
+ * GET /control?mode=ok|fail|hang cambia el comportamiento en marcha:
+ *   fail   responde 503 a todo
+ *   hang   acepta la solicitud y no responde nunca (servidor colgado)
+ * Con eso se ve que los nodos siguen midiendo y recibiendo (STATUS, /data)
+ * mientras el uplink espera, se retira y abre el circuito.
+ */
+
+const http = require('http');
+
+const BATCH_MAX_ROWS = 200;     // como BATCH.maxRows en src/routes/data.js
+
+const MODES = ['ok', 'fail', 'hang'];
+
+function createStandinServer({ latencyMs = 0, handshakeMs = 0, mode = 'ok', log = false } = {}) {
+    const stations = new Map();     // apiKey -> Map(packetId -> lectura)
+    const stats = {
+        requests: 0, connections: 0, bytes: 0, readings: 0, duplicates: 0,
+        failed: 0, hung: 0, byPath: {}
+    };
+    const greeted = new WeakSet();  // conexiones que ya pagaron el handshake
+
+    function store(apiKey, reading) {
+        if (!stations.has(apiKey)) stations.set(apiKey, new Map());
+        const list = stations.get(apiKey);
+        if (list.has(reading.packetId)) {
+            stats.duplicates++;
+            return false;
+        }
+        list.set(reading.packetId, reading);
+        stats.readings++;
+        return true;
+    }
+
+    function handle(req, body) {
+        const apiKey = req.headers['x-api-key'];
+        if (req.method === 'GET' && req.url === '/stats') {
+            return [200, { ...stats, mode, stations: stations.size }];
+        }
+        if (req.method === 'GET' && req.url.startsWith('/control')) {
+            const next = new URL(req.url, 'http://localhost').searchParams.get('mode');
+            if (!MODES.includes(next)) return [400, { error: `mode: ${MODES.join(' | ')}` }];
+            mode = next;
+            console.log(`Modo: ${mode}`);
+            return [200, { mode }];
+        }
+        if (mode === 'fail') {
+            stats.failed++;
+            return [503, { error: 'Servidor no disponible (simulado)' }];
+        }
+        if (req.method !== 'POST') return [404, { error: 'No encontrado' }];
+        if (!apiKey) return [401, { error: 'API key requerida' }];
+
+        let data;
+        try {
+            data = JSON.parse(body);
+        } catch (e) {
+            return [400, { error: 'JSON inválido' }];
+        }
+
+        switch (req.url) {
+            case '/api/data/ingest':
+                store(apiKey, data);
+                return [200, { success: true, backfill: [] }];
+
+            case '/api/data/batch': {
+                const { columns, rows } = data;
+                if (!Array.isArray(columns) || !Array.isArray(rows)) {
+                    return [400, { error: 'Se esperan columns y rows' }];
+                }
+                if (rows.length > BATCH_MAX_ROWS) {
+                    return [413, { error: `Máximo ${BATCH_MAX_ROWS} lecturas por lote` }];
+                }
+                let inserted = 0;
+                rows.forEach(row => {
+                    const r = {};
+                    columns.forEach((c, i) => { r[c] = row[i]; });
+                    if (store(apiKey, r)) inserted++;
+                });
+                return [200, { success: true, inserted, duplicates: rows.length - inserted, backfill: [] }];
+            }
+
+            case '/api/data/backfill': {
+                let inserted = 0;
+                (data.readings || []).forEach(r => { if (store(apiKey, r)) inserted++; });
+                return [200, { success: true, inserted, backfill: [] }];
+            }
+
+            default:
+                return [404, { error: 'No encontrado' }];
+        }
+    }
+
+    const server = http.createServer((req, res) => {
+        let delay = latencyMs;
+        if (!greeted.has(req.socket)) {
+            greeted.add(req.socket);
+            stats.connections++;
+            delay += handshakeMs;
+        }
+        const chunks = [];
+        req.on('data', c => chunks.push(c));
+        req.on('end', () => {
+            const body = Buffer.concat(chunks).toString();
+            stats.requests++;
+            stats.bytes += body.length;
+            stats.byPath[req.url] = (stats.byPath[req.url] || 0) + 1;
+
+            if (mode === 'hang' && !req.url.startsWith('/control') && req.url !== '/stats') {
+                stats.hung++;
+                if (log) console.log(`${req.method} ${req.url} ${body.length} B -> (sin respuesta)`);
+                return;
+            }
+            const [status, payload] = handle(req, body);
+            if (log) console.log(`${req.method} ${req.url} ${body.length} B -> ${status}`);
+            setTimeout(() => {
+                res.writeHead(status, { 'Content-Type': 'application/json' });
+                res.end(JSON.stringify(payload));
+            }, delay);
+        });
+    });
+    server.keepAliveTimeout = 75000;
+    return server;
+}
+
+module.exports = { createStandinServer };
+
+if (require.main === module) {
+    const port = parseInt(process.env.PORT) || 3000;
+    const latencyMs = parseInt(process.env.LATENCY_MS) || 0;
+    const handshakeMs = parseInt(process.env.HANDSHAKE_MS) || 0;
+    const mode = MODES.includes(process.env.MODE) ? process.env.MODE : 'ok';
+    createStandinServer({ latencyMs, handshakeMs, mode, log: true }).listen(port, () => {
+        console.log(`Servidor sustituto en http://localhost:${port} ` +
+            `(demora ${latencyMs} ms, handshake ${handshakeMs} ms, modo ${mode})`);
+    });
+}
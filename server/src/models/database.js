@@ -41,6 +41,7 @@ db.exec(`
     CREATE TABLE IF NOT EXISTS readings (
         id INTEGER PRIMARY KEY AUTOINCREMENT,
         station_id TEXT NOT NULL,
+        node_id INTEGER,
         timestamp TEXT DEFAULT CURRENT_TIMESTAMP,
         packet_id INTEGER,
         temp_air REAL,
@@ -59,6 +60,20 @@ db.exec(`
         FOREIGN KEY (station_id) REFERENCES stations(id)
     );
 
+    -- Perfil de suelo: una fila por sonda (profundidad) y lectura
+    CREATE TABLE IF NOT EXISTS soil_readings (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        reading_id INTEGER NOT NULL,
+        station_id TEXT NOT NULL,
+        sensor_addr TEXT,
+        depth_cm INTEGER,
+        vwc REAL,
+        temp REAL,
+        ec REAL,
+        FOREIGN KEY (reading_id) REFERENCES readings(id),
+        FOREIGN KEY (station_id) REFERENCES stations(id)
+    );
+
     -- Tabla de alertas
     CREATE TABLE IF NOT EXISTS alerts (
         id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -90,6 +105,25 @@ db.exec(`
     CREATE INDEX IF NOT EXISTS idx_readings_timestamp
         ON readings(timestamp DESC);
 
+    CREATE INDEX IF NOT EXISTS idx_soil_readings_reading
+        ON soil_readings(reading_id);
+
+    CREATE INDEX IF NOT EXISTS idx_readings_station_packet
+        ON readings(station_id, packet_id);
+
+    -- Rangos de packetId que la estación informó que no tiene (backfill)
+    CREATE TABLE IF NOT EXISTS backfill_unavailable (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        station_id TEXT NOT NULL,
+        first_id INTEGER NOT NULL,
+        last_id INTEGER NOT NULL,
+        created_at TEXT DEFAULT CURRENT_TIMESTAMP,
+        FOREIGN KEY (station_id) REFERENCES stations(id)
+    );
+
+    CREATE INDEX IF NOT EXISTS idx_backfill_unavailable_station
+        ON backfill_unavailable(station_id, last_id);
+
     CREATE INDEX IF NOT EXISTS idx_alerts_station
         ON alerts(station_id, acknowledged);
 
@@ -104,6 +138,18 @@ try {
     // Column already exists, nothing to do
 }
 
+// Migration: node_id (nodo LoRa detrás de un gateway; NULL en estaciones
+// directas). Cada nodo tiene su propia secuencia de packetId.
+try {
+    db.exec(`ALTER TABLE readings ADD COLUMN node_id INTEGER`);
+} catch (e) {
+    // Column already exists, nothing to do
+}
+db.exec(`
+    CREATE INDEX IF NOT EXISTS idx_readings_station_node_packet
+        ON readings(station_id, node_id, packet_id)
+`);
+
 // Funciones de estaciones
 const stationQueries = {
     getAll: db.prepare(`
@@ -145,10 +191,52 @@ const stationQueries = {
 const readingQueries = {
     insert: db.prepare(`
         INSERT INTO readings (
-            station_id, packet_id, temp_air, hum_air, temp_soil, vwc_soil, ec_soil,
+            station_id, node_id, packet_id, temp_air, hum_air, temp_soil, vwc_soil, ec_soil,
             pressure, par, solar_radiation, precipitation,
             rssi, snr, freq_error, battery_voltage
-        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    `),
+
+    // Lectura con la hora de muestreo (backfill, lotes)
+    insertAt: db.prepare(`
+        INSERT INTO readings (
+            station_id, node_id, timestamp, packet_id, temp_air, hum_air, temp_soil, vwc_soil, ec_soil,
+            pressure, par, solar_radiation, precipitation,
+            rssi, snr, freq_error, battery_voltage
+        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    `),
+
+    // La misma muestra ya guardada: mismo packetId con hora cercana (el
+    // packetId se reinicia con un arranque en frío, la hora no). Por nodo:
+    // node_id IS ? también empareja NULL (estación directa).
+    hasPacketNear: db.prepare(`
+        SELECT 1 FROM readings
+        WHERE station_id = ? AND node_id IS ? AND packet_id = ?
+          AND timestamp BETWEEN datetime(?, '-' || ? || ' seconds') AND datetime(?, '+' || ? || ' seconds')
+        LIMIT 1
+    `),
+
+    // Huecos de packetId de un nodo en [desde, hasta], los más recientes primero
+    getPacketGaps: db.prepare(`
+        WITH ids AS (
+            SELECT DISTINCT packet_id AS id FROM readings
+            WHERE station_id = ? AND node_id IS ? AND packet_id BETWEEN ? AND ?
+              AND timestamp >= datetime('now', ?)
+        )
+        SELECT prev + 1 AS first, id - 1 AS last FROM (
+            SELECT id, LAG(id) OVER (ORDER BY id) AS prev FROM ids
+        )
+        WHERE id - prev > 1
+        ORDER BY first DESC
+        LIMIT ?
+    `),
+
+    // Última lectura propia de una estación directa (sin nodos de gateway)
+    getLatestDirect: db.prepare(`
+        SELECT * FROM readings
+        WHERE station_id = ? AND node_id IS NULL
+        ORDER BY timestamp DESC
+        LIMIT 1
     `),
 
     getLatest: db.prepare(`
@@ -186,12 +274,35 @@ const readingQueries = {
         WHERE station_id = ? AND timestamp >= datetime('now', ?)
     `),
 
+    insertSoil: db.prepare(`
+        INSERT INTO soil_readings (reading_id, station_id, sensor_addr, depth_cm, vwc, temp, ec)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    `),
+
+    getSoilByReading: db.prepare(`
+        SELECT sensor_addr, depth_cm, vwc, temp, ec FROM soil_readings
+        WHERE reading_id = ?
+        ORDER BY depth_cm ASC
+    `),
+
     deleteOld: db.prepare(`
         DELETE FROM readings
         WHERE timestamp < datetime('now', ?)
     `)
 };
 
+// Backfill: rangos que la estación ya no tiene en su SD
+const backfillQueries = {
+    addUnavailable: db.prepare(`
+        INSERT INTO backfill_unavailable (station_id, first_id, last_id) VALUES (?, ?, ?)
+    `),
+
+    getUnavailable: db.prepare(`
+        SELECT first_id, last_id FROM backfill_unavailable
+        WHERE station_id = ? AND last_id >= ? AND created_at >= datetime('now', ?)
+    `)
+};
+
 // Funciones de alertas
 const alertQueries = {
     create: db.prepare(`
@@ -232,6 +343,7 @@ module.exports = {
     db,
     stations: stationQueries,
     readings: readingQueries,
+    backfill: backfillQueries,
     alerts: alertQueries,
     users: userQueries
 };
@@ -5,7 +5,7 @@
 
 const express = require('express');
 const router = express.Router();
-const { stations, readings, alerts } = require('../models/database');
+const { db, stations, readings, backfill, alerts } = require('../models/database');
 
 // Umbrales de alerta por defecto
 const ALERT_THRESHOLDS = {
@@ -17,6 +17,144 @@ const ALERT_THRESHOLDS = {
     rssi_low: -120
 };
 
+// Backfill: huecos de packetId que la estación puede reenviar desde su SD
+const BACKFILL = {
+    window: 5000,          // packetIds hacia atrás desde el último recibido
+    maxAge: '-7 days',     // mismo límite que BACKFILL_MAX_AGE_S en el firmware
+    maxAgeSec: 7 * 86400,  // antigüedad máxima aceptada en ageSec
+    maxRanges: 8,          // rangos por respuesta
+    scanRanges: 64,        // rangos leídos antes de descontar los no disponibles
+    maxReadings: 50        // lecturas por POST /backfill
+};
+
+// Lotes: lecturas acumuladas en la estación, varias por solicitud
+const BATCH = {
+    maxRows: 200,          // filas por POST /batch (el firmware envía hasta 100)
+    dedupeSec: 300         // tolerancia de hora al buscar duplicados
+};
+
+/**
+ * Nodo LoRa que originó la lectura: el gateway lo informa en `nodeId`; una
+ * estación directa no lo envía (null). Cada nodo numera sus packetId por
+ * separado.
+ */
+function nodeOf(data) {
+    return Number.isInteger(data.nodeId) ? data.nodeId : null;
+}
+
+/**
+ * ¿Ya está guardada esta muestra? (reintento de un lote o backfill cuya
+ * respuesta se perdió)
+ */
+function isDuplicate(stationId, nodeId, packetId, timestamp) {
+    return !!readings.hasPacketNear.get(stationId, nodeId, packetId,
+        timestamp, BATCH.dedupeSec, timestamp, BATCH.dedupeSec);
+}
+
+/**
+ * Hora de muestreo a partir de la antigüedad informada por la estación
+ * (segundos), en el formato de CURRENT_TIMESTAMP. La estación no necesita
+ * saber su zona horaria ni tener la fecha exacta. ageSec null: la estación
+ * no tenía hora al medir, se usa la de llegada. Antigüedades inválidas o
+ * mayores que BACKFILL.maxAgeSec dan null (fila descartada).
+ */
+function sampleTimestamp(ageSec) {
+    const age = ageSec === null ? 0 : Number(ageSec);
+    if (!Number.isFinite(age) || age < 0 || age > BACKFILL.maxAgeSec) return null;
+    return new Date(Date.now() - age * 1000).toISOString().slice(0, 19).replace('T', ' ');
+}
+
+/**
+ * Insertar una lectura (y su perfil de suelo). Sin timestamp se usa la hora
+ * de llegada.
+ */
+function insertReading(stationId, data, timestamp) {
+    const {
+        packetId,
+        tempAire, humAire, tempSuelo, vwcSuelo, ecSuelo,
+        pressure, par, solarRadiation, precipitation,
+        rssi, snr, freqError, batteryVoltage, soil
+    } = data;
+
+    const values = [
+        packetId || null,
+        tempAire ?? null,
+        humAire ?? null,
+        tempSuelo ?? null,
+        vwcSuelo ?? null,
+        ecSuelo ?? null,
+        pressure ?? null,
+        par ?? null,
+        solarRadiation ?? null,
+        precipitation ?? null,
+        rssi ?? null,
+        snr ?? null,
+        freqError ?? null,
+        batteryVoltage ?? null
+    ];
+    const nodeId = nodeOf(data);
+    const info = timestamp
+        ? readings.insertAt.run(stationId, nodeId, timestamp, ...values)
+        : readings.insert.run(stationId, nodeId, ...values);
+
+    // Perfil de suelo (varias sondas TEROS 12 por profundidad)
+    if (Array.isArray(soil)) {
+        soil.forEach(probe => {
+            readings.insertSoil.run(
+                info.lastInsertRowid,
+                stationId,
+                probe.addr ?? null,
+                probe.depth ?? null,
+                probe.vwc ?? null,
+                probe.temp ?? null,
+                probe.ec ?? null
+            );
+        });
+    }
+    return info;
+}
+
+/**
+ * Quitar de `ranges` los tramos cubiertos por `holes` (ambos [first, last])
+ */
+function subtractRanges(ranges, holes) {
+    let out = ranges;
+    holes.forEach(([hf, hl]) => {
+        const next = [];
+        out.forEach(([f, l]) => {
+            if (hl < f || hf > l) {
+                next.push([f, l]);
+                return;
+            }
+            if (f < hf) next.push([f, hf - 1]);
+            if (l > hl) next.push([hl + 1, l]);
+        });
+        out = next;
+    });
+    return out;
+}
+
+/**
+ * Huecos de packetId recientes de una estación directa, hasta
+ * `latestPacketId`. Solo entre ids recibidos (no se piden ids anteriores al
+ * primero de la ventana) y sin los rangos que la estación ya informó que no
+ * tiene. Las lecturas de nodos detrás de un gateway no cuentan: tienen su
+ * propia secuencia y el gateway no puede reenviarlas.
+ */
+function findBackfillGaps(stationId, latestPacketId) {
+    if (!Number.isInteger(latestPacketId) || latestPacketId <= 1) return [];
+    const from = Math.max(0, latestPacketId - BACKFILL.window);
+    const gaps = readings.getPacketGaps
+        .all(stationId, null, from, latestPacketId, BACKFILL.maxAge, BACKFILL.scanRanges)
+        .map(g => [g.first, g.last]);
+    if (gaps.length === 0) return [];
+
+    const holes = backfill.getUnavailable
+        .all(stationId, from, BACKFILL.maxAge)
+        .map(u => [u.first_id, u.last_id]);
+    return subtractRanges(gaps, holes).slice(0, BACKFILL.maxRanges);
+}
+
 /**
  * POST /api/data/ingest
  * Endpoint principal para recibir datos de las estaciones
@@ -36,32 +174,7 @@ router.post('/ingest', (req, res) => {
             return res.status(401).json({ error: 'API key inválida' });
         }
 
-        // Extraer datos del body
-        const {
-            packetId,
-            tempAire, humAire, tempSuelo, vwcSuelo, ecSuelo,
-            pressure, par, solarRadiation, precipitation,
-            rssi, snr, freqError, batteryVoltage
-        } = req.body;
-
-        // Insertar lectura
-        readings.insert.run(
-            station.id,
-            packetId || null,
-            tempAire ?? null,
-            humAire ?? null,
-            tempSuelo ?? null,
-            vwcSuelo ?? null,
-            ecSuelo ?? null,
-            pressure ?? null,
-            par ?? null,
-            solarRadiation ?? null,
-            precipitation ?? null,
-            rssi ?? null,
-            snr ?? null,
-            freqError ?? null,
-            batteryVoltage ?? null
-        );
+        insertReading(station.id, req.body, null);
 
         // Actualizar last_seen de la estación
         stations.updateLastSeen.run(station.id);
@@ -69,7 +182,10 @@ router.post('/ingest', (req, res) => {
         // Verificar alertas
         checkAndCreateAlerts(station.id, req.body);
 
-        // Responder con configuración pendiente (si hay)
+        // Responder con configuración pendiente (si hay) y los huecos que
+        // la estación puede completar desde su SD (un gateway no tiene SD
+        // que consultar: sin backfill para sus nodos)
+        const direct = nodeOf(req.body) === null;
         res.json({
             success: true,
             timestamp: new Date().toISOString(),
@@ -77,7 +193,8 @@ router.post('/ingest', (req, res) => {
                 sf: station.config_sf,
                 bw: station.config_bw,
                 interval: station.config_interval
-            }
+            },
+            backfill: direct ? findBackfillGaps(station.id, req.body.packetId) : []
         });
 
     } catch (error) {
@@ -86,6 +203,146 @@ router.post('/ingest', (req, res) => {
     }
 });
 
+/**
+ * POST /api/data/backfill
+ * Lecturas recuperadas del log de la SD para completar huecos de packetId
+ * Headers requeridos: X-API-Key
+ * Body: { readings: [{ packetId, ageSec, ... }], unavailable: [[first, last]] }
+ * Las lecturas ya presentes se ignoran; todo entra en una transacción.
+ */
+const insertBackfill = db.transaction((stationId, list, unavailable) => {
+    let inserted = 0;
+    list.forEach(r => {
+        if (!Number.isInteger(r.packetId)) return;
+        const timestamp = sampleTimestamp(r.ageSec);
+        if (!timestamp || isDuplicate(stationId, nodeOf(r), r.packetId, timestamp)) return;
+        insertReading(stationId, r, timestamp);
+        inserted++;
+    });
+    unavailable.forEach(([first, last]) => {
+        backfill.addUnavailable.run(stationId, first, last);
+    });
+    return inserted;
+});
+
+router.post('/backfill', (req, res) => {
+    try {
+        const apiKey = req.headers['x-api-key'];
+        if (!apiKey) {
+            return res.status(401).json({ error: 'API key requerida' });
+        }
+        const station = stations.getByApiKey.get(apiKey);
+        if (!station) {
+            return res.status(401).json({ error: 'API key inválida' });
+        }
+
+        const list = Array.isArray(req.body.readings) ? req.body.readings : [];
+        const unavailable = (Array.isArray(req.body.unavailable) ? req.body.unavailable : [])
+            .filter(r => Array.isArray(r) && Number.isInteger(r[0]) && Number.isInteger(r[1]) && r[0] <= r[1]);
+        if (list.length > BACKFILL.maxReadings) {
+            return res.status(413).json({ error: `Máximo ${BACKFILL.maxReadings} lecturas por envío` });
+        }
+
+        const inserted = insertBackfill(station.id, list, unavailable);
+        stations.updateLastSeen.run(station.id);
+
+        // Sin alertas: son datos pasados. Se devuelven los huecos que quedan
+        // respecto de la última lectura en vivo.
+        const latest = readings.getLatestDirect.get(station.id);
+        res.json({
+            success: true,
+            inserted,
+            backfill: latest ? findBackfillGaps(station.id, latest.packet_id) : []
+        });
+    } catch (error) {
+        console.error('Error en backfill:', error);
+        res.status(500).json({ error: 'Error al procesar datos' });
+    }
+});
+
+/**
+ * POST /api/data/batch
+ * Varias lecturas acumuladas por la estación en una sola solicitud
+ * Headers requeridos: X-API-Key
+ * Body: { columns: ["packetId", "ageSec", ...], rows: [[...], ...] }
+ * Cada fila trae los valores en el orden de `columns` (null si el sensor
+ * falló); `soil` es [[addr, depth, vwc, temp, ec], ...]. Filas de la más
+ * antigua a la más reciente. Todo entra en una transacción; las filas ya
+ * guardadas se ignoran, así que reintentar un lote es seguro.
+ */
+function rowToReading(columns, row) {
+    const r = {};
+    columns.forEach((c, i) => { r[c] = row[i]; });
+    if (r.vBat !== undefined) r.batteryVoltage = r.vBat;
+    if (Array.isArray(r.soil)) {
+        r.soil = r.soil
+            .filter(Array.isArray)
+            .map(([addr, depth, vwc, temp, ec]) => ({ addr, depth, vwc, temp, ec }));
+    }
+    return r;
+}
+
+const insertBatch = db.transaction((stationId, list) => {
+    let inserted = 0;
+    let duplicates = 0;
+    list.forEach(r => {
+        const timestamp = sampleTimestamp(r.ageSec);
+        if (!Number.isInteger(r.packetId) || !timestamp) return;
+        if (isDuplicate(stationId, nodeOf(r), r.packetId, timestamp)) {
+            duplicates++;
+            return;
+        }
+        insertReading(stationId, r, timestamp);
+        inserted++;
+    });
+    return { inserted, duplicates };
+});
+
+router.post('/batch', (req, res) => {
+    try {
+        const apiKey = req.headers['x-api-key'];
+        if (!apiKey) {
+            return res.status(401).json({ error: 'API key requerida' });
+        }
+        const station = stations.getByApiKey.get(apiKey);
+        if (!station) {
+            return res.status(401).json({ error: 'API key inválida' });
+        }
+
+        const { columns, rows } = req.body;
+        if (!Array.isArray(columns) || !Array.isArray(rows) ||
+            !columns.includes('packetId') || !columns.includes('ageSec')) {
+            return res.status(400).json({ error: 'Se esperan columns (con packetId y ageSec) y rows' });
+        }
+        if (rows.length > BATCH.maxRows) {
+            return res.status(413).json({ error: `Máximo ${BATCH.maxRows} lecturas por lote` });
+        }
+
+        const list = rows.filter(Array.isArray).map(row => rowToReading(columns, row));
+        const result = insertBatch(station.id, list);
+        stations.updateLastSeen.run(station.id);
+
+        // Alertas solo con la lectura más reciente, como en /ingest
+        const newest = list[list.length - 1];
+        if (newest) checkAndCreateAlerts(station.id, newest);
+
+        res.json({
+            success: true,
+            timestamp: new Date().toISOString(),
+            ...result,
+            config: {
+                sf: station.config_sf,
+                bw: station.config_bw,
+                interval: station.config_interval
+            },
+            backfill: newest ? findBackfillGaps(station.id, newest.packetId) : []
+        });
+    } catch (error) {
+        console.error('Error en lote:', error);
+        res.status(500).json({ error: 'Error al procesar datos' });
+    }
+});
+
 /**
  * Verificar y crear alertas según umbrales
  */
@@ -147,6 +404,7 @@ router.get('/:stationId/latest', (req, res) => {
         if (!reading) {
             return res.status(404).json({ error: 'Sin datos disponibles' });
         }
+        reading.soil = readings.getSoilByReading.all(reading.id);
         res.json(reading);
     } catch (error) {
         console.error('Error al obtener datos:', error);
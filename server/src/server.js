@@ -126,7 +126,7 @@ app.use((err, req, res, next) => {
 });
 
 // Iniciar servidor
-app.listen(PORT, () => {
+const server = app.listen(PORT, () => {
     console.log(`
 ╔════════════════════════════════════════════════════════════╗
 ║           GIPIS Weather Station Server v1.0.0              ║
@@ -137,4 +137,9 @@ app.listen(PORT, () => {
     `);
 });
 
+// Conexiones persistentes: las estaciones envían cada minuto y reusan la
+// conexión TLS (UPLINK_IDLE_MS = 70 s en el firmware)
+server.keepAliveTimeout = 75000;
+server.headersTimeout = 76000;
+
 module.exports = app;
@@ -33,7 +33,9 @@ void handleButton() {
                 longPressHandled = true;
                 
                 if (uiState == UI_VIEW) {
-                    if (currentScreen == 3) { // Config Screen
+                    if (currentScreen <= 1) { // Node Screens -> next node
+                        selectNextNode();
+                    } else if (currentScreen == 3) { // Config Screen
                         uiState = UI_EDIT;
                         editCursor = 0;
                     } else if (currentScreen == 2) { // WiFi Screen -> Popup
@@ -1,5 +1,6 @@
 #include "display.h"
 #include "lora.h"
+#include "../shared/oled_tiles.h"
 #include <WiFi.h>
 
 // Display Instance
@@ -9,6 +10,9 @@ U8G2_SSD1306_128X64_NONAME_F_HW_I2C display(U8G2_R0, OLED_RST, OLED_SCL, OLED_SD
 int currentScreen = 0;
 bool isScreenOn = true;
 
+// Node Selection
+int shownNode = -1;
+
 // UI State
 UIState uiState = UI_VIEW;
 int editCursor = 0;
@@ -55,41 +59,69 @@ void checkScreenTimeout() {
     }
 }
 
+// Copy of the node the data screens show
+static bool shownNodeState(NodeState& out) {
+    if (shownNode >= 0) return loraFindNode((uint16_t)shownNode, out);
+    if (lastData.packetId == 0 && !newData) return false;
+    return loraFindNode(lastData.nodeId, out);
+}
+
+void selectNextNode() {
+    int next = -1;
+    NodeState n;
+    for (uint32_t slot = 0; slot < NODE_TABLE_CAPACITY; slot++) {
+        if (!loraNodeAt(slot, n)) continue;
+        if (n.id > shownNode && (next < 0 || n.id < next)) next = n.id;
+    }
+    shownNode = next;
+}
+
 void drawRemoteData() {
     display.setFont(u8g2_font_6x10_tr);
-    display.drawStr(0, 10, "1. DATOS REMOTOS");
     
     char buf[32];
-    if (lastData.packetId == 0 && !newData) {
+    NodeState n;
+    if (!shownNodeState(n)) {
+        display.drawStr(0, 10, "1. DATOS REMOTOS");
         display.drawStr(0, 30, "Esperando datos...");
         return;
     }
     
-    sprintf(buf, "T.Air: %.1f C", lastData.tempAire); display.drawStr(0, 24, buf);
-    sprintf(buf, "Hum: %.1f %%", lastData.humAire);   display.drawStr(0, 36, buf);
-    sprintf(buf, "VWC: %.1f %%", lastData.vwcSuelo);  display.drawStr(0, 48, buf);
-    sprintf(buf, "T.Gnd: %.1f C", lastData.tempSuelo);display.drawStr(0, 60, buf);
+    sprintf(buf, "1. NODO %u%s", n.id, n.online ? "" : " (OFF)");
+    display.drawStr(0, 10, buf);
+    sprintf(buf, "T.Air: %.1f C", n.reading.tempAire); display.drawStr(0, 24, buf);
+    sprintf(buf, "Hum: %.1f %%", n.reading.humAire);   display.drawStr(0, 36, buf);
+    sprintf(buf, "VWC: %.1f %%", n.reading.vwcSuelo);  display.drawStr(0, 48, buf);
+    sprintf(buf, "T.Gnd: %.1f C", n.reading.tempSuelo);display.drawStr(0, 60, buf);
 }
 
 void drawLoRaInfo() {
     display.setFont(u8g2_font_6x10_tr);
-    display.drawStr(0, 10, "2. ESTADO LORA");
     char buf[32];
+    NodeState n;
     
-    if (radio.getRSSI() == 0) {
+    if (!shownNodeState(n)) {
+        display.drawStr(0, 10, "2. ESTADO LORA");
         display.drawStr(0, 30, "No Signal");
     } else {
-        sprintf(buf, "RSSI: %.1f dBm", radio.getRSSI());
-        display.drawStr(0, 30, buf);
+        sprintf(buf, "2. LORA NODO %u", n.id);
+        display.drawStr(0, 10, buf);
+
+        sprintf(buf, "RSSI: %.1f dBm", n.rssi);
+        display.drawStr(0, 24, buf);
         
-        sprintf(buf, "SNR: %.1f dB", radio.getSNR());
-        display.drawStr(0, 42, buf);
+        uint32_t total = n.received + n.lost;
+        sprintf(buf, "SNR: %.1f  Perd %.0f%%", n.snr, total ? n.lost * 100.0 / total : 0.0);
+        display.drawStr(0, 36, buf);
         
-        unsigned long secondsAgo = (millis() - lastPacketTime) / 1000;
-        if (lastPacketTime == 0) secondsAgo = 0;
-        sprintf(buf, "Last: %lu s ago", secondsAgo);
-        display.drawStr(0, 54, buf);
+        sprintf(buf, "Last: %lu s ago", (millis() - n.lastMs) / 1000);
+        display.drawStr(0, 48, buf);
     }
+
+    NodeTableStats ns;
+    loraGetNodeStats(ns);
+    sprintf(buf, "Nodos: %u (%u on)", ns.nodes, ns.online);
+    display.drawStr(0, 60, buf);
 }
 
 void drawPopup(const char* title, const char* opts[], int count, int sel) {
@@ -170,11 +202,83 @@ void drawConfig() {
     }
 }
 
+// Hash of everything the current screen shows. The frame is rebuilt only
+// when it changes.
+static uint32_t screenKey(bool rxBlink) {
+    uint32_t h = OLED_KEY_INIT;
+    oledKeyMix(h, &currentScreen, sizeof(currentScreen));
+    oledKeyMix(h, &uiState, sizeof(uiState));
+    oledKeyMix(h, &editCursor, sizeof(editCursor));
+    oledKeyMix(h, &popupSelection, sizeof(popupSelection));
+    oledKeyMix(h, &rxBlink, sizeof(rxBlink));
+    bool pendingCmd = loraHasPendingCmd();
+    oledKeyMix(h, &pendingCmd, sizeof(pendingCmd));
+
+    // Node screens: the node shown and what the screens print of it
+    NodeState n;
+    memset(&n, 0, sizeof(n));
+    if (currentScreen <= 1) {
+        bool known = shownNodeState(n);
+        oledKeyMix(h, &known, sizeof(known));
+        if (known) {
+            oledKeyMix(h, &n.id, sizeof(n.id));
+            oledKeyMix(h, &n.online, sizeof(n.online));
+            oledKeyMix(h, &n.lastSeq, sizeof(n.lastSeq));
+        }
+    }
+
+    switch (currentScreen) {
+        case 0:
+            oledKeyMix(h, &n.reading.tempAire, sizeof(n.reading.tempAire));
+            oledKeyMix(h, &n.reading.humAire, sizeof(n.reading.humAire));
+            oledKeyMix(h, &n.reading.vwcSuelo, sizeof(n.reading.vwcSuelo));
+            oledKeyMix(h, &n.reading.tempSuelo, sizeof(n.reading.tempSuelo));
+            break;
+        case 1: {
+            NodeTableStats ns;
+            loraGetNodeStats(ns);
+            unsigned long secondsAgo = (millis() - n.lastMs) / 1000;
+            oledKeyMix(h, &n.rssi, sizeof(n.rssi));
+            oledKeyMix(h, &n.snr, sizeof(n.snr));
+            oledKeyMix(h, &n.lost, sizeof(n.lost));
+            oledKeyMix(h, &secondsAgo, sizeof(secondsAgo));
+            oledKeyMix(h, &ns.nodes, sizeof(ns.nodes));
+            oledKeyMix(h, &ns.online, sizeof(ns.online));
+            break;
+        }
+        case 2: {
+            int status = WiFi.status();
+            long rssi = WiFi.RSSI();
+            oledKeyMix(h, &status, sizeof(status));
+            oledKeyMix(h, &rssi, sizeof(rssi));
+            break;
+        }
+        case 3:
+            oledKeyMix(h, &currentSF, sizeof(currentSF));
+            oledKeyMix(h, &currentBW, sizeof(currentBW));
+            oledKeyMix(h, &scrIndex, sizeof(scrIndex));
+            break;
+    }
+    return h;
+}
+
 void renderScreen() {
+    static unsigned long lastFrameTime = 0;
+    static uint32_t lastKey = 0;
+    static bool keyValid = false;
+
     if (!isScreenOn) {
-        delay(100);
+        keyValid = false; // redraw on wake
         return;
     }
+    if (millis() - lastFrameTime < OLED_MIN_FRAME_MS) return;
+    lastFrameTime = millis();
+
+    bool rxBlink = uiState != UI_POPUP && millis() - lastPacketTime < 1000 && lastPacketTime != 0;
+    uint32_t key = screenKey(rxBlink);
+    if (keyValid && key == lastKey) return;
+    lastKey = key;
+    keyValid = true;
     
     display.clearBuffer();
     switch (currentScreen) {
@@ -185,11 +289,9 @@ void renderScreen() {
     }
     
     // RX indicator
-    if (uiState != UI_POPUP && millis() - lastPacketTime < 1000 && lastPacketTime != 0) {
-        display.drawDisc(124, 4, 2);
-    }
+    if (rxBlink) display.drawDisc(124, 4, 2);
     // Pending command indicator
-    if (hasPendingCmd) display.drawStr(64, 4, "!");
+    if (loraHasPendingCmd()) display.drawStr(64, 4, "!");
     
-    display.sendBuffer();
+    oledFlush(display);
 }
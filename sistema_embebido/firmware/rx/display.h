@@ -18,6 +18,9 @@ extern UIState uiState;
 extern int editCursor;
 extern int popupSelection;
 
+// Node shown on the data and LoRa screens (-1: the one heard last)
+extern int shownNode;
+
 // Screen Timeout
 extern int scrIndex;
 extern unsigned long lastInteraction;
@@ -39,6 +42,10 @@ void wakeScreen();
 // Check and apply screen timeout
 void checkScreenTimeout();
 
+// Show the node with the next higher id; after the last one, back to
+// following the node heard last
+void selectNextNode();
+
 // Draw functions
 void drawRemoteData();
 void drawLoRaInfo();
@@ -46,7 +53,8 @@ void drawWiFiInfo();
 void drawConfig();
 void drawPopup(const char* title, const char* opts[], int count, int sel);
 
-// Full screen render cycle
+// Render cycle: redraws only when the screen's inputs change (at most every
+// OLED_MIN_FRAME_MS) and sends only the dirty tiles
 void renderScreen();
 
 #endif
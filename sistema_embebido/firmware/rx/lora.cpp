@@ -1,6 +1,9 @@
 #include "lora.h"
 #include "server_client.h"
+#include "../shared/spsc_ring.h"
+#include "../shared/wire_packet.h"
 #include <SPI.h>
+#include <esp_timer.h>
 
 // Radio Instance
 SX1262 radio = new Module(RADIO_NSS, RADIO_DIO_1, RADIO_RST, RADIO_BUSY);
@@ -18,31 +21,155 @@ float lastSNR = 0;
 float lastFreqError = 0;
 bool newData = false;
 
-// Reliability Stats
-unsigned long lastRxPacketId = 0;
-uint32_t packetsReceived = 0;
-uint32_t packetsLost = 0;
+// Remote Command: queued by the web server task, sent by the radio task.
+// cmdSeq tells the radio task whether a new command arrived while it was
+// sending the previous one.
+static ConfigPacket pendingCmd;
+static bool hasPendingCmd = false;
+static uint32_t cmdSeq = 0;
+static portMUX_TYPE cmdMux = portMUX_INITIALIZER_UNLOCKED;
 
-// Remote Command
-ConfigPacket pendingCmd;
-bool hasPendingCmd = false;
+// Radio task -> loop()
+static SpscRing<RxFrame, RX_RING_SIZE> rxRing;
+static TaskHandle_t radioTask = NULL;
+static volatile bool reconfigAsked = false;
+static volatile int64_t dio1Us = 0;
 
-// ISR Flag
-volatile bool operationDone = false;
-static void setFlag() { operationDone = true; }
+static LoraRxStats stats;
+
+// Per-node state: written by loop(), read by the web server task too.
+// update() and sweep() walk the table, so a mutex guards it rather than a
+// critical section (interrupts stay on); readers copy entries out.
+static NodeTable<NODE_TABLE_CAPACITY> nodes;
+static SemaphoreHandle_t nodesMutex = NULL;
+
+static inline void nodesLock() {
+    xSemaphoreTake(nodesMutex, portMAX_DELAY);
+}
+
+static inline void nodesUnlock() {
+    xSemaphoreGive(nodesMutex);
+}
+
+static bool isWireReading(const uint8_t* data, size_t len) {
+    return len >= WIRE_PREFIX_BYTES + WIRE_CRC_BYTES && len <= WIRE_FRAME_MAX &&
+           data[0] == WIRE_HEADER(WIRE_TYPE_READING);
+}
+
+// A reading: a wire frame (wire_format.h) or the raw struct of older firmware
+static bool isReading(const uint8_t* data, size_t len) {
+    return len == WIRE_LEGACY_BYTES || isWireReading(data, len);
+}
+
+static void IRAM_ATTR onDio1() {
+    dio1Us = esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    if (radioTask) vTaskNotifyGiveFromISR(radioTask, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// ============================================
+// Radio task
+// ============================================
+
+static void reconfigure() {
+    reconfigAsked = false;
+    Serial.print("Reconfig LoRa... ");
+    radio.setSpreadingFactor(currentSF);
+    radio.setBandwidth(currentBW);
+    radio.startReceive();
+    Serial.printf("Done: SF%d BW%.0f\n", currentSF, currentBW);
+}
+
+// Answer a data packet with the queued command, in the TX's receive window
+static void sendCommand() {
+    vTaskDelay(pdMS_TO_TICKS(RX_CMD_DELAY_MS));
+    Serial.print("Sending CMD... ");
+
+    portENTER_CRITICAL(&cmdMux);
+    ConfigPacket cmd = pendingCmd;
+    uint32_t seq = cmdSeq;
+    portEXIT_CRITICAL(&cmdMux);
+
+    int txState = radio.transmit((uint8_t*)&cmd, sizeof(ConfigPacket));
+    ulTaskNotifyTake(pdTRUE, 0);  // TX done, not a received frame
+
+    if (txState == RADIOLIB_ERR_NONE) {
+        Serial.println("OK");
+        portENTER_CRITICAL(&cmdMux);
+        if (cmdSeq == seq) hasPendingCmd = false;
+        portEXIT_CRITICAL(&cmdMux);
+
+        // Apply locally
+        bool reinit = false;
+        if (cmd.sf != currentSF) { currentSF = cmd.sf; reinit = true; }
+        if (cmd.bw != currentBW) { currentBW = cmd.bw; reinit = true; }
+        txInterval = cmd.interval;
+
+        if (reinit) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            reconfigure();
+            return;
+        }
+    } else {
+        Serial.print("Fail: "); Serial.println(txState);
+    }
+    radio.startReceive();
+}
+
+static void radioTaskFn(void* arg) {
+    RxFrame f;
+
+    while (true) {
+        bool irq = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RX_TASK_POLL_MS)) > 0;
+        if (reconfigAsked) reconfigure();
+        if (!irq) continue;
+
+        size_t len = radio.getPacketLength();
+        if (len > RX_FRAME_MAX) len = RX_FRAME_MAX;
+        int state = radio.readData(f.data, len);
+        f.rxMs = millis();
+        f.rssi = radio.getRSSI();
+        f.snr = radio.getSNR();
+        f.freqError = radio.getFrequencyError();
+        f.len = len;
+
+        // Listening again before anything else
+        radio.startReceive();
+        uint32_t us = esp_timer_get_time() - dio1Us;
+        if (us > stats.rearmMaxUs) stats.rearmMaxUs = us;
+
+        stats.frames++;
+        if (state != RADIOLIB_ERR_NONE) {
+            stats.crcErrors++;
+            continue;
+        }
+        rxRing.push(f);
+
+        if (loraHasPendingCmd() && isReading(f.data, len)) sendCommand();
+    }
+}
+
+// ============================================
+// Public API
+// ============================================
 
 bool loraInit() {
+    if (!nodesMutex) nodesMutex = xSemaphoreCreateMutex();
+
     Serial.print(F("[SX1262] Initializing ... "));
     SPI.begin(RADIO_SCLK, RADIO_MISO, RADIO_MOSI, RADIO_NSS);
-    
-    int state = radio.begin(LORA_FREQ, LORA_BW, LORA_SF, LORA_CR, 
-                            LORA_SYNC_WORD, LORA_POWER, LORA_PREAMBLE_LEN, 
+
+    int state = radio.begin(LORA_FREQ, LORA_BW, LORA_SF, LORA_CR,
+                            LORA_SYNC_WORD, LORA_POWER, LORA_PREAMBLE_LEN,
                             LORA_TCXO_VOLTAGE);
-    
+
     if (state == RADIOLIB_ERR_NONE) {
         Serial.println(F("success!"));
         radio.setDio2AsRfSwitch(true);
-        radio.setDio1Action(setFlag);
+        xTaskCreatePinnedToCore(radioTaskFn, "radio_rx", RX_TASK_STACK, NULL,
+                                RX_TASK_PRIORITY, &radioTask, RX_TASK_CORE);
+        radio.setDio1Action(onDio1);
         radio.startReceive();
         return true;
     } else {
@@ -53,88 +180,138 @@ bool loraInit() {
 }
 
 void applyLoRaConfig() {
-    Serial.print("Reconfig LoRa... ");
-    radio.setSpreadingFactor(currentSF);
-    radio.setBandwidth(currentBW);
-    radio.startReceive();
-    Serial.printf("Done: SF%d BW%.0f\n", currentSF, currentBW);
+    reconfigAsked = true;
+    if (radioTask) xTaskNotifyGive(radioTask);
 }
 
-void loraStartReceive() {
-    radio.startReceive();
+void loraQueueCommand(const ConfigPacket& cmd) {
+    portENTER_CRITICAL(&cmdMux);
+    pendingCmd = cmd;
+    hasPendingCmd = true;
+    cmdSeq++;
+    portEXIT_CRITICAL(&cmdMux);
+}
+
+bool loraHasPendingCmd() {
+    portENTER_CRITICAL(&cmdMux);
+    bool pending = hasPendingCmd;
+    portEXIT_CRITICAL(&cmdMux);
+    return pending;
 }
 
 bool loraProcessReceive() {
-    int state = radio.readData((uint8_t*)&lastData, sizeof(MeteorDataPacket));
-    
-    if (state == RADIOLIB_ERR_NONE) {
-        Serial.println("RX OK");
+    RxFrame f;
+    if (!rxRing.pop(f)) return false;
+
+    WireReading r;
+    bool wire = isWireReading(f.data, f.len);
+    WireStatus st = wire ? wireDecode(f.data, f.len, r) : WIRE_ERR_VERSION;
+    if (st != WIRE_OK && f.len == WIRE_LEGACY_BYTES) {
+        // Raw struct from firmware before the wire format. A wire frame of
+        // the same length gets here only if its CRC-16 fails as well.
+        st = wireDecodeLegacy(f.data, f.len, r);
+        wire = false;
+        stats.rawFrames++;
+    }
+    if (st != WIRE_OK) {
+        if (wire) {
+            stats.wireErrors++;
+            Serial.printf("RX Fail: wire frame, %u bytes, error %d\n", f.len, st);
+        } else {
+            stats.badLength++;
+            Serial.printf("RX Fail: %u bytes\n", f.len);
+        }
+        return true;
+    }
+
+    MeteorDataPacket pkt;
+    wireToPacket(r, pkt);
+
+    NodeReading reading = { pkt.tempAire, pkt.humAire, pkt.tempSuelo, pkt.vwcSuelo,
+                            pkt.ecSuelo, pkt.par, pkt.vBat, pkt.batPercent };
+    nodesLock();
+    NodeUpdate u = nodes.update(pkt.nodeId, pkt.packetId, reading, f.rssi, f.snr,
+                                pkt.interval, f.rxMs);
+    nodesUnlock();
+
+    switch (u) {
+        case NODE_DUPLICATE:
+            // Still uploaded: a reboot the table did not notice looks the
+            // same, and a repeated row costs less than a lost reading
+            stats.duplicates++;
+            Serial.printf("RX Dup: node %u #%lu\n", pkt.nodeId, (unsigned long)pkt.packetId);
+            break;
+        case NODE_NEW:
+            Serial.printf("[LoRa] New node %u\n", pkt.nodeId);
+            break;
+        case NODE_RESET:
+            Serial.printf("[LoRa] Node %u restarted at #%lu\n", pkt.nodeId, (unsigned long)pkt.packetId);
+            break;
+        case NODE_REJECTED:
+            // Still uploaded; only its link state is not kept
+            Serial.printf("[LoRa] Node table full, node %u not tracked\n", pkt.nodeId);
+            break;
+        default:
+            break;
+    }
+    Serial.printf("RX OK: node %u #%lu\n", pkt.nodeId, (unsigned long)pkt.packetId);
+
+    // A late or repeated frame fills a gap; the newest reading stays
+    if (u != NODE_LATE && u != NODE_DUPLICATE) {
+        lastData = pkt;
         newData = true;
-        
+
         // Capture Metrics
-        lastPacketTime = millis();
-        lastRSSI = radio.getRSSI();
-        lastSNR = radio.getSNR();
-        lastFreqError = radio.getFrequencyError();
-        
-        // Packet Loss Calculation
-        if (lastData.packetId > lastRxPacketId + 1) {
-            if (lastRxPacketId != 0) {
-                packetsLost += (lastData.packetId - lastRxPacketId - 1);
-            }
-        } else if (lastData.packetId < lastRxPacketId) {
-            // TX Reset detected
-            packetsReceived = 0;
-            packetsLost = 0;
-        }
-        lastRxPacketId = lastData.packetId;
-        packetsReceived++;
-        
+        lastPacketTime = f.rxMs;
+        lastRSSI = f.rssi;
+        lastSNR = f.snr;
+        lastFreqError = f.freqError;
+
         // Sync State from TX
-        txInterval = lastData.interval;
-        
-        // Send to remote server
-        sendToServer(lastData, lastRSSI, lastSNR, lastFreqError);
-        
-        return true;
-    } else {
-        Serial.print(F("RX Fail: ")); Serial.println(state);
-        radio.startReceive();
-        return false;
+        if (pkt.interval > 0) txInterval = pkt.interval;
     }
+
+    // Queue for the uplink task (never waits on the server)
+    sendToServer(pkt, f.rssi, f.snr, f.freqError);
+
+    return true;
 }
 
-bool loraSendCommand() {
-    if (!hasPendingCmd) return false;
-    
-    delay(150); // Wait for TX to open RX window
-    Serial.print("Sending CMD... ");
-    
-    operationDone = false;
-    int txState = radio.transmit((uint8_t*)&pendingCmd, sizeof(ConfigPacket));
-    
-    if (txState == RADIOLIB_ERR_NONE) {
-        Serial.println("OK");
-        hasPendingCmd = false;
-        
-        // Apply locally
-        bool reinit = false;
-        if (pendingCmd.sf != currentSF) { currentSF = pendingCmd.sf; reinit = true; }
-        if (pendingCmd.bw != currentBW) { currentBW = pendingCmd.bw; reinit = true; }
-        txInterval = pendingCmd.interval;
-        
-        if (reinit) {
-            delay(100);
-            applyLoRaConfig();
-        }
-        
-        operationDone = false;
-        radio.startReceive();
-        return true;
-    } else {
-        Serial.print("Fail: "); Serial.println(txState);
-        operationDone = false;
-        radio.startReceive();
-        return false;
-    }
+void loraGetStats(LoraRxStats& out) {
+    out = stats;
+    out.ringDrops = rxRing.overflowCount();
+    out.ringHighWater = rxRing.highWaterMark();
+}
+
+void loraNodesLoop() {
+    static unsigned long lastSweep = 0;
+    if (millis() - lastSweep < RX_NODE_SWEEP_MS) return;
+    lastSweep = millis();
+
+    nodesLock();
+    uint32_t changed = nodes.sweep(millis());
+    nodesUnlock();
+    if (changed) Serial.printf("[LoRa] %u node(s) went offline\n", changed);
+}
+
+bool loraNodeAt(uint32_t slot, NodeState& out) {
+    nodesLock();
+    const NodeState* e = nodes.at(slot);
+    if (e) out = *e;
+    nodesUnlock();
+    return e != NULL;
+}
+
+bool loraFindNode(uint16_t id, NodeState& out) {
+    nodesLock();
+    const NodeState* e = nodes.get(id);
+    if (e) out = *e;
+    nodesUnlock();
+    return e != NULL;
+}
+
+void loraGetNodeStats(NodeTableStats& out) {
+    nodesLock();
+    nodes.getStats(out);
+    nodesUnlock();
 }
@@ -1,9 +1,66 @@
+/**
+ * LoRa Reception (RX gateway)
+ *
+ * The radio belongs to a task of its own. DIO1 wakes it; it reads the
+ * frame with its RSSI/SNR, puts the radio back in receive mode at once and
+ * pushes the raw frame, timestamped, into a lock-free ring. loop() decodes
+ * frames from the ring (loraProcessReceive()) and hands them to the uplink
+ * task, so nothing downstream (display, server, a stalled upload) keeps the
+ * SX1262 out of receive mode. Only a full ring loses frames, and that is
+ * counted.
+ *
+ * Commands to the TX and SF/BW changes also run in the radio task.
+ *
+ * Frames are wire_format.h readings; a frame of WIRE_LEGACY_BYTES (40) is
+ * the raw struct older TX firmware sends, still accepted as node 0 with no
+ * soil profile.
+ *
+ * Every decoded frame updates the entry of its node (nodeId) in a
+ * NodeTable (node_table.h): loss, duplicates, link quality, last reading
+ * and online state per station. Late and duplicate frames are uploaded
+ * too (a duplicate may be a reboot the table did not recognize) but do
+ * not replace the newest reading. Other tasks (web server) read entries
+ * through the copying accessors below.
+ */
+
 #ifndef RX_LORA_H
 #define RX_LORA_H
 
 #include <Arduino.h>
 #include <RadioLib.h>
 #include "../shared/config.h"
+#include "node_table.h"
+
+#define RX_FRAME_MAX        255     // SX1262 FIFO
+#define RX_RING_SIZE        16      // frames waiting for loop()
+#define RX_TASK_STACK       4096
+#define RX_TASK_PRIORITY    3       // above loop() on its core
+#define RX_TASK_CORE        1
+#define RX_TASK_POLL_MS     1000    // wake-up for a reconfiguration without frames
+#define RX_CMD_DELAY_MS     150     // TX opens its receive window after sending
+#define RX_NODE_SWEEP_MS    1000    // online/offline check
+
+// One received frame, as read from the radio
+struct RxFrame {
+    uint32_t rxMs;              // millis() when it was read
+    float rssi;
+    float snr;
+    float freqError;
+    uint8_t len;
+    uint8_t data[RX_FRAME_MAX];
+};
+
+struct LoraRxStats {
+    uint32_t frames;            // read from the radio
+    uint32_t crcErrors;         // readData() failures
+    uint32_t badLength;         // neither a wire frame nor a raw legacy struct
+    uint32_t wireErrors;        // wire frames failing CRC / version / length
+    uint32_t rawFrames;         // raw 40-byte structs (older TX firmware)
+    uint32_t duplicates;        // already received from that node
+    uint32_t ringDrops;         // ring full
+    uint32_t ringHighWater;
+    uint32_t rearmMaxUs;        // DIO1 to receive mode again
+};
 
 // LoRa Radio Instance
 extern SX1262 radio;
@@ -13,7 +70,7 @@ extern int currentSF;
 extern float currentBW;
 extern unsigned long txInterval;
 
-// Reception State
+// Reception State (newest frame from any node)
 extern MeteorDataPacket lastData;
 extern unsigned long lastPacketTime;
 extern float lastRSSI;
@@ -21,32 +78,34 @@ extern float lastSNR;
 extern float lastFreqError;
 extern bool newData;
 
-// Reliability Stats
-extern unsigned long lastRxPacketId;
-extern uint32_t packetsReceived;
-extern uint32_t packetsLost;
-
-// Remote Command
-extern ConfigPacket pendingCmd;
-extern bool hasPendingCmd;
-
-// ISR Flag
-extern volatile bool operationDone;
-
-// Initialize LoRa radio
+// Initialize LoRa radio and start the radio task
 bool loraInit();
 
-// Apply current SF/BW config and restart receive
+// Apply current SF/BW config and restart receive (done by the radio task)
 void applyLoRaConfig();
 
-// Start receiving mode
-void loraStartReceive();
+// Queue a command for the TX; the radio task sends it after the next
+// reading it receives. Replaces a command still queued. Any task.
+void loraQueueCommand(const ConfigPacket& cmd);
+
+// A command is queued and not sent yet
+bool loraHasPendingCmd();
 
-// Process received packet (call when operationDone is true)
-// Returns true if valid data received
+// Decode the oldest frame in the ring and queue it for upload; call from
+// loop() until it returns false (ring empty)
 bool loraProcessReceive();
 
-// Send pending command to TX
-bool loraSendCommand();
+void loraGetStats(LoraRxStats& out);
+
+// Mark silent nodes offline (every RX_NODE_SWEEP_MS); call from loop()
+void loraNodesLoop();
+
+// Copy of the node in `slot` (0..NODE_TABLE_CAPACITY-1); false if empty
+bool loraNodeAt(uint32_t slot, NodeState& out);
+
+// Copy of node `id`; false if it is not in the table
+bool loraFindNode(uint16_t id, NodeState& out);
+
+void loraGetNodeStats(NodeTableStats& out);
 
 #endif
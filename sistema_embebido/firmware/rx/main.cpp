@@ -3,7 +3,7 @@
  * 
  * This is the receiver gateway of the weather station.
  * Modules:
- *   - lora: SX1262 reception and command sending
+ *   - lora: SX1262 reception (radio task), per-node state and command sending
  *   - wifi_manager: WiFi connection and web server
  *   - display: OLED UI
  *   - button: User input handling
@@ -18,9 +18,8 @@
 #include "button.h"
 #include "wifi_manager.h"
 #include "server_client.h"
-
-// Display update timing
-unsigned long lastDisplayUpdate = 0;
+#include "../shared/loop_stats.h"
+#include "../shared/uplink.h"
 
 void setup() {
     Serial.begin(115200);
@@ -46,29 +45,22 @@ void setup() {
 }
 
 void loop() {
+    loopStatsTick();
+    
     // 1. Handle User Input
     handleButton();
     
     // 2. Check Screen Timeout
     checkScreenTimeout();
     
-    // 3. LoRa Reception
-    if (operationDone) {
-        operationDone = false;
-        
-        if (loraProcessReceive()) {
-            // Valid packet received, check for pending command
-            if (hasPendingCmd) {
-                loraSendCommand();
-            } else {
-                loraStartReceive();
-            }
-        }
-    }
+    // 3. LoRa Reception: frames queued by the radio task (which also
+    // answers with the pending command)
+    while (loraProcessReceive()) {}
+    loraNodesLoop();
     
-    // 4. Update Display (throttled)
-    if (millis() - lastDisplayUpdate > 200) {
-        lastDisplayUpdate = millis();
-        renderScreen();
-    }
+    // 4. Update Display (change-driven, frame rate capped inside)
+    renderScreen();
+
+    // 5. Close the server connection once idle
+    uplinkLoop();
 }
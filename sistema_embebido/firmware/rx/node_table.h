@@ -0,0 +1,330 @@
+/**
+ * Per-Node State Table (RX gateway)
+ *
+ * One entry per TX node heard, keyed by the nodeId of MeteorDataPacket:
+ * sequence window, link quality, last reading, expected interval and
+ * online/offline state. Fixed capacity, open addressing with linear
+ * probing on a Fibonacci hash of the id, so the receive path finds its
+ * entry in O(1) without touching the heap.
+ *
+ * Load is kept at or below half of the slots, where linear probing needs
+ * 1.5 probes per lookup on average. A new node arriving at that point
+ * takes the slot of the node silent for the longest time if that one is
+ * offline; otherwise it is rejected and counted. Removal shifts the
+ * following entries of the probe run back, so there are no tombstones and
+ * probe runs do not grow with churn.
+ *
+ * Sequence window: packetIds up to NODE_SEQ_WINDOW - 1 behind the newest
+ * are tracked in a bitmap, so a repeated frame is a duplicate and a late
+ * one fills the gap it had counted as lost. A packetId further back means
+ * the node rebooted (the counter restarts); the window starts over. So
+ * does an older packetId after half an expected interval of silence: a
+ * repeat or a late frame follows the newest one within seconds, while a
+ * node that rebooted with a low lastSeq (its new 1, 2, ... inside the
+ * window) only sends again on its next cycle.
+ *
+ * No Arduino/IDF (built by tools/node_table_bench); not locked, lora.cpp guards its table.
+ */
+
+#ifndef RX_NODE_TABLE_H
+#define RX_NODE_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define NODE_TABLE_CAPACITY     128     // power of two; a field of up to 64 stations
+#define NODE_SEQ_WINDOW         32      // bits in the sequence bitmap
+#define NODE_INTERVAL_DEFAULT_MS 60000  // until the node reports or we measure one
+#define NODE_OFFLINE_MISSES     3       // expected intervals without a frame
+#define NODE_OFFLINE_SLACK_MS   30000
+
+#define NODE_ID_NONE            0       // unassigned (firmware without a node id)
+
+// Last reading of a node, as shown on the display and /data
+struct NodeReading {
+    float tempAire;
+    float humAire;
+    float tempSuelo;
+    float vwcSuelo;
+    float ecSuelo;
+    float par;
+    float vBat;
+    uint8_t batPercent;
+};
+
+struct NodeState {
+    uint16_t id;
+    bool used;                  // slot occupied
+    bool online;
+    uint32_t lastSeq;           // newest packetId
+    uint32_t seqMask;           // bit i: lastSeq - i received
+    uint32_t received;
+    uint32_t lost;              // gaps not (yet) filled by late frames
+    uint32_t duplicates;
+    uint32_t resets;            // packetId restarted (node reboot)
+    float rssi;
+    float snr;
+    float rssiAvg;              // EWMA, 1/8 per frame
+    float snrAvg;
+    float rssiMin;
+    uint32_t firstMs;
+    uint32_t lastMs;
+    uint32_t intervalMs;        // expected time between frames
+    bool intervalReported;      // intervalMs comes from the node, not measured
+    NodeReading reading;
+};
+
+enum NodeUpdate {
+    NODE_NEW,                   // first frame of this node
+    NODE_OK,
+    NODE_LATE,                  // inside the window, filled a gap
+    NODE_DUPLICATE,             // already seen; reading not applied
+    NODE_RESET,                 // packetId restarted
+    NODE_REJECTED               // table full, no offline node to replace
+};
+
+struct NodeTableStats {
+    uint32_t nodes;
+    uint32_t online;
+    uint32_t evictions;         // offline nodes replaced by new ones
+    uint32_t rejected;          // frames of nodes that found no slot
+    uint32_t maxProbe;          // longest probe run seen by a lookup
+};
+
+template <uint32_t N>
+class NodeTable {
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "NodeTable size must be a power of two");
+
+public:
+    static const uint32_t MAX_LOAD = N / 2;
+
+    NodeTable() { clear(); }
+
+    void clear() {
+        memset(slots, 0, sizeof(slots));
+        count = 0;
+        evictions = 0;
+        rejected = 0;
+        maxProbe = 0;
+    }
+
+    // Account one frame of `id`. Returns what it was; `reading` and the
+    // link values are applied only for the newest frame. reportedMs is the
+    // node's own interval (0 if it does not send one).
+    NodeUpdate update(uint16_t id, uint32_t seq, const NodeReading& reading,
+                      float rssi, float snr, uint32_t reportedMs, uint32_t nowMs) {
+        NodeState* e = find(id);
+        NodeUpdate result;
+
+        if (!e) {
+            e = insert(id, nowMs);
+            if (!e) {
+                rejected++;
+                return NODE_REJECTED;
+            }
+            e->lastSeq = seq;
+            e->seqMask = 1;
+            e->rssiAvg = rssi;
+            e->snrAvg = snr;
+            e->rssiMin = rssi;
+            e->intervalMs = NODE_INTERVAL_DEFAULT_MS;
+            result = NODE_NEW;
+        } else {
+            result = advance(*e, seq, nowMs);
+            if (result == NODE_DUPLICATE) {
+                e->duplicates++;
+                return result;
+            }
+        }
+
+        e->received++;
+        e->online = true;
+        if (result == NODE_LATE) return result;
+
+        e->rssi = rssi;
+        e->snr = snr;
+        if (result != NODE_NEW) {
+            e->rssiAvg += (rssi - e->rssiAvg) / 8;
+            e->snrAvg += (snr - e->snrAvg) / 8;
+            if (rssi < e->rssiMin) e->rssiMin = rssi;
+        }
+        if (reportedMs > 0) {
+            e->intervalMs = reportedMs;
+            e->intervalReported = true;
+        }
+        e->reading = reading;
+        e->lastMs = nowMs;
+        return result;
+    }
+
+    // Mark nodes silent for NODE_OFFLINE_MISSES intervals offline. Returns
+    // how many went offline in this call.
+    uint32_t sweep(uint32_t nowMs) {
+        uint32_t changed = 0;
+        for (uint32_t i = 0; i < N; i++) {
+            NodeState& e = slots[i];
+            if (!e.used || !e.online) continue;
+            if (nowMs - e.lastMs > offlineAfterMs(e)) {
+                e.online = false;
+                changed++;
+            }
+        }
+        return changed;
+    }
+
+    const NodeState* get(uint16_t id) const {
+        uint32_t i = home(id);
+        for (uint32_t probe = 0; probe < N; probe++, i = (i + 1) & (N - 1)) {
+            if (!slots[i].used) return 0;
+            if (slots[i].id == id) return &slots[i];
+        }
+        return 0;
+    }
+
+    // Enumeration by slot (0..N-1); NULL for an empty slot
+    const NodeState* at(uint32_t slot) const {
+        return slot < N && slots[slot].used ? &slots[slot] : 0;
+    }
+
+    bool remove(uint16_t id) {
+        NodeState* e = find(id);
+        if (!e) return false;
+        erase(e - slots);
+        return true;
+    }
+
+    void getStats(NodeTableStats& out) const {
+        out.nodes = count;
+        out.online = 0;
+        for (uint32_t i = 0; i < N; i++) {
+            if (slots[i].used && slots[i].online) out.online++;
+        }
+        out.evictions = evictions;
+        out.rejected = rejected;
+        out.maxProbe = maxProbe;
+    }
+
+    uint32_t size() const { return count; }
+    uint32_t capacity() const { return N; }
+
+    static uint32_t offlineAfterMs(const NodeState& e) {
+        return e.intervalMs * NODE_OFFLINE_MISSES + NODE_OFFLINE_SLACK_MS;
+    }
+
+    // First slot probed for `id`
+    static uint32_t home(uint16_t id) {
+        // Fibonacci hashing: consecutive ids land far apart
+        return ((uint32_t)(id * 2654435769U) >> 16) & (N - 1);
+    }
+
+private:
+
+    NodeState* find(uint16_t id) {
+        uint32_t i = home(id);
+        for (uint32_t probe = 0; probe < N; probe++, i = (i + 1) & (N - 1)) {
+            if (!slots[i].used) return 0;
+            if (slots[i].id == id) {
+                if (probe > maxProbe) maxProbe = probe;
+                return &slots[i];
+            }
+        }
+        return 0;
+    }
+
+    NodeState* insert(uint16_t id, uint32_t nowMs) {
+        if (count >= MAX_LOAD && !evictStalest(nowMs)) return 0;
+
+        uint32_t i = home(id);
+        uint32_t probe = 0;
+        while (slots[i].used) {
+            i = (i + 1) & (N - 1);
+            probe++;
+        }
+        if (probe > maxProbe) maxProbe = probe;
+
+        NodeState& e = slots[i];
+        memset(&e, 0, sizeof(e));
+        e.id = id;
+        e.used = true;
+        e.firstMs = nowMs;
+        e.lastMs = nowMs;
+        count++;
+        return &e;
+    }
+
+    // Only on admission to a full table: O(N)
+    bool evictStalest(uint32_t nowMs) {
+        uint32_t victim = N;
+        uint32_t oldest = 0;
+        for (uint32_t i = 0; i < N; i++) {
+            const NodeState& e = slots[i];
+            if (!e.used || e.online) continue;
+            if (victim == N || nowMs - e.lastMs > oldest) {
+                victim = i;
+                oldest = nowMs - e.lastMs;
+            }
+        }
+        if (victim == N) return false;
+        erase(victim);
+        evictions++;
+        return true;
+    }
+
+    // Backward-shift deletion: pull later entries of the run into the hole
+    // when their home slot allows it
+    void erase(uint32_t hole) {
+        slots[hole].used = false;
+        count--;
+        uint32_t i = hole;
+        while (true) {
+            i = (i + 1) & (N - 1);
+            if (!slots[i].used) return;
+            uint32_t h = home(slots[i].id);
+            // Can move if its home is not in (hole, i] (cyclically)
+            bool stays = hole <= i ? (h > hole && h <= i) : (h > hole || h <= i);
+            if (stays) continue;
+            slots[hole] = slots[i];
+            slots[i].used = false;
+            hole = i;
+        }
+    }
+
+    NodeUpdate advance(NodeState& e, uint32_t seq, uint32_t nowMs) {
+        if (seq > e.lastSeq) {
+            uint32_t gap = seq - e.lastSeq;
+            e.lost += gap - 1;
+            e.seqMask = gap >= NODE_SEQ_WINDOW ? 1 : (e.seqMask << gap) | 1;
+            // Measured interval (EWMA 1/4) when the node does not report one
+            if (!e.intervalReported) {
+                uint32_t perFrame = (nowMs - e.lastMs) / gap;
+                e.intervalMs = e.received == 1
+                             ? perFrame : e.intervalMs - e.intervalMs / 4 + perFrame / 4;
+            }
+            e.lastSeq = seq;
+            return NODE_OK;
+        }
+
+        uint32_t behind = e.lastSeq - seq;
+        if (behind < NODE_SEQ_WINDOW && nowMs - e.lastMs < e.intervalMs / 2) {
+            uint32_t bit = 1UL << behind;
+            if (e.seqMask & bit) return NODE_DUPLICATE;
+            e.seqMask |= bit;
+            if (e.lost > 0) e.lost--;
+            return NODE_LATE;
+        }
+
+        // Counter restarted: the frames lost across the reboot are unknown
+        e.resets++;
+        e.lastSeq = seq;
+        e.seqMask = 1;
+        return NODE_RESET;
+    }
+
+    NodeState slots[N];
+    uint32_t count;
+    uint32_t evictions;
+    uint32_t rejected;
+    uint32_t maxProbe;
+};
+
+#endif
@@ -1,7 +1,7 @@
 #include "server_client.h"
 #include <Preferences.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
+#include "../shared/uplink.h"
 
 // Configuration - Default values for vivero-olivos station
 String serverUrl = "https://gipis.unp.edu.ar/weather";
@@ -11,14 +11,9 @@ bool serverEnabled = true;
 // Pending config from server
 ServerConfig serverConfig = { false, 9, 125.0, 600000 };
 
-// HTTP client with secure support
-WiFiClientSecure secureClient;
-HTTPClient http;
-
 // ============================================
-// Retry Buffer - Circular buffer for failed packets
+// Retry Buffer - Circular buffer of packets waiting for the uplink task
 // ============================================
-#define RETRY_BUFFER_SIZE 20
 
 struct BufferedPacket {
     MeteorDataPacket data;
@@ -31,9 +26,15 @@ struct BufferedPacket {
 BufferedPacket retryBuffer[RETRY_BUFFER_SIZE];
 int retryHead = 0;  // Next write position
 int retryCount = 0; // Number of items in buffer
+static uint32_t retryDropped = 0;
+
+// Receive path (loop) and uplink task both touch the buffer
+static portMUX_TYPE retryMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t uplinkTask = NULL;
 
-// Add packet to retry buffer
+// Add packet to retry buffer; the oldest is overwritten when full
 void bufferPacket(const MeteorDataPacket& data, float rssi, float snr, float freqError) {
+    portENTER_CRITICAL(&retryMux);
     retryBuffer[retryHead].data = data;
     retryBuffer[retryHead].rssi = rssi;
     retryBuffer[retryHead].snr = snr;
@@ -43,20 +44,44 @@ void bufferPacket(const MeteorDataPacket& data, float rssi, float snr, float fre
     retryHead = (retryHead + 1) % RETRY_BUFFER_SIZE;
     if (retryCount < RETRY_BUFFER_SIZE) {
         retryCount++;
+    } else {
+        retryDropped++;
     }
-    
-    Serial.printf("[Server] Buffered packet (queue: %d)\n", retryCount);
+    portEXIT_CRITICAL(&retryMux);
+}
+
+// Copy of the oldest buffered packet; false if the buffer is empty
+static bool peekOldest(BufferedPacket& out) {
+    portENTER_CRITICAL(&retryMux);
+    bool ok = retryCount > 0;
+    if (ok) out = retryBuffer[(retryHead - retryCount + RETRY_BUFFER_SIZE) % RETRY_BUFFER_SIZE];
+    portEXIT_CRITICAL(&retryMux);
+    return ok;
 }
 
-// Internal function to send a single packet
-bool sendPacketToServer(const MeteorDataPacket& data, float rssi, float snr, float freqError) {
+// Drop the oldest packet once sent, unless it was overwritten meanwhile.
+// packetIds are per node, so the node must match too.
+static void popOldest(const BufferedPacket& sent) {
+    portENTER_CRITICAL(&retryMux);
+    int idx = (retryHead - retryCount + RETRY_BUFFER_SIZE) % RETRY_BUFFER_SIZE;
+    if (retryCount > 0 && retryBuffer[idx].data.nodeId == sent.data.nodeId &&
+        retryBuffer[idx].data.packetId == sent.data.packetId) {
+        retryBuffer[idx].valid = false;
+        retryCount--;
+    }
+    portEXIT_CRITICAL(&retryMux);
+}
+
+// Internal function to send a single packet; returns the HTTP status
+int sendPacketToServer(const MeteorDataPacket& data, float rssi, float snr, float freqError) {
     if (WiFi.status() != WL_CONNECTED) {
-        return false;
+        return -1;
     }
 
     // Build JSON payload
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<1024> doc;
     doc["packetId"] = data.packetId;
+    doc["nodeId"] = data.nodeId;
     doc["tempAire"] = data.tempAire;
     doc["humAire"] = data.humAire;
     doc["tempSuelo"] = data.tempSuelo;
@@ -65,21 +90,26 @@ bool sendPacketToServer(const MeteorDataPacket& data, float rssi, float snr, flo
     doc["snr"] = snr;
     doc["freqError"] = freqError;
 
+    // Soil profile: one entry per TEROS 12 depth
+    JsonArray soil = doc.createNestedArray("soil");
+    for (uint8_t i = 0; i < data.soilCount && i < SOIL_MAX_PROBES; i++) {
+        JsonObject probe = soil.createNestedObject();
+        probe["addr"]  = String((char)data.soil[i].addr);
+        probe["depth"] = data.soil[i].depthCm;
+        probe["vwc"]   = data.soil[i].vwc;
+        probe["temp"]  = data.soil[i].temp;
+        probe["ec"]    = data.soil[i].ec;
+    }
+
     String jsonPayload;
     serializeJson(doc, jsonPayload);
 
-    // Send HTTP POST
-    String endpoint = serverUrl + "/api/data/ingest";
-
-    http.begin(secureClient, endpoint);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-Key", apiKey);
-    http.setTimeout(10000);
-
-    int httpCode = http.POST(jsonPayload);
+    // Send HTTP POST (kept-alive connection, shared/uplink.h)
+    String response;
+    int httpCode = uplinkPost("/api/data/ingest", (const uint8_t*)jsonPayload.c_str(),
+                              jsonPayload.length(), &response);
 
     if (httpCode == 200) {
-        String response = http.getString();
         StaticJsonDocument<256> respDoc;
         DeserializationError err = deserializeJson(respDoc, response);
 
@@ -90,44 +120,52 @@ bool sendPacketToServer(const MeteorDataPacket& data, float rssi, float snr, flo
             serverConfig.interval = cfg["interval"] | 600000;
             serverConfig.hasPending = true;
         }
-
-        http.end();
-        return true;
-    } else {
-        http.end();
-        return false;
     }
+    return httpCode;
 }
 
-// Try to send buffered packets
+// Send buffered packets, oldest first, until the buffer is empty, a send
+// fails or the cycle budget is spent
 void flushRetryBuffer() {
-    if (retryCount == 0) return;
-    
-    Serial.printf("[Server] Flushing buffer (%d packets)...\n", retryCount);
-    
+    unsigned long start = millis();
     int sent = 0;
-    int startIdx = (retryHead - retryCount + RETRY_BUFFER_SIZE) % RETRY_BUFFER_SIZE;
-    
-    for (int i = 0; i < retryCount; i++) {
-        int idx = (startIdx + i) % RETRY_BUFFER_SIZE;
-        if (retryBuffer[idx].valid) {
-            if (sendPacketToServer(retryBuffer[idx].data, retryBuffer[idx].rssi, 
-                                   retryBuffer[idx].snr, retryBuffer[idx].freqError)) {
-                retryBuffer[idx].valid = false;
-                sent++;
-            } else {
-                // Stop trying if we hit a failure
-                break;
-            }
+    BufferedPacket p;
+
+    while (millis() - start < UPLINK_CYCLE_BUDGET_MS && peekOldest(p)) {
+        int code = sendPacketToServer(p.data, p.rssi, p.snr, p.freqError);
+        if (code == 400 || code == 413) {
+            // Rejected for its content: retrying would block the buffer
+            Serial.printf("[Server] Packet %lu rejected (%d), dropped\n",
+                          (unsigned long)p.data.packetId, code);
+            popOldest(p);
+            continue;
+        }
+        if (code != 200) {
+            Serial.printf("[Server] HTTP Error: %d, %d buffered\n", code, getPendingCount());
+            break;
         }
+        popOldest(p);
+        sent++;
     }
-    
-    // Recalculate count (remove sent packets)
-    retryCount -= sent;
-    if (retryCount < 0) retryCount = 0;
-    
+
     if (sent > 0) {
-        Serial.printf("[Server] Flushed %d buffered packets\n", sent);
+        Serial.printf("[Server] Sent %d packets (%d buffered)\n", sent, getPendingCount());
+    }
+}
+
+// ============================================
+// Uplink task
+// ============================================
+
+// Uploads run here so a slow or dead server never keeps the receive path
+// waiting: sendToServer() only buffers the packet and wakes the task.
+// Requests have deadlines and failures back off (shared/uplink.h).
+static void serverTask(void* arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERVER_TASK_POLL_MS));
+        uplinkLoop();
+        if (!serverEnabled || WiFi.status() != WL_CONNECTED || !uplinkReady()) continue;
+        flushRetryBuffer();
     }
 }
 
@@ -136,15 +174,16 @@ void flushRetryBuffer() {
 // ============================================
 
 void serverClientInit() {
-    // Allow insecure connection (skip certificate validation)
-    secureClient.setInsecure();
-    
     // Initialize retry buffer
     for (int i = 0; i < RETRY_BUFFER_SIZE; i++) {
         retryBuffer[i].valid = false;
     }
     
     loadServerSettings();
+    if (!uplinkTask) {
+        xTaskCreatePinnedToCore(serverTask, "uplink", SERVER_TASK_STACK, NULL,
+                                SERVER_TASK_PRIORITY, &uplinkTask, SERVER_TASK_CORE);
+    }
     Serial.println("[Server] Client initialized");
     if (serverEnabled) {
         Serial.print("[Server] URL: ");
@@ -168,6 +207,7 @@ void loadServerSettings() {
     }
 
     prefs.end();
+    uplinkSetServer(serverUrl, apiKey);
 }
 
 void saveServerSettings(const String& url, const String& key, bool enabled) {
@@ -183,6 +223,7 @@ void saveServerSettings(const String& url, const String& key, bool enabled) {
     serverUrl = url;
     apiKey = key;
     serverEnabled = enabled;
+    uplinkSetServer(serverUrl, apiKey);
 
     Serial.println("[Server] Settings saved");
 }
@@ -192,27 +233,9 @@ bool sendToServer(const MeteorDataPacket& data, float rssi, float snr, float fre
         return false;
     }
 
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("[Server] WiFi not connected, buffering");
-        bufferPacket(data, rssi, snr, freqError);
-        return false;
-    }
-
-    // Try to send current packet
-    if (sendPacketToServer(data, rssi, snr, freqError)) {
-        Serial.println("[Server] Data sent OK");
-        
-        // Success! Try to flush any buffered packets
-        if (retryCount > 0) {
-            flushRetryBuffer();
-        }
-        return true;
-    } else {
-        // Failed, buffer it for retry
-        Serial.println("[Server] Send failed, buffering");
-        bufferPacket(data, rssi, snr, freqError);
-        return false;
-    }
+    bufferPacket(data, rssi, snr, freqError);
+    if (uplinkTask) xTaskNotifyGive(uplinkTask);
+    return true;
 }
 
 bool checkServerConfig() {
@@ -224,5 +247,12 @@ bool checkServerConfig() {
 }
 
 int getPendingCount() {
-    return retryCount;
+    portENTER_CRITICAL(&retryMux);
+    int n = retryCount;
+    portEXIT_CRITICAL(&retryMux);
+    return n;
+}
+
+uint32_t getDroppedCount() {
+    return retryDropped;
 }
@@ -5,6 +5,22 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "../shared/config.h"
+#include "../shared/uplink.h"
+#include "node_table.h"
+
+// Packets waiting for upload. Sized to ride out an open breaker: every
+// station a full node table holds, at the default interval, for the open
+// period plus the minute of failures that opens it (384 x 128 B = 48 KB).
+// Past that the oldest packet is overwritten and counted.
+#define RETRY_BUFFER_STATIONS   (NODE_TABLE_CAPACITY / 2)
+#define RETRY_BUFFER_INTERVALS  ((UPLINK_BREAKER_OPEN_MS + 60000) / NODE_INTERVAL_DEFAULT_MS)
+#define RETRY_BUFFER_SIZE       (RETRY_BUFFER_STATIONS * RETRY_BUFFER_INTERVALS)
+
+// Uplink task: every upload runs there, never in the receive path
+#define SERVER_TASK_STACK       8192    // TLS handshake
+#define SERVER_TASK_PRIORITY    1
+#define SERVER_TASK_CORE        0       // with the WiFi stack, off the loop() core
+#define SERVER_TASK_POLL_MS     5000    // retry check without new packets
 
 // Server configuration
 extern String serverUrl;
@@ -23,17 +39,17 @@ extern ServerConfig serverConfig;
 
 /**
  * Initialize server client
- * Loads configuration from NVS
+ * Loads configuration from NVS and starts the uplink task
  */
 void serverClientInit();
 
 /**
- * Send data to server
+ * Queue data for the uplink task; returns at once
  * @param data Sensor data packet
  * @param rssi Signal strength
  * @param snr Signal to noise ratio
  * @param freqError Frequency error
- * @return true if successful
+ * @return true if queued (false when the server is not configured)
  */
 bool sendToServer(const MeteorDataPacket& data, float rssi, float snr, float freqError);
 
@@ -59,4 +75,9 @@ void loadServerSettings();
  */
 int getPendingCount();
 
+/**
+ * Packets overwritten in the full retry buffer before they could be sent
+ */
+uint32_t getDroppedCount();
+
 #endif
@@ -171,6 +171,19 @@ const char index_html[] PROGMEM = R"rawliteral(
                 </div>
             </div>
 
+            <!-- Nodes -->
+            <div class="bg-white p-6 rounded-xl shadow-md mb-8">
+                <h3 class="text-lg font-bold text-slate-700 mb-4 flex items-center gap-2"><i class="fas fa-network-wired text-emerald-500"></i> Nodos (<span id="nodeCount">0</span>, <span id="nodesOnline">0</span> en línea)</h3>
+                <div class="overflow-x-auto">
+                    <table class="w-full text-sm font-mono text-slate-700">
+                        <thead class="text-xs text-slate-500 uppercase text-left">
+                            <tr><th>Nodo</th><th>Estado</th><th>Paquete</th><th>Estab.</th><th>RSSI</th><th>SNR</th><th>Hace</th><th>T.Aire</th><th>Bat</th></tr>
+                        </thead>
+                        <tbody id="nodeRows"></tbody>
+                    </table>
+                </div>
+            </div>
+
             <!-- Remote Config -->
             <div class="bg-white p-6 rounded-xl shadow-md border border-slate-200">
                 <h3 class="text-lg font-bold text-slate-700 mb-4 flex items-center gap-2"><i class="fas fa-sliders-h text-blue-500"></i> Parámetros de Transmisión (RX & TX)</h3>
@@ -351,6 +364,20 @@ const char index_html[] PROGMEM = R"rawliteral(
                     document.getElementById("freqVal").innerText = freqErr.toFixed(0) + " Hz";
                 }
                 
+                // Nodes heard by the gateway
+                if(d.nodes) {
+                    document.getElementById("nodeCount").innerText = d.nodeCount;
+                    document.getElementById("nodesOnline").innerText = d.nodesOnline;
+                    document.getElementById("nodeRows").innerHTML = d.nodes
+                        .sort((a, b) => a.id - b.id)
+                        .map(n => `<tr class="border-t border-slate-100"><td>${n.id}</td>` +
+                            `<td class="${n.online ? 'text-emerald-600' : 'text-red-500'}">${n.online ? 'en línea' : 'sin señal'}</td>` +
+                            `<td>${n.packetId}</td><td>${n.reliability.toFixed(1)} %</td>` +
+                            `<td>${n.rssi.toFixed(0)}</td><td>${n.snr.toFixed(1)}</td><td>${n.ageS} s</td>` +
+                            `<td>${n.tempAire.toFixed(1)}</td><td>${n.vBat.toFixed(2)} V</td></tr>`)
+                        .join("");
+                }
+
                 if(d.packetId > 0 && d.packetId != lastPacketId) {
                     lastPacketId = d.packetId;
                     const now = new Date();
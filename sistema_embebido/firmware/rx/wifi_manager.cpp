@@ -3,6 +3,9 @@
 #include "display.h"
 #include "web_interface.h"
 #include "server_client.h"
+#include "../shared/loop_stats.h"
+#include "../shared/uplink.h"
+#include "../shared/oled_tiles.h"
 
 // Web Server Instance
 AsyncWebServer server(80);
@@ -91,13 +94,68 @@ void webServerInit() {
             json += "\"snr\":" + String(lastSNR) + ",";
             json += "\"freqErr\":" + String(lastFreqError) + ",";
             
+            json += "\"nodeId\":" + String(lastData.nodeId) + ",";
+
+            // One entry per node in the gateway's table; reliability over all of them
+            uint32_t received = 0;
+            uint32_t lost = 0;
+            String list = "[";
+            NodeState n;
+            for (uint32_t slot = 0; slot < NODE_TABLE_CAPACITY; slot++) {
+                if (!loraNodeAt(slot, n)) continue;
+                received += n.received;
+                lost += n.lost;
+                uint32_t total = n.received + n.lost;
+                if (list.length() > 1) list += ",";
+                list += "{\"id\":" + String(n.id);
+                list += ",\"online\":" + String(n.online ? "true" : "false");
+                list += ",\"packetId\":" + String(n.lastSeq);
+                list += ",\"rx\":" + String(n.received);
+                list += ",\"lost\":" + String(n.lost);
+                list += ",\"dup\":" + String(n.duplicates);
+                list += ",\"reliability\":" + String(total ? n.received * 100.0 / total : 100.0);
+                list += ",\"rssi\":" + String(n.rssi) + ",\"rssiAvg\":" + String(n.rssiAvg);
+                list += ",\"snr\":" + String(n.snr);
+                list += ",\"ageS\":" + String((millis() - n.lastMs) / 1000);
+                list += ",\"intervalS\":" + String(n.intervalMs / 1000);
+                list += ",\"tempAire\":" + String(n.reading.tempAire);
+                list += ",\"humAire\":" + String(n.reading.humAire);
+                list += ",\"vwcSuelo\":" + String(n.reading.vwcSuelo);
+                list += ",\"vBat\":" + String(n.reading.vBat) + "}";
+            }
+            list += "]";
             float reliability = 100.0;
-            uint32_t total = packetsReceived + packetsLost;
-            if (total > 0) reliability = (float)packetsReceived * 100.0 / (float)total;
+            if (received + lost > 0) reliability = (float)received * 100.0 / (float)(received + lost);
             json += "\"reliability\":" + String(reliability) + ",";
+            NodeTableStats ns;
+            loraGetNodeStats(ns);
+            json += "\"nodeCount\":" + String(ns.nodes) + ",";
+            json += "\"nodesOnline\":" + String(ns.online) + ",";
+            json += "\"nodesRejected\":" + String(ns.rejected) + ",";
+            json += "\"nodes\":" + list + ",";
             
             json += "\"sf\":" + String(currentSF) + ",";
             json += "\"bw\":" + String(currentBW) + ",";
+            LoopStats ls;
+            OledStats os;
+            loopStatsGet(ls);
+            oledGetStats(os);
+            json += "\"loopUs\":" + String(ls.avgUs) + ",";
+            json += "\"loopMaxUs\":" + String(ls.maxUs) + ",";
+            json += "\"oledBpm\":" + String(os.bytesPerMin) + ",";
+            UplinkStats us;
+            uplinkGetStats(us);
+            json += "\"upReq\":" + String(us.requests) + ",";
+            json += "\"upHandshakes\":" + String(us.handshakes) + ",";
+            json += "\"upMs\":" + String(us.lastMs) + ",";
+            json += "\"upBreaker\":" + String(us.breaker) + ",";
+            json += "\"pending\":" + String(getPendingCount()) + ",";
+            LoraRxStats rs;
+            loraGetStats(rs);
+            json += "\"rxDrops\":" + String(rs.ringDrops) + ",";
+            json += "\"rxRearmUs\":" + String(rs.rearmMaxUs) + ",";
+            json += "\"rxWireErr\":" + String(rs.wireErrors) + ",";
+            json += "\"rxRaw\":" + String(rs.rawFrames) + ",";
             json += "\"interval\":" + String(txInterval / 60000.0);
             json += "}";
             request->send(200, "application/json", json);
@@ -109,13 +167,14 @@ void webServerInit() {
                 int sVal = request->getParam("sf")->value().toInt();
                 float bVal = request->getParam("bw")->value().toFloat();
                 
-                pendingCmd.magic = CMD_MAGIC;
-                pendingCmd.interval = (uint32_t)(iVal * 60000.0);
-                pendingCmd.sf = (uint8_t)sVal;
-                pendingCmd.bw = bVal;
+                ConfigPacket cmd;
+                cmd.magic = CMD_MAGIC;
+                cmd.interval = (uint32_t)(iVal * 60000.0);
+                cmd.sf = (uint8_t)sVal;
+                cmd.bw = bVal;
                 
-                hasPendingCmd = true;
-                txInterval = pendingCmd.interval;
+                loraQueueCommand(cmd);
+                txInterval = cmd.interval;
                 
                 request->send(200, "text/plain", "Encolado. Esperando prox dato...");
             } else {
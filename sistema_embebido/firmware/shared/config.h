@@ -30,6 +30,17 @@
 #define OLED_RST 21
 #define VEXT_CTRL 36 // Control de energía VExt (OLED + Sensores)
 
+// --- Perfil de suelo: varias sondas TEROS 12 en un mismo bus SDI-12 ---
+#define SOIL_MAX_PROBES 4
+
+struct SoilProbeReading {
+    uint8_t addr;      // SDI-12 address ('0'..'9')
+    uint8_t depthCm;   // installation depth (cm)
+    float vwc;         // volumetric water content (%)
+    float temp;        // soil temperature (°C)
+    float ec;          // electrical conductivity (µS/cm)
+};
+
 // --- Estructura de Datos (Protocolo) ---
 // Esta estructura DEBE ser idéntica en TX y RX
 struct MeteorDataPacket {
@@ -43,6 +54,9 @@ struct MeteorDataPacket {
     uint32_t interval; // Sync TX interval state
     float vBat;        // Battery voltage (V)
     uint8_t batPercent; // Battery percentage (0-100)
+    uint8_t soilCount;  // Valid entries in soil[] (tempSuelo/vwcSuelo/ecSuelo mirror soil[0])
+    uint16_t nodeId;    // TX node (0 = unassigned); fills the padding before soil[]
+    SoilProbeReading soil[SOIL_MAX_PROBES];
 };
 
 // --- Estructura del Paquete de Control Unificado (RX -> TX) ---
@@ -0,0 +1,38 @@
+/**
+ * Loop Timing Statistics Implementation
+ */
+
+#include "loop_stats.h"
+
+static unsigned long lastTickUs = 0;
+static unsigned long windowStart = 0;
+static uint64_t winSumUs = 0;
+static uint32_t winMaxUs = 0;
+static uint32_t winLoops = 0;
+static LoopStats lastStats = { 0, 0, 0 };
+
+void loopStatsTick() {
+    unsigned long nowUs = micros();
+    if (lastTickUs != 0) {
+        uint32_t dt = nowUs - lastTickUs;
+        winSumUs += dt;
+        if (dt > winMaxUs) winMaxUs = dt;
+        winLoops++;
+    }
+    lastTickUs = nowUs;
+
+    unsigned long elapsed = millis() - windowStart;
+    if (elapsed >= 60000 && winLoops > 0) {
+        lastStats.avgUs = winSumUs / winLoops;
+        lastStats.maxUs = winMaxUs;
+        lastStats.loopsPerMin = (uint64_t)winLoops * 60000 / elapsed;
+        windowStart = millis();
+        winSumUs = 0;
+        winMaxUs = 0;
+        winLoops = 0;
+    }
+}
+
+void loopStatsGet(LoopStats& out) {
+    out = lastStats;
+}
@@ -0,0 +1,23 @@
+/**
+ * Loop Timing Statistics (shared by TX and RX)
+ *
+ * Call loopStatsTick() once at the top of loop(); the time between calls is
+ * one loop iteration. Values cover the last window of >= 1 minute.
+ */
+
+#ifndef SHARED_LOOP_STATS_H
+#define SHARED_LOOP_STATS_H
+
+#include <Arduino.h>
+
+struct LoopStats {
+    uint32_t avgUs;
+    uint32_t maxUs;
+    uint32_t loopsPerMin;
+};
+
+void loopStatsTick();
+
+void loopStatsGet(LoopStats& out);
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * OLED Tile Flush Implementation
+ */
+
+#include "oled_tiles.h"
+
+// Estimated wire cost of one updateDisplayArea() tile row (address, page
+// and column commands) and of each 32-byte I2C data chunk (address +
+// control byte)
+#define OLED_AREA_OVERHEAD  8
+#define OLED_CHUNK_BYTES    32
+#define OLED_CHUNK_OVERHEAD 2
+
+static uint8_t shadow[OLED_BUFFER_MAX];
+static bool shadowValid = false;
+
+// Counters of the current window
+static unsigned long windowStart = 0;
+static uint32_t winFrames = 0;
+static uint32_t winTiles = 0;
+static uint32_t winBytes = 0;
+static uint32_t winFullBytes = 0;
+static OledStats lastStats = { 0, 0, 0, 0 };
+
+static uint32_t wireBytes(uint32_t tiles) {
+    uint32_t data = tiles * 8;
+    return data + OLED_AREA_OVERHEAD +
+           (data + OLED_CHUNK_BYTES - 1) / OLED_CHUNK_BYTES * OLED_CHUNK_OVERHEAD;
+}
+
+static void rollWindow() {
+    unsigned long elapsed = millis() - windowStart;
+    if (elapsed < 60000) return;
+
+    lastStats.framesPerMin    = (uint64_t)winFrames * 60000 / elapsed;
+    lastStats.tilesPerMin     = (uint64_t)winTiles * 60000 / elapsed;
+    lastStats.bytesPerMin     = (uint64_t)winBytes * 60000 / elapsed;
+    lastStats.fullBytesPerMin = (uint64_t)winFullBytes * 60000 / elapsed;
+
+    windowStart = millis();
+    winFrames = winTiles = winBytes = winFullBytes = 0;
+}
+
+void oledInvalidate() {
+    shadowValid = false;
+}
+
+uint32_t oledFlush(U8G2& d) {
+    rollWindow();
+
+    uint8_t* buf = d.getBufferPtr();
+    uint8_t tw = d.getBufferTileWidth();
+    uint8_t th = d.getBufferTileHeight();
+    size_t rowBytes = (size_t)tw * 8;
+    size_t size = rowBytes * th;
+    uint32_t fullCost = 0;
+    for (uint8_t ty = 0; ty < th; ty++) fullCost += wireBytes(tw);
+
+    winFrames++;
+    winFullBytes += fullCost;
+
+    if (!shadowValid || size > sizeof(shadow)) {
+        d.sendBuffer();
+        if (size <= sizeof(shadow)) {
+            memcpy(shadow, buf, size);
+            shadowValid = true;
+        }
+        winTiles += (uint32_t)tw * th;
+        winBytes += fullCost;
+        return (uint32_t)tw * th;
+    }
+
+    uint32_t sent = 0;
+    for (uint8_t ty = 0; ty < th; ty++) {
+        const uint8_t* row = buf + ty * rowBytes;
+        uint8_t* shadowRow = shadow + ty * rowBytes;
+        int runStart = -1;
+        int lastDirty = -1;
+
+        // tx == tw closes the last run
+        for (int tx = 0; tx <= tw; tx++) {
+            bool dirty = tx < tw && memcmp(row + tx * 8, shadowRow + tx * 8, 8) != 0;
+            if (dirty) {
+                if (runStart < 0) runStart = tx;
+                lastDirty = tx;
+                continue;
+            }
+            if (runStart < 0) continue;
+            if (tx < tw && tx - lastDirty <= OLED_TILE_MERGE_GAP) continue;
+
+            uint8_t w = lastDirty - runStart + 1;
+            d.updateDisplayArea(runStart, ty, w, 1);
+            memcpy(shadowRow + runStart * 8, row + runStart * 8, w * 8);
+            sent += w;
+            winBytes += wireBytes(w);
+            runStart = -1;
+        }
+    }
+
+    winTiles += sent;
+    return sent;
+}
+
+void oledGetStats(OledStats& out) {
+    rollWindow();
+    out = lastStats;
+}
@@ -0,0 +1,51 @@
+/**
+ * OLED Tile Flush (shared by TX and RX)
+ *
+ * Sends only the 8x8 tiles of the U8g2 full-frame buffer that changed since
+ * the last flush. A shadow copy of the panel contents is diffed tile by tile
+ * and every dirty run of a tile row goes out with updateDisplayArea().
+ *
+ * Draw code stays the same (clearBuffer + draw* into RAM); call
+ * oledFlush() instead of sendBuffer(). Anything that calls sendBuffer()
+ * directly afterwards must call oledInvalidate().
+ */
+
+#ifndef SHARED_OLED_TILES_H
+#define SHARED_OLED_TILES_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+#define OLED_MIN_FRAME_MS   100   // frame rate cap (10 fps)
+#define OLED_TILE_MERGE_GAP 2     // clean tiles bridged to save a transfer
+#define OLED_BUFFER_MAX     1024  // 128x64 / 8
+
+// Traffic over the last window (>= 1 min), normalized per minute.
+// I2C bytes are estimated: payload plus command/framing overhead.
+struct OledStats {
+    uint32_t framesPerMin;
+    uint32_t tilesPerMin;
+    uint32_t bytesPerMin;
+    uint32_t fullBytesPerMin;   // same frames sent with sendBuffer()
+};
+
+// Send the dirty tiles; returns the number of tiles sent
+uint32_t oledFlush(U8G2& d);
+
+// Forget the shadow: the next flush sends the whole frame
+void oledInvalidate();
+
+void oledGetStats(OledStats& out);
+
+// FNV-1a accumulator for the renderers' input keys
+static inline void oledKeyMix(uint32_t& h, const void* p, size_t n) {
+    const uint8_t* b = (const uint8_t*)p;
+    for (size_t i = 0; i < n; i++) {
+        h ^= b[i];
+        h *= 16777619UL;
+    }
+}
+
+#define OLED_KEY_INIT 2166136261UL
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * Single-Producer / Single-Consumer Ring (shared by TX and RX)
+ *
+ * Fixed-capacity lock-free queue between exactly two tasks: one calls
+ * push(), the other pop(). Each index is written by one side only and
+ * published with release/acquire ordering, so neither side ever takes a
+ * lock or disables interrupts. T must be a POD (it is copied by value).
+ *
+ * A full ring rejects the new item and counts it; the producer never waits.
+ */
+
+#ifndef SHARED_SPSC_RING_H
+#define SHARED_SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0), overflows(0), highWater(0) {}
+
+    // Producer side
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= N) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buf[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        if (h + 1 - t > highWater.load(std::memory_order_relaxed)) {
+            highWater.store(h + 1 - t, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (t == h) return false;
+        out = buf[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side (a snapshot)
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    uint32_t capacity() const { return N; }
+    uint32_t overflowCount() const { return overflows.load(std::memory_order_relaxed); }
+    uint32_t highWaterMark() const { return highWater.load(std::memory_order_relaxed); }
+
+private:
+    T buf[N];
+    std::atomic<uint32_t> head;       // next slot to write (producer)
+    std::atomic<uint32_t> tail;       // next slot to read (consumer)
+    std::atomic<uint32_t> overflows;  // producer only
+    std::atomic<uint32_t> highWater;  // producer only
+};
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * Uplink Connection Implementation
+ */
+
+#include "uplink.h"
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+static WiFiClientSecure secureClient;
+static WiFiClient plainClient;
+static HTTPClient http;
+
+// Connection state (holders of connLock)
+static SemaphoreHandle_t connLock = NULL;
+static String base;
+static String key;
+static bool secure = true;
+static unsigned long lastUseMs = 0;
+
+// Settings from uplinkSetServer(), applied by the next request (cfgLock)
+static SemaphoreHandle_t cfgLock = NULL;
+static String newBase;
+static String newKey;
+static bool cfgChanged = false;
+
+// Failure handling
+static volatile uint8_t breaker = UPLINK_CLOSED;
+static volatile uint8_t failStreak = 0;
+static volatile bool holding = false;       // requests wait for retryAtMs
+static volatile unsigned long retryAtMs = 0;
+
+static UplinkStats stats;
+static uint64_t newSumMs = 0;
+static uint64_t reusedSumMs = 0;
+static uint32_t newCount = 0;
+static uint32_t reusedCount = 0;
+
+static WiFiClient& client() {
+    return secure ? (WiFiClient&)secureClient : plainClient;
+}
+
+static void takeConn() {
+    if (connLock) xSemaphoreTake(connLock, portMAX_DELAY);
+}
+
+static void giveConn() {
+    if (connLock) xSemaphoreGive(connLock);
+}
+
+static void applySettings() {
+    xSemaphoreTake(cfgLock, portMAX_DELAY);
+    if (cfgChanged) {
+        if (newBase != base) {
+            secureClient.stop();
+            plainClient.stop();
+        }
+        base = newBase;
+        key = newKey;
+        secure = !base.startsWith("http://");
+        cfgChanged = false;
+    }
+    xSemaphoreGive(cfgLock);
+}
+
+void uplinkSetServer(const String& baseUrl, const String& apiKey) {
+    if (!connLock) {
+        connLock = xSemaphoreCreateMutex();
+        cfgLock = xSemaphoreCreateMutex();
+        // Allow insecure connection (skip certificate validation)
+        secureClient.setInsecure();
+        secureClient.setHandshakeTimeout(UPLINK_HANDSHAKE_S);
+    }
+    xSemaphoreTake(cfgLock, portMAX_DELAY);
+    newBase = baseUrl;
+    newKey = apiKey;
+    cfgChanged = true;
+    xSemaphoreGive(cfgLock);
+}
+
+// ============================================
+// Backoff and circuit breaker
+// ============================================
+
+static void hold(uint32_t waitMs) {
+    retryAtMs = millis() + waitMs;
+    holding = true;
+}
+
+static void onFailure() {
+    if (failStreak < 255) failStreak++;
+
+    if (breaker == UPLINK_HALF_OPEN || failStreak >= UPLINK_BREAKER_FAILS) {
+        if (breaker != UPLINK_OPEN && breaker != UPLINK_HALF_OPEN) stats.trips++;
+        breaker = UPLINK_OPEN;
+        hold(UPLINK_BREAKER_OPEN_MS);
+        Serial.printf("[Uplink] Breaker open, next probe in %lu s\n",
+                      (unsigned long)(UPLINK_BREAKER_OPEN_MS / 1000));
+        return;
+    }
+
+    // Exponential, with the second half jittered so stations that failed
+    // together do not retry together
+    uint32_t waitMs = UPLINK_BACKOFF_MIN_MS;
+    for (uint8_t i = 1; i < failStreak && waitMs < UPLINK_BACKOFF_MAX_MS / 2; i++) waitMs *= 2;
+    if (waitMs > UPLINK_BACKOFF_MAX_MS) waitMs = UPLINK_BACKOFF_MAX_MS;
+    waitMs = waitMs / 2 + esp_random() % (waitMs / 2 + 1);
+    hold(waitMs);
+}
+
+static void onSuccess() {
+    if (breaker != UPLINK_CLOSED) Serial.println("[Uplink] Server back, breaker closed");
+    breaker = UPLINK_CLOSED;
+    failStreak = 0;
+    holding = false;
+}
+
+bool uplinkReady() {
+    if (!holding) return true;
+    if ((long)(millis() - retryAtMs) < 0) return false;
+    if (breaker == UPLINK_OPEN) breaker = UPLINK_HALF_OPEN;
+    return true;
+}
+
+// ============================================
+// Requests
+// ============================================
+
+int uplinkPost(const char* path, const uint8_t* body, size_t len, String* response) {
+    if (!uplinkReady()) {
+        stats.rejected++;
+        return UPLINK_ERROR_BACKOFF;
+    }
+
+    takeConn();
+    if (cfgLock) applySettings();
+
+    int code = 0;
+    for (int attempt = 0; ; attempt++) {
+        bool reused = client().connected();
+        unsigned long t0 = millis();
+
+        http.begin(client(), base + path);
+        http.setReuse(true);
+        http.setConnectTimeout(UPLINK_CONNECT_MS);
+        http.setTimeout(UPLINK_TIMEOUT_MS);
+        http.addHeader("Content-Type", "application/json");
+        http.addHeader("X-API-Key", key);
+        code = http.POST((uint8_t*)body, len);
+        if (code > 0 && response) *response = http.getString();
+        http.end();  // keeps the socket open when the server allows it
+
+        uint32_t ms = millis() - t0;
+        lastUseMs = millis();
+        stats.requests++;
+        if (!reused) stats.handshakes++;
+
+        if (code < 0) {
+            client().stop();
+            // The server closed an idle connection: once more on a new one
+            if (reused && attempt == 0) {
+                stats.retries++;
+                continue;
+            }
+            break;
+        }
+
+        if (reused) {
+            reusedSumMs += ms;
+            reusedCount++;
+        } else {
+            newSumMs += ms;
+            newCount++;
+        }
+        stats.lastMs = ms;
+        if (ms > stats.maxMs) stats.maxMs = ms;
+        break;
+    }
+    giveConn();
+
+    // 4xx is the server refusing this request, not an unreachable server
+    if (code < 0 || code >= 500) {
+        stats.failures++;
+        onFailure();
+    } else {
+        onSuccess();
+    }
+    return code;
+}
+
+void uplinkLoop() {
+    if (millis() - lastUseMs < UPLINK_IDLE_MS) return;
+    if (connLock && xSemaphoreTake(connLock, 0) != pdTRUE) return;  // request running
+    if (client().connected()) {
+        Serial.println("[Uplink] Idle, closing connection");
+        secureClient.stop();
+        plainClient.stop();
+    }
+    giveConn();
+}
+
+void uplinkClose() {
+    takeConn();
+    secureClient.stop();
+    plainClient.stop();
+    giveConn();
+}
+
+void uplinkGetStats(UplinkStats& out) {
+    out = stats;
+    out.avgNewMs = newCount ? newSumMs / newCount : 0;
+    out.avgReusedMs = reusedCount ? reusedSumMs / reusedCount : 0;
+    out.breaker = breaker;
+    out.failStreak = failStreak;
+    long left = (long)(retryAtMs - millis());
+    out.retryInMs = holding && left > 0 ? left : 0;
+}
+
+void uplinkPrintStatus() {
+    static const char* const breakerName[] = { "closed", "open", "half-open" };
+    UplinkStats s;
+    uplinkGetStats(s);
+    Serial.printf("Uplink: %lu requests, %lu handshakes, %lu retries, %lu failures, "
+                  "new %lu ms / reused %lu ms avg, max %lu ms, %s\n",
+                  (unsigned long)s.requests, (unsigned long)s.handshakes,
+                  (unsigned long)s.retries, (unsigned long)s.failures,
+                  (unsigned long)s.avgNewMs, (unsigned long)s.avgReusedMs,
+                  (unsigned long)s.maxMs, client().connected() ? "open" : "closed");
+    Serial.printf("Uplink: breaker %s, %u failures in a row, next request in %lu ms, "
+                  "%lu rejected, %lu trips\n",
+                  breakerName[s.breaker], s.failStreak, (unsigned long)s.retryInMs,
+                  (unsigned long)s.rejected, (unsigned long)s.trips);
+}
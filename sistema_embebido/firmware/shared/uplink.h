@@ -0,0 +1,94 @@
+/**
+ * Uplink Connection - one kept-alive HTTP(S) connection to the server
+ * (shared by TX and RX)
+ *
+ * Requests reuse the open connection (HTTP/1.1 keep-alive) while the server
+ * holds it, so only the first one after a pause pays for the TCP connect
+ * and the TLS handshake: several hundred ms with the radio on and a ~40 KB
+ * heap peak on the ESP32-S3. A request that fails on a reused connection
+ * (closed by the server while idle) is retried once on a new one.
+ *
+ * The connection is closed after UPLINK_IDLE_MS without use (uplinkLoop()),
+ * when the server URL changes and with uplinkClose() (before deep sleep).
+ * Host names are resolved by lwIP, whose DNS table keeps each answer for
+ * its TTL, so reconnects do not repeat the lookup either.
+ *
+ * TLS session resumption is not used: WiFiClientSecure (Arduino-ESP32
+ * 2.0.x) runs the whole handshake inside connect() and does not expose the
+ * mbedTLS session, so there is no ticket to keep in RTC memory or NVS. A
+ * wake from deep sleep pays one full handshake and reuses it for the rest
+ * of the cycle.
+ *
+ * Failures (no response or 5xx) are spaced out: each one waits an
+ * exponential backoff with jitter before the next request is let through,
+ * and UPLINK_BREAKER_FAILS in a row open a circuit breaker that allows one
+ * probe request per UPLINK_BREAKER_OPEN_MS until the server answers again.
+ * Meanwhile uplinkPost() returns UPLINK_ERROR_BACKOFF without touching the
+ * network. Every request has connect, handshake and read deadlines; callers
+ * bound a whole upload cycle with UPLINK_CYCLE_BUDGET_MS.
+ *
+ * Callable from any task (one request at a time). http:// URLs use a plain
+ * connection (local stand-in server).
+ */
+
+#ifndef SHARED_UPLINK_H
+#define SHARED_UPLINK_H
+
+#include <Arduino.h>
+
+#define UPLINK_CONNECT_MS       5000    // TCP connect deadline
+#define UPLINK_HANDSHAKE_S      5       // TLS handshake deadline
+#define UPLINK_TIMEOUT_MS       5000    // response deadline (per read)
+#define UPLINK_CYCLE_BUDGET_MS  20000   // all requests of one upload cycle
+#define UPLINK_IDLE_MS          70000   // below the server's keep-alive timeout (75 s)
+
+#define UPLINK_BACKOFF_MIN_MS   2000
+#define UPLINK_BACKOFF_MAX_MS   120000
+#define UPLINK_BREAKER_FAILS    5       // consecutive failures that open the breaker
+#define UPLINK_BREAKER_OPEN_MS  300000  // then one probe request per period
+
+#define UPLINK_ERROR_BACKOFF    (-100)  // uplinkPost(): not sent, waiting out a failure
+
+enum UplinkBreaker {
+    UPLINK_CLOSED,              // requests go through
+    UPLINK_OPEN,                // rejected until the period ends
+    UPLINK_HALF_OPEN            // one probe request
+};
+
+struct UplinkStats {
+    uint32_t requests;
+    uint32_t handshakes;        // requests that opened a new connection
+    uint32_t retries;           // reused connection found closed
+    uint32_t failures;          // no response or 5xx
+    uint32_t rejected;          // not sent during a backoff / open breaker
+    uint32_t trips;             // breaker openings
+    uint32_t avgNewMs;          // request latency on a new connection
+    uint32_t avgReusedMs;       // ... on a reused one
+    uint32_t maxMs;
+    uint32_t lastMs;
+    uint8_t breaker;            // UplinkBreaker
+    uint8_t failStreak;
+    uint32_t retryInMs;         // until the next request is let through
+};
+
+// Base URL (scheme, host, optional path prefix) and API key for every
+// request. A different server closes the current connection.
+void uplinkSetServer(const String& baseUrl, const String& apiKey);
+
+// POST a JSON body to baseUrl + path. Returns the HTTP status, a negative
+// HTTPClient error when there was no response, or UPLINK_ERROR_BACKOFF.
+// `response` gets the body of any response (may be NULL).
+int uplinkPost(const char* path, const uint8_t* body, size_t len, String* response);
+
+// False while a failure backoff or the open breaker holds requests back
+bool uplinkReady();
+
+// Close the connection once it has been idle for UPLINK_IDLE_MS
+void uplinkLoop();
+
+void uplinkClose();
+
+void uplinkGetStats(UplinkStats& out);
+void uplinkPrintStatus();
+
+#endif
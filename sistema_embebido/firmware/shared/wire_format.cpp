@@ -0,0 +1,282 @@
+/**
+ * LoRa Wire Format Implementation
+ */
+
+#include "wire_format.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================
+// Little-endian integers, one width per specialization
+// ============================================
+
+template <int Bytes> struct WireInt;
+
+template <> struct WireInt<1> {
+    static void put(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; }
+    static uint32_t get(const uint8_t* p) { return p[0]; }
+};
+
+template <> struct WireInt<2> {
+    static void put(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+    static uint32_t get(const uint8_t* p) { return p[0] | (uint32_t)p[1] << 8; }
+};
+
+template <> struct WireInt<3> {
+    static void put(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+    }
+    static uint32_t get(const uint8_t* p) {
+        return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+    }
+};
+
+// ============================================
+// Quantized fields
+// ============================================
+
+// A fixed-point value of `Bytes` bytes, `Scale` steps per unit. The top
+// code (all ones, or the most negative value when signed) is reserved for
+// "missing"; valid values are clamped below it.
+template <int Bytes, bool Signed, int32_t Scale>
+struct WireQ {
+    static const int32_t MISSING = Signed ? -(1L << (Bytes * 8 - 1)) : (1L << (Bytes * 8)) - 1;
+    static const int32_t MIN = Signed ? MISSING + 1 : 0;
+    static const int32_t MAX = Signed ? (1L << (Bytes * 8 - 1)) - 1 : MISSING - 1;
+
+    static int32_t quantize(float v) {
+        if (isnan(v)) return MISSING;
+        float q = roundf(v * Scale);
+        if (q < MIN) return MIN;
+        if (q > MAX) return MAX;
+        return (int32_t)q;
+    }
+
+    static float value(int32_t q) {
+        return q == MISSING ? NAN : (float)q / Scale;
+    }
+
+    static uint8_t* put(uint8_t* p, float v) {
+        WireInt<Bytes>::put(p, (uint32_t)quantize(v));
+        return p + Bytes;
+    }
+
+    static const uint8_t* get(const uint8_t* p, float& v) {
+        uint32_t raw = WireInt<Bytes>::get(p);
+        // Sign-extend
+        int32_t q = Signed && (raw >> (Bytes * 8 - 1)) ? (int32_t)(raw | ~0UL << (Bytes * 8)) : (int32_t)raw;
+        v = value(q);
+        return p + Bytes;
+    }
+};
+
+// A top-level field: present only when its value is, under bit `Bit`
+template <uint16_t Bit, int Bytes, bool Signed, int32_t Scale>
+struct WireField {
+    typedef WireQ<Bytes, Signed, Scale> Q;
+
+    static uint8_t* put(uint8_t* p, float v, uint16_t& present) {
+        if (isnan(v)) return p;
+        present |= Bit;
+        return Q::put(p, v);
+    }
+
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, float& v, uint16_t present) {
+        v = NAN;
+        if (!p || !(present & Bit)) return p;
+        if (end - p < Bytes) return 0;
+        return Q::get(p, v);
+    }
+
+    static size_t size(float v) { return isnan(v) ? 0 : Bytes; }
+};
+
+typedef WireField<WIRE_F_TEMP_AIRE,  2, true,  100>  FieldTempAire;
+typedef WireField<WIRE_F_HUM_AIRE,   2, false, 10>   FieldHumAire;
+typedef WireField<WIRE_F_TEMP_SUELO, 2, true,  100>  FieldTempSuelo;
+typedef WireField<WIRE_F_VWC_SUELO,  2, false, 10>   FieldVwcSuelo;
+typedef WireField<WIRE_F_EC_SUELO,   2, false, 1>    FieldEcSuelo;
+typedef WireField<WIRE_F_PAR,        2, false, 10>   FieldPar;
+typedef WireField<WIRE_F_VBAT,       2, false, 1000> FieldVBat;
+
+// Soil probe values (always present inside a probe; NaN as the reserved code)
+typedef WireQ<2, false, 10>  ProbeVwc;
+typedef WireQ<2, true,  100> ProbeTemp;
+typedef WireQ<2, false, 1>   ProbeEc;
+
+// ============================================
+// CRC
+// ============================================
+
+// CRC-16/CCITT-FALSE, nibble table
+static const uint16_t crcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t wireCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// ============================================
+// Frames
+// ============================================
+
+static bool hasBat(const WireReading& in) { return in.batPercent <= 100; }
+static bool hasInterval(const WireReading& in) { return in.intervalMs >= 500; }
+
+static uint8_t soilCount(const WireReading& in) {
+    return in.soilCount < WIRE_SOIL_MAX ? in.soilCount : WIRE_SOIL_MAX;
+}
+
+size_t wireFrameSize(const WireReading& in) {
+    size_t n = WIRE_PREFIX_BYTES + WIRE_CRC_BYTES;
+    n += FieldTempAire::size(in.tempAire) + FieldHumAire::size(in.humAire);
+    n += FieldTempSuelo::size(in.tempSuelo) + FieldVwcSuelo::size(in.vwcSuelo);
+    n += FieldEcSuelo::size(in.ecSuelo) + FieldPar::size(in.par) + FieldVBat::size(in.vBat);
+    if (hasBat(in)) n += 1;
+    if (hasInterval(in)) n += 2;
+    if (soilCount(in) > 0) n += 1 + soilCount(in) * WIRE_PROBE_BYTES;
+    return n;
+}
+
+size_t wireEncode(const WireReading& in, uint8_t* out, size_t size) {
+    size_t total = wireFrameSize(in);
+    if (size < total) return 0;
+
+    uint16_t present = 0;
+    out[0] = WIRE_HEADER(WIRE_TYPE_READING);
+    WireInt<2>::put(out + 1, in.nodeId);
+    WireInt<3>::put(out + 3, in.seq & WIRE_SEQ_MASK);
+
+    uint8_t* p = out + WIRE_PREFIX_BYTES;
+    p = FieldTempAire::put(p, in.tempAire, present);
+    p = FieldHumAire::put(p, in.humAire, present);
+    p = FieldTempSuelo::put(p, in.tempSuelo, present);
+    p = FieldVwcSuelo::put(p, in.vwcSuelo, present);
+    p = FieldEcSuelo::put(p, in.ecSuelo, present);
+    p = FieldPar::put(p, in.par, present);
+    p = FieldVBat::put(p, in.vBat, present);
+    if (hasBat(in)) {
+        present |= WIRE_F_BAT_PERCENT;
+        *p++ = in.batPercent;
+    }
+    if (hasInterval(in)) {
+        uint32_t s = (in.intervalMs + 500) / 1000;
+        present |= WIRE_F_INTERVAL;
+        WireInt<2>::put(p, s < 0xFFFF ? s : 0xFFFE);
+        p += 2;
+    }
+    uint8_t count = soilCount(in);
+    if (count > 0) {
+        present |= WIRE_F_SOIL;
+        *p++ = count;
+        for (uint8_t i = 0; i < count; i++) {
+            const WireSoil& s = in.soil[i];
+            *p++ = s.addr;
+            *p++ = s.depthCm;
+            p = ProbeVwc::put(p, s.vwc);
+            p = ProbeTemp::put(p, s.temp);
+            p = ProbeEc::put(p, s.ec);
+        }
+    }
+    WireInt<2>::put(out + 6, present);
+
+    WireInt<2>::put(p, wireCrc16(out, p - out));
+    return total;
+}
+
+WireStatus wireDecode(const uint8_t* buf, size_t len, WireReading& out) {
+    if (len < WIRE_PREFIX_BYTES + WIRE_CRC_BYTES) return WIRE_ERR_SHORT;
+    size_t body = len - WIRE_CRC_BYTES;
+    if (WireInt<2>::get(buf + body) != wireCrc16(buf, body)) return WIRE_ERR_CRC;
+    if (buf[0] != WIRE_HEADER(WIRE_TYPE_READING)) return WIRE_ERR_VERSION;
+
+    uint16_t present = WireInt<2>::get(buf + 6);
+    if (present & ~WIRE_F_KNOWN) return WIRE_ERR_VERSION;
+
+    memset(&out, 0, sizeof(out));
+    out.nodeId = WireInt<2>::get(buf + 1);
+    out.seq = WireInt<3>::get(buf + 3);
+
+    const uint8_t* end = buf + body;
+    const uint8_t* p = buf + WIRE_PREFIX_BYTES;
+    p = FieldTempAire::get(p, end, out.tempAire, present);
+    p = FieldHumAire::get(p, end, out.humAire, present);
+    p = FieldTempSuelo::get(p, end, out.tempSuelo, present);
+    p = FieldVwcSuelo::get(p, end, out.vwcSuelo, present);
+    p = FieldEcSuelo::get(p, end, out.ecSuelo, present);
+    p = FieldPar::get(p, end, out.par, present);
+    p = FieldVBat::get(p, end, out.vBat, present);
+    if (!p) return WIRE_ERR_LENGTH;
+
+    out.batPercent = WIRE_BAT_UNKNOWN;
+    if (present & WIRE_F_BAT_PERCENT) {
+        if (end - p < 1) return WIRE_ERR_LENGTH;
+        out.batPercent = *p++;
+    }
+    if (present & WIRE_F_INTERVAL) {
+        if (end - p < 2) return WIRE_ERR_LENGTH;
+        out.intervalMs = WireInt<2>::get(p) * 1000UL;
+        p += 2;
+    }
+    if (present & WIRE_F_SOIL) {
+        if (end - p < 1) return WIRE_ERR_LENGTH;
+        uint8_t count = *p++;
+        if (count == 0 || count > WIRE_SOIL_MAX) return WIRE_ERR_LENGTH;
+        if (end - p < count * WIRE_PROBE_BYTES) return WIRE_ERR_LENGTH;
+        out.soilCount = count;
+        for (uint8_t i = 0; i < count; i++) {
+            WireSoil& s = out.soil[i];
+            s.addr = *p++;
+            s.depthCm = *p++;
+            p = ProbeVwc::get(p, s.vwc);
+            p = ProbeTemp::get(p, s.temp);
+            p = ProbeEc::get(p, s.ec);
+        }
+    }
+    return p == end ? WIRE_OK : WIRE_ERR_LENGTH;
+}
+
+// ============================================
+// Raw struct of older firmware
+// ============================================
+
+static uint32_t legacyU32(const uint8_t* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static float legacyFloat(const uint8_t* p) {
+    uint32_t bits = legacyU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+WireStatus wireDecodeLegacy(const uint8_t* buf, size_t len, WireReading& out) {
+    if (len != WIRE_LEGACY_BYTES) return WIRE_ERR_LENGTH;
+
+    memset(&out, 0, sizeof(out));
+    out.tempAire = legacyFloat(buf);
+    out.humAire = legacyFloat(buf + 4);
+    out.tempSuelo = legacyFloat(buf + 8);
+    out.vwcSuelo = legacyFloat(buf + 12);
+    out.ecSuelo = legacyFloat(buf + 16);
+    wireSoilValues(out.vwcSuelo, out.tempSuelo, out.ecSuelo);
+    out.par = legacyFloat(buf + 20);
+    out.seq = legacyU32(buf + 24);
+    out.intervalMs = legacyU32(buf + 28);
+    out.vBat = legacyFloat(buf + 32);
+    out.batPercent = buf[36];
+    return WIRE_OK;
+}
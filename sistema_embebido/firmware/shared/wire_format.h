@@ -0,0 +1,140 @@
+/**
+ * LoRa Wire Format (shared by TX and RX)
+ *
+ * Packed, versioned frame for one reading, replacing the raw
+ * MeteorDataPacket struct (108 bytes of floats and padding, layout up to
+ * the compiler). Every field is quantized to fixed point and written
+ * little-endian byte by byte, so the frame is the same on any host:
+ *
+ *   offset  size
+ *   0       1     header: version (high nibble), frame type (low nibble)
+ *   1       2     nodeId
+ *   3       3     sequence (packetId, low 24 bits)
+ *   6       2     present bitmap (WIRE_F_*)
+ *   8       ...   present fields, in bit order (table below)
+ *   n       2     CRC-16/CCITT-FALSE of bytes 0..n-1
+ *
+ *   field        bytes  unit                 range
+ *   tempAire     2 s    0.01 °C              ±327.67
+ *   humAire      2      0.1 %                0..6553.4
+ *   tempSuelo    2 s    0.01 °C              ±327.67
+ *   vwcSuelo     2      0.1 % VWC            0..6553.4
+ *   ecSuelo      2      1 µS/cm              0..65534
+ *   par          2      0.1 µmol/m²s         0..6553.4
+ *   vBat         2      1 mV                 0..65.534 V
+ *   batPercent   1      %                    0..100
+ *   interval     2      1 s                  1..65534 s
+ *   soil         1+8n   count, then per probe addr, depthCm,
+ *                       vwc (0.1 %), temp (0.01 °C, s), ec (1 µS/cm)
+ *
+ * A field whose sensor failed (NaN) is left out and its bit cleared; values
+ * beyond the range are clamped. Inside a soil probe a missing value is the
+ * reserved all-ones (0x8000 when signed). A reading with one soil probe
+ * takes 36 bytes.
+ *
+ * Each field is a WireField instantiation, so the encoder and decoder are
+ * generated per field at compile time (width, sign and scale are template
+ * arguments, no per-field branches or tables at run time).
+ *
+ * No Arduino/IDF (built by tools/wire_bench).
+ */
+
+#ifndef SHARED_WIRE_FORMAT_H
+#define SHARED_WIRE_FORMAT_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIRE_VERSION            1
+#define WIRE_TYPE_READING       0x1
+#define WIRE_HEADER(type)       ((WIRE_VERSION << 4) | (type))
+
+#define WIRE_SOIL_MAX           4
+#define WIRE_PROBE_BYTES        8
+#define WIRE_PREFIX_BYTES       8       // header, nodeId, sequence, bitmap
+#define WIRE_CRC_BYTES          2
+#define WIRE_FIELDS_MAX         17      // every scalar field present
+#define WIRE_FRAME_MAX          (WIRE_PREFIX_BYTES + WIRE_FIELDS_MAX + 1 + \
+                                 WIRE_SOIL_MAX * WIRE_PROBE_BYTES + WIRE_CRC_BYTES)
+#define WIRE_SEQ_MASK           0xFFFFFFUL
+
+// Raw MeteorDataPacket of TX firmware before the wire format and the soil
+// profile, as the ESP32 lays it out (little-endian, 4-byte unsigned long):
+// tempAire, humAire, tempSuelo, vwcSuelo, ecSuelo, par (floats), packetId,
+// interval (uint32), vBat (float), batPercent, 3 bytes of padding
+#define WIRE_LEGACY_BYTES       40
+
+// Present bitmap
+#define WIRE_F_TEMP_AIRE        0x0001
+#define WIRE_F_HUM_AIRE         0x0002
+#define WIRE_F_TEMP_SUELO       0x0004
+#define WIRE_F_VWC_SUELO        0x0008
+#define WIRE_F_EC_SUELO         0x0010
+#define WIRE_F_PAR              0x0020
+#define WIRE_F_VBAT             0x0040
+#define WIRE_F_BAT_PERCENT      0x0080
+#define WIRE_F_INTERVAL         0x0100
+#define WIRE_F_SOIL             0x0200
+#define WIRE_F_KNOWN            0x03FF
+
+#define WIRE_BAT_UNKNOWN        0xFF    // batPercent not sent
+
+struct WireSoil {
+    uint8_t addr;               // SDI-12 address ('0'..'9')
+    uint8_t depthCm;
+    float vwc;
+    float temp;
+    float ec;
+};
+
+// One reading as the frame carries it; NaN = sensor failed / not sent
+struct WireReading {
+    uint16_t nodeId;
+    uint32_t seq;               // 24 bits on the wire
+    float tempAire;
+    float humAire;
+    float tempSuelo;
+    float vwcSuelo;
+    float ecSuelo;
+    float par;
+    float vBat;
+    uint8_t batPercent;         // WIRE_BAT_UNKNOWN if not sent
+    uint32_t intervalMs;        // 0 if not sent
+    uint8_t soilCount;
+    WireSoil soil[WIRE_SOIL_MAX];
+};
+
+// tx/sensors.cpp reports a TEROS 12 probe that did not answer as -1 in
+// vwc, temp and ec (a measured VWC is never negative). NaN them so the
+// frame leaves them out instead of clamping them to a real 0 % / 0 µS/cm.
+static inline void wireSoilValues(float& vwc, float& temp, float& ec) {
+    if (vwc < 0) vwc = temp = ec = NAN;
+}
+
+enum WireStatus {
+    WIRE_OK,
+    WIRE_ERR_SHORT,             // shorter than any frame
+    WIRE_ERR_CRC,
+    WIRE_ERR_VERSION,           // other version or frame type
+    WIRE_ERR_LENGTH             // fields do not fill the frame exactly
+};
+
+// Encode `in` into out[0..size). Returns the frame size, 0 if `size` is
+// too small (WIRE_FRAME_MAX always fits).
+size_t wireEncode(const WireReading& in, uint8_t* out, size_t size);
+
+// Decode the frame buf[0..len). On anything but WIRE_OK `out` is undefined.
+WireStatus wireDecode(const uint8_t* buf, size_t len, WireReading& out);
+
+// Decode a WIRE_LEGACY_BYTES raw struct. No nodeId (0) and no soil
+// profile; the full 32-bit packetId; the TEROS 12 -1 sentinel as NaN.
+WireStatus wireDecodeLegacy(const uint8_t* buf, size_t len, WireReading& out);
+
+// Bytes wireEncode() produces for `in`
+size_t wireFrameSize(const WireReading& in);
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+uint16_t wireCrc16(const uint8_t* data, size_t len);
+
+#endif
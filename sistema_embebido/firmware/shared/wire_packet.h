@@ -0,0 +1,63 @@
+/**
+ * MeteorDataPacket <-> Wire Frame (shared by TX and RX)
+ *
+ * Conversions between the in-memory packet (config.h) and the reading a
+ * wire_format.h frame carries. A packet that went through the wire holds
+ * the quantized values, NaN for fields the frame did not carry (a sensor
+ * that failed, including a TEROS 12 probe's -1), and a 24-bit packetId.
+ */
+
+#ifndef SHARED_WIRE_PACKET_H
+#define SHARED_WIRE_PACKET_H
+
+#include "config.h"
+#include "wire_format.h"
+
+static inline void wireFromPacket(const MeteorDataPacket& pkt, WireReading& out) {
+    out.nodeId = pkt.nodeId;
+    out.seq = pkt.packetId;
+    out.tempAire = pkt.tempAire;
+    out.humAire = pkt.humAire;
+    out.tempSuelo = pkt.tempSuelo;
+    out.vwcSuelo = pkt.vwcSuelo;
+    out.ecSuelo = pkt.ecSuelo;
+    wireSoilValues(out.vwcSuelo, out.tempSuelo, out.ecSuelo);
+    out.par = pkt.par;
+    out.vBat = pkt.vBat;
+    out.batPercent = pkt.batPercent;
+    out.intervalMs = pkt.interval;
+    out.soilCount = pkt.soilCount < WIRE_SOIL_MAX ? pkt.soilCount : WIRE_SOIL_MAX;
+    for (uint8_t i = 0; i < out.soilCount; i++) {
+        out.soil[i].addr = pkt.soil[i].addr;
+        out.soil[i].depthCm = pkt.soil[i].depthCm;
+        out.soil[i].vwc = pkt.soil[i].vwc;
+        out.soil[i].temp = pkt.soil[i].temp;
+        out.soil[i].ec = pkt.soil[i].ec;
+        wireSoilValues(out.soil[i].vwc, out.soil[i].temp, out.soil[i].ec);
+    }
+}
+
+static inline void wireToPacket(const WireReading& in, MeteorDataPacket& pkt) {
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.nodeId = in.nodeId;
+    pkt.packetId = in.seq;
+    pkt.tempAire = in.tempAire;
+    pkt.humAire = in.humAire;
+    pkt.tempSuelo = in.tempSuelo;
+    pkt.vwcSuelo = in.vwcSuelo;
+    pkt.ecSuelo = in.ecSuelo;
+    pkt.par = in.par;
+    pkt.vBat = in.vBat;
+    pkt.batPercent = in.batPercent == WIRE_BAT_UNKNOWN ? 0 : in.batPercent;
+    pkt.interval = in.intervalMs;
+    pkt.soilCount = in.soilCount < SOIL_MAX_PROBES ? in.soilCount : SOIL_MAX_PROBES;
+    for (uint8_t i = 0; i < pkt.soilCount; i++) {
+        pkt.soil[i].addr = in.soil[i].addr;
+        pkt.soil[i].depthCm = in.soil[i].depthCm;
+        pkt.soil[i].vwc = in.soil[i].vwc;
+        pkt.soil[i].temp = in.soil[i].temp;
+        pkt.soil[i].ec = in.soil[i].ec;
+    }
+}
+
+#endif
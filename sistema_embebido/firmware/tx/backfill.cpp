@@ -0,0 +1,144 @@
+/**
+ * Backfill Implementation
+ */
+
+#include "backfill.h"
+#include "binlog.h"
+#include "clock.h"
+#include "log_segments.h"
+#include "sd_logger.h"
+#include <SD.h>
+#include <esp_timer.h>
+
+// Pending ranges survive deep sleep
+RTC_DATA_ATTR static BackfillRange ranges[BACKFILL_MAX_RANGES];
+RTC_DATA_ATTR static uint8_t rangeCount = 0;
+
+static uint32_t recordsFound = 0;
+static uint32_t idsMissing = 0;
+static uint32_t recordReads = 0;
+static uint32_t collectMaxUs = 0;
+
+void backfillSetRanges(const BackfillRange* list, uint8_t count) {
+    rangeCount = 0;
+    for (uint8_t i = 0; i < count && rangeCount < BACKFILL_MAX_RANGES; i++) {
+        if (list[i].first > list[i].last) continue;
+        ranges[rangeCount++] = list[i];
+    }
+}
+
+uint8_t backfillRangeCount() {
+    return rangeCount;
+}
+
+// Records of `span` in one segment's .bin, by index: a lower bound and an
+// in-order read while packetIds are sorted, one lookup per missing id if not
+static void searchSegment(const char* path, const BackfillRange& span, uint32_t minEpoch,
+                          BinlogRecord* found, bool* have) {
+    File reader;
+    BinlogState st;
+    BinlogIo io;
+    if (!binlogOpenReader(path, reader, st, io)) return;
+
+    BinlogRecord rec;
+    if (st.packetSorted) {
+        for (uint32_t i = binlogFindPacketFrom(io, st, span.first); i < st.count; i++) {
+            recordReads++;
+            if (!binlogReadRecord(io, i, rec)) continue;
+            if (rec.packetId > span.last) break;
+            uint32_t k = rec.packetId - span.first;
+            if (rec.packetId >= span.first && !have[k] && rec.epoch >= minEpoch) {
+                found[k] = rec;
+                have[k] = true;
+            }
+        }
+    } else {
+        for (uint32_t id = span.first; id <= span.last; id++) {
+            uint32_t k = id - span.first;
+            if (have[k]) continue;
+            int32_t i = binlogFindPacket(io, st, id);
+            recordReads++;
+            if (i >= 0 && binlogReadRecord(io, i, rec) && rec.epoch >= minEpoch) {
+                found[k] = rec;
+                have[k] = true;
+            }
+        }
+    }
+    reader.close();
+}
+
+bool backfillCollect(BackfillBatch& out) {
+    out.count = 0;
+    out.missingCount = 0;
+    if (rangeCount == 0 || !sdConnected) return false;
+    int64_t t0 = esp_timer_get_time();
+
+    out.span.first = ranges[0].first;
+    out.span.last = ranges[0].last - ranges[0].first >= BACKFILL_BATCH ?
+                    ranges[0].first + BACKFILL_BATCH - 1 : ranges[0].last;
+    uint32_t now = clockNowEpoch();
+    uint32_t minEpoch = now > BACKFILL_MAX_AGE_S ? now - BACKFILL_MAX_AGE_S : 0;
+
+    bool have[BACKFILL_BATCH] = { false };
+    uint32_t want = out.span.last - out.span.first + 1;
+    uint32_t got = 0;
+
+    sdLock();
+    uint32_t end = logSegEnd();
+    for (uint32_t n = 0; n < BACKFILL_MAX_SEGMENTS && n < end && got < want; n++) {
+        LogSegment s;
+        if (!logSegEntry(end - 1 - n, s) || s.records == 0) continue;
+        if (logSegTimeSorted() && s.lastEpoch < minEpoch) break;
+        if (s.maxPacket < out.span.first || s.minPacket > out.span.last) continue;
+
+        char path[LOG_SEG_PATH_LEN];
+        logSegPath(s, "bin", path, sizeof(path));
+        searchSegment(path, out.span, minEpoch, out.records, have);
+        got = 0;
+        for (uint32_t k = 0; k < want; k++) got += have[k];
+    }
+    sdUnlock();
+
+    // Compact in packetId order; what is left is reported as unavailable
+    uint8_t count = 0;
+    for (uint32_t k = 0; k < want; k++) {
+        uint32_t id = out.span.first + k;
+        if (have[k]) {
+            if (count != k) out.records[count] = out.records[k];
+            count++;
+        } else if (out.missingCount > 0 && out.missing[out.missingCount - 1].last + 1 == id) {
+            out.missing[out.missingCount - 1].last = id;
+        } else {
+            out.missing[out.missingCount].first = id;
+            out.missing[out.missingCount].last = id;
+            out.missingCount++;
+        }
+    }
+    out.count = count;
+    recordsFound += count;
+    idsMissing += want - count;
+
+    uint32_t us = esp_timer_get_time() - t0;
+    if (us > collectMaxUs) collectMaxUs = us;
+    return true;
+}
+
+void backfillDone(const BackfillBatch& batch) {
+    if (rangeCount == 0 || ranges[0].first != batch.span.first) return;
+    if (batch.span.last < ranges[0].last) {
+        ranges[0].first = batch.span.last + 1;
+        return;
+    }
+    rangeCount--;
+    memmove(ranges, ranges + 1, rangeCount * sizeof(ranges[0]));
+}
+
+void backfillPrintStatus() {
+    uint32_t ids = 0;
+    for (uint8_t i = 0; i < rangeCount; i++) ids += ranges[i].last - ranges[i].first + 1;
+    Serial.printf("Backfill: %u ranges (%lu ids) pending, %lu found, %lu not on card, "
+                  "%lu record reads, collect max %lu us\n",
+                  rangeCount, (unsigned long)ids, (unsigned long)recordsFound,
+                  (unsigned long)idsMissing, (unsigned long)recordReads,
+                  (unsigned long)collectMaxUs);
+}
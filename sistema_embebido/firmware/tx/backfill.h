@@ -0,0 +1,56 @@
+/**
+ * Backfill - server-requested packetId gaps, re-read from the SD log
+ *
+ * The ingest response lists the packetId ranges the server is missing
+ * (newest first). They are kept in RTC memory, and once the upload queue
+ * is empty server_client uploads them BACKFILL_BATCH records at a time to
+ * /api/data/backfill, at a lower rate than live data.
+ *
+ * Records are found through the manifest (newest segments first, only those
+ * whose packetId range overlaps) and the binlog index, then read in order:
+ * the cost grows with the gap, not with the amount of history on the card.
+ * Records older than BACKFILL_MAX_AGE_S are ignored (packetId restarts on a
+ * cold boot, so an old segment can hold the same ids). Ids that are not on
+ * the card are reported back as unavailable so the server stops asking.
+ */
+
+#ifndef TX_BACKFILL_H
+#define TX_BACKFILL_H
+
+#include <Arduino.h>
+#include "binlog_format.h"
+
+#define BACKFILL_MAX_RANGES     8
+#define BACKFILL_BATCH          10      // records per upload
+#define BACKFILL_INTERVAL_MS    10000   // between uploads from loop()
+#define BACKFILL_DUTY_BATCHES   3       // uploads per deep-sleep wake
+#define BACKFILL_MAX_AGE_S      (7UL * 24 * 3600)  // server: BACKFILL.maxAge
+#define BACKFILL_MAX_SEGMENTS   16      // newest manifest entries searched
+
+struct BackfillRange {
+    uint32_t first;
+    uint32_t last;
+};
+
+struct BackfillBatch {
+    BinlogRecord records[BACKFILL_BATCH];
+    uint8_t count;
+    BackfillRange span;                     // packetIds this batch covers
+    BackfillRange missing[BACKFILL_BATCH];  // parts of the span not on the card
+    uint8_t missingCount;
+};
+
+// Replace the pending ranges (from a server response)
+void backfillSetRanges(const BackfillRange* ranges, uint8_t count);
+uint8_t backfillRangeCount();
+
+// Read the next span (start of the first range, at most BACKFILL_BATCH ids)
+// from the card. False if nothing is pending or the card is not mounted.
+bool backfillCollect(BackfillBatch& out);
+
+// The batch was accepted: drop its span from the pending ranges
+void backfillDone(const BackfillBatch& batch);
+
+void backfillPrintStatus();
+
+#endif
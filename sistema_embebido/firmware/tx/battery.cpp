@@ -4,18 +4,21 @@
  */
 
 #include "battery.h"
+#include "par_adc.h"
+#include "power.h"
 
-// Cached values
-static float cachedVoltage = 0.0;
-static uint8_t cachedPercent = 0;
+// Cached values (RTC memory: kept across deep sleep)
+static RTC_DATA_ATTR float cachedVoltage = 0.0;
+static RTC_DATA_ATTR uint8_t cachedPercent = 0;
 
 void batteryInit() {
     // Configure ADC for battery reading
     analogReadResolution(12);  // 12-bit (0-4095)
     analogSetAttenuation(ADC_11db);  // Full range 0-3.3V
     
-    // Initial reading
-    readBatteryVoltage();
+    // Initial reading (after deep sleep the cached value is still valid and
+    // the next measurement refreshes it)
+    if (!powerWokeFromSleep()) readBatteryVoltage();
     
     Serial.printf("[Battery] Init OK - %.2fV (%d%%)\n", cachedVoltage, cachedPercent);
 }
@@ -25,10 +28,13 @@ float readBatteryVoltage() {
     uint32_t sum = 0;
     const int samples = 16;
     
+    // ADC1 is shared with the PAR DMA stream
+    parAdcPause();
     for (int i = 0; i < samples; i++) {
         sum += analogRead(VBAT_PIN);
         delayMicroseconds(100);
     }
+    parAdcResume();
     
     uint32_t avgRaw = sum / samples;
     
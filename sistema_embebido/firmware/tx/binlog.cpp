@@ -0,0 +1,211 @@
+/**
+ * Binary Log Implementation
+ */
+
+#include "binlog.h"
+#include "clock.h"
+#include <SD.h>
+
+#define BINLOG_BUF_SLOTS (512 / BINLOG_SLOT_SIZE)
+
+static File binFile;
+static bool binOpen = false;
+static BinlogState binState;
+static uint8_t binBuf[BINLOG_BUF_SLOTS * BINLOG_SLOT_SIZE];
+static size_t binBufLen = 0;
+static char binPath[BINLOG_PATH_LEN] = "";
+
+static bool readFile(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    File* f = (File*)ctx;
+    return f->seek(offset) && f->read(buf, len) == len;
+}
+
+bool binlogFlush(bool sync) {
+    if (!binOpen) return false;
+    if (binBufLen > 0) {
+        if (binFile.write(binBuf, binBufLen) != binBufLen) {
+            Serial.println("[Binlog] Write failed");
+            binlogClose();
+            return false;
+        }
+        binBufLen = 0;
+    }
+    if (sync) binFile.flush();
+    return true;
+}
+
+static bool appendSlot(const uint8_t* slot) {
+    if (binBufLen + BINLOG_SLOT_SIZE > sizeof(binBuf) && !binlogFlush(false)) return false;
+    memcpy(binBuf + binBufLen, slot, BINLOG_SLOT_SIZE);
+    binBufLen += BINLOG_SLOT_SIZE;
+    return true;
+}
+
+bool binlogOpen(const char* path) {
+    binlogClose();
+    strlcpy(binPath, path, sizeof(binPath));
+    binFile = SD.open(binPath, FILE_APPEND);
+    if (!binFile) {
+        Serial.println("[Binlog] Open failed");
+        return false;
+    }
+    binOpen = true;
+    binBufLen = 0;
+
+    uint32_t size = binFile.size();
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    if (size == 0) {
+        binlogStateInit(binState);
+        binlogEncodeHeader(clockNowEpoch(), slot);
+        appendSlot(slot);
+        return binlogFlush(true);
+    }
+
+    // A torn slot from a power cut: pad it so later slots stay aligned (it
+    // then reads back as a record with a bad CRC)
+    if (size % BINLOG_SLOT_SIZE) {
+        memset(slot, 0xFF, sizeof(slot));
+        binFile.write(slot, BINLOG_SLOT_SIZE - size % BINLOG_SLOT_SIZE);
+        binFile.flush();
+        size += BINLOG_SLOT_SIZE - size % BINLOG_SLOT_SIZE;
+    }
+
+    File reader = SD.open(binPath, FILE_READ);
+    BinlogIo io = { &reader, readFile };
+    bool ok = reader && binlogResume(io, size, binState);
+    if (reader) reader.close();
+    if (!ok) {
+        // Unknown layout: leave it for the host tool, don't append to it
+        Serial.println("[Binlog] Bad header or layout, binary log disabled");
+        binlogClose();
+        return false;
+    }
+
+    if (binState.group.count == BINLOG_INDEX_EVERY) {
+        binlogCloseGroup(binState, slot);
+        appendSlot(slot);
+    }
+
+    Serial.printf("[Binlog] %s: %u records, %s\n", binPath, binState.count,
+                  binState.epochSorted ? "time-sorted" : "time unsorted (scan)");
+    return binlogFlush(false);
+}
+
+void binlogClose() {
+    if (binOpen) binFile.close();
+    binOpen = false;
+    binBufLen = 0;
+}
+
+void binlogRecordFromPacket(const MeteorDataPacket& data, uint32_t epoch, BinlogRecord& rec) {
+    memset(&rec, 0, sizeof(rec));
+    rec.epoch = epoch;
+    rec.packetId = data.packetId;
+    rec.tempAire = data.tempAire;
+    rec.humAire = data.humAire;
+    rec.tempSuelo = data.tempSuelo;
+    rec.vwcSuelo = data.vwcSuelo;
+    rec.ecSuelo = data.ecSuelo;
+    rec.par = data.par;
+    rec.vBat = data.vBat;
+    rec.batPercent = data.batPercent;
+    rec.soilCount = data.soilCount;
+    for (uint8_t i = 0; i < SOIL_MAX_PROBES && i < BINLOG_SOIL_MAX; i++) {
+        rec.soil[i].addr = data.soil[i].addr;
+        rec.soil[i].depthCm = data.soil[i].depthCm;
+        rec.soil[i].vwc = data.soil[i].vwc;
+        rec.soil[i].temp = data.soil[i].temp;
+        rec.soil[i].ec = data.soil[i].ec;
+    }
+}
+
+void binlogPacketFromRecord(const BinlogRecord& rec, MeteorDataPacket& data) {
+    memset(&data, 0, sizeof(data));
+    data.packetId = rec.packetId;
+    data.tempAire = rec.tempAire;
+    data.humAire = rec.humAire;
+    data.tempSuelo = rec.tempSuelo;
+    data.vwcSuelo = rec.vwcSuelo;
+    data.ecSuelo = rec.ecSuelo;
+    data.par = rec.par;
+    data.vBat = rec.vBat;
+    data.batPercent = rec.batPercent;
+    data.soilCount = rec.soilCount < SOIL_MAX_PROBES ? rec.soilCount : SOIL_MAX_PROBES;
+    for (uint8_t i = 0; i < SOIL_MAX_PROBES && i < BINLOG_SOIL_MAX; i++) {
+        data.soil[i].addr = rec.soil[i].addr;
+        data.soil[i].depthCm = rec.soil[i].depthCm;
+        data.soil[i].vwc = rec.soil[i].vwc;
+        data.soil[i].temp = rec.soil[i].temp;
+        data.soil[i].ec = rec.soil[i].ec;
+    }
+}
+
+bool binlogAppend(const MeteorDataPacket& data, uint32_t epoch) {
+    if (!binOpen) return false;
+
+    BinlogRecord rec;
+    binlogRecordFromPacket(data, epoch, rec);
+
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    binlogEncodeRecord(rec, slot);
+    if (!appendSlot(slot)) return false;
+    if (binlogAdd(binState, rec, slot) && !appendSlot(slot)) return false;
+    return true;
+}
+
+uint32_t binlogCount() {
+    return binOpen ? binState.count : 0;
+}
+
+// ============================================
+// Lookups
+// ============================================
+
+bool binlogOpenReader(const char* path, File& reader, BinlogState& st, BinlogIo& io) {
+    bool current = binOpen && strcmp(path, binPath) == 0;
+    if (current && !binlogFlush(false)) return false;
+    reader = SD.open(path, FILE_READ);
+    if (!reader) return false;
+    io.ctx = &reader;
+    io.read = readFile;
+    if (current) {
+        st = binState;
+        return true;
+    }
+    if (binlogResume(io, reader.size(), st)) return true;
+    reader.close();
+    return false;
+}
+
+bool binlogLookupTime(const char* path, uint32_t epoch, BinlogRecord& out) {
+    File reader;
+    BinlogState st;
+    BinlogIo io;
+    if (!binlogOpenReader(path, reader, st, io)) return false;
+    uint32_t i = binlogFindTime(io, st, epoch);
+    bool ok = i < st.count && binlogReadRecord(io, i, out);
+    reader.close();
+    return ok;
+}
+
+bool binlogLookupPacket(const char* path, uint32_t packetId, BinlogRecord& out) {
+    File reader;
+    BinlogState st;
+    BinlogIo io;
+    if (!binlogOpenReader(path, reader, st, io)) return false;
+    int32_t i = binlogFindPacket(io, st, packetId);
+    bool ok = i >= 0 && binlogReadRecord(io, i, out);
+    reader.close();
+    return ok;
+}
+
+void binlogPrintStatus() {
+    if (!binOpen) {
+        Serial.println("Binlog: closed");
+        return;
+    }
+    Serial.printf("Binlog: %s %u records, %u B buffered, time %s, packetId %s\n",
+                  binPath, binState.count, (unsigned)binBufLen,
+                  binState.epochSorted ? "sorted" : "unsorted",
+                  binState.packetSorted ? "sorted" : "unsorted");
+}
@@ -0,0 +1,52 @@
+/**
+ * Binary Log - .bin file next to each CSV segment
+ *
+ * Appends every measurement as a fixed-size, CRC-checked record in the
+ * indexed format described in binlog_format.h, and answers lookups by time
+ * or packetId in O(log n) slot reads. Slots are collected in a one-sector
+ * RAM buffer and written as whole 512-byte sectors.
+ *
+ * Driven by sd_logger (open per segment, append per record, flush at its
+ * durability points); enabled with SD_BINLOG_ENABLED. Lookups across
+ * segments go through log_segments.
+ */
+
+#ifndef TX_BINLOG_H
+#define TX_BINLOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "binlog_format.h"
+#include "../shared/config.h"
+
+#define BINLOG_PATH_LEN 24
+
+// Open (or create) `path` for appending and rebuild its index state
+bool binlogOpen(const char* path);
+void binlogClose();
+
+bool binlogAppend(const MeteorDataPacket& data, uint32_t epoch);
+
+// Conversions between the firmware packet and the on-card record
+void binlogRecordFromPacket(const MeteorDataPacket& data, uint32_t epoch, BinlogRecord& rec);
+void binlogPacketFromRecord(const BinlogRecord& rec, MeteorDataPacket& data);
+
+// Write the buffered sector; `sync` also fsyncs
+bool binlogFlush(bool sync);
+
+uint32_t binlogCount();
+
+// First record of `path` at or after `epoch` / with this packetId. The
+// open file is flushed first; any other one has its state rebuilt.
+bool binlogLookupTime(const char* path, uint32_t epoch, BinlogRecord& out);
+bool binlogLookupPacket(const char* path, uint32_t packetId, BinlogRecord& out);
+
+// Open `path` for reading with the state to search it by: the live state
+// for the file being written (flushed first, records appended later are
+// not in it), otherwise rebuilt from the file. `io` reads through `reader`,
+// which the caller closes. Caller holds sdLock().
+bool binlogOpenReader(const char* path, File& reader, BinlogState& st, BinlogIo& io);
+
+void binlogPrintStatus();
+
+#endif
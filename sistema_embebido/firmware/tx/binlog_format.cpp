@@ -0,0 +1,406 @@
+/**
+ * Binary Time-Series Log Format Implementation
+ */
+
+#include "binlog_format.h"
+#include <string.h>
+
+#define GROUP_SLOTS (BINLOG_INDEX_EVERY + 1)
+
+// Record slot layout
+#define REC_SOIL_OFFSET  44
+#define REC_SOIL_SIZE    14
+
+// CRC-32 (IEEE 802.3, reflected), nibble table
+static const uint32_t crcNibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t binlogCrc32(const uint8_t* data, size_t len, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crcNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crcNibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+// ============================================
+// Little-endian field access
+// ============================================
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline void putFloat(uint8_t* p, float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    put32(p, v);
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+    return p[0] | (uint16_t)p[1] << 8;
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline float getFloat(const uint8_t* p) {
+    uint32_t v = get32(p);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+static void sealSlot(uint8_t* slot) {
+    put32(slot + BINLOG_CRC_OFFSET, binlogCrc32(slot, BINLOG_CRC_OFFSET));
+}
+
+static bool slotValid(const uint8_t* slot, uint32_t magic) {
+    return get32(slot) == magic &&
+           get32(slot + BINLOG_CRC_OFFSET) == binlogCrc32(slot, BINLOG_CRC_OFFSET);
+}
+
+// ============================================
+// Layout
+// ============================================
+
+uint32_t binlogRecordOffset(uint32_t index) {
+    uint32_t slot = 1 + (index / BINLOG_INDEX_EVERY) * GROUP_SLOTS + index % BINLOG_INDEX_EVERY;
+    return slot * BINLOG_SLOT_SIZE;
+}
+
+uint32_t binlogIndexOffset(uint32_t group) {
+    return (1 + group * GROUP_SLOTS + BINLOG_INDEX_EVERY) * BINLOG_SLOT_SIZE;
+}
+
+uint32_t binlogRecordCount(uint32_t size) {
+    if (size < BINLOG_SLOT_SIZE) return 0;
+    uint32_t slots = size / BINLOG_SLOT_SIZE - 1;
+    uint32_t rem = slots % GROUP_SLOTS;
+    return (slots / GROUP_SLOTS) * BINLOG_INDEX_EVERY +
+           (rem < BINLOG_INDEX_EVERY ? rem : BINLOG_INDEX_EVERY);
+}
+
+uint32_t binlogFileSize(uint32_t count) {
+    uint32_t slots = 1 + count + count / BINLOG_INDEX_EVERY;
+    return slots * BINLOG_SLOT_SIZE;
+}
+
+// ============================================
+// Slot codecs
+// ============================================
+
+void binlogEncodeHeader(uint32_t createdEpoch, uint8_t* slot) {
+    memset(slot, 0, BINLOG_SLOT_SIZE);
+    put32(slot, BINLOG_MAGIC);
+    put16(slot + 4, BINLOG_SCHEMA);
+    put16(slot + 6, BINLOG_SLOT_SIZE);
+    put16(slot + 8, BINLOG_INDEX_EVERY);
+    put32(slot + 12, createdEpoch);
+    sealSlot(slot);
+}
+
+bool binlogDecodeHeader(const uint8_t* slot, BinlogHeader& out) {
+    if (!slotValid(slot, BINLOG_MAGIC)) return false;
+    out.schema = get16(slot + 4);
+    out.slotSize = get16(slot + 6);
+    out.indexEvery = get16(slot + 8);
+    out.createdEpoch = get32(slot + 12);
+    return true;
+}
+
+void binlogEncodeRecord(const BinlogRecord& rec, uint8_t* slot, uint32_t tag) {
+    memset(slot, 0, BINLOG_SLOT_SIZE);
+    put32(slot, BINLOG_REC_MAGIC);
+    put32(slot + 4, rec.epoch);
+    put32(slot + 8, rec.packetId);
+    putFloat(slot + 12, rec.tempAire);
+    putFloat(slot + 16, rec.humAire);
+    putFloat(slot + 20, rec.tempSuelo);
+    putFloat(slot + 24, rec.vwcSuelo);
+    putFloat(slot + 28, rec.ecSuelo);
+    putFloat(slot + 32, rec.par);
+    putFloat(slot + 36, rec.vBat);
+    slot[40] = rec.batPercent;
+    slot[41] = rec.soilCount > BINLOG_SOIL_MAX ? BINLOG_SOIL_MAX : rec.soilCount;
+    for (uint8_t i = 0; i < BINLOG_SOIL_MAX; i++) {
+        uint8_t* p = slot + REC_SOIL_OFFSET + i * REC_SOIL_SIZE;
+        p[0] = rec.soil[i].addr;
+        p[1] = rec.soil[i].depthCm;
+        putFloat(p + 2, rec.soil[i].vwc);
+        putFloat(p + 6, rec.soil[i].temp);
+        putFloat(p + 10, rec.soil[i].ec);
+    }
+    put32(slot + BINLOG_TAG_OFFSET, tag);
+    sealSlot(slot);
+}
+
+bool binlogDecodeRecord(const uint8_t* slot, BinlogRecord& out) {
+    if (!slotValid(slot, BINLOG_REC_MAGIC)) return false;
+    out.epoch = get32(slot + 4);
+    out.packetId = get32(slot + 8);
+    out.tempAire = getFloat(slot + 12);
+    out.humAire = getFloat(slot + 16);
+    out.tempSuelo = getFloat(slot + 20);
+    out.vwcSuelo = getFloat(slot + 24);
+    out.ecSuelo = getFloat(slot + 28);
+    out.par = getFloat(slot + 32);
+    out.vBat = getFloat(slot + 36);
+    out.batPercent = slot[40];
+    out.soilCount = slot[41] > BINLOG_SOIL_MAX ? BINLOG_SOIL_MAX : slot[41];
+    for (uint8_t i = 0; i < BINLOG_SOIL_MAX; i++) {
+        const uint8_t* p = slot + REC_SOIL_OFFSET + i * REC_SOIL_SIZE;
+        out.soil[i].addr = p[0];
+        out.soil[i].depthCm = p[1];
+        out.soil[i].vwc = getFloat(p + 2);
+        out.soil[i].temp = getFloat(p + 6);
+        out.soil[i].ec = getFloat(p + 10);
+    }
+    return true;
+}
+
+uint32_t binlogRecordTag(const uint8_t* slot) {
+    return get32(slot + BINLOG_TAG_OFFSET);
+}
+
+void binlogEncodeIndex(const BinlogIndex& idx, uint8_t* slot) {
+    memset(slot, 0, BINLOG_SLOT_SIZE);
+    put32(slot, BINLOG_IDX_MAGIC);
+    put32(slot + 4, idx.group);
+    put32(slot + 8, idx.minEpoch);
+    put32(slot + 12, idx.maxEpoch);
+    put32(slot + 16, idx.minPacket);
+    put32(slot + 20, idx.maxPacket);
+    put32(slot + 24, idx.lastEpoch);
+    put32(slot + 28, idx.lastPacket);
+    put16(slot + 32, idx.count);
+    put16(slot + 34, idx.flags);
+    sealSlot(slot);
+}
+
+bool binlogDecodeIndex(const uint8_t* slot, BinlogIndex& out) {
+    if (!slotValid(slot, BINLOG_IDX_MAGIC)) return false;
+    out.group = get32(slot + 4);
+    out.minEpoch = get32(slot + 8);
+    out.maxEpoch = get32(slot + 12);
+    out.minPacket = get32(slot + 16);
+    out.maxPacket = get32(slot + 20);
+    out.lastEpoch = get32(slot + 24);
+    out.lastPacket = get32(slot + 28);
+    out.count = get16(slot + 32);
+    out.flags = get16(slot + 34);
+    return true;
+}
+
+// ============================================
+// Writer state
+// ============================================
+
+void binlogStateInit(BinlogState& st) {
+    memset(&st, 0, sizeof(st));
+    st.epochSorted = true;
+    st.packetSorted = true;
+}
+
+static void accumulate(BinlogState& st, const BinlogRecord* rec) {
+    BinlogIndex& g = st.group;
+    if (g.count == 0) {
+        g.group = st.count / BINLOG_INDEX_EVERY;
+        g.minEpoch = g.minPacket = UINT32_MAX;
+        g.maxEpoch = g.maxPacket = 0;
+    }
+    g.count++;
+    st.count++;
+    if (!rec) return;  // unreadable record: occupies its slot, no keys
+
+    if (st.count > 1) {
+        if (rec->epoch < st.lastEpoch) st.epochSorted = false;
+        if (rec->packetId < st.lastPacket) st.packetSorted = false;
+    }
+    st.lastEpoch = rec->epoch;
+    st.lastPacket = rec->packetId;
+    if (rec->epoch < g.minEpoch) g.minEpoch = rec->epoch;
+    if (rec->epoch > g.maxEpoch) g.maxEpoch = rec->epoch;
+    if (rec->packetId < g.minPacket) g.minPacket = rec->packetId;
+    if (rec->packetId > g.maxPacket) g.maxPacket = rec->packetId;
+}
+
+void binlogCloseGroup(BinlogState& st, uint8_t* indexSlot) {
+    BinlogIndex& g = st.group;
+    g.lastEpoch = st.lastEpoch;
+    g.lastPacket = st.lastPacket;
+    g.flags = (st.epochSorted ? BINLOG_IDX_EPOCH_SORTED : 0) |
+              (st.packetSorted ? BINLOG_IDX_PACKET_SORTED : 0);
+    binlogEncodeIndex(g, indexSlot);
+    g.count = 0;
+}
+
+bool binlogAdd(BinlogState& st, const BinlogRecord& rec, uint8_t* indexSlot) {
+    accumulate(st, &rec);
+    if (st.group.count < BINLOG_INDEX_EVERY) return false;
+    binlogCloseGroup(st, indexSlot);
+    return true;
+}
+
+static bool readSlot(const BinlogIo& io, uint32_t offset, uint8_t* slot) {
+    return io.read(io.ctx, offset, slot, BINLOG_SLOT_SIZE);
+}
+
+bool binlogReadRecord(const BinlogIo& io, uint32_t index, BinlogRecord& out) {
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    return readSlot(io, binlogRecordOffset(index), slot) && binlogDecodeRecord(slot, out);
+}
+
+static bool readIndex(const BinlogIo& io, uint32_t group, BinlogIndex& out) {
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    return readSlot(io, binlogIndexOffset(group), slot) && binlogDecodeIndex(slot, out);
+}
+
+bool binlogResume(const BinlogIo& io, uint32_t size, BinlogState& st) {
+    binlogStateInit(st);
+
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    BinlogHeader hdr;
+    if (!readSlot(io, 0, slot) || !binlogDecodeHeader(slot, hdr)) return false;
+    if (hdr.slotSize != BINLOG_SLOT_SIZE || hdr.indexEvery != BINLOG_INDEX_EVERY) return false;
+
+    uint32_t count = binlogRecordCount(size);
+    uint32_t indexed = size / BINLOG_SLOT_SIZE > 0 ? (size / BINLOG_SLOT_SIZE - 1) / GROUP_SLOTS : 0;
+
+    if (indexed > 0) {
+        BinlogIndex last;
+        if (readIndex(io, indexed - 1, last)) {
+            st.lastEpoch = last.lastEpoch;
+            st.lastPacket = last.lastPacket;
+            st.epochSorted = (last.flags & BINLOG_IDX_EPOCH_SORTED) != 0;
+            st.packetSorted = (last.flags & BINLOG_IDX_PACKET_SORTED) != 0;
+        } else {
+            // Summary lost: stop trusting binary search for this file
+            st.epochSorted = false;
+            st.packetSorted = false;
+        }
+    }
+    st.count = indexed * BINLOG_INDEX_EVERY;
+
+    // Replay the unfinished group (a full one whose index was never written
+    // stays at count == BINLOG_INDEX_EVERY; see binlogCloseGroup)
+    for (uint32_t i = st.count; i < count; i++) {
+        BinlogRecord rec;
+        accumulate(st, binlogReadRecord(io, i, rec) ? &rec : 0);
+    }
+    return true;
+}
+
+// ============================================
+// Lookups
+// ============================================
+
+static bool recordKey(const BinlogIo& io, uint32_t index, bool byPacket, uint32_t& key) {
+    BinlogRecord rec;
+    if (!binlogReadRecord(io, index, rec)) return false;
+    key = byPacket ? rec.packetId : rec.epoch;
+    return true;
+}
+
+// First record in [lo, hi) with key >= target (keys non-decreasing)
+static uint32_t lowerBoundRecords(const BinlogIo& io, uint32_t lo, uint32_t hi,
+                                  bool byPacket, uint32_t target) {
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t key = 0;
+        recordKey(io, mid, byPacket, key);  // unreadable: treated as smallest
+        if (key < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// First record in [lo, hi) with key >= target, in file order
+static uint32_t scanRecords(const BinlogIo& io, uint32_t lo, uint32_t hi,
+                            bool byPacket, uint32_t target) {
+    for (uint32_t i = lo; i < hi; i++) {
+        uint32_t key;
+        if (recordKey(io, i, byPacket, key) && key >= target) return i;
+    }
+    return hi;
+}
+
+static uint32_t findFirst(const BinlogIo& io, const BinlogState& st, bool byPacket, uint32_t target) {
+    uint32_t groups = (st.count - st.group.count) / BINLOG_INDEX_EVERY;
+    uint32_t tailStart = groups * BINLOG_INDEX_EVERY;
+    bool sorted = byPacket ? st.packetSorted : st.epochSorted;
+
+    if (sorted) {
+        // First group whose largest key reaches the target
+        uint32_t lo = 0, hi = groups;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            BinlogIndex idx;
+            uint32_t max = 0;
+            if (readIndex(io, mid, idx)) max = byPacket ? idx.maxPacket : idx.maxEpoch;
+            if (max < target) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < groups) {
+            uint32_t start = lo * BINLOG_INDEX_EVERY;
+            return lowerBoundRecords(io, start, start + BINLOG_INDEX_EVERY, byPacket, target);
+        }
+        return lowerBoundRecords(io, tailStart, st.count, byPacket, target);
+    }
+
+    for (uint32_t g = 0; g < groups; g++) {
+        BinlogIndex idx;
+        if (readIndex(io, g, idx) && (byPacket ? idx.maxPacket : idx.maxEpoch) < target) continue;
+        uint32_t start = g * BINLOG_INDEX_EVERY;
+        uint32_t i = scanRecords(io, start, start + BINLOG_INDEX_EVERY, byPacket, target);
+        if (i < start + BINLOG_INDEX_EVERY) return i;
+    }
+    return scanRecords(io, tailStart, st.count, byPacket, target);
+}
+
+uint32_t binlogFindTime(const BinlogIo& io, const BinlogState& st, uint32_t epoch) {
+    return findFirst(io, st, false, epoch);
+}
+
+uint32_t binlogFindPacketFrom(const BinlogIo& io, const BinlogState& st, uint32_t packetId) {
+    return findFirst(io, st, true, packetId);
+}
+
+int32_t binlogFindPacket(const BinlogIo& io, const BinlogState& st, uint32_t packetId) {
+    if (st.packetSorted) {
+        uint32_t i = findFirst(io, st, true, packetId);
+        uint32_t key;
+        if (i < st.count && recordKey(io, i, true, key) && key == packetId) return i;
+        return -1;
+    }
+
+    // Unsorted: only groups whose range contains the id are read
+    uint32_t groups = (st.count - st.group.count) / BINLOG_INDEX_EVERY;
+    for (uint32_t g = 0; g <= groups; g++) {
+        uint32_t start = g * BINLOG_INDEX_EVERY;
+        uint32_t end = g < groups ? start + BINLOG_INDEX_EVERY : st.count;
+        BinlogIndex idx;
+        if (g < groups && readIndex(io, g, idx) &&
+            (packetId < idx.minPacket || packetId > idx.maxPacket)) continue;
+        for (uint32_t i = start; i < end; i++) {
+            uint32_t key;
+            if (recordKey(io, i, true, key) && key == packetId) return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,149 @@
+/**
+ * Binary Time-Series Log Format
+ *
+ * Fixed-size 128-byte slots (four per SD sector, never straddling one):
+ *
+ *   slot 0            file header (magic, schema version, layout)
+ *   slots 1..N        N records
+ *   slot N+1          index of the group above
+ *   ...               repeats; the last group has no index until it is full
+ *
+ * Every slot ends with a CRC32 of its first 124 bytes. Record i lives at a
+ * computable offset, and the index slots carry the epoch/packetId range of
+ * their group, so a lookup is a binary search over index slots followed by
+ * one inside a group: O(log n) slot reads.
+ *
+ * Binary search needs keys that never decrease. The state tracks whether
+ * that held for the whole file (a reboot resets packetId, a SET_TIME can
+ * move the clock back); if not, lookups fall back to scanning index slots
+ * and only read the groups whose range matches.
+ *
+ * No Arduino/IDF (built by tools/binlog_tool). Fields are little-endian.
+ */
+
+#ifndef TX_BINLOG_FORMAT_H
+#define TX_BINLOG_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BINLOG_MAGIC        0x474C424DUL  // "MBLG"
+#define BINLOG_REC_MAGIC    0x44434552UL  // "RECD"
+#define BINLOG_IDX_MAGIC    0x58444E49UL  // "INDX"
+#define BINLOG_SCHEMA       1
+#define BINLOG_SLOT_SIZE    128
+#define BINLOG_CRC_OFFSET   (BINLOG_SLOT_SIZE - 4)
+#define BINLOG_INDEX_EVERY  32            // records per indexed group
+#define BINLOG_SOIL_MAX     4
+#define BINLOG_TAG_OFFSET   (BINLOG_CRC_OFFSET - 4)  // record slots: caller's tag
+
+struct BinlogSoil {
+    char addr;
+    uint8_t depthCm;
+    float vwc;
+    float temp;
+    float ec;
+};
+
+struct BinlogRecord {
+    uint32_t epoch;
+    uint32_t packetId;
+    float tempAire;
+    float humAire;
+    float tempSuelo;
+    float vwcSuelo;
+    float ecSuelo;
+    float par;
+    float vBat;
+    uint8_t batPercent;
+    uint8_t soilCount;
+    BinlogSoil soil[BINLOG_SOIL_MAX];
+};
+
+struct BinlogHeader {
+    uint16_t schema;
+    uint16_t slotSize;
+    uint16_t indexEvery;
+    uint32_t createdEpoch;
+};
+
+#define BINLOG_IDX_EPOCH_SORTED   0x0001  // holds from the start of the file
+#define BINLOG_IDX_PACKET_SORTED  0x0002
+
+struct BinlogIndex {
+    uint32_t group;
+    uint32_t minEpoch;
+    uint32_t maxEpoch;
+    uint32_t minPacket;
+    uint32_t maxPacket;
+    uint32_t lastEpoch;
+    uint32_t lastPacket;
+    uint16_t count;
+    uint16_t flags;
+};
+
+// Running summary of a file: rebuilt by binlogResume(), kept current by
+// binlogAdd()
+struct BinlogState {
+    uint32_t count;         // records in the file
+    BinlogIndex group;      // group being filled
+    uint32_t lastEpoch;
+    uint32_t lastPacket;
+    bool epochSorted;       // no record went back in time
+    bool packetSorted;      // packetId never decreased
+};
+
+// Random-access reader (SD File on the device, FILE* on the host)
+struct BinlogIo {
+    void* ctx;
+    bool (*read)(void* ctx, uint32_t offset, uint8_t* buf, size_t len);
+};
+
+uint32_t binlogCrc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+// Slot offsets
+uint32_t binlogRecordOffset(uint32_t index);
+uint32_t binlogIndexOffset(uint32_t group);
+// Complete records contained in a file of `size` bytes
+uint32_t binlogRecordCount(uint32_t size);
+// File size once `count` records (and their full-group indexes) are written
+uint32_t binlogFileSize(uint32_t count);
+
+void binlogEncodeHeader(uint32_t createdEpoch, uint8_t* slot);
+bool binlogDecodeHeader(const uint8_t* slot, BinlogHeader& out);
+// `tag` is stored with the record for the caller (0 in /data.bin; the
+// upload queue numbers its ring slots with it)
+void binlogEncodeRecord(const BinlogRecord& rec, uint8_t* slot, uint32_t tag = 0);
+bool binlogDecodeRecord(const uint8_t* slot, BinlogRecord& out);
+uint32_t binlogRecordTag(const uint8_t* slot);
+void binlogEncodeIndex(const BinlogIndex& idx, uint8_t* slot);
+bool binlogDecodeIndex(const uint8_t* slot, BinlogIndex& out);
+
+void binlogStateInit(BinlogState& st);
+
+// Account for a record appended to the file. Returns true when it completed
+// a group; `indexSlot` then holds the index to append right after it.
+bool binlogAdd(BinlogState& st, const BinlogRecord& rec, uint8_t* indexSlot);
+
+// Encode the index of the current (full) group and start a new one. Only
+// needed directly when binlogResume() finds a full group without its index.
+void binlogCloseGroup(BinlogState& st, uint8_t* indexSlot);
+
+// Rebuild the state of a file of `size` bytes from the last index slot and
+// the records of the unfinished group (at most BINLOG_INDEX_EVERY + 2 slot
+// reads). Returns false if the header is bad.
+bool binlogResume(const BinlogIo& io, uint32_t size, BinlogState& st);
+
+bool binlogReadRecord(const BinlogIo& io, uint32_t index, BinlogRecord& out);
+
+// First record (in file order) with epoch >= `epoch`; st.count if none
+uint32_t binlogFindTime(const BinlogIo& io, const BinlogState& st, uint32_t epoch);
+
+// Record with this packetId (the first one if reused); -1 if absent
+int32_t binlogFindPacket(const BinlogIo& io, const BinlogState& st, uint32_t packetId);
+
+// First record with packetId >= `packetId`, for range reads. Only meaningful
+// when st.packetSorted; st.count if none.
+uint32_t binlogFindPacketFrom(const BinlogIo& io, const BinlogState& st, uint32_t packetId);
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * Clock Service Implementation
+ */
+
+#include "clock.h"
+#include "rtc.h"
+#include <esp_timer.h>
+
+// now = anchorEpochUs + (t - anchorUs) + slew(t), where the slew moves
+// linearly from 0 to slewTotalUs over slewDurUs starting at anchorUs
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+static bool valid = false;
+static bool phaseKnown = false;  // false until the first seconds edge after a step
+static int64_t anchorUs = 0;
+static int64_t anchorEpochUs = 0;
+static int64_t slewTotalUs = 0;
+static int64_t slewDurUs = 0;
+
+static ClockStats stats = { 0, 0, 0, 0, 0, 0 };
+
+enum SyncState { SYNC_IDLE, SYNC_WAIT_EDGE };
+static SyncState syncState = SYNC_IDLE;
+static unsigned long lastSyncMs = 0;
+static unsigned long syncStartMs = 0;
+static int64_t lastPollUs = 0;
+static uint32_t syncBaseEpoch = 0;  // RTC epoch read when the sync started
+static int syncBaseSec = -1;
+
+// Caller holds clockMux
+static int64_t epochUsAt(int64_t t) {
+    int64_t elapsed = t - anchorUs;
+    int64_t slew = slewTotalUs;
+    if (elapsed < slewDurUs) slew = slewTotalUs * elapsed / slewDurUs;
+    return anchorEpochUs + elapsed + slew;
+}
+
+static void step(int64_t t, int64_t epochUs) {
+    portENTER_CRITICAL(&clockMux);
+    anchorUs = t;
+    anchorEpochUs = epochUs;
+    slewTotalUs = 0;
+    slewDurUs = 0;
+    valid = true;
+    portEXIT_CRITICAL(&clockMux);
+}
+
+// Start slewing out `errorUs` (software ahead when positive)
+static void slew(int64_t t, int64_t errorUs) {
+    portENTER_CRITICAL(&clockMux);
+    anchorEpochUs = epochUsAt(t);
+    anchorUs = t;
+    slewTotalUs = -errorUs;
+    slewDurUs = (errorUs < 0 ? -errorUs : errorUs) * 1000000LL / CLOCK_SLEW_PPM;
+    portEXIT_CRITICAL(&clockMux);
+}
+
+void clockSyncNow() {
+    uint32_t epoch = rtcGetEpoch();
+    if (epoch == 0) {
+        Serial.println("[Clock] RTC not available");
+        return;
+    }
+    // Phase within the second is unknown until the next edge sync
+    step(esp_timer_get_time(), (int64_t)epoch * 1000000LL);
+    stats.steps++;
+    phaseKnown = false;
+    syncState = SYNC_IDLE;
+    lastSyncMs = millis() - CLOCK_RESYNC_MS;  // edge sync on the next clockLoop()
+}
+
+void clockInit() {
+    clockSyncNow();
+}
+
+void clockLoop() {
+    if (!valid && syncState == SYNC_IDLE) return;
+
+    if (syncState == SYNC_IDLE) {
+        if (millis() - lastSyncMs < CLOCK_RESYNC_MS) return;
+        syncBaseEpoch = rtcGetEpoch();
+        syncBaseSec = syncBaseEpoch ? (int)(syncBaseEpoch % 60) : -1;
+        if (syncBaseSec < 0) {
+            lastSyncMs = millis();
+            return;
+        }
+        syncState = SYNC_WAIT_EDGE;
+        syncStartMs = millis();
+        lastPollUs = 0;
+        return;
+    }
+
+    // SYNC_WAIT_EDGE: one seconds-register read per poll period
+    int64_t t = esp_timer_get_time();
+    if (t - lastPollUs < CLOCK_EDGE_POLL_US) return;
+    lastPollUs = t;
+
+    int sec = rtcReadSeconds();
+    if (sec < 0 || millis() - syncStartMs > CLOCK_EDGE_TIMEOUT_MS) {
+        syncState = SYNC_IDLE;
+        lastSyncMs = millis();
+        return;
+    }
+    if (sec == syncBaseSec) return;
+
+    // Edge: the RTC just entered second `sec`
+    uint32_t rtcEpoch = syncBaseEpoch + (uint32_t)((sec - syncBaseSec + 60) % 60);
+    int64_t rtcUs = (int64_t)rtcEpoch * 1000000LL;
+
+    portENTER_CRITICAL(&clockMux);
+    int64_t softUs = epochUsAt(t);
+    portEXIT_CRITICAL(&clockMux);
+
+    int64_t errorUs = softUs - rtcUs;
+    unsigned long sinceLast = millis() - lastSyncMs;
+
+    if (errorUs > CLOCK_STEP_MS * 1000LL || errorUs < -CLOCK_STEP_MS * 1000LL) {
+        step(t, rtcUs);
+        stats.steps++;
+    } else {
+        slew(t, errorUs);
+        // A coarse read has no sub-second phase: its error is not drift
+        if (phaseKnown) {
+            int32_t absErr = errorUs < 0 ? -errorUs : errorUs;
+            if (absErr > stats.maxAbsErrorUs) stats.maxAbsErrorUs = absErr;
+            if (sinceLast > 0) stats.driftPpm = errorUs * 1000 / (int64_t)sinceLast;
+        }
+    }
+    phaseKnown = true;
+
+    stats.syncs++;
+    stats.lastErrorUs = errorUs;
+    syncState = SYNC_IDLE;
+    lastSyncMs = millis();
+}
+
+bool clockValid() {
+    return valid;
+}
+
+uint64_t clockNowMs() {
+    if (!valid) return 0;
+    int64_t t = esp_timer_get_time();
+    portENTER_CRITICAL(&clockMux);
+    int64_t us = epochUsAt(t);
+    portEXIT_CRITICAL(&clockMux);
+    return us / 1000;
+}
+
+uint32_t clockNowEpoch() {
+    return clockNowMs() / 1000;
+}
+
+size_t clockFormatTimestamp(char* buf, size_t size) {
+    return clockFormatEpoch(clockNowEpoch(), buf, size);
+}
+
+size_t clockFormatEpoch(uint32_t epoch, char* buf, size_t size) {
+    RtcTime t = rtcEpochToTime(epoch);
+    int n = snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d",
+                     t.year, t.month, t.day, t.hour, t.minute, t.second);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+size_t clockFormatTime(char* buf, size_t size) {
+    RtcTime t = rtcEpochToTime(clockNowEpoch());
+    int n = snprintf(buf, size, "%02d:%02d:%02d", t.hour, t.minute, t.second);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+size_t clockFormatDate(char* buf, size_t size) {
+    RtcTime t = rtcEpochToTime(clockNowEpoch());
+    int n = snprintf(buf, size, "%02d/%02d/%04d", t.day, t.month, t.year);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+void clockGetStats(ClockStats& out) {
+    out = stats;
+    int64_t t = esp_timer_get_time();
+    portENTER_CRITICAL(&clockMux);
+    int64_t elapsed = t - anchorUs;
+    int64_t remaining = elapsed < slewDurUs ? slewTotalUs - slewTotalUs * elapsed / slewDurUs : 0;
+    portEXIT_CRITICAL(&clockMux);
+    out.pendingSlewUs = remaining;
+}
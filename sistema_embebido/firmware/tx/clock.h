@@ -0,0 +1,61 @@
+/**
+ * Clock Service - cached wall clock
+ *
+ * Reads the PCF8563 once at boot and then keeps time from esp_timer as a
+ * 64-bit epoch (microseconds), so timestamps cost no I2C traffic and no
+ * heap. clockLoop() re-reads the RTC every CLOCK_RESYNC_MS: it watches the
+ * seconds register for the next edge (polled, non-blocking), compares the
+ * software time at that instant with the RTC and slews the difference out
+ * at CLOCK_SLEW_PPM so time never jumps or runs backwards. Errors above
+ * CLOCK_STEP_MS (boot, SET_TIME) are stepped.
+ *
+ * Safe to call from any task.
+ */
+
+#ifndef TX_CLOCK_H
+#define TX_CLOCK_H
+
+#include <Arduino.h>
+
+#define CLOCK_RESYNC_MS      600000  // RTC comparison every 10 min
+#define CLOCK_EDGE_POLL_US   2000    // seconds-register poll period during a sync
+#define CLOCK_EDGE_TIMEOUT_MS 1500
+#define CLOCK_SLEW_PPM       500     // 0.5 ms of correction per second
+#define CLOCK_STEP_MS        1000
+
+#define CLOCK_TS_LEN 20  // "YYYY-MM-DD HH:MM:SS" + NUL
+
+struct ClockStats {
+    uint32_t syncs;
+    int32_t lastErrorUs;     // software - RTC at the last seconds edge
+    int32_t maxAbsErrorUs;   // since boot, steps excluded
+    int32_t driftPpm;        // last error / time since the previous sync
+    int32_t pendingSlewUs;   // correction not yet applied
+    uint32_t steps;
+};
+
+// Read the RTC (coarse, ±1 s) and arm the first edge sync. Call after rtcInit().
+void clockInit();
+
+// Drive the periodic resync; call from loop() (cheap when idle)
+void clockLoop();
+
+// Re-read the RTC now and step (after the RTC was set)
+void clockSyncNow();
+
+// False until a valid RTC time was read
+bool clockValid();
+
+// Current time; 0 if not valid
+uint32_t clockNowEpoch();
+uint64_t clockNowMs();
+
+// Non-allocating formatters; return the length written
+size_t clockFormatTimestamp(char* buf, size_t size);  // YYYY-MM-DD HH:MM:SS
+size_t clockFormatTime(char* buf, size_t size);       // HH:MM:SS
+size_t clockFormatDate(char* buf, size_t size);       // DD/MM/YYYY
+size_t clockFormatEpoch(uint32_t epoch, char* buf, size_t size);  // as clockFormatTimestamp
+
+void clockGetStats(ClockStats& out);
+
+#endif
@@ -0,0 +1,293 @@
+/**
+ * Delta Record Codec Implementation
+ */
+
+#include "delta_codec.h"
+#include <math.h>
+#include <string.h>
+
+#define DELTA_NAN INT32_MIN   // quantized NaN
+
+// Fixed-point scale of each quantized field
+static const int32_t fieldScale[DELTA_FIELDS] = {
+    100,    // tempAire   0.01 °C
+    100,    // humAire    0.01 %
+    100,    // tempSuelo
+    100,    // vwcSuelo
+    10,     // ecSuelo    0.1 µS/cm
+    10,     // par        0.1 µmol/m²s
+    1000,   // vBat       1 mV
+    1       // batPercent
+};
+static const int32_t soilScale[DELTA_SOIL_FIELDS] = { 100, 100, 10 };  // vwc, temp, ec
+
+static int32_t quantize(float v, int32_t scale) {
+    if (isnan(v)) return DELTA_NAN;
+    double q = floor((double)v * scale + 0.5);
+    if (q <= (double)INT32_MIN) return INT32_MIN + 1;
+    if (q > (double)INT32_MAX) return INT32_MAX;
+    return (int32_t)q;
+}
+
+static float dequantize(int32_t q, int32_t scale) {
+    if (q == DELTA_NAN) return NAN;
+    return (float)((double)q / scale);
+}
+
+float deltaQuantize(float v, int32_t scale) {
+    return dequantize(quantize(v, scale), scale);
+}
+
+static void recordFields(const BinlogRecord& r, int32_t* q) {
+    const float f[DELTA_FIELDS - 1] = { r.tempAire, r.humAire, r.tempSuelo, r.vwcSuelo,
+                                        r.ecSuelo, r.par, r.vBat };
+    for (int i = 0; i < DELTA_FIELDS - 1; i++) q[i] = quantize(f[i], fieldScale[i]);
+    q[DELTA_FIELDS - 1] = r.batPercent;
+}
+
+static void soilFields(const BinlogSoil& s, int32_t* q) {
+    q[0] = quantize(s.vwc, soilScale[0]);
+    q[1] = quantize(s.temp, soilScale[1]);
+    q[2] = quantize(s.ec, soilScale[2]);
+}
+
+// ============================================
+// Varints
+// ============================================
+
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static size_t putVarint(uint8_t* p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool getVarint(const uint8_t* p, size_t len, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < len; shift += 7) {
+        uint8_t b = p[pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline size_t putDelta(uint8_t* p, int64_t d) {
+    return putVarint(p, zigzag(d));
+}
+
+static bool getDelta(const uint8_t* p, size_t len, size_t& pos, int64_t& d) {
+    uint64_t v;
+    if (!getVarint(p, len, pos, v)) return false;
+    d = unzigzag(v);
+    return true;
+}
+
+static uint16_t frameCrc(const uint8_t* p, size_t len) {
+    return (uint16_t)binlogCrc32(p, len);
+}
+
+// ============================================
+// Encoder
+// ============================================
+
+void deltaReset(DeltaState& st) {
+    memset(&st, 0, sizeof(st));
+}
+
+size_t deltaEncode(DeltaState& st, const BinlogRecord& rec, uint8_t* out, size_t size) {
+    bool key = !st.valid || st.sinceKey >= DELTA_KEYFRAME_EVERY;
+    DeltaState next;
+    DeltaState zero;
+    deltaReset(zero);
+    const DeltaState& prev = key ? zero : st;
+
+    memset(&next, 0, sizeof(next));
+    next.epoch = rec.epoch;
+    next.interval = key ? 0 : rec.epoch - st.epoch;
+    next.packetId = rec.packetId;
+    recordFields(rec, next.q);
+    next.soilCount = rec.soilCount < BINLOG_SOIL_MAX ? rec.soilCount : BINLOG_SOIL_MAX;
+    for (uint8_t i = 0; i < next.soilCount; i++) {
+        next.addr[i] = rec.soil[i].addr;
+        next.depthCm[i] = rec.soil[i].depthCm;
+        soilFields(rec.soil[i], next.soil[i]);
+    }
+    next.sinceKey = key ? 1 : st.sinceKey + 1;
+    next.valid = true;
+
+    bool layout = next.soilCount != prev.soilCount ||
+                  memcmp(next.addr, prev.addr, sizeof(next.addr)) != 0 ||
+                  memcmp(next.depthCm, prev.depthCm, sizeof(next.depthCm)) != 0;
+
+    uint8_t payload[DELTA_PAYLOAD_MAX];
+    size_t n = 0;
+    // A regular frame (next packetId, same probes) spends one byte on both
+    int64_t seq = (int64_t)rec.packetId - prev.packetId - 1;
+    bool irregular = seq != 0 || layout;
+    n += putVarint(payload + n, zigzag((int64_t)rec.epoch - prev.epoch - prev.interval) << 1 |
+                                (irregular ? DELTA_FLAG_SEQ : 0));
+    if (irregular) n += putVarint(payload + n, zigzag(seq) << 1 | (layout ? DELTA_FLAG_LAYOUT : 0));
+    for (int i = 0; i < DELTA_FIELDS; i++) {
+        n += putDelta(payload + n, (int64_t)next.q[i] - prev.q[i]);
+    }
+    if (layout) {
+        payload[n++] = next.soilCount;
+        for (uint8_t i = 0; i < next.soilCount; i++) {
+            payload[n++] = (uint8_t)next.addr[i];
+            payload[n++] = next.depthCm[i];
+        }
+    }
+    for (uint8_t i = 0; i < next.soilCount; i++) {
+        for (int k = 0; k < DELTA_SOIL_FIELDS; k++) {
+            n += putDelta(payload + n, (int64_t)next.soil[i][k] - prev.soil[i][k]);
+        }
+    }
+
+    size_t frame = (key ? 3 : 0) + n + 2;
+    if (frame > size) return 0;
+    size_t p = 0;
+    if (key) {
+        out[p++] = DELTA_SYNC0;
+        out[p++] = DELTA_SYNC1;
+        out[p++] = (uint8_t)n;
+    }
+    memcpy(out + p, payload, n);
+    p += n;
+    uint16_t crc = frameCrc(payload, n);
+    out[p++] = crc;
+    out[p++] = crc >> 8;
+
+    st = next;
+    return p;
+}
+
+// ============================================
+// Decoder
+// ============================================
+
+// Parse a payload against `prev` into `next`; `pos` ends past the last field
+static bool parsePayload(const DeltaState& prev, bool key, const uint8_t* payload, size_t len,
+                         size_t& pos, DeltaState& next) {
+    next = prev;
+    pos = 0;
+
+    int64_t d;
+    uint64_t v;
+    if (!getVarint(payload, len, pos, v)) return false;
+    next.epoch = (uint32_t)(prev.epoch + prev.interval + unzigzag(v >> 1));
+    next.interval = key ? 0 : next.epoch - prev.epoch;
+    next.packetId = prev.packetId + 1;
+    bool layout = false;
+    if (v & DELTA_FLAG_SEQ) {
+        if (!getVarint(payload, len, pos, v)) return false;
+        next.packetId = (uint32_t)(prev.packetId + 1 + unzigzag(v >> 1));
+        layout = v & DELTA_FLAG_LAYOUT;
+    }
+    for (int i = 0; i < DELTA_FIELDS; i++) {
+        if (!getDelta(payload, len, pos, d)) return false;
+        next.q[i] = (int32_t)(prev.q[i] + d);
+    }
+    if (layout) {
+        if (pos >= len) return false;
+        uint8_t count = payload[pos++];
+        if (count > BINLOG_SOIL_MAX || pos + 2 * count > len) return false;
+        memset(next.addr, 0, sizeof(next.addr));
+        memset(next.depthCm, 0, sizeof(next.depthCm));
+        next.soilCount = count;
+        for (uint8_t i = 0; i < count; i++) {
+            next.addr[i] = (char)payload[pos++];
+            next.depthCm[i] = payload[pos++];
+        }
+        // The encoder keeps zeros for missing probes
+        for (uint8_t i = count; i < BINLOG_SOIL_MAX; i++) {
+            memset(next.soil[i], 0, sizeof(next.soil[i]));
+        }
+    }
+    for (uint8_t i = 0; i < next.soilCount; i++) {
+        for (int k = 0; k < DELTA_SOIL_FIELDS; k++) {
+            if (!getDelta(payload, len, pos, d)) return false;
+            next.soil[i][k] = (int32_t)(prev.soil[i][k] + d);
+        }
+    }
+    next.sinceKey = key ? 1 : prev.sinceKey + 1;
+    next.valid = true;
+    return true;
+}
+
+// A keyframe carries its length; a delta frame ends where its fields do
+static size_t decodeFrame(DeltaState& st, bool key, const uint8_t* buf, size_t len,
+                          BinlogRecord& out) {
+    DeltaState zero;
+    deltaReset(zero);
+    DeltaState next;
+    const uint8_t* payload;
+    size_t n;
+
+    if (key) {
+        if (len < 3) return 0;
+        n = buf[2];
+        if (n > DELTA_PAYLOAD_MAX || 3 + n + 2 > len) return 0;
+        payload = buf + 3;
+        size_t pos;
+        if (!parsePayload(zero, true, payload, n, pos, next) || pos != n) return 0;
+    } else {
+        if (!st.valid) return 0;
+        payload = buf;
+        size_t limit = len < DELTA_PAYLOAD_MAX ? len : DELTA_PAYLOAD_MAX;
+        if (!parsePayload(st, false, payload, limit, n, next) || n + 2 > len) return 0;
+    }
+    uint16_t crc = payload[n] | (uint16_t)payload[n + 1] << 8;
+    if (frameCrc(payload, n) != crc) return 0;
+
+    memset(&out, 0, sizeof(out));
+    out.epoch = next.epoch;
+    out.packetId = next.packetId;
+    float* f[DELTA_FIELDS - 1] = { &out.tempAire, &out.humAire, &out.tempSuelo, &out.vwcSuelo,
+                                   &out.ecSuelo, &out.par, &out.vBat };
+    for (int i = 0; i < DELTA_FIELDS - 1; i++) *f[i] = dequantize(next.q[i], fieldScale[i]);
+    out.batPercent = (uint8_t)next.q[DELTA_FIELDS - 1];
+    out.soilCount = next.soilCount;
+    for (uint8_t i = 0; i < next.soilCount; i++) {
+        out.soil[i].addr = next.addr[i];
+        out.soil[i].depthCm = next.depthCm[i];
+        out.soil[i].vwc = dequantize(next.soil[i][0], soilScale[0]);
+        out.soil[i].temp = dequantize(next.soil[i][1], soilScale[1]);
+        out.soil[i].ec = dequantize(next.soil[i][2], soilScale[2]);
+    }
+
+    st = next;
+    return (key ? 3 : 0) + n + 2;
+}
+
+size_t deltaDecode(DeltaState& st, const uint8_t* buf, size_t len, BinlogRecord& out) {
+    // A delta frame can start with the sync bytes too; it then fails as a
+    // keyframe (length or CRC) and is read as a delta
+    if (len >= 2 && buf[0] == DELTA_SYNC0 && buf[1] == DELTA_SYNC1) {
+        size_t n = decodeFrame(st, true, buf, len, out);
+        if (n > 0) return n;
+    }
+    return decodeFrame(st, false, buf, len, out);
+}
+
+size_t deltaFindKeyframe(const uint8_t* buf, size_t len, size_t from) {
+    for (size_t i = from; i + 1 < len; i++) {
+        if (buf[i] != DELTA_SYNC0 || buf[i + 1] != DELTA_SYNC1) continue;
+        DeltaState st;
+        BinlogRecord r;
+        deltaReset(st);
+        if (decodeFrame(st, true, buf + i, len - i, r) > 0) return i;
+    }
+    return len;
+}
@@ -0,0 +1,104 @@
+/**
+ * Delta Log Implementation
+ */
+
+#include "delta_log.h"
+#include "binlog.h"
+#include <SD.h>
+
+#define DELTA_SECTOR 512
+
+static File dltFile;
+static bool dltOpen = false;
+static DeltaState dltState;
+static uint8_t dltBuf[DELTA_LOG_BUF];
+static size_t dltBufLen = 0;
+static uint32_t dltSize = 0;        // bytes on the card (= offset of dltBuf[0])
+static uint32_t dltRecords = 0;     // appended since open
+static uint32_t dltBytes = 0;
+static char dltPath[BINLOG_PATH_LEN] = "";
+
+// Encoder state as of the last complete write (survives deep sleep)
+RTC_DATA_ATTR static DeltaState rtcState;
+RTC_DATA_ATTR static char rtcPath[BINLOG_PATH_LEN];
+RTC_DATA_ATTR static uint32_t rtcSize = 0;
+
+static bool writeOut(size_t n) {
+    if (n == 0) return true;
+    if (dltFile.write(dltBuf, n) != n) {
+        Serial.println("[Delta] Write failed");
+        deltaLogClose();
+        return false;
+    }
+    dltSize += n;
+    dltBufLen -= n;
+    memmove(dltBuf, dltBuf + n, dltBufLen);
+    return true;
+}
+
+bool deltaLogOpen(const char* path) {
+    deltaLogClose();
+    strlcpy(dltPath, path, sizeof(dltPath));
+    dltFile = SD.open(dltPath, FILE_APPEND);
+    if (!dltFile) {
+        Serial.println("[Delta] Open failed");
+        return false;
+    }
+    dltOpen = true;
+    dltBufLen = 0;
+    dltRecords = 0;
+    dltBytes = 0;
+    dltSize = dltFile.size();
+
+    if (rtcState.valid && rtcSize == dltSize && strcmp(rtcPath, dltPath) == 0) {
+        dltState = rtcState;
+    } else {
+        deltaReset(dltState);  // next frame is a keyframe
+    }
+    return true;
+}
+
+void deltaLogClose() {
+    if (dltOpen) dltFile.close();
+    dltOpen = false;
+    dltBufLen = 0;
+}
+
+bool deltaLogAppend(const MeteorDataPacket& data, uint32_t epoch) {
+    if (!dltOpen) return false;
+
+    BinlogRecord rec;
+    binlogRecordFromPacket(data, epoch, rec);
+
+    if (dltBufLen + DELTA_FRAME_MAX > sizeof(dltBuf) && !deltaLogFlush(false)) return false;
+    size_t n = deltaEncode(dltState, rec, dltBuf + dltBufLen, sizeof(dltBuf) - dltBufLen);
+    if (n == 0) return false;
+    dltBufLen += n;
+    dltRecords++;
+    dltBytes += n;
+
+    // Whole sectors only; the tail waits for more frames or a flush
+    uint32_t end = (dltSize + dltBufLen) & ~(uint32_t)(DELTA_SECTOR - 1);
+    return end <= dltSize || writeOut(end - dltSize);
+}
+
+bool deltaLogFlush(bool sync) {
+    if (!dltOpen) return false;
+    if (!writeOut(dltBufLen)) return false;
+    if (sync) dltFile.flush();
+
+    rtcState = dltState;
+    strlcpy(rtcPath, dltPath, sizeof(rtcPath));
+    rtcSize = dltSize;
+    return true;
+}
+
+void deltaLogPrintStatus() {
+    if (!dltOpen) {
+        Serial.println("Delta: closed");
+        return;
+    }
+    Serial.printf("Delta: %s %lu B, %u records since open (%.1f B/record), %u B buffered\n",
+                  dltPath, (unsigned long)(dltSize + dltBufLen), dltRecords,
+                  dltRecords ? (float)dltBytes / dltRecords : 0.0f, (unsigned)dltBufLen);
+}
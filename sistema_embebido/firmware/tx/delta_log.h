@@ -0,0 +1,37 @@
+/**
+ * Delta Log - compressed .dlt file next to each CSV segment
+ *
+ * Appends every measurement as a delta frame (delta_codec.h), about a
+ * quarter of the bytes of its CSV line. Frames are collected in RAM and
+ * written in whole 512-byte sectors; the tail goes out at the durability
+ * points.
+ *
+ * The encoder state is kept in RTC memory together with the file size it
+ * belongs to, so a deep-sleep wake continues the delta chain instead of
+ * starting with a keyframe. Any mismatch (cold boot, torn write) just
+ * starts a new keyframe.
+ *
+ * Driven by sd_logger like the binary log; enabled with SD_DELTA_ENABLED.
+ */
+
+#ifndef TX_DELTA_LOG_H
+#define TX_DELTA_LOG_H
+
+#include <Arduino.h>
+#include "delta_codec.h"
+#include "../shared/config.h"
+
+#define DELTA_LOG_BUF   1024    // RAM buffer (two sectors)
+
+// Open (or create) `path` for appending
+bool deltaLogOpen(const char* path);
+void deltaLogClose();
+
+bool deltaLogAppend(const MeteorDataPacket& data, uint32_t epoch);
+
+// Write everything buffered; `sync` also fsyncs
+bool deltaLogFlush(bool sync);
+
+void deltaLogPrintStatus();
+
+#endif
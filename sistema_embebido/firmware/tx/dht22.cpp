@@ -0,0 +1,150 @@
+/**
+ * DHT22 Driver Implementation (ESP-IDF legacy RMT RX driver)
+ */
+
+#include "dht22.h"
+#include "dht22_decode.h"
+#include <driver/rmt.h>
+
+// RX-capable channel on the ESP32-S3 (4-7); 2 memory blocks = 96 items,
+// the frame needs ~43 (start + response + 40 bits).
+#define DHT22_RMT_CHANNEL  RMT_CHANNEL_4
+#define DHT22_RMT_BLOCKS   2
+#define DHT22_MAX_RUNS     (DHT22_RMT_BLOCKS * 48 * 2)
+
+enum DhtState { DHT_IDLE, DHT_RECEIVING };
+
+static gpio_num_t dhtPin = GPIO_NUM_NC;
+static RingbufHandle_t dhtRing = NULL;
+static DhtState dhtState = DHT_IDLE;
+static unsigned long dhtStartTime = 0;
+static unsigned long dhtLastRequest = 0;
+static bool dhtEverRequested = false;
+
+static float cachedTemp = NAN;
+static float cachedHum = NAN;
+static unsigned long cachedTime = 0;
+static bool cachedValid = false;
+
+static Dht22Callback dhtCallback = NULL;
+uint32_t dht22ErrorCount = 0;
+
+bool dht22Begin(uint8_t pin) {
+    dhtPin = (gpio_num_t)pin;
+
+    rmt_config_t cfg = RMT_DEFAULT_CONFIG_RX(dhtPin, DHT22_RMT_CHANNEL);
+    cfg.clk_div = 80;                          // 1 us per tick
+    cfg.mem_block_num = DHT22_RMT_BLOCKS;
+    cfg.rx_config.idle_threshold = 200;        // 200 us without edges ends the frame
+    cfg.rx_config.filter_en = true;
+    cfg.rx_config.filter_ticks_thresh = 100;   // ignore glitches < ~1.25 us (APB ticks)
+
+    if (rmt_config(&cfg) != ESP_OK ||
+        rmt_driver_install(DHT22_RMT_CHANNEL, 1024, 0) != ESP_OK ||
+        rmt_get_ringbuf_handle(DHT22_RMT_CHANNEL, &dhtRing) != ESP_OK) {
+        Serial.println("[DHT22] RMT init failed");
+        return false;
+    }
+
+    // Open drain so the same pin drives the start pulse and feeds the RMT
+    gpio_set_direction(dhtPin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(dhtPin, GPIO_PULLUP_ONLY);
+    gpio_set_level(dhtPin, 1);
+    return true;
+}
+
+static void drainRing() {
+    size_t len = 0;
+    void* item;
+    while ((item = xRingbufferReceive(dhtRing, &len, 0)) != NULL) {
+        vRingbufferReturnItem(dhtRing, item);
+    }
+}
+
+bool dht22Request() {
+    if (!dhtRing || dhtState != DHT_IDLE) return false;
+    if (dhtEverRequested && millis() - dhtLastRequest < DHT22_MIN_INTERVAL_MS) return false;
+
+    drainRing();
+
+    // Host start signal: hold the line low >= 1 ms, then release. The RMT is
+    // armed before the release so the 80 us response is captured.
+    gpio_set_level(dhtPin, 0);
+    delayMicroseconds(1100);
+    rmt_rx_start(DHT22_RMT_CHANNEL, true);
+    gpio_set_level(dhtPin, 1);
+
+    dhtState = DHT_RECEIVING;
+    dhtStartTime = millis();
+    dhtLastRequest = dhtStartTime;
+    dhtEverRequested = true;
+    return true;
+}
+
+static void finish(bool ok, float t, float h) {
+    rmt_rx_stop(DHT22_RMT_CHANNEL);
+    dhtState = DHT_IDLE;
+
+    if (ok) {
+        cachedTemp = t;
+        cachedHum = h;
+        cachedTime = millis();
+        cachedValid = true;
+    } else {
+        dht22ErrorCount++;
+    }
+    if (dhtCallback) dhtCallback(ok, t, h);
+}
+
+bool dht22Poll() {
+    if (dhtState != DHT_RECEIVING) return false;
+
+    size_t len = 0;
+    rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(dhtRing, &len, 0);
+    if (!items) {
+        if (millis() - dhtStartTime > DHT22_FRAME_TIMEOUT_MS) {
+            Serial.println("[DHT22] Timeout");
+            finish(false, NAN, NAN);
+            return true;
+        }
+        return false;
+    }
+
+    // Each RMT item holds two level/duration runs; a zero duration ends the frame
+    static Dht22Run runs[DHT22_MAX_RUNS];
+    size_t n = 0;
+    size_t itemCount = len / sizeof(rmt_item32_t);
+    for (size_t i = 0; i < itemCount && n + 2 <= DHT22_MAX_RUNS; i++) {
+        if (items[i].duration0 == 0) break;
+        runs[n++] = { (uint8_t)items[i].level0, (uint16_t)items[i].duration0 };
+        if (items[i].duration1 == 0) break;
+        runs[n++] = { (uint8_t)items[i].level1, (uint16_t)items[i].duration1 };
+    }
+    vRingbufferReturnItem(dhtRing, items);
+
+    float t = NAN, h = NAN;
+    Dht22Status st = dht22DecodeRuns(runs, n, t, h);
+    if (st != DHT22_OK) {
+        Serial.printf("[DHT22] Decode error %d (%u runs)\n", st, (unsigned)n);
+    }
+    finish(st == DHT22_OK, t, h);
+    return true;
+}
+
+bool dht22Busy() {
+    return dhtState != DHT_IDLE;
+}
+
+void dht22GetCached(float& temperature, float& humidity) {
+    if (!cachedValid || millis() - cachedTime > DHT22_STALE_MS) {
+        temperature = NAN;
+        humidity = NAN;
+        return;
+    }
+    temperature = cachedTemp;
+    humidity = cachedHum;
+}
+
+void dht22SetCallback(Dht22Callback cb) {
+    dhtCallback = cb;
+}
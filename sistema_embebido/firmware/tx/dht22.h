@@ -0,0 +1,45 @@
+/**
+ * DHT22 Driver (RMT capture)
+ *
+ * Replaces the bit-banged Adafruit DHT library, which disabled interrupts for
+ * ~5 ms per read (SDI-12 soft serial, AsyncTCP and the radio IRQ suffered).
+ * The host start pulse is driven on the GPIO; the sensor's 40-bit frame is
+ * captured by the ESP32-S3 RMT receiver and decoded by dht22DecodeRuns().
+ *
+ * Usage: dht22Request() starts a conversion (ignored if the previous one was
+ * less than DHT22_MIN_INTERVAL_MS ago), dht22Poll() advances it from loop(),
+ * dht22GetCached() returns the last good reading.
+ */
+
+#ifndef TX_DHT22_H
+#define TX_DHT22_H
+
+#include <Arduino.h>
+
+#define DHT22_MIN_INTERVAL_MS  2000    // sensor needs 2 s between conversions
+#define DHT22_FRAME_TIMEOUT_MS 50      // start → complete frame
+#define DHT22_STALE_MS         300000  // cached reading expires after 5 min
+
+// Optional completion callback (runs from dht22Poll, i.e. loop context)
+typedef void (*Dht22Callback)(bool ok, float temperature, float humidity);
+
+bool dht22Begin(uint8_t pin);
+
+// Start a conversion. Returns false if one is running or the sensor is
+// still inside its minimum interval (the cached reading stays valid).
+bool dht22Request();
+
+// Advance the capture. Returns true once when a conversion finishes.
+bool dht22Poll();
+
+bool dht22Busy();
+
+// Last good reading; NAN if none or older than DHT22_STALE_MS
+void dht22GetCached(float& temperature, float& humidity);
+
+void dht22SetCallback(Dht22Callback cb);
+
+// Failed conversions since boot
+extern uint32_t dht22ErrorCount;
+
+#endif
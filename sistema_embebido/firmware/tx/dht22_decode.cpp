@@ -0,0 +1,57 @@
+/**
+ * DHT22 Frame Decoder Implementation
+ */
+
+#include "dht22_decode.h"
+
+// Pulse width limits (us), with margin for sensor and capture tolerance
+#define DHT22_RESP_MIN   50
+#define DHT22_RESP_MAX   110
+#define DHT22_BIT_LOW_MIN  30
+#define DHT22_BIT_LOW_MAX  90
+#define DHT22_BIT_HIGH_MIN 10
+#define DHT22_BIT_HIGH_MAX 95
+#define DHT22_BIT_ONE_US   48  // HIGH longer than this is a 1
+
+static inline bool inRange(uint16_t v, uint16_t lo, uint16_t hi) {
+    return v >= lo && v <= hi;
+}
+
+Dht22Status dht22DecodeRuns(const Dht22Run* runs, size_t count,
+                            float& temperature, float& humidity) {
+    // Find the response preamble: LOW ~80us followed by HIGH ~80us.
+    // Anything before it (host start pulse, release edge) is skipped.
+    size_t i = 0;
+    bool found = false;
+    for (; i + 1 < count; i++) {
+        if (runs[i].level == 0 && runs[i + 1].level == 1 &&
+            inRange(runs[i].us, DHT22_RESP_MIN, DHT22_RESP_MAX) &&
+            inRange(runs[i + 1].us, DHT22_RESP_MIN, DHT22_RESP_MAX)) {
+            found = true;
+            i += 2;
+            break;
+        }
+    }
+    if (!found) return DHT22_ERR_NO_RESPONSE;
+
+    uint8_t data[5] = {0, 0, 0, 0, 0};
+    for (int bit = 0; bit < 40; bit++, i += 2) {
+        if (i + 1 >= count) return DHT22_ERR_SHORT;
+        const Dht22Run& lo = runs[i];
+        const Dht22Run& hi = runs[i + 1];
+        if (lo.level != 0 || hi.level != 1) return DHT22_ERR_TIMING;
+        if (!inRange(lo.us, DHT22_BIT_LOW_MIN, DHT22_BIT_LOW_MAX)) return DHT22_ERR_TIMING;
+        if (!inRange(hi.us, DHT22_BIT_HIGH_MIN, DHT22_BIT_HIGH_MAX)) return DHT22_ERR_TIMING;
+
+        data[bit / 8] <<= 1;
+        if (hi.us > DHT22_BIT_ONE_US) data[bit / 8] |= 1;
+    }
+
+    uint8_t sum = (uint8_t)(data[0] + data[1] + data[2] + data[3]);
+    if (sum != data[4]) return DHT22_ERR_CHECKSUM;
+
+    humidity = ((data[0] << 8) | data[1]) * 0.1f;
+    float t = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+    temperature = (data[2] & 0x80) ? -t : t;
+    return DHT22_OK;
+}
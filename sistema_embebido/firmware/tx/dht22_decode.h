@@ -0,0 +1,36 @@
+/**
+ * DHT22 Frame Decoder
+ *
+ * Turns the level/duration runs captured from the DHT22 data line into a
+ * temperature/humidity reading. Pure function, no Arduino/IDF dependency,
+ * so it can be built and exercised on the host with recorded captures.
+ *
+ * Frame (after the host start pulse):
+ *   response: LOW ~80us, HIGH ~80us
+ *   40 bits:  LOW ~50us, then HIGH ~26-28us (0) or ~70us (1)
+ *   data:     hum16, temp16 (bit 15 = sign), checksum8
+ */
+
+#ifndef TX_DHT22_DECODE_H
+#define TX_DHT22_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct Dht22Run {
+    uint8_t level;    // 0 = low, 1 = high
+    uint16_t us;      // duration in microseconds
+};
+
+enum Dht22Status {
+    DHT22_OK = 0,
+    DHT22_ERR_NO_RESPONSE,  // response preamble not found
+    DHT22_ERR_SHORT,        // fewer than 40 bits captured
+    DHT22_ERR_TIMING,       // pulse width out of spec
+    DHT22_ERR_CHECKSUM
+};
+
+Dht22Status dht22DecodeRuns(const Dht22Run* runs, size_t count,
+                            float& temperature, float& humidity);
+
+#endif
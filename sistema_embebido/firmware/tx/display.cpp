@@ -13,9 +13,11 @@
 #include "display.h"
 #include "sd_logger.h"
 #include "rtc.h"
+#include "clock.h"
 #include "wifi_manager.h"
 #include "server_client.h"
 #include "sensors.h"
+#include "../shared/oled_tiles.h"
 #include <WiFi.h>
 
 // Display Instance
@@ -34,8 +36,8 @@ int popupSelection = 0;
 int scrIndex = 2; // Default 15m
 unsigned long lastInteraction = 0;
 
-// Intervals
-unsigned long measureInterval = 60000;  // 1 min default
+// Intervals (RTC memory: kept across deep sleep)
+RTC_DATA_ATTR unsigned long measureInterval = 60000;  // 1 min default
 
 // Config Options
 const unsigned long measureValues[] = {10000, 60000, 300000, 600000, 1800000};
@@ -151,7 +153,7 @@ void drawSDStatus() {
     display.drawStr(0, 10, "3. ESTADO SD");
     
     char buf[32];
-    sprintf(buf, "Status: %s", sdStatusMsg.c_str());
+    sprintf(buf, "Status: %s", sdStatusMsg);
     display.drawStr(0, 25, buf);
     
     if (sdConnected) {
@@ -210,24 +212,23 @@ void drawRTC() {
     display.setFont(u8g2_font_6x10_tr);
     display.drawStr(0, 10, "5. RELOJ (RTC)");
     
-    if (!rtcIsRunning()) {
+    if (!clockValid()) {
         display.drawStr(0, 30, "RTC no disponible");
         display.drawStr(0, 45, "Verificar conexion");
         return;
     }
     
-    RtcTime t = rtcGetTime();
     char buf[32];
     
     // Large time display
     display.setFont(u8g2_font_ncenB14_tr);
-    sprintf(buf, "%02d:%02d:%02d", t.hour, t.minute, t.second);
+    clockFormatTime(buf, sizeof(buf));
     int w = display.getStrWidth(buf);
     display.drawStr(64 - (w/2), 35, buf);
     
     // Date below
     display.setFont(u8g2_font_6x10_tr);
-    sprintf(buf, "%02d/%02d/%04d", t.day, t.month, t.year);
+    clockFormatDate(buf, sizeof(buf));
     w = display.getStrWidth(buf);
     display.drawStr(64 - (w/2), 52, buf);
     
@@ -291,11 +292,87 @@ void drawPopup(const char* title, const char* opts[], int count, int sel) {
 }
 
 
+// Progress bar width (time until next send), -1 when hidden
+static int progressWidth(unsigned long lastSendTime, unsigned long sendIntervalMs) {
+    if (uiState == UI_POPUP || currentScreen == 4) return -1;
+    int prog = map(millis() - lastSendTime, 0, sendIntervalMs, 0, 128);
+    return prog > 128 ? 128 : prog;
+}
+
+// Hash of everything the current screen shows. The frame is rebuilt only
+// when it changes.
+static uint32_t screenKey(const MeteorDataPacket& data, int prog) {
+    extern unsigned long sendInterval;
+    uint32_t h = OLED_KEY_INIT;
+    oledKeyMix(h, &currentScreen, sizeof(currentScreen));
+    oledKeyMix(h, &uiState, sizeof(uiState));
+    oledKeyMix(h, &editCursor, sizeof(editCursor));
+    oledKeyMix(h, &popupSelection, sizeof(popupSelection));
+    oledKeyMix(h, &prog, sizeof(prog));
+
+    switch (currentScreen) {
+        case 0:
+            oledKeyMix(h, &data.tempAire, sizeof(data.tempAire));
+            oledKeyMix(h, &data.humAire, sizeof(data.humAire));
+            oledKeyMix(h, &data.vwcSuelo, sizeof(data.vwcSuelo));
+            oledKeyMix(h, &data.tempSuelo, sizeof(data.tempSuelo));
+            oledKeyMix(h, &data.ecSuelo, sizeof(data.ecSuelo));
+            oledKeyMix(h, &data.batPercent, sizeof(data.batPercent));
+            oledKeyMix(h, &parRawMV, sizeof(parRawMV));
+            break;
+        case 1: {
+            int status = WiFi.status();
+            int rssi = WiFi.RSSI();
+            int pending = getPendingCount();
+            oledKeyMix(h, &status, sizeof(status));
+            oledKeyMix(h, &rssi, sizeof(rssi));
+            oledKeyMix(h, &wifiConnected, sizeof(wifiConnected));
+            oledKeyMix(h, &serverEnabled, sizeof(serverEnabled));
+            oledKeyMix(h, &lastServerOk, sizeof(lastServerOk));
+            oledKeyMix(h, &pending, sizeof(pending));
+            break;
+        }
+        case 2:
+            oledKeyMix(h, &sdConnected, sizeof(sdConnected));
+            oledKeyMix(h, &sdTotalSpace, sizeof(sdTotalSpace));
+            oledKeyMix(h, &sdWriteCount, sizeof(sdWriteCount));
+            oledKeyMix(h, sdStatusMsg, strlen(sdStatusMsg));
+            break;
+        case 3:
+            oledKeyMix(h, &measureInterval, sizeof(measureInterval));
+            oledKeyMix(h, &sendInterval, sizeof(sendInterval));
+            oledKeyMix(h, &scrIndex, sizeof(scrIndex));
+            break;
+        case 4: {
+            uint32_t epoch = clockNowEpoch();
+            oledKeyMix(h, &epoch, sizeof(epoch));
+            break;
+        }
+        case 5:
+            oledKeyMix(h, &data.vBat, sizeof(data.vBat));
+            oledKeyMix(h, &data.batPercent, sizeof(data.batPercent));
+            break;
+    }
+    return h;
+}
+
 void renderScreen(const MeteorDataPacket& data, unsigned long lastSendTime, unsigned long sendIntervalMs) {
+    static unsigned long lastFrameTime = 0;
+    static uint32_t lastKey = 0;
+    static bool keyValid = false;
+
     if (!isScreenOn) {
-        delay(100);
+        keyValid = false; // redraw on wake
         return;
     }
+    if (millis() - lastFrameTime < OLED_MIN_FRAME_MS) return;
+    lastFrameTime = millis();
+
+    int prog = progressWidth(lastSendTime, sendIntervalMs);
+    uint32_t key = screenKey(data, prog);
+    if (keyValid && key == lastKey) return;
+    lastKey = key;
+    keyValid = true;
     
     display.clearBuffer();
     switch (currentScreen) {
@@ -314,10 +391,6 @@ void renderScreen(const MeteorDataPacket& data, unsigned long lastSendTime, unsi
     }
     
     // Progress bar (time until next send)
-    if (uiState != UI_POPUP && currentScreen != 4) {
-        int prog = map(millis() - lastSendTime, 0, sendIntervalMs, 0, 128);
-        if (prog > 128) prog = 128;
-        display.drawHLine(0, 63, prog);
-    }
-    display.sendBuffer();
+    if (prog >= 0) display.drawHLine(0, 63, prog);
+    oledFlush(display);
 }
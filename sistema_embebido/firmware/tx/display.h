@@ -50,7 +50,8 @@ void drawRTC();
 void drawConfig();
 void drawPopup(const char* title, const char* opts[], int count, int sel);
 
-// Full screen render cycle
+// Render cycle: redraws only when the screen's inputs change (at most every
+// OLED_MIN_FRAME_MS) and sends only the dirty tiles
 void renderScreen(const MeteorDataPacket& data, unsigned long lastSendTime, unsigned long sendInterval);
 
 #endif
@@ -0,0 +1,244 @@
+/**
+ * History Download Implementation
+ */
+
+#include "history.h"
+#include "binlog.h"
+#include "clock.h"
+#include "delta_codec.h"
+#include "journal_format.h"
+#include "log_segments.h"
+#include "sd_logger.h"
+#include <SD.h>
+#include <esp_timer.h>
+#include <new>
+
+#define HISTORY_RECORD_ROOM 160     // longest CSV line or delta frame
+#define HISTORY_FILLS_PER_READ 8    // empty batches (filtered out) before giving up a call
+
+struct HistoryCursor {
+    uint32_t from;
+    uint32_t to;
+    HistoryFormat format;
+    bool seeked;                // seg/segEnd set (first chunk)
+    uint32_t seg;               // manifest entry being read
+    uint32_t segEnd;
+    bool segOpen;               // st/next/path belong to entry `seg`
+    char path[LOG_SEG_PATH_LEN];
+    BinlogState st;             // snapshot taken when the segment was reached
+    uint32_t next;              // next record index in it
+    DeltaState delta;
+    uint8_t stage[HISTORY_STAGE];
+    size_t stageLen;
+    size_t stagePos;
+    bool done;                  // nothing left to read from the card
+    bool finished;              // everything was sent
+    uint32_t records;
+    uint32_t bytes;
+    unsigned long startMs;
+};
+
+static uint8_t active = 0;      // async_tcp task only
+
+static uint32_t downloads = 0;
+static uint32_t aborted = 0;
+static uint32_t busyRetries = 0;
+static uint32_t lastRecords = 0;
+static uint32_t lastBytes = 0;
+static uint32_t lastMs = 0;
+static uint32_t chunkMaxUs = 0;
+
+static bool readFile(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    File* f = (File*)ctx;
+    return f->seek(offset) && f->read(buf, len) == len;
+}
+
+static void emit(HistoryCursor* c, const BinlogRecord& rec) {
+    uint8_t* out = c->stage + c->stageLen;
+    size_t room = HISTORY_STAGE - c->stageLen;
+    size_t n = 0;
+
+    if (c->format == HISTORY_DELTA) {
+        n = deltaEncode(c->delta, rec, out, room);
+    } else {
+        char ts[CLOCK_TS_LEN];
+        clockFormatEpoch(rec.epoch, ts, sizeof(ts));
+        int len = snprintf((char*)out, room, "%s,%lu,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%u\n",
+                           ts, (unsigned long)rec.packetId,
+                           rec.tempAire, rec.humAire,
+                           rec.tempSuelo, rec.vwcSuelo,
+                           rec.ecSuelo, rec.par,
+                           rec.vBat, (unsigned)rec.batPercent);
+        if (len > 0 && (size_t)len < room) n = len;
+    }
+    if (n == 0) return;
+    c->stageLen += n;
+    c->records++;
+}
+
+static void endSegment(HistoryCursor* c) {
+    c->segOpen = false;
+    c->seg++;
+}
+
+// Position on entry `seg`: skip it if it cannot hold the range, otherwise
+// snapshot its .bin and seek to `from` through the index
+static void openSegment(HistoryCursor* c) {
+    if (c->seg >= c->segEnd) {
+        c->done = true;
+        return;
+    }
+    LogSegment s;
+    if (!logSegEntry(c->seg, s) || s.records == 0) {
+        c->seg++;
+        return;
+    }
+    // Entry epochs only bound the records while segments are in time order
+    if (logSegTimeSorted()) {
+        if (s.firstEpoch > c->to) {
+            c->done = true;
+            return;
+        }
+        if (s.lastEpoch < c->from) {
+            c->seg++;
+            return;
+        }
+    }
+
+    logSegPath(s, "bin", c->path, sizeof(c->path));
+    File reader;
+    BinlogIo io;
+    if (!binlogOpenReader(c->path, reader, c->st, io)) {
+        c->seg++;
+        return;
+    }
+    c->next = binlogFindTime(io, c->st, c->from);
+    reader.close();
+    c->segOpen = true;
+}
+
+// One chunk from the card: at most HISTORY_BATCH steps under sdLock()
+static bool fill(HistoryCursor* c) {
+    if (!sdTryLock(HISTORY_LOCK_WAIT_MS)) return false;
+    int64_t t0 = esp_timer_get_time();
+
+    if (!c->seeked) {
+        c->seg = logSegSeek(c->from);
+        c->segEnd = logSegEnd();
+        c->seeked = true;
+    }
+
+    File reader;
+    BinlogIo io = { &reader, readFile };
+    for (uint32_t step = 0; step < HISTORY_BATCH && !c->done &&
+         HISTORY_STAGE - c->stageLen >= HISTORY_RECORD_ROOM; step++) {
+        if (!c->segOpen) {
+            if (reader) reader.close();
+            openSegment(c);
+            continue;
+        }
+        if (c->next >= c->st.count) {
+            endSegment(c);
+            continue;
+        }
+        if (!reader && !(reader = SD.open(c->path, FILE_READ))) {
+            endSegment(c);
+            continue;
+        }
+
+        BinlogRecord rec;
+        if (!binlogReadRecord(io, c->next++, rec)) continue;  // torn slot
+        if (rec.epoch > c->to) {
+            // Sorted file: the rest of it is later too
+            if (c->st.epochSorted) {
+                endSegment(c);
+                if (logSegTimeSorted()) c->done = true;
+            }
+            continue;
+        }
+        if (rec.epoch >= c->from) emit(c, rec);
+    }
+    if (reader) reader.close();
+    sdUnlock();
+
+    uint32_t us = esp_timer_get_time() - t0;
+    if (us > chunkMaxUs) chunkMaxUs = us;
+
+    // Let the loop and storage tasks (lower priority than async_tcp) run
+    vTaskDelay(pdMS_TO_TICKS(HISTORY_YIELD_MS));
+    return true;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+HistoryCursor* historyOpen(uint32_t from, uint32_t to, HistoryFormat format) {
+    if (active >= HISTORY_MAX_ACTIVE || !sdConnected) return NULL;
+    HistoryCursor* c = new (std::nothrow) HistoryCursor;
+    if (!c) return NULL;
+
+    memset(c, 0, sizeof(*c));
+    c->from = from;
+    c->to = to;
+    c->format = format;
+    c->startMs = millis();
+    deltaReset(c->delta);  // the stream starts with a keyframe
+    if (format == HISTORY_CSV) {
+        c->stageLen = snprintf((char*)c->stage, HISTORY_STAGE, JNL_CSV_COLUMNS "\n");
+    }
+
+    active++;
+    downloads++;
+    Serial.printf("[History] %s %lu..%lu\n", format == HISTORY_CSV ? "csv" : "bin",
+                  (unsigned long)from, (unsigned long)to);
+    return c;
+}
+
+size_t historyRead(HistoryCursor* c, uint8_t* buf, size_t maxLen) {
+    if (maxLen == 0) return HISTORY_TRY_AGAIN;
+
+    // Batches can come back empty (records outside the range in an
+    // unsorted file); give the connection back after a few
+    for (int i = 0; c->stagePos == c->stageLen; i++) {
+        c->stagePos = 0;
+        c->stageLen = 0;
+        if (c->done) {
+            c->finished = true;
+            return 0;
+        }
+        if (i == HISTORY_FILLS_PER_READ) return HISTORY_TRY_AGAIN;
+        if (!fill(c)) {
+            busyRetries++;
+            return HISTORY_TRY_AGAIN;
+        }
+    }
+
+    size_t n = c->stageLen - c->stagePos;
+    if (n > maxLen) n = maxLen;
+    memcpy(buf, c->stage + c->stagePos, n);
+    c->stagePos += n;
+    c->bytes += n;
+    return n;
+}
+
+void historyClose(HistoryCursor* c) {
+    if (!c) return;
+    lastRecords = c->records;
+    lastBytes = c->bytes;
+    lastMs = millis() - c->startMs;
+    if (!c->finished) aborted++;
+    Serial.printf("[History] %s: %lu records, %lu bytes in %lu ms\n",
+                  c->finished ? "Done" : "Aborted", (unsigned long)lastRecords,
+                  (unsigned long)lastBytes, (unsigned long)lastMs);
+    delete c;
+    if (active > 0) active--;
+}
+
+void historyPrintStatus() {
+    Serial.printf("History: %lu downloads (%lu aborted), last %lu records / %lu B in %lu ms, "
+                  "chunk max %lu us, %lu busy retries\n",
+                  (unsigned long)downloads, (unsigned long)aborted, (unsigned long)lastRecords,
+                  (unsigned long)lastBytes, (unsigned long)lastMs, (unsigned long)chunkMaxUs,
+                  (unsigned long)busyRetries);
+}
@@ -0,0 +1,54 @@
+/**
+ * History Download - time range of the SD log over HTTP
+ *
+ * GET /history?from=<epoch>&to=<epoch>&format=csv|bin streams the records
+ * of that range as a chunked response:
+ *
+ *   csv   the columns of the segment CSV, without the journal frame
+ *   bin   delta frames (delta_codec.h) starting with a keyframe, the same
+ *         stream as a .dlt file: `binlog_tool dlt-csv` reads it
+ *
+ * Records come from the binary logs. The start is found through the
+ * manifest and the binlog index (O(log n) reads, no scan of older data);
+ * after that the slots are read in order. Nothing stays open between
+ * chunks: each one takes sdLock(), reopens the .bin, reads at most
+ * HISTORY_BATCH slots into a HISTORY_STAGE-byte buffer and releases the
+ * card, so the storage task keeps writing and a remount in the middle of a
+ * download is harmless. The measurement loop never waits on the card.
+ *
+ * One download at a time; the cursor is freed when the response ends or the
+ * client goes away.
+ */
+
+#ifndef TX_HISTORY_H
+#define TX_HISTORY_H
+
+#include <Arduino.h>
+
+#define HISTORY_STAGE       1024    // formatted bytes waiting to be sent
+#define HISTORY_BATCH       16      // slot reads per chunk (bounds sdLock time)
+#define HISTORY_LOCK_WAIT_MS 20     // card busy: the chunk is retried later
+#define HISTORY_YIELD_MS    2       // pause after each chunk read from the card
+#define HISTORY_MAX_ACTIVE  1
+
+enum HistoryFormat {
+    HISTORY_CSV,
+    HISTORY_DELTA
+};
+
+struct HistoryCursor;
+
+// Start a download of [from, to]. NULL if the card is not mounted or
+// another download is running.
+HistoryCursor* historyOpen(uint32_t from, uint32_t to, HistoryFormat format);
+
+// Fill `buf` with up to `maxLen` bytes. Returns 0 at the end and
+// HISTORY_TRY_AGAIN while the card is busy.
+#define HISTORY_TRY_AGAIN 0xFFFFFFFF
+size_t historyRead(HistoryCursor* c, uint8_t* buf, size_t maxLen);
+
+void historyClose(HistoryCursor* c);
+
+void historyPrintStatus();
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * Journaled CSV Lines Implementation
+ */
+
+#include "journal_format.h"
+#include <stdio.h>
+#include <string.h>
+
+#define JNL_CRC_HEX 8
+
+static uint32_t crcOf(const char* p, size_t len, uint32_t seed) {
+    return binlogCrc32((const uint8_t*)p, len, seed);
+}
+
+// Decimal / hex fields of exactly the bytes [p, p + len)
+static bool parseDec(const char* p, size_t len, uint32_t& out) {
+    if (len == 0 || len > 10) return false;
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        v = v * 10 + (p[i] - '0');
+    }
+    if (v > 0xFFFFFFFFULL) return false;
+    out = (uint32_t)v;
+    return true;
+}
+
+static bool parseHex(const char* p, size_t len, uint32_t& out) {
+    if (len != JNL_CRC_HEX) return false;
+    uint32_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = p[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else return false;
+        v = (v << 4) | d;
+    }
+    out = v;
+    return true;
+}
+
+// Last ',' in [p, p + len), or -1
+static long lastComma(const char* p, size_t len) {
+    for (size_t i = len; i > 0; i--) {
+        if (p[i - 1] == ',') return (long)(i - 1);
+    }
+    return -1;
+}
+
+static size_t findNewline(const char* buf, size_t from, size_t n) {
+    const void* p = memchr(buf + from, '\n', n - from);
+    return p ? (const char*)p - buf : n;
+}
+
+size_t journalFrame(char* buf, size_t len, size_t size, uint32_t fileId, uint32_t* crc) {
+    if (len >= size) return 0;
+    uint32_t c = crcOf(buf, len, fileId);
+    int n = snprintf(buf + len, size - len, ",%u,%08lx\n", (unsigned)len, (unsigned long)c);
+    if (n <= 0 || len + n >= size) return 0;
+    if (crc) *crc = c;
+    return len + n;
+}
+
+size_t journalCommit(uint32_t records, uint32_t offset, uint32_t fileId, char* buf, size_t size) {
+    int n = snprintf(buf, size, JNL_COMMIT_TAG "%lu,%lu",
+                     (unsigned long)records, (unsigned long)offset);
+    if (n <= 0 || (size_t)n >= size) return 0;
+    uint32_t crc = crcOf(buf, n, fileId);
+    int m = snprintf(buf + n, size - n, ",%08lx\n", (unsigned long)crc);
+    if (m <= 0 || (size_t)(n + m) >= size) return 0;
+    return n + m;
+}
+
+JournalLine journalCheckLine(const char* line, size_t len, uint32_t offset, uint32_t fileId,
+                             uint32_t* records) {
+    long c = lastComma(line, len);
+    uint32_t crc;
+    if (c < 0 || !parseHex(line + c + 1, len - c - 1, crc)) return JNL_BAD;
+
+    size_t tagLen = sizeof(JNL_COMMIT_TAG) - 1;
+    if (len > tagLen && memcmp(line, JNL_COMMIT_TAG, tagLen) == 0) {
+        if (crcOf(line, c, fileId) != crc) return JNL_BAD;
+        long c2 = lastComma(line, c);
+        uint32_t count, at;
+        if (c2 < (long)tagLen ||
+            !parseDec(line + tagLen, c2 - tagLen, count) ||
+            !parseDec(line + c2 + 1, c - c2 - 1, at) ||
+            at != offset) {
+            return JNL_BAD;
+        }
+        if (records) *records = count;
+        return JNL_COMMIT;
+    }
+
+    long c2 = lastComma(line, c);
+    uint32_t payloadLen;
+    if (c2 < 0 || !parseDec(line + c2 + 1, c - c2 - 1, payloadLen) ||
+        payloadLen != (uint32_t)c2 || crcOf(line, c2, fileId) != crc) {
+        return JNL_BAD;
+    }
+    return JNL_RECORD;
+}
+
+bool journalRecover(const BinlogIo& io, uint32_t size, char* buf, JournalRecovery& out) {
+    memset(&out, 0, sizeof(out));
+    out.journaled = true;
+    out.recordsKnown = true;
+    if (size == 0) return true;
+
+    // Header, and the file id: CRC of the first record right after it
+    size_t h = size < JNL_HEAD_READ ? size : JNL_HEAD_READ;
+    if (!io.read(io.ctx, 0, (uint8_t*)buf, h)) return false;
+    out.scanned = h;
+
+    size_t e1 = findNewline(buf, 0, h);
+    size_t oldLen = sizeof(JNL_CSV_COLUMNS) - 1;
+    size_t newLen = sizeof(JNL_CSV_HEADER) - 2;
+    if (e1 == h) {
+        out.validSize = 0;  // torn header: start the file over
+        return true;
+    }
+    if (e1 == oldLen && memcmp(buf, JNL_CSV_COLUMNS, oldLen) == 0) {
+        out.journaled = false;
+        out.validSize = size;
+        return true;
+    }
+    if (e1 != newLen || memcmp(buf, JNL_CSV_HEADER, newLen) != 0) {
+        out.validSize = 0;
+        return true;
+    }
+
+    uint32_t first = e1 + 1;  // offset of the first record
+    bool haveId = false;
+    size_t e2 = findNewline(buf, first, h);
+    if (e2 < h && journalCheckLine(buf + first, e2 - first, first, 0, NULL) == JNL_RECORD) {
+        parseHex(buf + e2 - JNL_CRC_HEX, JNL_CRC_HEX, out.fileId);
+        haveId = true;
+    }
+    uint32_t id = out.fileId;
+
+    uint32_t start = size > JNL_SCAN_WINDOW ? size - JNL_SCAN_WINDOW : 0;
+    size_t n = size - start;
+    if (!io.read(io.ctx, start, (uint8_t*)buf, n)) return false;
+    out.scanned += n;
+
+    // Last commit marker in the window (seed and offset authenticate it)
+    size_t pos = n;
+    uint32_t records = 0;
+    for (size_t i = haveId ? n : 0; i > 0; i--) {
+        size_t at = i - 1;
+        if (buf[at] != '#' || (at > 0 && buf[at - 1] != '\n')) continue;
+        size_t e = findNewline(buf, at, n);
+        if (e == n) continue;
+        if (journalCheckLine(buf + at, e - at, start + at, id, &records) == JNL_COMMIT) {
+            pos = e + 1;
+            out.checkpoint = true;
+            break;
+        }
+    }
+
+    if (!out.checkpoint) {
+        records = 0;
+        if (start == 0) {
+            pos = first;
+        } else {
+            // No marker in the window: resync on the first valid line
+            out.recordsKnown = false;
+            size_t e = findNewline(buf, 0, n);
+            pos = n;
+            while (e < n) {
+                size_t s = e + 1;
+                e = findNewline(buf, s, n);
+                if (e == n) break;
+                if (journalCheckLine(buf + s, e - s, start + s, id, NULL) != JNL_BAD) {
+                    pos = s;
+                    break;
+                }
+            }
+            if (pos == n) {
+                // Nothing checks out in the tail: leave the file as it is
+                out.validSize = size;
+                return true;
+            }
+        }
+    }
+
+    // Forward over valid lines; the first bad or unterminated one ends the log
+    while (pos < n) {
+        size_t e = findNewline(buf, pos, n);
+        if (e == n) break;
+        uint32_t marked;
+        uint32_t seed = start + pos == first ? 0 : id;
+        JournalLine t = journalCheckLine(buf + pos, e - pos, start + pos, seed, &marked);
+        if (t == JNL_BAD) break;
+        if (t == JNL_RECORD) {
+            records++;
+        } else {
+            records = marked;
+            out.recordsKnown = true;
+        }
+        pos = e + 1;
+    }
+
+    out.validSize = start + pos;
+    out.records = records;
+    return true;
+}
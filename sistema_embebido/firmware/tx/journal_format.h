@@ -0,0 +1,81 @@
+/**
+ * Journaled CSV Lines
+ *
+ * Every data line of a CSV segment ends with two extra columns, the length
+ * of the payload before them and its CRC32, so a line torn by a power cut
+ * (or glued to the next one after a reboot) fails the check. The CRC of the
+ * first record is the file id; the CRCs of later records and of commit
+ * markers are seeded with it, so lines of an older segment left in a
+ * reused cluster do not check out in this one:
+ *
+ *   2026-01-15 10:00:00,42,21.50,...,3.91,87,81,1a2b3c4d
+ *
+ * Every JNL_COMMIT_EVERY records, and at each durability point, a commit
+ * marker notes how many records precede it and its own file offset:
+ *
+ *   #commit,512,48200,9f00aa12
+ *
+ * A marker only counts at the offset it names. Recovery reads the first
+ * record (for the file id) and the last JNL_SCAN_WINDOW bytes, starts at the
+ * last valid marker there and walks forward over valid lines; whatever
+ * follows the last one is garbage to truncate. The cost is the same for a
+ * 1 KB and a 4 MB file.
+ *
+ * Files with the old header (JNL_CSV_COLUMNS alone, written before this
+ * format) are left alone; any other first line is a torn header and the
+ * file starts over.
+ *
+ * No Arduino/IDF (built by tools/journal_tool).
+ */
+
+#ifndef TX_JOURNAL_FORMAT_H
+#define TX_JOURNAL_FORMAT_H
+
+#include "binlog_format.h"
+
+#define JNL_CSV_COLUMNS     "timestamp,packetId,tempAir,humAir,tempGnd,vwcGnd,ecGnd,par,vBat,batPct"
+#define JNL_HEADER_TAIL     ",len,crc"
+#define JNL_CSV_HEADER      JNL_CSV_COLUMNS JNL_HEADER_TAIL "\n"
+#define JNL_COMMIT_TAG      "#commit,"
+#define JNL_FRAME_MAX       14      // ",<len>,<crc>\n" added to a payload
+#define JNL_COMMIT_EVERY    16      // records between commit markers
+#define JNL_SCAN_WINDOW     8192    // recovery reads at most this tail
+#define JNL_HEAD_READ       512     // ...and this much for the header and first record
+
+enum JournalLine {
+    JNL_BAD,
+    JNL_RECORD,
+    JNL_COMMIT
+};
+
+struct JournalRecovery {
+    uint32_t validSize;     // bytes to keep
+    uint32_t records;       // data lines before validSize (if recordsKnown)
+    uint32_t scanned;       // bytes read
+    uint32_t fileId;        // CRC of the first record (seeds commit markers)
+    bool recordsKnown;      // false: no marker inside the window
+    bool checkpoint;        // the walk started at a commit marker
+    bool journaled;         // false: pre-journal file, nothing to truncate
+};
+
+// Frame the payload in buf[0..len): appends ",<len>,<crc>\n". `fileId` is 0
+// for the first record of a file; `crc` (optional) receives the CRC, which
+// for that record is the file id. Returns the line length, 0 if it does
+// not fit in `size` bytes.
+size_t journalFrame(char* buf, size_t len, size_t size, uint32_t fileId, uint32_t* crc = NULL);
+
+// Commit marker line for a file offset (with '\n'; 0 if it does not fit)
+size_t journalCommit(uint32_t records, uint32_t offset, uint32_t fileId, char* buf, size_t size);
+
+// Check one line (without its '\n') that starts at file offset `offset`
+// (`fileId` 0 for the first record). For a commit marker, `records`
+// receives its record count.
+JournalLine journalCheckLine(const char* line, size_t len, uint32_t offset, uint32_t fileId,
+                             uint32_t* records);
+
+// Valid end of a journaled file of `size` bytes: reads the first two lines
+// and the last JNL_SCAN_WINDOW bytes. `buf` must hold JNL_SCAN_WINDOW bytes.
+// Returns false if the file cannot be read.
+bool journalRecover(const BinlogIo& io, uint32_t size, char* buf, JournalRecovery& out);
+
+#endif
@@ -0,0 +1,379 @@
+/**
+ * Log Segments Implementation
+ */
+
+#include "log_segments.h"
+#include "binlog.h"
+#include "rtc.h"
+#include "sd_logger.h"
+#include <SD.h>
+
+#define MF_MAGIC        0x4745534DUL  // "MSEG"
+#define MF_VERSION      1
+#define MF_SLOT         32
+#define MF_CRC_OFFSET   (MF_SLOT - 4)
+#define MF_TIME_SORTED  0x0001        // header: segments never overlap in time
+#define SEG_DELETED     0x0001        // entry: removed by retention
+
+static bool segReady = false;
+static uint32_t mfFirstLive = 0;  // oldest entry not deleted
+static uint32_t mfCount = 0;      // entries in the manifest
+static uint32_t mfFlags = 0;
+
+static LogSegment cur;            // entry mfCount - 1
+static bool curValid = false;
+static bool curDirty = false;
+static uint32_t prevLastEpoch = 0;
+
+static inline void put16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void put32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline uint16_t get16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+static inline uint32_t get32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+// ============================================
+// Manifest I/O
+// ============================================
+
+static bool writeSlot(uint32_t offset, uint8_t* slot) {
+    put32(slot + MF_CRC_OFFSET, binlogCrc32(slot, MF_CRC_OFFSET));
+    File f = SD.open(LOG_SEG_MANIFEST, "r+");
+    if (!f) return false;
+    bool ok = f.seek(offset) && f.write(slot, MF_SLOT) == MF_SLOT;
+    f.close();
+    return ok;
+}
+
+static bool writeHeader() {
+    uint8_t slot[MF_SLOT];
+    memset(slot, 0, sizeof(slot));
+    put32(slot, MF_MAGIC);
+    put16(slot + 4, MF_VERSION);
+    put16(slot + 6, MF_SLOT);
+    put32(slot + 8, mfFirstLive);
+    put32(slot + 12, mfFlags);
+    return writeSlot(0, slot);
+}
+
+static bool writeEntry(uint32_t index, const LogSegment& s) {
+    uint8_t slot[MF_SLOT];
+    put32(slot, s.date);
+    put16(slot + 4, s.part);
+    put16(slot + 6, s.flags);
+    put32(slot + 8, s.firstEpoch);
+    put32(slot + 12, s.lastEpoch);
+    put32(slot + 16, s.records);
+    put32(slot + 20, s.minPacket);
+    put32(slot + 24, s.maxPacket);
+    return writeSlot(MF_SLOT * (1 + index), slot);
+}
+
+static bool readSlot(File& f, uint32_t offset, uint8_t* slot) {
+    return f.seek(offset) && f.read(slot, MF_SLOT) == MF_SLOT &&
+           get32(slot + MF_CRC_OFFSET) == binlogCrc32(slot, MF_CRC_OFFSET);
+}
+
+static bool readEntry(File& f, uint32_t index, LogSegment& s) {
+    if (index == mfCount - 1 && curValid) {
+        s = cur;
+        return true;
+    }
+    uint8_t slot[MF_SLOT];
+    if (!readSlot(f, MF_SLOT * (1 + index), slot)) return false;
+    s.date = get32(slot);
+    s.part = get16(slot + 4);
+    s.flags = get16(slot + 6);
+    s.firstEpoch = get32(slot + 8);
+    s.lastEpoch = get32(slot + 12);
+    s.records = get32(slot + 16);
+    s.minPacket = get32(slot + 20);
+    s.maxPacket = get32(slot + 24);
+    return true;
+}
+
+static void segmentPath(const LogSegment& s, const char* ext, char* buf, size_t size) {
+    if (s.part == 0) {
+        snprintf(buf, size, LOG_SEG_DIR "/%08lu.%s", (unsigned long)s.date, ext);
+    } else {
+        snprintf(buf, size, LOG_SEG_DIR "/%08lu_%u.%s", (unsigned long)s.date, s.part, ext);
+    }
+}
+
+static uint32_t dateOf(uint32_t epoch) {
+    RtcTime t = rtcEpochToTime(epoch);
+    return t.year * 10000UL + t.month * 100UL + t.day;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+bool logSegBegin() {
+    segReady = false;
+    curValid = false;
+    curDirty = false;
+    SD.mkdir(LOG_SEG_DIR);
+
+    File f = SD.open(LOG_SEG_MANIFEST, FILE_READ);
+    uint8_t slot[MF_SLOT];
+    if (f && readSlot(f, 0, slot) && get32(slot) == MF_MAGIC && get16(slot + 6) == MF_SLOT) {
+        mfFirstLive = get32(slot + 8);
+        mfFlags = get32(slot + 12);
+        mfCount = (f.size() - MF_SLOT) / MF_SLOT;  // a torn last entry is rewritten
+        if (mfCount > 0 && readEntry(f, mfCount - 1, cur)) {
+            curValid = true;
+            prevLastEpoch = cur.lastEpoch;
+        }
+        f.close();
+    } else {
+        if (f) f.close();
+        File nf = SD.open(LOG_SEG_MANIFEST, FILE_WRITE);
+        if (!nf) {
+            Serial.println("[LogSeg] Cannot create manifest");
+            return false;
+        }
+        nf.close();
+        mfFirstLive = 0;
+        mfCount = 0;
+        mfFlags = MF_TIME_SORTED;
+        if (!writeHeader()) return false;
+    }
+    if (mfFirstLive > mfCount) mfFirstLive = mfCount;
+
+    segReady = true;
+    logSegRetention();
+    Serial.printf("[LogSeg] %u segments (%u live)\n", mfCount, mfCount - mfFirstLive);
+    return true;
+}
+
+bool logSegRoll(uint32_t epoch, uint32_t csvSize) {
+    if (!segReady) return false;
+
+    uint32_t date = dateOf(epoch);
+    if (curValid && cur.date == date && csvSize < LOG_SEG_MAX_BYTES) return false;
+
+    logSegSync();
+
+    LogSegment next;
+    memset(&next, 0, sizeof(next));
+    next.date = date;
+    if (curValid && date == cur.date) {
+        next.part = cur.part + 1;
+    } else if (curValid && date < cur.date) {
+        // Clock moved back to a day that may already have files: the entry
+        // index cannot collide with a size-capped part number
+        next.part = mfCount;
+    }
+    next.firstEpoch = epoch;
+    next.lastEpoch = epoch;
+    next.minPacket = UINT32_MAX;
+
+    if (!writeEntry(mfCount, next)) {
+        Serial.println("[LogSeg] Manifest write failed");
+        return false;
+    }
+    if (curValid) prevLastEpoch = cur.lastEpoch;
+    cur = next;
+    curValid = true;
+    curDirty = false;
+    mfCount++;
+
+    char path[LOG_SEG_PATH_LEN];
+    segmentPath(cur, "csv", path, sizeof(path));
+    Serial.printf("[LogSeg] New segment %s\n", path);
+
+    logSegRetention();
+    return true;
+}
+
+void logSegCsvPath(char* buf, size_t size) {
+    if (curValid) segmentPath(cur, "csv", buf, size);
+    else if (size) buf[0] = '\0';
+}
+
+void logSegBinPath(char* buf, size_t size) {
+    if (curValid) segmentPath(cur, "bin", buf, size);
+    else if (size) buf[0] = '\0';
+}
+
+void logSegDeltaPath(char* buf, size_t size) {
+    if (curValid) segmentPath(cur, "dlt", buf, size);
+    else if (size) buf[0] = '\0';
+}
+
+void logSegNote(uint32_t epoch, uint32_t packetId) {
+    if (!curValid) return;
+    if (cur.records == 0) {
+        cur.firstEpoch = epoch;
+        if (epoch < prevLastEpoch && (mfFlags & MF_TIME_SORTED)) {
+            mfFlags &= ~MF_TIME_SORTED;
+            writeHeader();
+        }
+    } else if (epoch < cur.lastEpoch && (mfFlags & MF_TIME_SORTED)) {
+        mfFlags &= ~MF_TIME_SORTED;
+        writeHeader();
+    }
+    cur.records++;
+    cur.lastEpoch = epoch;
+    if (packetId < cur.minPacket) cur.minPacket = packetId;
+    if (packetId > cur.maxPacket) cur.maxPacket = packetId;
+    curDirty = true;
+}
+
+void logSegSync() {
+    if (!segReady || !curValid || !curDirty) return;
+    if (writeEntry(mfCount - 1, cur)) curDirty = false;
+}
+
+void logSegRetention() {
+    if (!segReady) return;
+
+    uint64_t minFree = (uint64_t)LOG_SEG_MIN_FREE_MB * 1024 * 1024;
+    uint64_t freeBytes = SD.totalBytes() - SD.usedBytes();
+    uint32_t removed = 0;
+
+    // The current segment is never deleted
+    while (freeBytes < minFree && mfFirstLive + 1 < mfCount) {
+        File f = SD.open(LOG_SEG_MANIFEST, FILE_READ);
+        LogSegment s;
+        bool ok = f && readEntry(f, mfFirstLive, s);
+        if (f) f.close();
+
+        if (ok) {
+            char path[LOG_SEG_PATH_LEN];
+            segmentPath(s, "csv", path, sizeof(path));
+            SD.remove(path);
+            segmentPath(s, "bin", path, sizeof(path));
+            SD.remove(path);
+            segmentPath(s, "dlt", path, sizeof(path));
+            SD.remove(path);
+            s.flags |= SEG_DELETED;
+            writeEntry(mfFirstLive, s);
+        }
+        mfFirstLive++;
+        removed++;
+        freeBytes = SD.totalBytes() - SD.usedBytes();
+    }
+
+    if (removed > 0) {
+        writeHeader();
+        Serial.printf("[LogSeg] Retention removed %u segment(s), %llu MB free\n",
+                      removed, (unsigned long long)(freeBytes / (1024 * 1024)));
+    }
+}
+
+// ============================================
+// Lookups
+// ============================================
+
+// First live entry that reaches `epoch`: binary search while segments are
+// in time order, otherwise the first live one
+static uint32_t seekEntry(File& f, uint32_t epoch) {
+    uint32_t lo = mfFirstLive, hi = mfCount;
+    if (mfFlags & MF_TIME_SORTED) {
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            LogSegment s;
+            if (readEntry(f, mid, s) && s.lastEpoch < epoch) lo = mid + 1;
+            else hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool lookupTime(uint32_t epoch, BinlogRecord& out) {
+    if (!segReady || mfFirstLive >= mfCount) return false;
+    File f = SD.open(LOG_SEG_MANIFEST, FILE_READ);
+    if (!f) return false;
+
+    bool found = false;
+    char path[LOG_SEG_PATH_LEN];
+    for (uint32_t i = seekEntry(f, epoch); i < mfCount && !found; i++) {
+        LogSegment s;
+        if (!readEntry(f, i, s) || s.records == 0 || s.lastEpoch < epoch) continue;
+        segmentPath(s, "bin", path, sizeof(path));
+        found = binlogLookupTime(path, epoch, out);
+    }
+    f.close();
+    return found;
+}
+
+static bool lookupPacket(uint32_t packetId, BinlogRecord& out) {
+    if (!segReady) return false;
+    File f = SD.open(LOG_SEG_MANIFEST, FILE_READ);
+    if (!f) return false;
+
+    // packetId restarts on cold boots: check every segment whose range has it
+    bool found = false;
+    char path[LOG_SEG_PATH_LEN];
+    for (uint32_t i = mfFirstLive; i < mfCount && !found; i++) {
+        LogSegment s;
+        if (!readEntry(f, i, s) || s.records == 0) continue;
+        if (packetId < s.minPacket || packetId > s.maxPacket) continue;
+        segmentPath(s, "bin", path, sizeof(path));
+        found = binlogLookupPacket(path, packetId, out);
+    }
+    f.close();
+    return found;
+}
+
+// The storage task appends to the same files
+bool logSegLookupTime(uint32_t epoch, BinlogRecord& out) {
+    sdLock();
+    bool found = lookupTime(epoch, out);
+    sdUnlock();
+    return found;
+}
+
+bool logSegLookupPacket(uint32_t packetId, BinlogRecord& out) {
+    sdLock();
+    bool found = lookupPacket(packetId, out);
+    sdUnlock();
+    return found;
+}
+
+uint32_t logSegSeek(uint32_t epoch) {
+    if (!segReady || mfFirstLive >= mfCount) return mfCount;
+    File f = SD.open(LOG_SEG_MANIFEST, FILE_READ);
+    if (!f) return mfCount;
+    uint32_t i = seekEntry(f, epoch);
+    f.close();
+    return i;
+}
+
+uint32_t logSegEnd() {
+    return segReady ? mfCount : 0;
+}
+
+bool logSegEntry(uint32_t index, LogSegment& out) {
+    if (!segReady || index < mfFirstLive || index >= mfCount) return false;
+    File f = SD.open(LOG_SEG_MANIFEST, FILE_READ);
+    if (!f) return false;
+    bool ok = readEntry(f, index, out) && !(out.flags & SEG_DELETED);
+    f.close();
+    return ok;
+}
+
+void logSegPath(const LogSegment& s, const char* ext, char* buf, size_t size) {
+    segmentPath(s, ext, buf, size);
+}
+
+bool logSegTimeSorted() {
+    return (mfFlags & MF_TIME_SORTED) != 0;
+}
+
+uint32_t logSegCount() {
+    return mfCount - mfFirstLive;
+}
+
+void logSegPrintStatus() {
+    if (!segReady) {
+        Serial.println("Segments: not mounted");
+        return;
+    }
+    char path[LOG_SEG_PATH_LEN];
+    logSegCsvPath(path, sizeof(path));
+    Serial.printf("Segments: %u live, %u deleted, current %s (%u records), %s\n",
+                  mfCount - mfFirstLive, mfFirstLive, curValid ? path : "-",
+                  curValid ? cur.records : 0,
+                  (mfFlags & MF_TIME_SORTED) ? "time-sorted" : "time unsorted");
+}
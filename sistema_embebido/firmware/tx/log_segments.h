@@ -0,0 +1,80 @@
+/**
+ * Log Segments - per-day data files with a manifest and retention
+ *
+ * The CSV, binary and delta logs are split into segments under /log, one
+ * per RTC day (/log/20260115.csv + .bin + .dlt), with extra parts (_1,
+ * _2...) when a day outgrows LOG_SEG_MAX_BYTES. Files stay small, so append and open cost do
+ * not depend on how much history is on the card, and a bad cluster only
+ * takes out one segment.
+ *
+ * /log/manifest.dat lists every segment (32-byte CRC-checked entries at
+ * fixed offsets): date, part, first/last epoch, record count and packetId
+ * range. Boot reads the header and the last entry; lookups binary-search the
+ * entries. No directory listing is ever needed.
+ *
+ * Retention deletes the oldest segments while free space is below
+ * LOG_SEG_MIN_FREE_MB (checked at boot and when a segment rolls over).
+ */
+
+#ifndef TX_LOG_SEGMENTS_H
+#define TX_LOG_SEGMENTS_H
+
+#include <Arduino.h>
+#include "binlog_format.h"
+
+#define LOG_SEG_DIR          "/log"
+#define LOG_SEG_MANIFEST     "/log/manifest.dat"
+#define LOG_SEG_MAX_BYTES    (4UL * 1024 * 1024)  // CSV size that starts a new part
+#define LOG_SEG_MIN_FREE_MB  64
+#define LOG_SEG_PATH_LEN     24
+
+struct LogSegment {
+    uint32_t date;        // YYYYMMDD (RTC local)
+    uint16_t part;
+    uint16_t flags;
+    uint32_t firstEpoch;
+    uint32_t lastEpoch;
+    uint32_t records;
+    uint32_t minPacket;
+    uint32_t maxPacket;
+};
+
+// Load the manifest and apply retention. Call once the card is mounted.
+bool logSegBegin();
+
+// True if a record at `epoch` must go to a new segment (new day, or the
+// current CSV has reached LOG_SEG_MAX_BYTES). Creates the manifest entry.
+bool logSegRoll(uint32_t epoch, uint32_t csvSize);
+
+// Paths of the current segment (empty until the first roll)
+void logSegCsvPath(char* buf, size_t size);
+void logSegBinPath(char* buf, size_t size);
+void logSegDeltaPath(char* buf, size_t size);
+
+// Account for a record written to the current segment
+void logSegNote(uint32_t epoch, uint32_t packetId);
+
+// Persist the current entry (durability points)
+void logSegSync();
+
+// Delete oldest segments while free space is low
+void logSegRetention();
+
+// Record lookups across segments
+bool logSegLookupTime(uint32_t epoch, BinlogRecord& out);
+bool logSegLookupPacket(uint32_t packetId, BinlogRecord& out);
+
+// Range reads (history downloads); the caller holds sdLock(). logSegSeek
+// returns the first live entry that can hold records at or after `epoch`
+// (binary search while segments are in time order), logSegEnd one past the
+// last entry. An entry removed by retention fails logSegEntry.
+uint32_t logSegSeek(uint32_t epoch);
+uint32_t logSegEnd();
+bool logSegEntry(uint32_t index, LogSegment& out);
+void logSegPath(const LogSegment& s, const char* ext, char* buf, size_t size);
+bool logSegTimeSorted();
+
+uint32_t logSegCount();
+void logSegPrintStatus();
+
+#endif
@@ -12,31 +12,123 @@
  *   - display: OLED UI
  *   - button: User input handling
  *   - rtc: Real time clock
+ *   - clock: Cached wall clock (esp_timer, RTC-disciplined)
+ *   - power: Deep-sleep duty cycle (optional operating mode)
  */
 
 #include <Arduino.h>
+#include <Preferences.h>
 #include "../shared/config.h"
 #include "sensors.h"
 #include "sd_logger.h"
+#include "binlog.h"
+#include "delta_log.h"
+#include "history.h"
+#include "log_segments.h"
 #include "display.h"
 #include "button.h"
 #include "rtc.h"
+#include "clock.h"
 #include "wifi_manager.h"
 #include "server_client.h"
+#include "upload_queue.h"
+#include "backfill.h"
 #include "battery.h"
+#include "power.h"
+#include "../shared/loop_stats.h"
+#include "../shared/oled_tiles.h"
+#include "../shared/uplink.h"
 
-// Current sensor readings
-MeteorDataPacket currentData;
+// Current sensor readings (RTC memory: last measurement is sent after sleep)
+RTC_DATA_ATTR MeteorDataPacket currentData;
 
 // Timing
 unsigned long lastMeasureTime = 0;
 unsigned long lastSendTime = 0;
 
 // Send interval (ms) - configurable via web interface
-unsigned long sendInterval = 60000;  // 1 minute default
+RTC_DATA_ATTR unsigned long sendInterval = 60000;  // 1 minute default
 
-// Packet counter
-unsigned long packetCounter = 0;
+// Packet counter (RTC memory: survives deep sleep)
+RTC_DATA_ATTR unsigned long packetCounter = 0;
+
+// Node id carried in every packet (the RX gateway keeps state per node).
+// Set with NODE,<id>; by default the last two bytes of the MAC.
+void loadNodeId() {
+    Preferences prefs;
+    prefs.begin("node-cfg", true);
+    uint16_t id = prefs.getUShort("id", 0);
+    prefs.end();
+    if (id == 0) {
+        uint64_t mac = ESP.getEfuseMac();
+        id = (uint16_t)(((mac >> 32) & 0xFF) << 8 | ((mac >> 40) & 0xFF));
+        if (id == 0) id = 1;
+    }
+    currentData.nodeId = id;
+}
+
+void takeMeasurement() {
+    currentData.packetId = ++packetCounter;
+
+    // Read battery
+    currentData.vBat = readBatteryVoltage();
+    currentData.batPercent = getBatteryPercent();
+
+    // Log to SD and queue for the next upload
+    logToSD(currentData);
+    serverQueueReading(currentData);
+    lastMeasureTime = millis();
+    powerMarkMeasured();
+
+    char ts[CLOCK_TS_LEN];
+    clockFormatTimestamp(ts, sizeof(ts));
+    Serial.printf("[%s] Measured: T=%.1f H=%.1f Bat=%.2fV (%d%%)\n", 
+                  ts, currentData.tempAire, currentData.humAire,
+                  currentData.vBat, currentData.batPercent);
+}
+
+// Timer wake in deep-sleep mode: no display, web server or config AP.
+// Measure and upload when due, then sleep again. Does not return.
+void runDutyCycle() {
+    rtcInit();
+    clockInit();
+    sensorsInit();
+    batteryInit();
+    sdInit();
+    serverClientInit();
+
+    // The RTC countdown is not phase-locked to its seconds register and can
+    // fire just before the boundary
+    uint32_t early = powerSecondsUntilDue();
+    if (early > 0 && early <= POWER_EARLY_WAKE_S) delay(early * 1000);
+
+    if (powerMeasureDue()) {
+        // VExt was off during sleep; give the DHT22 and probes time to boot
+        while (millis() < POWER_SENSOR_WARMUP_MS) {
+            clockLoop();
+            delay(1);
+        }
+        readSensors(currentData);
+        takeMeasurement();
+    }
+
+    if (powerSendDue() && packetCounter > 0) {
+        powerWifiOn();
+        wifiConnectSta(POWER_WIFI_TIMEOUT_MS);
+        // One budget for the whole wake: queue first, then backfill
+        unsigned long deadline = millis() + UPLINK_CYCLE_BUDGET_MS;
+        bool ok = serverUpload(UPQ_DUTY_DRAIN_MAX, deadline);  // readings stay queued when not connected
+        if (ok && getPendingCount() == 0) serverBackfill(BACKFILL_DUTY_BATCHES, deadline);
+        char ts[CLOCK_TS_LEN];
+        clockFormatTimestamp(ts, sizeof(ts));
+        Serial.printf("[%s] Server send: %s\n", ts, ok ? "OK" : "FAIL");
+        powerMarkSent();
+    }
+
+    uplinkClose();
+    sdSync();
+    powerSleep();
+}
 
 
 void setup() {
@@ -44,17 +136,24 @@ void setup() {
     Serial.println("\n=== TX WiFi Mode ===");
     
     // 1. Power Control
+    powerInit();
+    loadNodeId();
     pinMode(VEXT_CTRL, OUTPUT);
     digitalWrite(VEXT_CTRL, LOW); // Enable VExt
     pinMode(35, OUTPUT);
     digitalWrite(35, LOW); // LED Off
     delay(100);
     
+    if (powerMode == POWER_DEEP_SLEEP && powerWokeFromSleep() && !powerWokeByButton()) {
+        runDutyCycle();
+    }
+    
     // 2. Initialize Display first (for status messages)
     displayInit();
     
     // 3. Initialize RTC
     rtcInit();
+    clockInit();
     
     // 4. Initialize sensors
     sensorsInit();
@@ -67,19 +166,22 @@ void setup() {
     
     // 6. Initialize WiFi
     bool wifiOk = wifiInit();
+    powerWifiOn(); // STA or config AP: the radio is up either way
     delay(1000);
     
     // 7. Initialize web server
     webServerInit();
     
-    // 8. Initialize server client
+    // 8. Initialize server client and its uplink task
     serverClientInit();
+    serverClientStart();
     
     // 9. Initialize button
     buttonInit();
     lastInteraction = millis();
     
-    Serial.println("TX Ready. Commands: SET_TIME,YYYY,MM,DD,HH,MM,SS | GET_TIME");
+    Serial.println("TX Ready. Commands: SET_TIME,YYYY,MM,DD,HH,MM,SS | GET_TIME | POWER[,ON|,SLEEP] | NODE[,<id>]");
+    Serial.printf("Node id: %u\n", currentData.nodeId);
     if (wifiOk) {
         Serial.print("IP: ");
         Serial.println(WiFi.localIP());
@@ -106,30 +208,95 @@ void handleSerial() {
             
             if (idx == 6) {
                 rtcSetTime(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
+                clockSyncNow();
                 Serial.printf("RTC Set: %04d-%02d-%02d %02d:%02d:%02d\n",
                               parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
             } else {
                 Serial.println("Error: Use SET_TIME,YYYY,MM,DD,HH,MM,SS");
             }
         } else if (cmd == "GET_TIME") {
-            Serial.printf("RTC: %s\n", rtcGetTimestamp().c_str());
+            char ts[CLOCK_TS_LEN];
+            clockFormatTimestamp(ts, sizeof(ts));
+            ClockStats cs;
+            clockGetStats(cs);
+            Serial.printf("RTC: %s  Clock: %s\n", rtcGetTimestamp().c_str(), ts);
+            Serial.printf("Clock: err %ld us (max %ld), drift %ld ppm, slew pending %ld us, %u syncs, %u steps\n",
+                          (long)cs.lastErrorUs, (long)cs.maxAbsErrorUs, (long)cs.driftPpm,
+                          (long)cs.pendingSlewUs, cs.syncs, cs.steps);
         } else if (cmd == "SEND") {
             // Force send now
             readSensors(currentData);
             currentData.packetId = ++packetCounter;
-            sendToServer(currentData);
+            serverQueueReading(currentData);
+            serverRequestUpload();
+            powerMarkSent();
         } else if (cmd == "STATUS") {
             Serial.printf("WiFi: %s RSSI: %d\n", 
                          WiFi.status() == WL_CONNECTED ? "OK" : "DISC",
                          WiFi.RSSI());
-            Serial.printf("Server: %s Pending: %d\n",
+            Serial.printf("Server: %s Pending: %d (%s, %u dropped)\n",
                          lastServerOk ? "OK" : "FAIL",
-                         getPendingCount());
+                         getPendingCount(),
+                         uploadQueueDurable() ? "SD" : "RAM",
+                         uploadQueueDropped());
+            powerPrintStatus();
+            sdPrintStats();
+            logSegPrintStatus();
+            binlogPrintStatus();
+            deltaLogPrintStatus();
+            historyPrintStatus();
+            backfillPrintStatus();
+            uplinkPrintStatus();
+            LoopStats ls;
+            OledStats os;
+            loopStatsGet(ls);
+            oledGetStats(os);
+            Serial.printf("Loop: avg %u us, max %u us, %u/min\n", ls.avgUs, ls.maxUs, ls.loopsPerMin);
+            Serial.printf("OLED: %u frames/min, %u tiles/min, %u B/min (full frames: %u B/min)\n",
+                          os.framesPerMin, os.tilesPerMin, os.bytesPerMin, os.fullBytesPerMin);
+        } else if (cmd == "POWER,ON") {
+            powerSetMode(POWER_ALWAYS_ON);
+        } else if (cmd == "POWER,SLEEP") {
+            // Takes effect once the screen times out
+            powerSetMode(POWER_DEEP_SLEEP);
+        } else if (cmd == "POWER") {
+            powerPrintStatus();
+        } else if (cmd.startsWith("NODE,")) {
+            long id = cmd.substring(5).toInt();
+            if (id > 0 && id <= 0xFFFF) {
+                Preferences prefs;
+                prefs.begin("node-cfg", false);
+                prefs.putUShort("id", (uint16_t)id);
+                prefs.end();
+                currentData.nodeId = (uint16_t)id;
+                Serial.printf("Node id set to %u\n", currentData.nodeId);
+            } else {
+                Serial.println("Error: Use NODE,<1-65535>");
+            }
+        } else if (cmd == "NODE") {
+            Serial.printf("Node id: %u\n", currentData.nodeId);
+        } else if (cmd.startsWith("FIND,") && cmd.length() > 7) {
+            // FIND,T,<epoch> (first record at/after) | FIND,P,<packetId>
+            uint32_t v = strtoul(cmd.c_str() + 7, NULL, 10);
+            BinlogRecord r;
+            bool found = cmd.charAt(5) == 'P' ? logSegLookupPacket(v, r) : logSegLookupTime(v, r);
+            if (found) {
+                char ts[CLOCK_TS_LEN];
+                clockFormatEpoch(r.epoch, ts, sizeof(ts));
+                Serial.printf("[%s] #%u T=%.1f H=%.1f Tg=%.1f VWC=%.1f EC=%.0f PAR=%.0f Bat=%.2fV\n",
+                              ts, r.packetId, r.tempAire, r.humAire, r.tempSuelo,
+                              r.vwcSuelo, r.ecSuelo, r.par, r.vBat);
+            } else {
+                Serial.println("Not found");
+            }
         }
     }
 }
 
 void loop() {
+    loopStatsTick();
+    clockLoop();
+    
     // 1. Handle User Input
     handleButton();
     handleSerial();
@@ -140,44 +307,37 @@ void loop() {
     // 3. Maintain WiFi connection
     wifiLoop();
     
-    // 4. Measurement Cycle (every measureInterval)
-    if (millis() - lastMeasureTime > measureInterval || lastMeasureTime == 0) {
-        readSensors(currentData);
-        currentData.packetId = ++packetCounter;
-        
-        // Read battery
-        currentData.vBat = readBatteryVoltage();
-        currentData.batPercent = getBatteryPercent();
-        
-        // Log to SD
-        logToSD(currentData);
-        lastMeasureTime = millis();
-        
-        Serial.printf("[%s] Measured: T=%.1f H=%.1f Bat=%.2fV (%d%%)\n", 
-                      rtcGetTimestamp().c_str(), currentData.tempAire, currentData.humAire,
-                      currentData.vBat, currentData.batPercent);
+    // 4. Measurement Cycle (on measureInterval wall-clock boundaries)
+    // The acquisition runs as a state machine: start it when due, then keep
+    // polling so button, display and web server stay responsive meanwhile.
+    if (!sensorsBusy() && powerMeasureDue()) {
+        sensorsStartCycle();
     }
     
-    // 5. Server Send Cycle (every sendInterval)
-    if (millis() - lastSendTime > sendInterval || lastSendTime == 0) {
-        // Ensure fresh data
-        if (lastMeasureTime == 0 || millis() - lastMeasureTime > measureInterval) {
-            readSensors(currentData);
-            currentData.packetId = ++packetCounter;
-        }
-        
-        // Send to server
-        if (wifiConnected) {
-            bool ok = sendToServer(currentData);
-            Serial.printf("[%s] Server send: %s\n", 
-                         rtcGetTimestamp().c_str(), 
-                         ok ? "OK" : "FAIL");
-        }
+    if (sensorsPoll(currentData)) {
+        takeMeasurement();
+    }
+    
+    // 5. Server Send Cycle (on sendInterval boundaries)
+    // Waits for an in-flight measurement so the uploaded data is fresh.
+    if (powerSendDue() && lastMeasureTime != 0 && !sensorsBusy()) {
+        // Send to server (uplink task; loop() does not wait for it)
+        if (wifiConnected) serverRequestUpload();
         
         lastSendTime = millis();
+        powerMarkSent();
     }
     
     // 6. Render Display
     renderScreen(currentData, lastSendTime, sendInterval);
     
+    // 7. Deep-sleep mode: the interactive session (cold boot or button wake)
+    // ends when the screen times out
+    if (powerMode == POWER_DEEP_SLEEP && !isScreenOn && !sensorsBusy()) {
+        // Let the uplink task finish its request first; a hung one keeps
+        // the connection lock, and deep sleep drops the connection anyway
+        if (serverClientStop()) uplinkClose();
+        sdSync();
+        powerSleep();
+    }
 }
@@ -0,0 +1,170 @@
+/**
+ * PAR Continuous ADC Implementation (ESP-IDF adc_digi DMA driver)
+ */
+
+#include "par_adc.h"
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+#define PAR_DMA_FRAME_BYTES (PAR_DMA_DECIMATION * SOC_ADC_DIGI_RESULT_BYTES)
+
+static esp_adc_cal_characteristics_t adcChars;
+static uint8_t parChannel = 0;
+static volatile bool parRunning = false;
+static TaskHandle_t parTask = NULL;
+
+// Window accumulator (shared with the sampling task, guarded by parMux)
+static portMUX_TYPE parMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t winSum = 0;         // Σ raw codes
+static uint32_t winSamples = 0;
+static uint16_t winMin = 0xFFFF;
+static uint16_t winMax = 0;
+static uint32_t winOverruns = 0;
+static unsigned long winStart = 0;
+
+// Decimation block (sampling task only)
+static uint32_t blockSum = 0;
+static uint16_t blockCount = 0;
+
+static void accumulateFrame(const uint8_t* buf, uint32_t len) {
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t* p = (const adc_digi_output_data_t*)&buf[i];
+        if (p->type2.unit != 0 || p->type2.channel != parChannel) continue;
+
+        blockSum += p->type2.data;
+        if (++blockCount < PAR_DMA_DECIMATION) continue;
+
+        // Block complete: fold into the window
+        uint16_t blockMean = blockSum / blockCount;
+        portENTER_CRITICAL(&parMux);
+        winSum += blockSum;
+        winSamples += blockCount;
+        if (blockMean < winMin) winMin = blockMean;
+        if (blockMean > winMax) winMax = blockMean;
+        portEXIT_CRITICAL(&parMux);
+
+        blockSum = 0;
+        blockCount = 0;
+    }
+}
+
+static void parAdcTask(void* arg) {
+    static uint8_t buf[PAR_DMA_FRAME_BYTES];
+
+    for (;;) {
+        if (!parRunning) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        uint32_t len = 0;
+        esp_err_t err = adc_digi_read_bytes(buf, sizeof(buf), &len, 100);
+
+        // INVALID_STATE: the driver pool overflowed; the returned data is valid
+        if (err == ESP_ERR_INVALID_STATE) {
+            portENTER_CRITICAL(&parMux);
+            winOverruns++;
+            portEXIT_CRITICAL(&parMux);
+        }
+        if ((err == ESP_OK || err == ESP_ERR_INVALID_STATE) && len > 0) {
+            accumulateFrame(buf, len);
+        }
+    }
+}
+
+bool parAdcBegin(uint8_t pin) {
+    int8_t ch = digitalPinToAnalogChannel(pin);
+    if (ch < 0 || ch >= SOC_ADC_MAX_CHANNEL_NUM) {
+        Serial.printf("[PAR] GPIO%d is not an ADC1 pin, DMA disabled\n", pin);
+        return false;
+    }
+    parChannel = ch;
+
+    adc_digi_init_config_t initCfg = {};
+    initCfg.max_store_buf_size = PAR_DMA_FRAME_BYTES * 4;
+    initCfg.conv_num_each_intr = PAR_DMA_FRAME_BYTES;
+    initCfg.adc1_chan_mask = BIT(parChannel);
+    initCfg.adc2_chan_mask = 0;
+
+    if (adc_digi_initialize(&initCfg) != ESP_OK) {
+        Serial.println("[PAR] adc_digi_initialize failed");
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_ATTEN_DB_11;
+    pattern.channel = parChannel;
+    pattern.unit = 0; // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_digi_configuration_t cfg = {};
+    cfg.conv_limit_en = false;
+    cfg.conv_limit_num = 250;
+    cfg.pattern_num = 1;
+    cfg.adc_pattern = &pattern;
+    cfg.sample_freq_hz = PAR_DMA_SAMPLE_HZ;
+    cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+
+    if (adc_digi_controller_configure(&cfg) != ESP_OK) {
+        Serial.println("[PAR] adc_digi_controller_configure failed");
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adcChars);
+
+    winStart = millis();
+    adc_digi_start();
+    parRunning = true;
+    xTaskCreate(parAdcTask, "par_adc", 3072, NULL, 2, &parTask);
+
+    Serial.printf("[PAR] DMA sampling at %d Hz (ADC1 ch%d)\n", PAR_DMA_SAMPLE_HZ, parChannel);
+    return true;
+}
+
+bool parAdcTakeWindow(ParWindow& out) {
+    unsigned long now = millis();
+
+    portENTER_CRITICAL(&parMux);
+    uint64_t sum = winSum;
+    uint32_t n = winSamples;
+    out.minRaw = winMin;
+    out.maxRaw = winMax;
+    out.overruns = winOverruns;
+    winSum = 0;
+    winSamples = 0;
+    winMin = 0xFFFF;
+    winMax = 0;
+    portEXIT_CRITICAL(&parMux);
+
+    out.samples = n;
+    out.durationMs = now - winStart;
+    winStart = now;
+
+    if (n == 0) return false;
+    out.meanRawQ8 = (uint32_t)((sum << 8) / n);
+    return true;
+}
+
+float parAdcRawQ8ToMilliVolts(uint32_t rawQ8) {
+    // Calibrate the two codes around the mean and interpolate the fraction
+    uint32_t lo = rawQ8 >> 8;
+    uint32_t frac = rawQ8 & 0xFF;
+    uint32_t vLo = esp_adc_cal_raw_to_voltage(lo, &adcChars);
+    if (frac == 0 || lo >= 4095) return vLo;
+    uint32_t vHi = esp_adc_cal_raw_to_voltage(lo + 1, &adcChars);
+    return vLo + (float)(vHi - vLo) * frac / 256.0f;
+}
+
+void parAdcPause() {
+    if (!parTask || !parRunning) return;
+    parRunning = false;
+    adc_digi_stop();
+}
+
+void parAdcResume() {
+    if (!parTask || parRunning) return;
+    adc_digi_start();
+    parRunning = true;
+}
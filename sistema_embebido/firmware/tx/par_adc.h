@@ -0,0 +1,47 @@
+/**
+ * PAR Continuous ADC Module
+ *
+ * Samples the PAR radiometer continuously with the ESP32-S3 ADC digital
+ * controller (DMA) instead of busy-waiting on analogReadMilliVolts().
+ * A background task decimates the DMA stream into blocks and keeps a
+ * fixed-point window accumulator: mean, min/max (of block means) and the
+ * raw integral. readSensors() takes the window, which resets it, so every
+ * reading covers the whole time since the previous one.
+ *
+ * The ADC1 unit cannot serve oneshot reads (analogRead) while the digital
+ * controller owns it: wrap them in parAdcPause() / parAdcResume().
+ */
+
+#ifndef TX_PAR_ADC_H
+#define TX_PAR_ADC_H
+
+#include <Arduino.h>
+
+#define PAR_DMA_SAMPLE_HZ   1000  // ESP32-S3 minimum is 611 Hz
+#define PAR_DMA_DECIMATION  50    // samples per decimated block (50 ms @ 1 kHz)
+
+// Accumulated acquisition window. Raw values are 12-bit ADC codes; the mean
+// is fixed-point Q8 (raw × 256) so averaging keeps sub-LSB resolution.
+struct ParWindow {
+    uint32_t meanRawQ8;
+    uint16_t minRaw;        // lowest block mean
+    uint16_t maxRaw;        // highest block mean
+    uint32_t samples;
+    uint32_t durationMs;
+    uint32_t overruns;      // DMA frames lost since boot
+};
+
+// Configure the digital controller for PAR_PIN and start the sampling task
+bool parAdcBegin(uint8_t pin);
+
+// Copy and reset the current window. Returns false if no samples yet.
+bool parAdcTakeWindow(ParWindow& out);
+
+// Convert a Q8 raw ADC mean to calibrated millivolts
+float parAdcRawQ8ToMilliVolts(uint32_t rawQ8);
+
+// Temporarily release ADC1 for oneshot reads
+void parAdcPause();
+void parAdcResume();
+
+#endif
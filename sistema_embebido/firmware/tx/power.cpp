@@ -0,0 +1,259 @@
+/**
+ * Power Module Implementation
+ */
+
+#include "power.h"
+#include "button.h"
+#include "rtc.h"
+#include "clock.h"
+#include "../shared/config.h"
+#include <Preferences.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+#include <sys/time.h>
+
+#define POWER_RTC_MAGIC 0x50575232  // "PWR2"
+
+extern unsigned long measureInterval;
+extern unsigned long sendInterval;
+
+// Survives deep sleep; validated with the magic on every wake
+struct PowerRtcState {
+    uint32_t magic;
+    uint32_t cycles;
+    uint64_t clockBaseMs;       // powerClockMs() when millis() was 0
+    uint32_t nextMeasure;       // schedule seconds (see scheduleNow)
+    uint32_t nextSend;
+    bool scheduleOnRtc;
+    uint64_t sleepStartClockMs; // powerClockMs() at the last sleep
+    int64_t  sleepStartUs;      // gettimeofday() at the last sleep
+    uint32_t plannedSleepMs;
+    uint32_t lastAwakeMs;       // wake-to-sleep time of the last cycle
+    uint32_t lastWifiMs;
+    uint64_t totalAwakeMs;
+    uint64_t totalWifiMs;
+    uint64_t totalSleepMs;
+};
+
+static RTC_DATA_ATTR PowerRtcState rtcState;
+
+PowerMode powerMode = POWER_ALWAYS_ON;
+
+static bool wokeFromSleep = false;
+static bool wokeByButton = false;
+
+// WiFi on-time of the current wake
+static bool wifiIsOn = false;
+static unsigned long wifiOnSince = 0;
+static unsigned long cycleWifiMs = 0;
+
+static int64_t wallClockUs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static float averageCurrentMa(uint64_t awakeMs, uint64_t wifiMs, uint64_t sleepMs) {
+    uint64_t total = awakeMs + sleepMs;
+    if (total == 0) return 0;
+    return (awakeMs * POWER_AWAKE_MA + wifiMs * POWER_WIFI_MA + sleepMs * POWER_SLEEP_MA) / total;
+}
+
+void powerInit() {
+    Preferences prefs;
+    prefs.begin("power-cfg", true);
+    powerMode = (PowerMode)prefs.getUChar("mode", POWER_ALWAYS_ON);
+    prefs.end();
+
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    wokeFromSleep = (cause == ESP_SLEEP_WAKEUP_TIMER || cause == ESP_SLEEP_WAKEUP_EXT0 ||
+                     cause == ESP_SLEEP_WAKEUP_EXT1) &&
+                    rtcState.magic == POWER_RTC_MAGIC;
+    wokeByButton = wokeFromSleep && cause == ESP_SLEEP_WAKEUP_EXT0;
+
+    if (!wokeFromSleep) {
+        memset(&rtcState, 0, sizeof(rtcState));
+        rtcState.magic = POWER_RTC_MAGIC;
+        Serial.printf("[Power] Cold boot, mode %s\n",
+                      powerMode == POWER_DEEP_SLEEP ? "SLEEP" : "ON");
+        return;
+    }
+
+    // The system time keeps running in deep sleep; a button wake ends the
+    // sleep early, so measure it instead of trusting the planned duration.
+    int64_t sleptMs = (wallClockUs() - rtcState.sleepStartUs) / 1000;
+    if (sleptMs < 0 || sleptMs > (int64_t)rtcState.plannedSleepMs + 5000) {
+        sleptMs = rtcState.plannedSleepMs;
+    }
+    rtcState.clockBaseMs = rtcState.sleepStartClockMs + sleptMs;
+    rtcState.totalSleepMs += sleptMs;
+
+    if (wokeByButton) rtc_gpio_deinit((gpio_num_t)BTN_PIN);
+    rtc_gpio_deinit((gpio_num_t)RTC_INT_PIN);
+
+    Serial.printf("[Power] Wake #%u by %s after %lld ms\n", rtcState.cycles,
+                  wokeByButton ? "button" : cause == ESP_SLEEP_WAKEUP_EXT1 ? "RTC" : "timer",
+                  (long long)sleptMs);
+}
+
+bool powerWokeFromSleep() {
+    return wokeFromSleep;
+}
+
+bool powerWokeByButton() {
+    return wokeByButton;
+}
+
+void powerSetMode(PowerMode mode) {
+    Preferences prefs;
+    prefs.begin("power-cfg", false);
+    prefs.putUChar("mode", (uint8_t)mode);
+    prefs.end();
+    powerMode = mode;
+    Serial.printf("[Power] Mode set to %s\n", mode == POWER_DEEP_SLEEP ? "SLEEP" : "ON");
+}
+
+uint64_t powerClockMs() {
+    return rtcState.clockBaseMs + millis();
+}
+
+// ============================================
+// Schedule
+// ============================================
+
+// Schedule time in seconds: wall-clock epoch when the RTC runs, so due
+// times fall on wall-clock boundaries (:00/:10/...); otherwise seconds of
+// powerClockMs(). Switching source invalidates the stored due times.
+static uint32_t scheduleNow() {
+    uint32_t epoch = clockNowEpoch();
+    bool onRtc = epoch != 0;
+    if (onRtc != rtcState.scheduleOnRtc) {
+        rtcState.scheduleOnRtc = onRtc;
+        rtcState.nextMeasure = 0;
+        rtcState.nextSend = 0;
+    }
+    return onRtc ? epoch : powerClockMs() / 1000;
+}
+
+// Next multiple of the interval strictly after `now`. All interval options
+// divide a day, so epoch multiples are round wall-clock times.
+static uint32_t nextBoundary(uint32_t now, unsigned long intervalMs) {
+    uint32_t s = intervalMs / 1000;
+    if (s == 0) s = 1;
+    return (now / s + 1) * s;
+}
+
+bool powerMeasureDue() {
+    return scheduleNow() >= rtcState.nextMeasure;
+}
+
+bool powerSendDue() {
+    return scheduleNow() >= rtcState.nextSend;
+}
+
+void powerMarkMeasured() {
+    rtcState.nextMeasure = nextBoundary(scheduleNow(), measureInterval);
+}
+
+void powerMarkSent() {
+    rtcState.nextSend = nextBoundary(scheduleNow(), sendInterval);
+}
+
+// Both intervals combined into the single next wake-up
+static uint32_t nextWake() {
+    return rtcState.nextMeasure < rtcState.nextSend ? rtcState.nextMeasure : rtcState.nextSend;
+}
+
+uint32_t powerSecondsUntilDue() {
+    uint32_t now = scheduleNow();
+    uint32_t next = nextWake();
+    return next > now ? next - now : 0;
+}
+
+// ============================================
+// Accounting
+// ============================================
+
+void powerWifiOn() {
+    if (wifiIsOn) return;
+    wifiIsOn = true;
+    wifiOnSince = millis();
+}
+
+void powerWifiOff() {
+    if (!wifiIsOn) return;
+    wifiIsOn = false;
+    cycleWifiMs += millis() - wifiOnSince;
+}
+
+void powerPrintStatus() {
+    unsigned long wifiMs = cycleWifiMs + (wifiIsOn ? millis() - wifiOnSince : 0);
+    Serial.printf("[Power] Mode: %s, cycles: %u, clock: %llu ms\n",
+                  powerMode == POWER_DEEP_SLEEP ? "SLEEP" : "ON",
+                  rtcState.cycles, (unsigned long long)powerClockMs());
+    Serial.printf("[Power] This wake: %lu ms awake, %lu ms WiFi (~%.1f mA while awake)\n",
+                  millis(), wifiMs, averageCurrentMa(millis(), wifiMs, 0));
+    if (rtcState.cycles > 0) {
+        Serial.printf("[Power] Last cycle: %u ms awake, %u ms WiFi\n",
+                      rtcState.lastAwakeMs, rtcState.lastWifiMs);
+        Serial.printf("[Power] Since boot: %llu ms awake, %llu ms asleep, avg ~%.2f mA\n",
+                      (unsigned long long)rtcState.totalAwakeMs,
+                      (unsigned long long)rtcState.totalSleepMs,
+                      averageCurrentMa(rtcState.totalAwakeMs, rtcState.totalWifiMs,
+                                       rtcState.totalSleepMs));
+    }
+}
+
+// ============================================
+// Sleep
+// ============================================
+
+void powerSleep() {
+    uint32_t now = scheduleNow();
+    uint32_t next = nextWake();
+    if (next <= now) next = now + 1;
+    uint64_t sleepMs = (uint64_t)(next - now) * 1000;
+
+    // PCF8563 INT ends the sleep on the boundary; the ESP32 timer is only a
+    // backstop in case the alarm is lost
+    bool rtcWake = rtcState.scheduleOnRtc && rtcSetWakeAt(next);
+
+    powerWifiOff();
+    unsigned long awakeMs = millis();
+    rtcState.lastAwakeMs = awakeMs;
+    rtcState.lastWifiMs = cycleWifiMs;
+    rtcState.totalAwakeMs += awakeMs;
+    rtcState.totalWifiMs += cycleWifiMs;
+    rtcState.cycles++;
+
+    Serial.printf("[Power] Cycle %u: awake %lu ms (WiFi %lu ms), sleeping %llu ms (%s), "
+                  "cycle ~%.2f mA, avg ~%.2f mA\n",
+                  rtcState.cycles, awakeMs, cycleWifiMs, (unsigned long long)sleepMs,
+                  rtcWake ? "RTC" : "timer",
+                  averageCurrentMa(awakeMs, cycleWifiMs, sleepMs),
+                  averageCurrentMa(rtcState.totalAwakeMs, rtcState.totalWifiMs,
+                                   rtcState.totalSleepMs + sleepMs));
+
+    if (WiFi.getMode() != WIFI_OFF) {
+        WiFi.disconnect(true);
+        WiFi.mode(WIFI_OFF);
+    }
+    digitalWrite(VEXT_CTRL, HIGH);  // VExt off: OLED + sensors
+
+    rtcState.sleepStartClockMs = powerClockMs();
+    rtcState.sleepStartUs = wallClockUs();
+    rtcState.plannedSleepMs = sleepMs;
+
+    if (rtcWake) {
+        esp_sleep_enable_ext1_wakeup(1ULL << RTC_INT_PIN, ESP_EXT1_WAKEUP_ALL_LOW);
+        rtc_gpio_pullup_en((gpio_num_t)RTC_INT_PIN);
+        esp_sleep_enable_timer_wakeup((sleepMs + POWER_RTC_BACKSTOP_MS) * 1000ULL);
+    } else {
+        esp_sleep_enable_timer_wakeup(sleepMs * 1000ULL);
+    }
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)BTN_PIN, 0);  // button pulls low
+    rtc_gpio_pullup_en((gpio_num_t)BTN_PIN);
+    Serial.flush();
+    esp_deep_sleep_start();
+}
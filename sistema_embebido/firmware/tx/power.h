@@ -0,0 +1,82 @@
+/**
+ * Power Module - Deep-Sleep Duty Cycle
+ *
+ * Two operating modes, stored in NVS ("power-cfg"):
+ *   - POWER_ALWAYS_ON: loop() runs continuously (WiFi, display, web server).
+ *   - POWER_DEEP_SLEEP: the node wakes on the timer, measures, logs, uploads
+ *     when the send interval is due and goes back to deep sleep. A press on
+ *     the button (GPIO0) wakes it into an interactive session that lasts
+ *     until the screen times out.
+ *
+ * The schedule (next measure/send), packet counter, retry queue and battery
+ * cache live in RTC slow memory (RTC_DATA_ATTR) and survive deep sleep.
+ *
+ * Due times are wall-clock boundaries of each interval (:00/:10/:20 for
+ * 10 min) taken from the PCF8563, and the sleep is ended by its INT pin
+ * (alarm or countdown, see rtcSetWakeAt). Measure and send intervals are
+ * combined into one wake-up. Without a running RTC the schedule falls back
+ * to powerClockMs(), which survives deep sleep but is not aligned.
+ *
+ * Current is not measured: the average is estimated from awake/WiFi/sleep
+ * time and the nominal draws below. Adjust them after measuring the board.
+ */
+
+#ifndef TX_POWER_H
+#define TX_POWER_H
+
+#include <Arduino.h>
+
+enum PowerMode {
+    POWER_ALWAYS_ON = 0,
+    POWER_DEEP_SLEEP = 1
+};
+
+// Nominal draw (mA) for the average current estimate
+#define POWER_AWAKE_MA      45.0f   // CPU + sensors on VExt, radio off
+#define POWER_WIFI_MA       85.0f   // additional while WiFi is up
+#define POWER_SLEEP_MA      0.02f   // deep sleep, VExt off
+
+#define POWER_RTC_BACKSTOP_MS   60000  // ESP32 timer wake if the RTC INT is missed
+#define POWER_EARLY_WAKE_S      2      // waits this short are spent awake
+#define POWER_SENSOR_WARMUP_MS  1200   // VExt on → DHT22/TEROS 12 ready
+#define POWER_WIFI_TIMEOUT_MS   10000  // STA connect budget per timer wake
+
+extern PowerMode powerMode;
+
+// Read the mode and wake cause; restores or resets the RTC schedule.
+// Call first thing in setup().
+void powerInit();
+
+// True if this boot is a wake from deep sleep (RTC memory is valid)
+bool powerWokeFromSleep();
+
+// True if the button (not the timer) ended the last sleep
+bool powerWokeByButton();
+
+// Persist the operating mode to NVS
+void powerSetMode(PowerMode mode);
+
+// Milliseconds since the schedule started, continuous across deep sleep
+uint64_t powerClockMs();
+
+// Measurement/upload schedule (intervals: measureInterval / sendInterval)
+bool powerMeasureDue();
+bool powerSendDue();
+void powerMarkMeasured();
+void powerMarkSent();
+
+// Seconds until the next measure/send is due (0 = due now)
+uint32_t powerSecondsUntilDue();
+
+// WiFi radio accounting for the current estimate
+void powerWifiOn();
+void powerWifiOff();
+
+// Power down peripherals and sleep until the next measure/send is due.
+// Does not return.
+void powerSleep();
+
+// Print mode, cycle statistics and the average current estimate
+void powerPrintStatus();
+
+#endif
@@ -12,6 +12,33 @@ static PCF8563_Class rtc;
 // Flag to track initialization status
 static bool rtcInitialized = false;
 
+// PCF8563 registers used directly for the wake-up interrupt
+#define PCF8563_ADDR        0x51
+#define PCF8563_CTRL2       0x01  // TI_TP | AF | TF | AIE | TIE
+#define PCF8563_SECONDS     0x02  // bit 7 = VL (clock integrity lost)
+#define PCF8563_ALARM_MIN   0x09  // bit 7 = AE (1 = ignore this field)
+#define PCF8563_TIMER_CTRL  0x0E  // TE | TD1..0
+#define PCF8563_TIMER       0x0F
+
+#define CTRL2_AF    0x08
+#define CTRL2_TF    0x04
+#define CTRL2_AIE   0x02
+#define CTRL2_TIE   0x01
+#define ALARM_AE    0x80
+#define TIMER_TE    0x80
+#define TIMER_1HZ   0x02
+
+static void writeReg(uint8_t reg, uint8_t value) {
+    Wire1.beginTransmission(PCF8563_ADDR);
+    Wire1.write(reg);
+    Wire1.write(value);
+    Wire1.endTransmission();
+}
+
+static uint8_t toBcd(uint8_t v) {
+    return ((v / 10) << 4) | (v % 10);
+}
+
 bool rtcInit() {
     // Initialize second I2C bus for RTC (separate from OLED)
     Wire1.begin(RTC_SDA, RTC_SCL);
@@ -26,6 +53,7 @@ bool rtcInit() {
     }
     
     rtcInitialized = true;
+    rtcClearWake(); // a wake-up alarm may still hold INT low
     
     // If RTC lost power, set a default time
     if (!rtcIsRunning()) {
@@ -89,3 +117,95 @@ bool rtcIsRunning() {
     RtcTime t = rtcGetTime();
     return (t.year >= 2020 && t.year <= 2100);
 }
+
+// ============================================
+// Epoch helpers
+// ============================================
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant)
+static int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+    y -= m <= 2;
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+uint32_t rtcTimeToEpoch(const RtcTime& t) {
+    int32_t days = daysFromCivil(t.year, t.month, t.day);
+    return (uint32_t)days * 86400UL + t.hour * 3600UL + t.minute * 60UL + t.second;
+}
+
+RtcTime rtcEpochToTime(uint32_t epoch) {
+    RtcTime t;
+    uint32_t secs = epoch % 86400UL;
+    int32_t z = epoch / 86400UL + 719468;
+    int32_t era = z / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+
+    t.year = yoe + era * 400 + (m <= 2);
+    t.month = m;
+    t.day = doy - (153 * mp + 2) / 5 + 1;
+    t.hour = secs / 3600;
+    t.minute = (secs / 60) % 60;
+    t.second = secs % 60;
+    return t;
+}
+
+uint32_t rtcGetEpoch() {
+    if (!rtcInitialized) return 0;
+    RtcTime t = rtcGetTime();
+    if (t.year < 2020 || t.year > 2100) return 0;
+    return rtcTimeToEpoch(t);
+}
+
+int rtcReadSeconds() {
+    if (!rtcInitialized) return -1;
+    Wire1.beginTransmission(PCF8563_ADDR);
+    Wire1.write(PCF8563_SECONDS);
+    if (Wire1.endTransmission(false) != 0) return -1;
+    if (Wire1.requestFrom(PCF8563_ADDR, 1) != 1) return -1;
+    uint8_t v = Wire1.read() & 0x7F;
+    return (v >> 4) * 10 + (v & 0x0F);
+}
+
+// ============================================
+// Wake-up interrupt
+// ============================================
+
+void rtcClearWake() {
+    if (!rtcInitialized) return;
+    writeReg(PCF8563_TIMER_CTRL, 0x03);  // timer off, lowest-power source
+    writeReg(PCF8563_CTRL2, 0);          // clear AF/TF, disable AIE/TIE
+    for (uint8_t reg = PCF8563_ALARM_MIN; reg <= PCF8563_ALARM_MIN + 3; reg++) {
+        writeReg(reg, ALARM_AE);
+    }
+}
+
+bool rtcSetWakeAt(uint32_t epoch) {
+    uint32_t now = rtcGetEpoch();
+    if (now == 0 || epoch <= now) return false;
+
+    rtcClearWake();
+    uint32_t delta = epoch - now;
+
+    if (delta <= 255) {
+        writeReg(PCF8563_TIMER, delta);
+        writeReg(PCF8563_TIMER_CTRL, TIMER_TE | TIMER_1HZ);
+        writeReg(PCF8563_CTRL2, CTRL2_TIE);
+        return true;
+    }
+
+    // Minute/hour/day match; weekday stays disabled
+    RtcTime t = rtcEpochToTime(epoch);
+    writeReg(PCF8563_ALARM_MIN,     toBcd(t.minute));
+    writeReg(PCF8563_ALARM_MIN + 1, toBcd(t.hour));
+    writeReg(PCF8563_ALARM_MIN + 2, toBcd(t.day));
+    writeReg(PCF8563_CTRL2, CTRL2_AIE);
+    return true;
+}
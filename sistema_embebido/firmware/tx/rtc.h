@@ -17,6 +17,10 @@
 #define RTC_SDA 41
 #define RTC_SCL 42
 
+// PCF8563 INT output (open drain, active low) → RTC-capable GPIO for ext1
+// deep-sleep wake-up. Needs the pull-up enabled while sleeping.
+#define RTC_INT_PIN 2
+
 // Time structure for easy handling
 struct RtcTime {
     uint16_t year;
@@ -49,4 +53,32 @@ String rtcGetDateStr();
 // Check if RTC is running
 bool rtcIsRunning();
 
+// ============================================
+// Epoch helpers (Unix seconds, RTC local time)
+// ============================================
+
+// Current time as epoch seconds; 0 if the RTC is absent or not running
+uint32_t rtcGetEpoch();
+
+uint32_t rtcTimeToEpoch(const RtcTime& t);
+RtcTime rtcEpochToTime(uint32_t epoch);
+
+// Seconds register only (one short I2C read); -1 on error. Used by the
+// clock service to find the seconds edge.
+int rtcReadSeconds();
+
+// ============================================
+// Wake-up interrupt (alarm / countdown timer)
+// ============================================
+// Targets up to 255 s away use the 1 Hz countdown timer (second
+// resolution); later ones use the alarm, which matches minute/hour/day and
+// fires at second :00 of the target minute (early if the target has seconds).
+
+// Program INT to fire at `epoch`. Returns false if the RTC is unavailable
+// or the target is not in the future.
+bool rtcSetWakeAt(uint32_t epoch);
+
+// Disable alarm and timer and release INT
+void rtcClearWake();
+
 #endif
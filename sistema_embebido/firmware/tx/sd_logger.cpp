@@ -1,5 +1,13 @@
 #include "sd_logger.h"
-#include "rtc.h"
+#include "clock.h"
+#include "binlog.h"
+#include "delta_log.h"
+#include "log_segments.h"
+#include "journal_format.h"
+#include "upload_queue.h"
+#include "../shared/spsc_ring.h"
+#include <esp_timer.h>
+#include <unistd.h>
 
 // SPI Instance for SD
 static SPIClass sdSPI(HSPI);
@@ -8,68 +16,461 @@ static SPIClass sdSPI(HSPI);
 bool sdConnected = false;
 uint64_t sdTotalSpace = 0;
 unsigned long sdWriteCount = 0;
-String sdStatusMsg = "No Card";
+const char* sdStatusMsg = "No Card";
 
 static int sdFailCount = 0;
 static const int SD_MAX_FAILS = 3;
 
-void sdInit() {
-    sdSPI.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
-    
-    if(!SD.begin(SD_CS, sdSPI)) {
+static const char* LOG_HEADER = JNL_CSV_HEADER;
+
+// Measurement loop -> storage task. The timestamp is taken when the record
+// is queued, not when the card gets to it.
+struct SdRecord {
+    MeteorDataPacket data;
+    uint32_t epoch;
+};
+
+static SpscRing<SdRecord, SD_RING_SIZE> ring;
+static TaskHandle_t storeTask = NULL;
+static SemaphoreHandle_t sdMutex = NULL;
+static uint32_t enqueueMaxUs = 0;  // measurement loop only
+// Records pushed into the ring (measurement loop) and taken out and
+// appended to wbBuf (storage task, under sdLock); sdSync() waits for them
+// to match, since the ring is already empty while the task holds the last
+// record between pop() and writeRecord()
+static volatile uint32_t recordsQueued = 0;
+static volatile uint32_t recordsStored = 0;
+static uint32_t remounts = 0;
+static bool mountLost = false;     // the card was mounted before
+
+// Write-behind state (storage task, or holders of sdMutex)
+static File logFile;
+static char wbBuf[SD_WB_SIZE];
+static size_t wbLen = 0;
+static uint32_t fileSize = 0;        // bytes on the card (= offset of wbBuf[0])
+static unsigned long wbFirstMs = 0;  // age of the oldest buffered byte
+static uint32_t flushesSinceSync = 0;
+
+// Journal state of the open segment
+static uint32_t jnlFileId = 0;       // CRC of its first record (0 = none yet)
+static uint32_t jnlRecords = 0;
+static uint32_t jnlUncommitted = 0;
+static char jnlScan[JNL_SCAN_WINDOW];
+
+static SdStats stats;
+static uint64_t recordTotalUs = 0;
+static uint32_t flushLat[SD_LAT_SAMPLES];
+static uint8_t flushLatHead = 0;
+static uint8_t flushLatCount = 0;
+
+void sdLock() {
+    if (sdMutex) xSemaphoreTakeRecursive(sdMutex, portMAX_DELAY);
+}
+
+void sdUnlock() {
+    if (sdMutex) xSemaphoreGiveRecursive(sdMutex);
+}
+
+bool sdTryLock(uint32_t waitMs) {
+    if (!sdMutex) return true;
+    return xSemaphoreTakeRecursive(sdMutex, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+}
+
+static bool mountCard() {
+    if (logFile) logFile.close();
+    wbLen = 0;
+
+    SD.end();  // begin() is a no-op while the old mount is still registered
+    if(!SD.begin(SD_CS, sdSPI, 4000000, SD_MOUNT_POINT)) {
         Serial.println("SD Mount Failed");
         sdStatusMsg = "Mount Fail";
         sdConnected = false;
-    } else {
-        Serial.println("SD Mounted");
-        sdStatusMsg = "Ready";
-        sdConnected = true;
-        sdTotalSpace = SD.totalBytes() / (1024 * 1024);
-        
-        // Init CSV Headers if needed
-        if(!SD.exists("/data.csv")) {
-            File file = SD.open("/data.csv", FILE_WRITE);
-            if(file) {
-                file.println("timestamp,packetId,tempAir,humAir,tempGnd,vwcGnd,ecGnd,par,vBat,batPct");
-                file.close();
-            }
-        }
+        return false;
     }
+
+    Serial.println("SD Mounted");
+    sdStatusMsg = "Ready";
+    sdConnected = true;
+    sdTotalSpace = SD.totalBytes() / (1024 * 1024);
+
+    // Segment files are opened with the first record (the day is
+    // only known then)
+    logSegBegin();
+    return true;
 }
 
-void logToSD(const MeteorDataPacket& data) {
-    if(!sdConnected) {
-        // Try to recover if previously connected
-        if(sdFailCount > 0) sdInit();
-        if(!sdConnected) return;
+static void storageTask(void* arg);
+
+void sdInit() {
+    if (!sdMutex) sdMutex = xSemaphoreCreateRecursiveMutex();
+
+    sdSPI.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
+    sdLock();
+    mountCard();
+    sdUnlock();
+
+    if (!storeTask) {
+        xTaskCreate(storageTask, "sd_store", SD_TASK_STACK, NULL, SD_TASK_PRIORITY, &storeTask);
     }
+}
+
+static void writeFailed() {
+    sdFailCount++;
+    Serial.printf("SD Write Fail (%d/%d)\n", sdFailCount, SD_MAX_FAILS);
+    sdStatusMsg = "Write Err";
+    if(sdFailCount >= SD_MAX_FAILS) {
+        // The storage task remounts; buffered records are lost
+        if (logFile) logFile.close();
+        wbLen = 0;
+        binlogClose();
+        deltaLogClose();
+        sdConnected = false;
+        mountLost = true;
+        sdFailCount = 0;
+        Serial.println("SD: forcing re-init");
+    }
+}
+
+static void recordFlushLatency(uint32_t us) {
+    flushLat[flushLatHead] = us;
+    flushLatHead = (flushLatHead + 1) % SD_LAT_SAMPLES;
+    if (flushLatCount < SD_LAT_SAMPLES) flushLatCount++;
+    if (us > stats.flushMaxUs) stats.flushMaxUs = us;
+}
 
-    File file = SD.open("/data.csv", FILE_APPEND);
-    if(!file) {
-        sdFailCount++;
-        Serial.printf("SD Write Fail (%d/%d)\n", sdFailCount, SD_MAX_FAILS);
-        sdStatusMsg = "Write Err";
-        if(sdFailCount >= SD_MAX_FAILS) {
-            // Force re-initialization on next call
-            sdConnected = false;
-            sdFailCount = 0;
-            Serial.println("SD: forcing re-init");
+// Write buffered bytes to the card. With `all` false only the part that
+// ends on a sector boundary is written and the tail stays buffered; the
+// first write after a partial one completes that sector.
+static bool flushBuffer(bool all, bool sync) {
+    if (!logFile) return false;
+
+    size_t n = wbLen;
+    if (!all) {
+        uint32_t end = (fileSize + wbLen) & ~(uint32_t)(SD_SECTOR_SIZE - 1);
+        n = end > fileSize ? end - fileSize : 0;
+    }
+    if (n == 0 && !sync) return true;
+
+    int64_t t0 = esp_timer_get_time();
+    if (n > 0) {
+        size_t written = logFile.write((const uint8_t*)wbBuf, n);
+        if (written != n) {
+            writeFailed();
+            return false;
         }
+        uint32_t firstSector = fileSize / SD_SECTOR_SIZE;
+        uint32_t lastSector = (fileSize + n - 1) / SD_SECTOR_SIZE;
+        stats.sectorWrites += lastSector - firstSector + 1;
+        stats.payloadBytes += n;
+        stats.flushes++;
+        fileSize += n;
+        wbLen -= n;
+        memmove(wbBuf, wbBuf + n, wbLen);
+        wbFirstMs = millis();
+        flushesSinceSync++;
+    }
+
+    if (sync || (SD_SYNC_EVERY > 0 && flushesSinceSync >= SD_SYNC_EVERY)) {
+        logFile.flush();  // fflush + fsync: data and FAT/directory entry
+        stats.syncs++;
+        flushesSinceSync = 0;
+    }
+    recordFlushLatency(esp_timer_get_time() - t0);
+    sdFailCount = 0;
+    return true;
+}
+
+// Append a commit marker for the records buffered since the last one
+static void appendCommit() {
+    if (jnlUncommitted == 0 || !logFile) return;
+    if (wbLen + SD_RECORD_MAX > SD_WB_SIZE && !flushBuffer(true, false)) return;
+    size_t n = journalCommit(jnlRecords, fileSize + wbLen, jnlFileId,
+                             wbBuf + wbLen, SD_WB_SIZE - wbLen);
+    if (n == 0) return;
+    if (wbLen == 0) wbFirstMs = millis();
+    wbLen += n;
+    jnlUncommitted = 0;
+}
+
+static bool readFile(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    File* f = (File*)ctx;
+    return f->seek(offset) && f->read(buf, len) == len;
+}
+
+// Cut a tail torn by a power cut back to the last valid line. Reads the
+// first record and at most JNL_SCAN_WINDOW bytes, whatever the file size.
+static void recoverSegment(const char* path) {
+    int64_t t0 = esp_timer_get_time();
+    JournalRecovery rec;
+    File reader = SD.open(path, FILE_READ);
+    BinlogIo io = { &reader, readFile };
+    bool ok = reader && journalRecover(io, fileSize, jnlScan, rec);
+    if (reader) reader.close();
+    if (!ok) return;
+
+    jnlFileId = rec.fileId;
+    jnlRecords = rec.recordsKnown ? rec.records : 0;
+    if (rec.journaled && rec.validSize < fileSize) {
+        char full[LOG_SEG_PATH_LEN + sizeof(SD_MOUNT_POINT)];
+        snprintf(full, sizeof(full), SD_MOUNT_POINT "%s", path);
+        logFile.close();
+        if (truncate(full, rec.validSize) == 0) {
+            stats.tornBytes += fileSize - rec.validSize;
+            Serial.printf("[Journal] %s: cut %lu torn bytes\n", path,
+                          (unsigned long)(fileSize - rec.validSize));
+        } else {
+            Serial.printf("[Journal] %s: truncate failed\n", path);
+        }
+        logFile = SD.open(path, FILE_APPEND);
+        fileSize = logFile ? logFile.size() : 0;
+        if (logFile && fileSize > rec.validSize) {
+            // Not cut: end the torn line so the next record starts on its
+            // own line; the next commit marker lets recovery skip past it
+            wbBuf[0] = '\n';
+            wbLen = 1;
+            wbFirstMs = millis();
+        }
+    }
+
+    uint32_t us = esp_timer_get_time() - t0;
+    if (us > stats.recoveryMaxUs) stats.recoveryMaxUs = us;
+}
+
+// Close the previous segment (everything written and synced) and open the
+// current one's CSV and binary files
+static bool openSegment() {
+    if (logFile) {
+        appendCommit();
+        flushBuffer(true, true);
+        logFile.close();
+    }
+    wbLen = 0;
+    jnlFileId = 0;
+    jnlRecords = 0;
+    jnlUncommitted = 0;
+
+    char path[LOG_SEG_PATH_LEN];
+    logSegCsvPath(path, sizeof(path));
+    if (!path[0]) return false;
+    logFile = SD.open(path, FILE_APPEND);
+    if (!logFile) return false;
+    fileSize = logFile.size();
+    if (fileSize > 0) recoverSegment(path);
+    if (!logFile) return false;
+    if (fileSize == 0) {
+        wbLen = strlcpy(wbBuf, LOG_HEADER, sizeof(wbBuf));
+        wbFirstMs = millis();
+    }
+
+#if SD_BINLOG_ENABLED
+    binlogFlush(true);
+    logSegBinPath(path, sizeof(path));
+    binlogOpen(path);
+#endif
+#if SD_DELTA_ENABLED
+    deltaLogFlush(true);
+    logSegDeltaPath(path, sizeof(path));
+    deltaLogOpen(path);
+#endif
+    return true;
+}
+
+// ============================================
+// Storage task
+// ============================================
+
+static void writeRecord(const SdRecord& r) {
+    int64_t t0 = esp_timer_get_time();
+    const MeteorDataPacket& data = r.data;
+    uint32_t epoch = r.epoch;
+
+    if ((logSegRoll(epoch, fileSize + wbLen) || !logFile) && !openSegment()) {
+        writeFailed();
         return;
     }
 
-    String line = rtcGetTimestamp() + "," + String(data.packetId) + "," +
-                  String(data.tempAire) + "," + String(data.humAire) + "," +
-                  String(data.tempSuelo) + "," + String(data.vwcSuelo) + "," +
-                  String(data.ecSuelo, 1) + "," +
-                  String(data.par, 1) + "," +
-                  String(data.vBat, 2) + "," + String(data.batPercent);
+    // Make room for the longest record
+    if (wbLen + SD_RECORD_MAX > SD_WB_SIZE && !flushBuffer(true, false)) return;
+
+    char ts[CLOCK_TS_LEN];
+    clockFormatEpoch(epoch, ts, sizeof(ts));
+    int n = snprintf(wbBuf + wbLen, SD_WB_SIZE - wbLen,
+                     "%s,%lu,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%u",
+                     ts, data.packetId,
+                     data.tempAire, data.humAire,
+                     data.tempSuelo, data.vwcSuelo,
+                     data.ecSuelo, data.par,
+                     data.vBat, (unsigned)data.batPercent);
+    if (n <= 0 || wbLen + n >= SD_WB_SIZE) return;
+    bool first = jnlFileId == 0;
+    size_t line = journalFrame(wbBuf + wbLen, n, SD_WB_SIZE - wbLen, jnlFileId,
+                               first ? &jnlFileId : NULL);
+    if (line == 0) return;
+    if (wbLen == 0) wbFirstMs = millis();
+    wbLen += line;
+    jnlRecords++;
+    if (++jnlUncommitted >= JNL_COMMIT_EVERY) appendCommit();
+
+    if (wbLen >= SD_FLUSH_BYTES) flushBuffer(false, false);
+#if SD_BINLOG_ENABLED
+    binlogAppend(data, epoch);
+#endif
+#if SD_DELTA_ENABLED
+    deltaLogAppend(data, epoch);
+#endif
+    logSegNote(epoch, data.packetId);
 
-    file.println(line);
-    file.close();
-    sdFailCount = 0;
     sdWriteCount++;
     sdStatusMsg = "Logging...";
-    Serial.println("SD Log OK");
+
+    uint32_t us = esp_timer_get_time() - t0;
+    stats.records++;
+    recordTotalUs += us;
+    if (us > stats.recordMaxUs) stats.recordMaxUs = us;
+}
+
+static void storageTask(void* arg) {
+    uint32_t backoffMs = SD_REMOUNT_MIN_MS;
+    unsigned long lastMountTry = 0;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SD_TASK_POLL_MS));
+
+        // Upload queue first: it keeps packets in RTC memory without a card
+        uploadQueueStore();
+
+        // Remount only when there is something to write, at most once per
+        // backoff period; records wait in the ring meanwhile
+        if (!sdConnected) {
+            if (ring.empty() || millis() - lastMountTry < backoffMs) continue;
+            lastMountTry = millis();
+            sdLock();
+            bool ok = mountCard();
+            sdUnlock();
+            if (!ok) {
+                backoffMs = backoffMs * 2 > SD_REMOUNT_MAX_MS ? SD_REMOUNT_MAX_MS : backoffMs * 2;
+                Serial.printf("SD: next mount attempt in %lu s\n", (unsigned long)(backoffMs / 1000));
+                continue;
+            }
+            if (mountLost) remounts++;
+            backoffMs = SD_REMOUNT_MIN_MS;
+        }
+
+        SdRecord r;
+        while (sdConnected && ring.pop(r)) {
+            sdLock();
+            writeRecord(r);
+            recordsStored = recordsStored + 1;
+            sdUnlock();
+        }
+
+        // Time threshold
+        sdLock();
+        if (sdConnected && wbLen > 0 && millis() - wbFirstMs >= SD_FLUSH_MS) {
+            flushBuffer(true, false);
+            binlogFlush(false);
+            deltaLogFlush(false);
+            logSegSync();
+            uploadQueueFlush();
+        }
+        sdUnlock();
+    }
+}
+
+void logToSD(const MeteorDataPacket& data) {
+    int64_t t0 = esp_timer_get_time();
+
+    SdRecord r;
+    r.data = data;
+    r.epoch = clockNowEpoch();
+    if (ring.push(r)) {
+        recordsQueued = recordsQueued + 1;
+        if (storeTask) xTaskNotifyGive(storeTask);
+    }
+
+    uint32_t us = esp_timer_get_time() - t0;
+    if (us > enqueueMaxUs) enqueueMaxUs = us;
 }
 
+void sdNotify() {
+    if (storeTask) xTaskNotifyGive(storeTask);
+}
+
+void sdSync() {
+    if (!storeTask) return;
+
+    // Let the task write what is queued (it gives up while the card is out)
+    xTaskNotifyGive(storeTask);
+    unsigned long start = millis();
+    while (recordsStored != recordsQueued && sdConnected && millis() - start < SD_SYNC_WAIT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    // The upload queue's ring is not in RTC memory either
+    uploadQueueWait(SD_SYNC_WAIT_MS);
+
+    sdLock();
+    if (sdConnected) {
+        appendCommit();
+        flushBuffer(true, true);
+        binlogFlush(true);
+        deltaLogFlush(true);
+        logSegSync();
+        uploadQueueFlush();
+    }
+    sdUnlock();
+}
+
+// ============================================
+// Statistics
+// ============================================
+
+static uint32_t percentile(const uint32_t* sorted, uint8_t count, uint8_t pct) {
+    if (count == 0) return 0;
+    return sorted[(count - 1) * pct / 100];
+}
+
+void sdGetStats(SdStats& out) {
+    uint32_t sorted[SD_LAT_SAMPLES];
+
+    sdLock();
+    out = stats;
+    out.buffered = wbLen;
+    out.recordAvgUs = stats.records ? recordTotalUs / stats.records : 0;
+    uint8_t count = flushLatCount;
+    memcpy(sorted, flushLat, count * sizeof(uint32_t));
+    sdUnlock();
+
+    out.queued = ring.size();
+    out.queueHigh = ring.highWaterMark();
+    out.overflows = ring.overflowCount();
+    out.enqueueMaxUs = enqueueMaxUs;
+    out.remounts = remounts;
+    for (uint8_t i = 1; i < count; i++) {
+        uint32_t v = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    out.flushP50Us = percentile(sorted, count, 50);
+    out.flushP90Us = percentile(sorted, count, 90);
+    out.flushP99Us = percentile(sorted, count, 99);
+}
+
+void sdPrintStats() {
+    SdStats s;
+    sdGetStats(s);
+    Serial.printf("SD: %u records (avg %u us, max %u us), %u B buffered\n",
+                  s.records, s.recordAvgUs, s.recordMaxUs, s.buffered);
+    Serial.printf("SD: %u flushes, %u syncs, %u B in %u sectors\n",
+                  s.flushes, s.syncs, s.payloadBytes, s.sectorWrites);
+    Serial.printf("SD queue: %u/%u (high %u), %u overflows, enqueue max %u us, %u remounts\n",
+                  s.queued, (unsigned)SD_RING_SIZE, s.queueHigh, s.overflows,
+                  s.enqueueMaxUs, s.remounts);
+    Serial.printf("SD journal: %u torn bytes cut, recovery max %u us\n",
+                  s.tornBytes, s.recoveryMaxUs);
+    Serial.printf("SD flush: p50 %u us, p90 %u us, p99 %u us, max %u us\n",
+                  s.flushP50Us, s.flushP90Us, s.flushP99Us, s.flushMaxUs);
+}
@@ -12,17 +12,96 @@
 #define SD_MISO 33
 #define SD_MOSI 47
 #define SD_CS   26
+#define SD_MOUNT_POINT "/sd"  // VFS prefix for POSIX calls (truncate)
 
-// State (read-only access)
+// --- Write-behind buffer ---
+// Records are formatted into a RAM buffer and written in whole 512-byte
+// sectors (file data starts on a cluster boundary, so file offsets that are
+// multiples of 512 are sector aligned on the card). The CSV stays open
+// between flushes. Files are per-day segments under /log (log_segments.h).
+#define SD_SECTOR_SIZE      512
+#define SD_WB_SIZE          4096   // buffer capacity (8 sectors)
+#define SD_FLUSH_BYTES      2048   // size threshold: write the aligned part
+#define SD_FLUSH_MS         300000 // time threshold: write everything buffered
+#define SD_SYNC_EVERY       4      // fsync every N flushes (0 = only in sdSync)
+#define SD_RECORD_MAX       160    // longest formatted CSV line (with its frame)
+#define SD_LAT_SAMPLES      64     // flush latencies kept for percentiles
+
+// CSV lines carry a length + CRC32 frame and periodic commit markers; a
+// segment reopened after a power cut is cut back to its last valid line
+// (journal_format.h)
+
+// Indexed binary copy of every record in /data.bin (see binlog.h)
+#define SD_BINLOG_ENABLED   1
+
+// Delta-compressed copy of every record in the .dlt segment (delta_log.h)
+#define SD_DELTA_ENABLED    1
+
+// --- Storage task ---
+// logToSD() only copies the record into a lock-free ring (spsc_ring.h); the
+// "sd_store" task formats and writes it, applies the time threshold and
+// remounts a lost card with exponential backoff. It also stores the
+// upload queue's pushes (upload_queue.h). The measurement path never
+// touches SPI. Other modules that use the card (upload queue, lookups) hold
+// sdLock() around their file operations.
+#define SD_RING_SIZE        32      // records waiting for the task (power of 2)
+#define SD_TASK_STACK       6144
+#define SD_TASK_PRIORITY    1
+#define SD_TASK_POLL_MS     1000    // wake-up without new records
+#define SD_REMOUNT_MIN_MS   2000    // backoff after a failed mount, doubling
+#define SD_REMOUNT_MAX_MS   120000
+#define SD_SYNC_WAIT_MS     2000    // sdSync(): max wait for queued records to be stored
+
+// State (read-only access; written by the storage task)
 extern bool sdConnected;
 extern uint64_t sdTotalSpace;
 extern unsigned long sdWriteCount;
-extern String sdStatusMsg;
+extern const char* sdStatusMsg;
 
-// Initialize SD Card
+struct SdStats {
+    uint32_t records;
+    uint32_t flushes;
+    uint32_t syncs;
+    uint32_t payloadBytes;      // CSV bytes written to the card
+    uint32_t sectorWrites;      // sectors touched by those writes
+    uint32_t buffered;          // bytes waiting in RAM
+    uint32_t recordAvgUs;       // record write cost in the storage task
+    uint32_t recordMaxUs;
+    uint32_t queued;            // records waiting in the ring
+    uint32_t queueHigh;         // ring high-water mark
+    uint32_t overflows;         // records lost to a full ring
+    uint32_t enqueueMaxUs;      // logToSD() cost on the measurement path
+    uint32_t remounts;          // successful mounts after a failure
+    uint32_t tornBytes;         // garbage cut from segment tails on reopen
+    uint32_t recoveryMaxUs;     // slowest tail recovery
+    uint32_t flushP50Us;        // write + optional fsync, last SD_LAT_SAMPLES
+    uint32_t flushP90Us;
+    uint32_t flushP99Us;
+    uint32_t flushMaxUs;
+};
+
+// Mount the card and start the storage task
 void sdInit();
 
-// Log data to CSV
+// Queue a record for the storage task. Never blocks; the record is counted
+// as an overflow if the ring is full.
 void logToSD(const MeteorDataPacket& data);
 
+// Wake the storage task for work queued outside logToSD()
+void sdNotify();
+
+// Durability point: wait until the storage task has taken every queued
+// record (not just until the ring is empty), write everything buffered
+// and fsync (before deep sleep, on demand)
+void sdSync();
+
+// Exclusive access to the card and the logging state (recursive)
+void sdLock();
+void sdUnlock();
+// As sdLock(), giving up after `waitMs` (callers that must not stall)
+bool sdTryLock(uint32_t waitMs);
+
+void sdGetStats(SdStats& out);
+void sdPrintStats();
+
 #endif
@@ -0,0 +1,269 @@
+/**
+ * SDI-12 Bus Manager Implementation
+ */
+
+#include "sdi12_bus.h"
+#include "sensors.h"
+#include "sdi12_parse.h"
+#include "sdi12_port.h"
+
+RTC_DATA_ATTR Sdi12Sensor sdi12Sensors[SDI12_MAX_SENSORS];
+RTC_DATA_ATTR uint8_t sdi12SensorCount = 0;
+
+// Discard any bytes sitting in the SDI-12 receive buffer.
+// Called before every sendCommand to prevent stale responses from a previous
+// cycle from being read as the current response.
+static void flushSDI12() {
+    sdi12PortFlush();
+}
+
+static void sendCommand(char addr, const char* cmd) {
+    char buf[8];
+    snprintf(buf, sizeof(buf), "%c%s", addr, cmd);
+    flushSDI12();
+    sdi12PortSend(buf);
+}
+
+// Blocking line read used only during discovery (setup).
+// Fills `buf` without the trailing "\r\n"; returns the length. The timeout
+// starts once the command is out.
+static size_t readLineBlocking(char* buf, size_t size, unsigned long timeoutMs) {
+    while (sdi12PortSending()) delay(1);
+
+    size_t n = 0;
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs) {
+        if (!sdi12PortAvailable()) {
+            delay(1);
+            continue;
+        }
+        int c = sdi12PortRead();
+        if (c == '\n') break;
+        if (n < size - 1) buf[n++] = c;
+    }
+    while (n > 0 && (buf[n - 1] == '\r' || buf[n - 1] == ' ')) n--;
+    buf[n] = '\0';
+    return n;
+}
+
+// ============================================
+// Discovery
+// ============================================
+
+static void addSensor(char addr) {
+    if (sdi12SensorCount >= SDI12_MAX_SENSORS) return;
+    Sdi12Sensor& s = sdi12Sensors[sdi12SensorCount++];
+    s.addr = addr;
+    s.expected = 3;
+    s.ok = false;
+    s.valueCount = 0;
+}
+
+void sdi12BusBegin(char fallbackAddr, bool rescan) {
+    if (!sdi12PortBegin(TEROS12_PIN)) {
+        // Without the line every cycle would only time out
+        Serial.println("[SDI12] Line init failed, soil sensors unavailable");
+        sdi12SensorCount = 0;
+        return;
+    }
+    delay(500); // Allow sensors to power up
+
+    if (!rescan && sdi12SensorCount > 0) {
+        Serial.printf("[SDI12] %u sensor(s) kept from before sleep\n", sdi12SensorCount);
+        return;
+    }
+    sdi12SensorCount = 0;
+
+    // Acknowledge-active scan: only the addressed sensor answers, so this is
+    // safe with several probes on the line (unlike "?!").
+    char line[SDI12_LINE_MAX];
+    for (char addr = '0'; addr <= '9' && sdi12SensorCount < SDI12_MAX_SENSORS; addr++) {
+        sendCommand(addr, "!");
+        size_t n = readLineBlocking(line, sizeof(line), SDI12_DISCOVERY_TIMEOUT);
+        if (n > 0 && line[0] == addr) addSensor(addr);
+    }
+
+    // Single sensor with a non-numeric address
+    if (sdi12SensorCount == 0) {
+        flushSDI12();
+        sdi12PortSend("?!");
+        size_t n = readLineBlocking(line, sizeof(line), SDI12_DISCOVERY_TIMEOUT);
+        if (n == 1) addSensor(line[0]);
+    }
+
+    for (uint8_t i = 0; i < sdi12SensorCount; i++) {
+        sendCommand(sdi12Sensors[i].addr, "I!");
+        // ~35 characters: longer than an ACK, and the RMT backend only
+        // delivers the line once the capture has ended
+        readLineBlocking(line, sizeof(line), SDI12_DATA_TIMEOUT);
+        Serial.printf("[SDI12] Sensor '%c': %s\n", sdi12Sensors[i].addr, line);
+    }
+
+    if (sdi12SensorCount == 0) {
+        Serial.printf("[SDI12] No sensors found, using address '%c'\n", fallbackAddr);
+        addSensor(fallbackAddr);
+    }
+    flushSDI12();
+}
+
+// ============================================
+// Concurrent Acquisition State Machine
+// ============================================
+
+enum BusState {
+    BUS_IDLE,
+    BUS_WAIT_ACK,     // aC! sent to sensor `busCur`, waiting for "atttnn"
+    BUS_SETTLE,       // every sensor measuring
+    BUS_WAIT_DATA,    // aD0! sent to sensor `busCur`, collecting the data line
+    BUS_RETRY_WAIT    // parse failed, short pause before asking again
+};
+
+static BusState busState = BUS_IDLE;
+static unsigned long busStateTime = 0;
+static unsigned long busSettleMs = SDI12_MIN_SETTLE_MS;
+static uint8_t busCur = 0;
+static int busAttempt = 0;
+
+// Response line, filled straight from the SDI-12 stream
+static char busLine[SDI12_LINE_MAX];
+static size_t busLineLen = 0;
+
+static void busEnter(BusState s) {
+    busState = s;
+    busStateTime = millis();
+}
+
+// Collect bytes from the SDI-12 buffer into busLine without blocking.
+// Returns true once a complete line ('\n' terminated) is available.
+static bool collectLine() {
+    while (sdi12PortAvailable()) {
+        char c = sdi12PortRead();
+        if (c == '\n') return true;
+        if (c == '\r') continue;
+        if (busLineLen < SDI12_LINE_MAX - 1) {
+            busLine[busLineLen++] = c;
+            busLine[busLineLen] = '\0';
+        }
+    }
+    return false;
+}
+
+static void clearLine() {
+    busLineLen = 0;
+    busLine[0] = '\0';
+}
+
+static void requestConcurrent(uint8_t idx) {
+    busCur = idx;
+    clearLine();
+    sendCommand(sdi12Sensors[idx].addr, "C!");
+    busEnter(BUS_WAIT_ACK);
+}
+
+static void requestData(uint8_t idx) {
+    busCur = idx;
+    clearLine();
+    sendCommand(sdi12Sensors[idx].addr, "D0!");
+    busEnter(BUS_WAIT_DATA);
+}
+
+// "atttnn": ttt = seconds until data ready, nn = number of values.
+// Sensors report whole seconds; a TEROS 12 says 001 but is ready in < 500ms,
+// so anything up to 1 s keeps the SDI12_MIN_SETTLE_MS window.
+static void handleConcurrentAck(Sdi12Sensor& s) {
+    if (busLineLen < 6 || busLine[0] != s.addr) return;
+    long ttt = sdi12ParseField(busLine, busLineLen, 1, 3);
+    long nn  = sdi12ParseField(busLine, busLineLen, 4, 2);
+    if (nn > 0) s.expected = nn > SDI12_MAX_VALUES ? SDI12_MAX_VALUES : nn;
+    if (ttt > 1 && (unsigned long)ttt * 1000 > busSettleMs) busSettleMs = ttt * 1000;
+}
+
+static void nextSensorData() {
+    busAttempt = 0;
+    if (busCur + 1 < sdi12SensorCount) {
+        requestData(busCur + 1);
+    } else {
+        busEnter(BUS_IDLE);
+    }
+}
+
+void sdi12BusStart() {
+    if (busState != BUS_IDLE || sdi12SensorCount == 0) return;
+    busSettleMs = SDI12_MIN_SETTLE_MS;
+    busAttempt = 0;
+    for (uint8_t i = 0; i < sdi12SensorCount; i++) {
+        sdi12Sensors[i].ok = false;
+        sdi12Sensors[i].valueCount = 0;
+    }
+    requestConcurrent(0);
+}
+
+bool sdi12BusBusy() {
+    return busState != BUS_IDLE;
+}
+
+bool sdi12BusSettling() {
+    return busState == BUS_SETTLE;
+}
+
+bool sdi12BusPoll() {
+    // Command still going out: the response timeout starts when it ends
+    if ((busState == BUS_WAIT_ACK || busState == BUS_WAIT_DATA) && sdi12PortSending()) {
+        busStateTime = millis();
+        return false;
+    }
+    unsigned long elapsed = millis() - busStateTime;
+
+    switch (busState) {
+        case BUS_IDLE:
+            return false;
+
+        case BUS_WAIT_ACK:
+            if (collectLine() || elapsed > SDI12_ACK_TIMEOUT) {
+                handleConcurrentAck(sdi12Sensors[busCur]);
+                flushSDI12(); // drop any trailing \r or extra bytes
+                if (busCur + 1 < sdi12SensorCount) {
+                    requestConcurrent(busCur + 1);
+                } else {
+                    busEnter(BUS_SETTLE);
+                }
+            }
+            break;
+
+        case BUS_SETTLE:
+            if (elapsed >= busSettleMs) requestData(0);
+            break;
+
+        case BUS_WAIT_DATA: {
+            bool complete = collectLine();
+            if (!complete && elapsed <= SDI12_DATA_TIMEOUT) break;
+
+            Sdi12Sensor& s = sdi12Sensors[busCur];
+            Serial.printf("[SDI12] '%c' att%d raw: '%s'\n", s.addr, busAttempt + 1, busLine);
+
+            if (busLineLen > 0 && busLine[0] == s.addr) {
+                s.valueCount = sdi12ParseValues(busLine, busLineLen, s.values, SDI12_MAX_VALUES);
+            } else {
+                s.valueCount = 0;
+            }
+
+            if (s.valueCount >= s.expected) {
+                s.ok = true;
+                nextSensorData();
+            } else if (++busAttempt < SDI12_MAX_ATTEMPTS) {
+                // D0 can be re-read until the next measurement command
+                busEnter(BUS_RETRY_WAIT);
+            } else {
+                Serial.printf("[SDI12] '%c' parse failed: '%s'\n", s.addr, busLine);
+                nextSensorData();
+            }
+            break;
+        }
+
+        case BUS_RETRY_WAIT:
+            if (elapsed >= SDI12_RETRY_DELAY) requestData(busCur);
+            break;
+    }
+
+    return busState == BUS_IDLE;
+}
@@ -0,0 +1,64 @@
+/**
+ * SDI-12 Bus Manager
+ *
+ * Handles several SDI-12 sensors (e.g. TEROS 12 probes at different depths)
+ * sharing one data line:
+ *   - Discovery: "a!" acknowledge scan over addresses 0-9 ("?!" fallback),
+ *     "aI!" identification for every sensor found.
+ *   - Acquisition: "aC!" concurrent measurement sent to every sensor back to
+ *     back, one shared settle window, then "aD0!" collected from each sensor.
+ *     Total time ≈ one settle window regardless of the number of probes.
+ *
+ * The acquisition is a polled state machine; call sdi12BusPoll() from loop().
+ * Line access goes through sdi12_port (RMT or software-serial backend).
+ */
+
+#ifndef TX_SDI12_BUS_H
+#define TX_SDI12_BUS_H
+
+#include <Arduino.h>
+#include "../shared/config.h"
+
+#define SDI12_MAX_SENSORS  SOIL_MAX_PROBES
+#define SDI12_MAX_VALUES   9   // values kept per sensor from the D0 response
+#define SDI12_LINE_MAX     82  // SDI-12 limits a D response to 75 characters
+
+// Transaction timing (ms)
+#define SDI12_DISCOVERY_TIMEOUT 80    // "a!" → "a\r\n"
+#define SDI12_ACK_TIMEOUT       300   // aC! → "atttnn" acknowledgement
+#define SDI12_MIN_SETTLE_MS     600   // TEROS 12 measurement time < 500ms
+#define SDI12_DATA_TIMEOUT      1500  // aD0! → data line
+#define SDI12_RETRY_DELAY       200
+#define SDI12_MAX_ATTEMPTS      3
+
+struct Sdi12Sensor {
+    char addr;
+    uint8_t expected;              // value count announced in the aC! ACK
+    bool ok;                       // last acquisition parsed successfully
+    uint8_t valueCount;
+    float values[SDI12_MAX_VALUES];
+};
+
+// Sensors found on the bus (valid after sdi12BusBegin; kept in RTC memory).
+// No sensors at all only if the line could not be set up.
+extern Sdi12Sensor sdi12Sensors[SDI12_MAX_SENSORS];
+extern uint8_t sdi12SensorCount;
+
+// Initialize the line and discover sensors (blocking, call from setup).
+// If nothing answers, `fallbackAddr` is used so a late-powered probe still works.
+// With `rescan` false the table kept from before deep sleep is reused. If
+// sdi12PortBegin() fails the table is left empty and no cycle touches the line.
+void sdi12BusBegin(char fallbackAddr, bool rescan = true);
+
+// Start a concurrent measurement on every sensor (no-op if one is running)
+void sdi12BusStart();
+
+// Advance the state machine. Returns true once when all sensors are done.
+bool sdi12BusPoll();
+
+// True while no bus traffic is expected (sensors measuring)
+bool sdi12BusSettling();
+
+bool sdi12BusBusy();
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * SDI-12 Frame Codec Implementation
+ */
+
+#include "sdi12_frame.h"
+
+#define SDI12_BITS_PER_CHAR 10  // start + 7 data + parity + stop
+
+// Time (us) of bit edge k, counted from the first start bit
+static inline uint32_t bitEdge(uint32_t k) {
+    return (k * SDI12_BIT_US_X3 + 1) / 3;
+}
+
+static inline uint8_t evenParity(uint8_t c) {
+    uint8_t p = 0;
+    for (int i = 0; i < 7; i++) p ^= (c >> i) & 1;
+    return p;
+}
+
+size_t sdi12EncodeCommand(const char* cmd, Sdi12Run* runs, size_t maxRuns) {
+    if (maxRuns < 2) return 0;
+    size_t n = 0;
+    runs[n++] = { 1, SDI12_BREAK_US };
+    runs[n++] = { 0, SDI12_MARKING_US };
+
+    // Emit one line level per bit, merging equal neighbours into a run
+    uint32_t bit = 0;
+    uint8_t curLevel = 0;
+    uint32_t curStart = 0;
+    bool open = false;
+
+    for (const char* p = cmd; *p; p++) {
+        uint8_t c = (uint8_t)*p & 0x7F;
+        uint8_t frame[SDI12_BITS_PER_CHAR];
+        frame[0] = 1;                                  // start: spacing
+        for (int i = 0; i < 7; i++) frame[1 + i] = !((c >> i) & 1);
+        frame[8] = !evenParity(c);
+        frame[9] = 0;                                  // stop: marking
+
+        for (int i = 0; i < SDI12_BITS_PER_CHAR; i++, bit++) {
+            if (open && frame[i] == curLevel) continue;
+            if (open) {
+                if (n >= maxRuns) return 0;
+                runs[n++] = { curLevel, (uint16_t)(bitEdge(bit) - bitEdge(curStart)) };
+            }
+            curLevel = frame[i];
+            curStart = bit;
+            open = true;
+        }
+    }
+
+    if (open) {
+        if (n >= maxRuns) return 0;
+        runs[n++] = { curLevel, (uint16_t)(bitEdge(bit) - bitEdge(curStart)) };
+    }
+    return n;
+}
+
+size_t sdi12DecodeRuns(const Sdi12Run* runs, size_t count,
+                       char* out, size_t maxOut, uint16_t* errors) {
+    size_t written = 0;
+    size_t r = 0;       // current run
+    uint32_t tr = 0;    // start time of run r
+
+    while (r < count && written < maxOut) {
+        // Idle marking between characters
+        if (runs[r].level != 1) {
+            tr += runs[r].us;
+            r++;
+            continue;
+        }
+
+        // Spacing longer than a whole character is a break
+        if (runs[r].us > bitEdge(SDI12_BITS_PER_CHAR)) {
+            tr += runs[r].us;
+            r++;
+            continue;
+        }
+
+        // Start bit begins at tr: sample every bit at its centre. Past the
+        // end of the capture the line is idle (marking).
+        uint32_t t0 = tr;
+        size_t rr = r;
+        uint32_t trr = tr;
+        uint8_t frame[SDI12_BITS_PER_CHAR];
+        for (int b = 0; b < SDI12_BITS_PER_CHAR; b++) {
+            uint32_t centre = t0 + (bitEdge(b) + bitEdge(b + 1)) / 2;
+            while (rr < count && trr + runs[rr].us <= centre) {
+                trr += runs[rr].us;
+                rr++;
+            }
+            frame[b] = rr < count ? runs[rr].level : 0;
+        }
+
+        uint8_t c = 0;
+        for (int i = 0; i < 7; i++) {
+            if (!frame[1 + i]) c |= (1 << i);
+        }
+        bool ok = frame[0] == 1 && frame[9] == 0 && (uint8_t)!frame[8] == evenParity(c);
+
+        if (ok) {
+            out[written++] = (char)c;
+        } else if (errors) {
+            (*errors)++;
+        }
+
+        // Resume at the run holding the stop bit (marking when valid); skip
+        // past it on errors so the scan always advances.
+        if (rr >= count) break;
+        if (ok && rr > r) {
+            r = rr;
+            tr = trr;
+        } else {
+            tr = trr + runs[rr].us;
+            r = rr + 1;
+        }
+    }
+    return written;
+}
+
+void sdi12FifoClear(Sdi12Fifo& f) {
+    f.head = f.tail = 0;
+}
+
+size_t sdi12FifoPush(Sdi12Fifo& f, const char* text, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t next = (f.head + 1) % SDI12_FIFO_SIZE;
+        if (next == f.tail) return len - i;
+        f.buf[f.head] = text[i];
+        f.head = next;
+    }
+    return 0;
+}
+
+int sdi12FifoPop(Sdi12Fifo& f) {
+    if (f.head == f.tail) return -1;
+    char c = f.buf[f.tail];
+    f.tail = (f.tail + 1) % SDI12_FIFO_SIZE;
+    return c;
+}
+
+size_t sdi12FifoCount(const Sdi12Fifo& f) {
+    return (f.head - f.tail + SDI12_FIFO_SIZE) % SDI12_FIFO_SIZE;
+}
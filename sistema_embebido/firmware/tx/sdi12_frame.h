@@ -0,0 +1,56 @@
+/**
+ * SDI-12 Frame Codec
+ *
+ * Converts between SDI-12 characters and the line waveform as run-length
+ * level/duration pairs (what the RMT peripheral transmits and captures).
+ * Pure C++ (no Arduino/IDF), so recorded waveforms can be decoded on the host.
+ *
+ * Line format: 1200 baud, 7 data bits LSB first, even parity, 1 stop bit,
+ * inverted logic — marking (logic 1, idle) is LOW, spacing (logic 0) is HIGH.
+ * A command is preceded by a break (>= 12 ms spacing) and 8.33 ms marking.
+ */
+
+#ifndef TX_SDI12_FRAME_H
+#define TX_SDI12_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SDI12_FIFO_SIZE   128    // decoded characters waiting to be read (one slot kept free)
+#define SDI12_BREAK_US    12500
+#define SDI12_MARKING_US  8333
+#define SDI12_BIT_US_X3   2500   // bit time ×3 (833.33 us), keeps edges exact
+
+struct Sdi12Run {
+    uint8_t level;    // line level: 1 = high (spacing), 0 = low (marking)
+    uint16_t us;      // duration in microseconds
+};
+
+// Encode break + marking + command characters. Returns the number of runs
+// written, or 0 if `maxRuns` is too small.
+size_t sdi12EncodeCommand(const char* cmd, Sdi12Run* runs, size_t maxRuns);
+
+// Decode captured runs into characters. Bytes with framing or parity
+// errors are dropped and counted in `errors` (if not NULL); a break is
+// skipped silently. Returns the number of characters written to `out`.
+size_t sdi12DecodeRuns(const Sdi12Run* runs, size_t count,
+                       char* out, size_t maxOut, uint16_t* errors);
+
+// Decoded characters between a capture and sdi12PortRead()
+struct Sdi12Fifo {
+    char buf[SDI12_FIFO_SIZE];
+    uint8_t head;
+    uint8_t tail;
+};
+
+void sdi12FifoClear(Sdi12Fifo& f);
+
+// Append `len` characters; returns how many did not fit (dropped from the end)
+size_t sdi12FifoPush(Sdi12Fifo& f, const char* text, size_t len);
+
+// Oldest character, -1 if empty
+int sdi12FifoPop(Sdi12Fifo& f);
+
+size_t sdi12FifoCount(const Sdi12Fifo& f);
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * SDI-12 Response Parser Implementation
+ */
+
+#include "sdi12_parse.h"
+
+// SDI-12 values carry at most 7 digits; significant digits past this many
+// are dropped (an integer digit still scales the value)
+#define SDI12_MAX_DIGITS 9
+#define SDI12_MAX_POW10  10     // largest power of ten exact in a float
+
+static const float pow10Table[SDI12_MAX_POW10 + 1] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static inline bool isEnd(char c) {
+    return c == '\r' || c == '\n' || c == '\0';
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// v × 10^exp; one division by an exact power for in-spec values
+static float scale10(float v, int exp) {
+    while (exp > SDI12_MAX_POW10) { v *= pow10Table[SDI12_MAX_POW10]; exp -= SDI12_MAX_POW10; }
+    while (exp < -SDI12_MAX_POW10) { v /= pow10Table[SDI12_MAX_POW10]; exp += SDI12_MAX_POW10; }
+    return exp >= 0 ? v * pow10Table[exp] : v / pow10Table[-exp];
+}
+
+uint8_t sdi12ParseValues(const char* line, size_t len, float* values, uint8_t maxValues) {
+    uint8_t count = 0;
+    size_t i = 1; // skip address character
+
+    while (i < len && !isEnd(line[i]) && count < maxValues) {
+        char c = line[i];
+        if (c != '+' && c != '-') {
+            i++;
+            continue;
+        }
+
+        bool negative = (c == '-');
+        i++;
+
+        // Significant digits, power of ten and decimal point. Like strtod,
+        // the number ends at the first character that cannot continue it;
+        // the rest up to the next sign is skipped.
+        uint32_t mantissa = 0;
+        int digits = 0;
+        int exp = 0;
+        bool point = false;
+        bool done = false;
+        while (i < len && !isEnd(line[i]) && line[i] != '+' && line[i] != '-') {
+            c = line[i++];
+            if (done) continue;
+            if (isDigit(c)) {
+                if (digits < SDI12_MAX_DIGITS) {
+                    mantissa = mantissa * 10 + (uint32_t)(c - '0');
+                    if (mantissa > 0) digits++;   // leading zeros are not significant
+                    if (point) exp--;
+                } else if (!point) {
+                    exp++;
+                }
+            } else if (c == '.' && !point) {
+                point = true;
+            } else {
+                done = true;
+            }
+        }
+
+        float v = scale10((float)mantissa, exp);
+        values[count++] = negative ? -v : v;
+    }
+    return count;
+}
+
+long sdi12ParseField(const char* line, size_t len, size_t pos, size_t width) {
+    if (pos + width > len) return -1;
+    long v = 0;
+    for (size_t i = pos; i < pos + width; i++) {
+        if (!isDigit(line[i])) return -1;
+        v = v * 10 + (line[i] - '0');
+    }
+    return v;
+}
@@ -0,0 +1,29 @@
+/**
+ * SDI-12 Response Parser
+ *
+ * Parses data responses ("a+v1-v2+v3...") straight from a fixed char buffer:
+ * no String, no heap, no strtof. Signs act as both delimiters and value
+ * signs, so any number of values is handled (up to maxValues), which covers
+ * D0..D9 responses of any SDI-12 sensor, not only the TEROS 12. Values up
+ * to the 7 digits SDI-12 allows give the same float as strtod; a number
+ * ends where strtod would end it (a second '.', a space, any other
+ * character) and digits past the ninth significant one are dropped.
+ *
+ * Plain C++ (no Arduino dependency) so it can also be built on the host.
+ */
+
+#ifndef TX_SDI12_PARSE_H
+#define TX_SDI12_PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Parse the values of a data response. `line` starts with the sensor address;
+// parsing stops at '\r', '\n', '\0' or `len`. Returns the number of values.
+uint8_t sdi12ParseValues(const char* line, size_t len, float* values, uint8_t maxValues);
+
+// Parse the fixed-width decimal field line[pos .. pos+width). Returns -1 if
+// any character is not a digit or the field runs past `len`.
+long sdi12ParseField(const char* line, size_t len, size_t pos, size_t width);
+
+#endif
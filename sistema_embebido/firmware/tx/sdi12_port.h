@@ -0,0 +1,40 @@
+/**
+ * SDI-12 Line Transport
+ *
+ * Byte-level access to the SDI-12 data line used by the bus manager.
+ * Two backends, selected with SDI12_RMT_ENABLED (sensors.h):
+ *   - sdi12_port_rmt: RMT TX sends break + marking + command in one
+ *     transfer, RMT RX captures the response; the CPU only decodes a
+ *     finished capture (sdi12_frame) instead of servicing one interrupt
+ *     per bit.
+ *   - sdi12_port_lib: EnviroDIY SDI12 library (software serial).
+ */
+
+#ifndef TX_SDI12_PORT_H
+#define TX_SDI12_PORT_H
+
+#include <Arduino.h>
+
+// Configure the line. Returns false if the peripheral could not be set up.
+bool sdi12PortBegin(uint8_t pin);
+
+// Wake the bus and send a command (e.g. "0D0!"). May return before the
+// transfer ends; the port releases the line and listens for the response
+// as soon as the last stop bit is out.
+void sdi12PortSend(const char* cmd);
+
+// True while the last command is still going out (response timeouts count
+// from the end of the command)
+bool sdi12PortSending();
+
+// Received response bytes (non-blocking)
+int sdi12PortAvailable();
+int sdi12PortRead();
+
+// Drop pending response bytes
+void sdi12PortFlush();
+
+// Characters dropped for framing/parity errors (or a full receive FIFO) since boot
+extern uint32_t sdi12PortErrorCount;
+
+#endif
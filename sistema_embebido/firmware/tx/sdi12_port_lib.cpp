@@ -0,0 +1,43 @@
+/**
+ * SDI-12 Line Transport — EnviroDIY SDI12 library backend
+ */
+
+#include "sensors.h"
+
+#if !SDI12_RMT_ENABLED
+
+#include "sdi12_port.h"
+#include <SDI12.h>
+
+static SDI12 sdi12;
+
+uint32_t sdi12PortErrorCount = 0;
+
+bool sdi12PortBegin(uint8_t pin) {
+    sdi12.setDataPin(pin);
+    sdi12.begin();
+    return true;
+}
+
+void sdi12PortSend(const char* cmd) {
+    sdi12.sendCommand(cmd);
+}
+
+// sendCommand() returns once the command is out
+bool sdi12PortSending() {
+    return false;
+}
+
+int sdi12PortAvailable() {
+    return sdi12.available();
+}
+
+int sdi12PortRead() {
+    return sdi12.read();
+}
+
+void sdi12PortFlush() {
+    while (sdi12.available()) sdi12.read();
+}
+
+#endif
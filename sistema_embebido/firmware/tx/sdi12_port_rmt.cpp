@@ -0,0 +1,159 @@
+/**
+ * SDI-12 Line Transport — RMT backend (ESP-IDF legacy RMT driver)
+ *
+ * One GPIO is shared by a TX and an RX channel. The TX channel owns the
+ * output only while a command is sent; afterwards the pin is switched back
+ * to input (line released) and the RX channel captures the response.
+ * The send does not wait for the transfer: the TX-end interrupt turns the
+ * line around, so a loop() held up elsewhere cannot miss the response.
+ */
+
+#include "sensors.h"
+
+#if SDI12_RMT_ENABLED
+
+#include "sdi12_port.h"
+#include "sdi12_frame.h"
+#include <driver/rmt.h>
+
+// TX-capable channels are 0-3 and RX-capable 4-7 on the ESP32-S3; the DHT22
+// uses 4-5. Two RX blocks (96 items); longer responses are streamed by the
+// driver's ping-pong refill.
+#define SDI12_TX_CHANNEL   RMT_CHANNEL_0
+#define SDI12_RX_CHANNEL   RMT_CHANNEL_6
+#define SDI12_RX_BLOCKS    2
+#define SDI12_RX_IDLE_US   10000  // > inter-character gap (1.66 ms max)
+#define SDI12_RX_RING      2048
+#define SDI12_TX_MAX_RUNS  64     // break + marking + 5 characters worst case
+#define SDI12_RX_MAX_RUNS  512
+
+static gpio_num_t sdiPin = GPIO_NUM_NC;
+static RingbufHandle_t rxRing = NULL;
+
+// Decoded response bytes
+static Sdi12Fifo fifo;
+
+uint32_t sdi12PortErrorCount = 0;
+
+// TX-end interrupt (driver ISR): release the line and start listening; the
+// sensor answers within 15 ms of the last stop bit
+static void onTxEnd(rmt_channel_t channel, void* arg) {
+    (void)arg;
+    if (channel != SDI12_TX_CHANNEL) return;
+    gpio_set_direction(sdiPin, GPIO_MODE_INPUT);
+    rmt_rx_start(SDI12_RX_CHANNEL, true);
+}
+
+bool sdi12PortBegin(uint8_t pin) {
+    sdiPin = (gpio_num_t)pin;
+
+    rmt_config_t rx = RMT_DEFAULT_CONFIG_RX(sdiPin, SDI12_RX_CHANNEL);
+    rx.clk_div = 80;                           // 1 us per tick
+    rx.mem_block_num = SDI12_RX_BLOCKS;
+    rx.rx_config.idle_threshold = SDI12_RX_IDLE_US;
+    rx.rx_config.filter_en = true;
+    rx.rx_config.filter_ticks_thresh = 255;    // ignore glitches < ~3 us (APB ticks)
+
+    rmt_config_t tx = RMT_DEFAULT_CONFIG_TX(sdiPin, SDI12_TX_CHANNEL);
+    tx.clk_div = 80;
+    tx.mem_block_num = 1;
+    tx.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;  // marking
+    tx.tx_config.idle_output_en = true;
+
+    if (rmt_config(&rx) != ESP_OK ||
+        rmt_driver_install(SDI12_RX_CHANNEL, SDI12_RX_RING, 0) != ESP_OK ||
+        rmt_get_ringbuf_handle(SDI12_RX_CHANNEL, &rxRing) != ESP_OK ||
+        rmt_config(&tx) != ESP_OK ||
+        rmt_driver_install(SDI12_TX_CHANNEL, 0, 0) != ESP_OK) {
+        Serial.println("[SDI12] RMT init failed");
+        rxRing = NULL;
+        return false;
+    }
+
+    rmt_register_tx_end_callback(onTxEnd, NULL);
+
+    // rmt_config(tx) made the pin an output; release the line until needed
+    gpio_set_direction(sdiPin, GPIO_MODE_INPUT);
+    return true;
+}
+
+static void drainRing() {
+    size_t len = 0;
+    void* item;
+    while ((item = xRingbufferReceive(rxRing, &len, 0)) != NULL) {
+        vRingbufferReturnItem(rxRing, item);
+    }
+}
+
+void sdi12PortFlush() {
+    if (rxRing) drainRing();
+    sdi12FifoClear(fifo);
+}
+
+void sdi12PortSend(const char* cmd) {
+    if (!rxRing) return;
+
+    static Sdi12Run runs[SDI12_TX_MAX_RUNS];
+    static rmt_item32_t items[SDI12_TX_MAX_RUNS / 2 + 1];
+    size_t n = sdi12EncodeCommand(cmd, runs, SDI12_TX_MAX_RUNS);
+    if (n == 0) return;
+
+    size_t itemCount = 0;
+    for (size_t i = 0; i < n; i += 2) {
+        rmt_item32_t& it = items[itemCount++];
+        it.level0 = runs[i].level;
+        it.duration0 = runs[i].us;
+        it.level1 = i + 1 < n ? runs[i + 1].level : 0;
+        it.duration1 = i + 1 < n ? runs[i + 1].us : 0;  // 0 ends the transfer
+    }
+
+    rmt_rx_stop(SDI12_RX_CHANNEL);
+    sdi12PortFlush();
+
+    // Take the line and start the transfer (`items` is static, the driver
+    // reads it until the end); onTxEnd() releases the line
+    rmt_set_gpio(SDI12_TX_CHANNEL, RMT_MODE_TX, sdiPin, false);
+    rmt_write_items(SDI12_TX_CHANNEL, items, itemCount, false);
+}
+
+bool sdi12PortSending() {
+    if (!rxRing) return false;
+    return rmt_wait_tx_done(SDI12_TX_CHANNEL, 0) != ESP_OK;
+}
+
+// Decode finished captures into the FIFO
+static void pumpCaptures() {
+    if (!rxRing) return;
+
+    size_t len = 0;
+    rmt_item32_t* items;
+    while ((items = (rmt_item32_t*)xRingbufferReceive(rxRing, &len, 0)) != NULL) {
+        static Sdi12Run runs[SDI12_RX_MAX_RUNS];
+        size_t n = 0;
+        size_t itemCount = len / sizeof(rmt_item32_t);
+        for (size_t i = 0; i < itemCount && n + 2 <= SDI12_RX_MAX_RUNS; i++) {
+            if (items[i].duration0 == 0) break;
+            runs[n++] = { (uint8_t)items[i].level0, (uint16_t)items[i].duration0 };
+            if (items[i].duration1 == 0) break;
+            runs[n++] = { (uint8_t)items[i].level1, (uint16_t)items[i].duration1 };
+        }
+        vRingbufferReturnItem(rxRing, items);
+
+        char text[SDI12_FIFO_SIZE];
+        uint16_t errors = 0;
+        size_t count = sdi12DecodeRuns(runs, n, text, sizeof(text), &errors);
+        // Full FIFO: the rest of the capture is dropped
+        sdi12PortErrorCount += errors + sdi12FifoPush(fifo, text, count);
+    }
+}
+
+int sdi12PortAvailable() {
+    pumpCaptures();
+    return sdi12FifoCount(fifo);
+}
+
+int sdi12PortRead() {
+    return sdi12FifoPop(fifo);
+}
+
+#endif
@@ -1,122 +1,157 @@
 #include "sensors.h"
+#include "sdi12_bus.h"
+#include "par_adc.h"
+#include "power.h"
 
-static SDI12 sdi12(TEROS12_PIN);
-static DHT sensorAire(DHT_PIN, DHT_TYPE);
+static const uint8_t terosDepthsCm[10] = TEROS12_DEPTHS_CM;
 
 float parSensorUV = 0;
 float parRawMV    = 0;
+float parMin      = 0;
+float parMax      = 0;
+float parIntegral = 0;
+
+static bool parDmaActive = false;
 
 void sensorsInit() {
-    sensorAire.begin();
-    sdi12.begin();
+    dht22Begin(DHT_PIN);
     analogSetPinAttenuation(PAR_PIN, ADC_11db);
-    delay(500); // Allow TEROS 12 to power up
+#if PAR_DMA_ENABLED
+    parDmaActive = parAdcBegin(PAR_PIN);
+#endif
+    // Powers up and discovers TEROS 12 probes; a timer wake reuses the table
+    sdi12BusBegin(TEROS12_ADDR, !powerWokeFromSleep());
 }
 
-static float readPAR() {
+// AD620 output (mV at the ADC pin) → µmol/m²s
+static float parFromAmplifiedMV(float amplificado_mV) {
+    float sensor_mV = amplificado_mV / PAR_AD620_GAIN;
+    float par       = (sensor_mV - PAR_ZERO_OFFSET_MV) * PAR_SENSITIVITY;
+    return par < 0 ? 0 : par;
+}
+
+static float readPARBurst() {
     long suma = 0;
+    parAdcPause(); // no-op unless the DMA stream owns ADC1
     for (int i = 0; i < PAR_SAMPLES; i++) {
         suma += analogReadMilliVolts(PAR_PIN);
         delayMicroseconds(200);
     }
+    parAdcResume();
     float amplificado_mV = suma / (float)PAR_SAMPLES;
     parRawMV             = amplificado_mV;
-    float sensor_mV      = amplificado_mV / PAR_AD620_GAIN;
-    parSensorUV          = sensor_mV * 1000.0f;
-    float par            = (sensor_mV - PAR_ZERO_OFFSET_MV) * PAR_SENSITIVITY;
-    return par < 0 ? 0 : par;
+    parSensorUV          = amplificado_mV / PAR_AD620_GAIN * 1000.0f;
+    float par            = parFromAmplifiedMV(amplificado_mV);
+    parMin = parMax = par;
+    parIntegral = 0;
+    return par;
 }
 
-// Discard any bytes sitting in the SDI-12 receive buffer.
-// Called before every sendCommand to prevent stale responses from a previous
-// cycle from being read as the current response.
-static void flushSDI12() {
-    while (sdi12.available()) sdi12.read();
+// Read the DMA window accumulated since the last call. The calibration and
+// PAR conversion run once per window, not per sample.
+static float readPAR() {
+    ParWindow w;
+    if (!parDmaActive || !parAdcTakeWindow(w)) return readPARBurst();
+
+    float amplificado_mV = parAdcRawQ8ToMilliVolts(w.meanRawQ8);
+    parRawMV             = amplificado_mV;
+    parSensorUV          = amplificado_mV / PAR_AD620_GAIN * 1000.0f;
+    float par            = parFromAmplifiedMV(amplificado_mV);
+
+    parMin      = parFromAmplifiedMV(parAdcRawQ8ToMilliVolts((uint32_t)w.minRaw << 8));
+    parMax      = parFromAmplifiedMV(parAdcRawQ8ToMilliVolts((uint32_t)w.maxRaw << 8));
+    parIntegral = par * (w.durationMs / 1000.0f);
+    return par;
 }
 
-// Parse SDI-12 response: "0+VWC+TEMP+EC"
-// Signs (+/-) act as both delimiters and value signs.
-static bool parseTEROS12(const String& response, float& vwc, float& temp, float& ec) {
-    if (response.length() < 5) return false;
-
-    float values[3] = {0, 0, 0};
-    int count = 0;
-    int i = 1; // skip address character
-
-    while (i < (int)response.length() && count < 3) {
-        if (response[i] == '+' || response[i] == '-') {
-            int start = i++;
-            while (i < (int)response.length() &&
-                   response[i] != '+' && response[i] != '-' &&
-                   response[i] != '\r' && response[i] != '\n') {
-                i++;
-            }
-            values[count++] = response.substring(start, i).toFloat();
-        } else {
-            i++;
-        }
-    }
+// Convert a TEROS 12 D0 response "a+VWC+TEMP+EC" into a soil reading
+static bool convertTEROS12(const Sdi12Sensor& s, SoilProbeReading& out) {
+    out.addr    = s.addr;
+    out.depthCm = (s.addr >= '0' && s.addr <= '9') ? terosDepthsCm[s.addr - '0'] : 0;
 
-    if (count < 3) return false;
+    if (!s.ok || s.valueCount < 3) {
+        out.vwc  = -1;
+        out.temp = -1;
+        out.ec   = -1;
+        return false;
+    }
 
-    vwc  = values[0] / 100.0f; // raw is ε×100, divide to get VWC%
-    if (vwc < 0) vwc = 0;
-    temp = values[1];
-    ec   = values[2]; // µS/cm, no scaling needed
+    out.vwc  = s.values[0] / 100.0f; // raw is ε×100, divide to get VWC%
+    if (out.vwc < 0) out.vwc = 0;
+    out.temp = s.values[1];
+    out.ec   = s.values[2]; // µS/cm, no scaling needed
     return true;
 }
 
-void readSensors(MeteorDataPacket& data) {
-    // Air sensor (DHT22)
-    data.humAire  = sensorAire.readHumidity();
-    data.tempAire = sensorAire.readTemperature();
-
-    // TEROS 12 via SDI-12 — up to 3 attempts.
-    // Root cause of -1 failures: stale bytes from the previous measurement cycle
-    // accumulate in the buffer. When readStringUntil('\n') runs for the 0M! ACK it
-    // consumes a leftover '\n' from old data, leaving the real ACK in the buffer.
-    // Then the 0D0! read picks up the ACK instead of the data → parse fails.
-    // Fix: flush before every sendCommand so the buffer is always empty.
-    bool ok = false;
-    for (int attempt = 0; attempt < 3 && !ok; attempt++) {
-        if (attempt > 0) delay(200);
-
-        // Step 1: start measurement — response is "a0003\r\n"
-        flushSDI12();
-        sdi12.sendCommand("0M!");
-        sdi12.setTimeout(300);
-        sdi12.readStringUntil('\n'); // consume ACK, discard
-        flushSDI12();                // drop any trailing \r or extra bytes
-
-        delay(600); // TEROS 12 measurement time < 500ms
-
-        // Step 2: request data
-        flushSDI12();
-        sdi12.sendCommand("0D0!");
-        sdi12.setTimeout(1500);
-        String response = sdi12.readStringUntil('\n');
-        response.trim();
-
-        Serial.printf("[TEROS12] att%d raw: '%s'\n", attempt + 1, response.c_str());
-
-        float vwc, tempSuelo, ec;
-        if (parseTEROS12(response, vwc, tempSuelo, ec)) {
-            data.vwcSuelo  = vwc;
-            data.tempSuelo = tempSuelo;
-            data.ecSuelo   = ec;
-            ok = true;
-        } else {
-            Serial.printf("[TEROS12] Parse failed: '%s'\n", response.c_str());
-        }
+// ============================================
+// Acquisition Cycle
+// ============================================
+// The SDI-12 bus state machine runs the TEROS 12 transactions and the DHT22
+// frame is captured by the RMT in the background; PAR is read once per cycle
+// inside the probes' settle window.
+
+static bool cycleActive = false;
+static bool auxRead = false;
+static float cyclePar;
+
+// Sample the fast sensors; runs once per cycle
+static void readAuxSensors() {
+    cyclePar = readPAR();
+    auxRead = true;
+}
+
+void sensorsStartCycle() {
+    if (cycleActive) return;
+    cycleActive = true;
+    auxRead = false;
+    dht22Request(); // ignored inside the 2 s minimum spacing; cache is used
+    sdi12BusStart();
+}
+
+bool sensorsBusy() {
+    return cycleActive;
+}
+
+bool sensorsPoll(MeteorDataPacket& data) {
+    if (!cycleActive) return false;
+
+    dht22Poll();
+    if (sdi12BusBusy()) {
+        sdi12BusPoll();
+        if (!auxRead && sdi12BusSettling()) readAuxSensors();
+    }
+    if (sdi12BusBusy() || dht22Busy()) return false;
+
+    // Cycle complete — publish results
+    cycleActive = false;
+    if (!auxRead) readAuxSensors();
+    dht22GetCached(data.tempAire, data.humAire);
+    data.par = cyclePar;
+
+    data.soilCount = sdi12SensorCount;
+    for (uint8_t i = 0; i < sdi12SensorCount; i++) {
+        convertTEROS12(sdi12Sensors[i], data.soil[i]);
     }
 
-    if (!ok) {
-        data.vwcSuelo  = -1;
-        data.tempSuelo = -1;
-        data.ecSuelo   = -1;
+    // Legacy single-probe fields mirror soil[0], the lowest address (the
+    // shallowest probe with TEROS12_DEPTHS_CM); -1 when the SDI-12 line is
+    // not available
+    if (sdi12SensorCount > 0) {
+        data.vwcSuelo  = data.soil[0].vwc;
+        data.tempSuelo = data.soil[0].temp;
+        data.ecSuelo   = data.soil[0].ec;
+    } else {
+        data.vwcSuelo = data.tempSuelo = data.ecSuelo = -1;
     }
 
-    // PAR radiometer
-    data.par = readPAR();
-    Serial.printf("[PAR] %.0f umol/m2s (%.1f uV)\n", data.par, parSensorUV);
+    Serial.printf("[PAR] %.0f umol/m2s (%.1f uV) min %.0f max %.0f\n",
+                  data.par, parSensorUV, parMin, parMax);
+    return true;
+}
+
+void readSensors(MeteorDataPacket& data) {
+    sensorsStartCycle();
+    while (!sensorsPoll(data)) {
+        delay(1);
+    }
 }
@@ -2,17 +2,23 @@
 #define TX_SENSORS_H
 
 #include <Arduino.h>
-#include <SDI12.h>
-#include <DHT.h>
+#include "dht22.h"
 #include "../shared/config.h"
 
 // TEROS 12 SDI-12 (reuses former EC-5 pin)
 #define TEROS12_PIN  5
-#define TEROS12_ADDR '0'
+#define TEROS12_ADDR '0'   // fallback when discovery finds no probe
 
-// DHT22 air sensor (unchanged)
+// 1 = SDI-12 line driven by the RMT peripheral (sdi12_port_rmt), 0 = EnviroDIY
+// SDI12 library (pin-change interrupt per bit)
+#define SDI12_RMT_ENABLED 1
+
+// Installation depth (cm) of each TEROS 12, indexed by SDI-12 address '0'..'9'.
+// Set each probe's address (aAb!) to match its depth before burying it.
+#define TEROS12_DEPTHS_CM { 10, 30, 60, 90, 0, 0, 0, 0, 0, 0 }
+
+// DHT22 air sensor (RMT capture, see dht22.h)
 #define DHT_PIN  6
-#define DHT_TYPE DHT22
 
 // PAR radiometer (reuses former DS18B20 pin)
 // AD620 instrumentation amplifier: Rg = 200Ω → G = 49400/200 + 1 = 248
@@ -28,10 +34,33 @@
 #define PAR_SAMPLES         64
 #define PAR_ZERO_OFFSET_MV  0.0f    // mV — set after dark calibration
 
+// 1 = continuous DMA sampling between readings (par_adc), 0 = legacy burst of
+// PAR_SAMPLES oneshot reads inside readSensors()
+#define PAR_DMA_ENABLED     1
+
 extern float parSensorUV; // µV at sensor input (before AD620) — debug
 extern float parRawMV;    // raw ADC reading at GPIO7 in mV — debug
 
+// Statistics of the last PAR window (DMA mode; equal to `par` otherwise)
+extern float parMin;      // µmol/m²s, lowest decimated block
+extern float parMax;      // µmol/m²s, highest decimated block
+extern float parIntegral; // µmol/m² received during the window
+
 void sensorsInit();
+
+// Non-blocking acquisition cycle.
+// sensorsStartCycle() issues a concurrent measurement to every TEROS 12 on
+// the SDI-12 bus and returns immediately; sensorsPoll() must then be called
+// from loop(). The DHT22 and PAR are sampled while the probes settle, so a
+// cycle takes as long as the slowest sensor. sensorsPoll() returns true
+// exactly once, when `data` has been filled with the results of the cycle.
+// Without an SDI-12 line (sdi12_bus.h) soilCount is 0 and the legacy soil
+// fields are -1.
+void sensorsStartCycle();
+bool sensorsPoll(MeteorDataPacket& data);
+bool sensorsBusy();
+
+// Blocking wrapper (start + poll until done). Used by serial commands.
 void readSensors(MeteorDataPacket& data);
 
 #endif
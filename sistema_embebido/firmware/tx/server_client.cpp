@@ -1,13 +1,17 @@
 /**
  * Server Client for TX Node
- * Sends sensor data directly to server via HTTPS
+ * Uploads queued readings to the server in batches via HTTPS
  */
 
 #include "server_client.h"
 #include <Preferences.h>
+#include <math.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include "rtc.h"
+#include "../shared/uplink.h"
+#include "clock.h"
+#include "binlog.h"
+#include "upload_queue.h"
+#include "backfill.h"
 
 // Configuration - defaults (same as RX vivero-olivos station)
 String serverUrl = "https://gipis.unp.edu.ar/weather";
@@ -19,46 +23,13 @@ bool lastServerOk = false;
 unsigned long lastServerSendTime = 0;
 int serverPendingCount = 0;
 
-// HTTP client
-WiFiClientSecure secureClient;
-HTTPClient http;
+static TaskHandle_t uplinkTask = NULL;
+static volatile bool serverConfigured = false;  // enabled, URL and key set
+static volatile bool uploadAsked = false;       // a regular send is due
+static volatile bool stopAsked = false;         // serverClientStop()
 
-// ============================================
-// Retry Buffer
-// ============================================
-#define RETRY_BUFFER_SIZE 20
-
-struct BufferedPacket {
-    MeteorDataPacket data;
-    String timestamp;
-    bool valid;
-};
-
-BufferedPacket retryBuffer[RETRY_BUFFER_SIZE];
-int retryHead = 0;
-int retryCount = 0;
-
-void bufferPacket(const MeteorDataPacket& data) {
-    retryBuffer[retryHead].data = data;
-    retryBuffer[retryHead].timestamp = rtcGetTimestamp();
-    retryBuffer[retryHead].valid = true;
-    
-    retryHead = (retryHead + 1) % RETRY_BUFFER_SIZE;
-    if (retryCount < RETRY_BUFFER_SIZE) {
-        retryCount++;
-    }
-    
-    serverPendingCount = retryCount;
-    Serial.printf("[Server] Buffered packet (queue: %d)\n", retryCount);
-}
-
-bool sendPacketToServer(const MeteorDataPacket& data, const String& timestamp) {
-    if (WiFi.status() != WL_CONNECTED) {
-        return false;
-    }
-
-    // Build JSON payload
-    JsonDocument doc;
+// Measurement fields of one reading (backfill body)
+static void packetToJson(JsonObject doc, const MeteorDataPacket& data) {
     doc["packetId"] = data.packetId;
     doc["tempAire"] = data.tempAire;
     doc["humAire"] = data.humAire;
@@ -68,61 +39,264 @@ bool sendPacketToServer(const MeteorDataPacket& data, const String& timestamp) {
     doc["par"] = data.par;
     doc["vBat"] = data.vBat;
     doc["batPercent"] = data.batPercent;
-    doc["timestamp"] = timestamp;
 
-    String jsonPayload;
-    serializeJson(doc, jsonPayload);
+    // Soil profile: one entry per TEROS 12 depth
+    JsonArray soil = doc["soil"].to<JsonArray>();
+    for (uint8_t i = 0; i < data.soilCount && i < SOIL_MAX_PROBES; i++) {
+        JsonObject probe = soil.add<JsonObject>();
+        probe["addr"]  = String((char)data.soil[i].addr);
+        probe["depth"] = data.soil[i].depthCm;
+        probe["vwc"]   = data.soil[i].vwc;
+        probe["temp"]  = data.soil[i].temp;
+        probe["ec"]    = data.soil[i].ec;
+    }
+}
 
-    // Send HTTP POST
-    String endpoint = serverUrl + "/api/data/ingest";
+// "backfill": [[first, last], ...] in a server response replaces the
+// pending gap list (absent: older server, nothing changes)
+static void parseBackfillRanges(const String& response) {
+    JsonDocument resp;
+    if (deserializeJson(resp, response)) return;
+    JsonArrayConst list = resp["backfill"].as<JsonArrayConst>();
+    if (list.isNull()) return;
 
-    http.begin(secureClient, endpoint);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-Key", apiKey);
-    http.setTimeout(10000);
+    BackfillRange ranges[BACKFILL_MAX_RANGES];
+    uint8_t n = 0;
+    for (JsonArrayConst r : list) {
+        if (n == BACKFILL_MAX_RANGES) break;
+        ranges[n].first = r[0] | 0UL;
+        ranges[n].last = r[1] | 0UL;
+        n++;
+    }
+    backfillSetRanges(ranges, n);
+}
 
-    Serial.printf("[Server] POST to %s\n", endpoint.c_str());
-    int httpCode = http.POST(jsonPayload);
+// ============================================
+// Batch upload
+// ============================================
 
-    if (httpCode == 200) {
-        String response = http.getString();
-        Serial.printf("[Server] Response: %s\n", response.c_str());
-        http.end();
-        return true;
-    } else {
-        Serial.printf("[Server] HTTP Error: %d\n", httpCode);
-        http.end();
+#define BATCH_COLUMNS "\"packetId\",\"ageSec\",\"tempAire\",\"humAire\",\"tempSuelo\"," \
+                      "\"vwcSuelo\",\"ecSuelo\",\"par\",\"vBat\",\"batPercent\",\"soil\""
+
+static char batchBuf[SERVER_BATCH_BYTES];
+
+// JSON has no NaN: a failed sensor (or a garbage value) goes out as null
+static int putFloat(char* p, size_t room, float v, int decimals) {
+    if (isnan(v) || fabsf(v) >= 1e6f) return snprintf(p, room, "null");
+    return snprintf(p, room, "%.*f", decimals, v);
+}
+
+// Age of a record in seconds. Unknown (false) when the record or the
+// clock has no time (RTC not set): it goes out as null and the server
+// uses the arrival time.
+static bool recordAge(uint32_t now, uint32_t epoch, uint32_t& age) {
+    if (now == 0 || epoch == 0) return false;
+    age = now > epoch ? now - epoch : 0;
+    return true;
+}
+
+// One row of the column table, at most SERVER_ROW_MAX bytes (with the
+// leading comma). Precision as in the CSV log.
+static size_t putRow(char* p, const BinlogRecord& r, uint32_t now, bool first) {
+    size_t room = SERVER_ROW_MAX;
+    uint32_t age;
+    size_t n = snprintf(p, room, "%s[%lu,", first ? "" : ",", (unsigned long)r.packetId);
+    if (recordAge(now, r.epoch, age)) n += snprintf(p + n, room - n, "%lu,", (unsigned long)age);
+    else n += snprintf(p + n, room - n, "null,");
+    const float v[] = { r.tempAire, r.humAire, r.tempSuelo, r.vwcSuelo, r.ecSuelo, r.par, r.vBat };
+    const int dec[] = { 2, 2, 2, 2, 1, 1, 3 };
+    for (int i = 0; i < 7; i++) {
+        n += putFloat(p + n, room - n, v[i], dec[i]);
+        p[n++] = ',';
+    }
+    n += snprintf(p + n, room - n, "%u,[", (unsigned)r.batPercent);
+    for (uint8_t i = 0; i < r.soilCount && i < BINLOG_SOIL_MAX; i++) {
+        const BinlogSoil& s = r.soil[i];
+        char addr = isalnum((unsigned char)s.addr) ? s.addr : '?';  // SDI-12 address
+        n += snprintf(p + n, room - n, "%s[\"%c\",%u,", i ? "," : "", addr, (unsigned)s.depthCm);
+        n += putFloat(p + n, room - n, s.vwc, 2);
+        p[n++] = ',';
+        n += putFloat(p + n, room - n, s.temp, 2);
+        p[n++] = ',';
+        n += putFloat(p + n, room - n, s.ec, 1);
+        p[n++] = ']';
+    }
+    n += snprintf(p + n, room - n, "]]");
+    return n;
+}
+
+// Body with up to `max` of the oldest queued readings; returns its length
+// and the number of rows
+static size_t buildBatch(int max, int& rows) {
+    size_t len = snprintf(batchBuf, sizeof(batchBuf), "{\"columns\":[" BATCH_COLUMNS "],\"rows\":[");
+    uint32_t now = clockNowEpoch();
+    BinlogRecord chunk[UPQ_PEEK_CHUNK];
+    rows = 0;
+
+    bool full = false;
+    while (rows < max && !full) {
+        int want = max - rows < UPQ_PEEK_CHUNK ? max - rows : UPQ_PEEK_CHUNK;
+        uint8_t n = uploadQueuePeek(chunk, want, rows);
+        if (n == 0) break;
+        for (uint8_t i = 0; i < n; i++) {
+            if (sizeof(batchBuf) - len < SERVER_ROW_MAX + 3) {
+                full = true;
+                break;
+            }
+            len += putRow(batchBuf + len, chunk[i], now, rows == 0);
+            rows++;
+        }
+    }
+    len += snprintf(batchBuf + len, sizeof(batchBuf) - len, "]}");
+    return len;
+}
+
+static bool postBatch(size_t len, int rows) {
+    unsigned long t0 = millis();
+    String response;
+    int httpCode = uplinkPost("/api/data/batch", (const uint8_t*)batchBuf, len, &response);
+    if (httpCode != 200) {
+        Serial.printf("[Server] Batch HTTP Error: %d\n", httpCode);
         return false;
     }
+    parseBackfillRanges(response);
+    Serial.printf("[Server] Batch of %d (%u B) in %lu ms\n", rows, (unsigned)len, millis() - t0);
+    return true;
 }
 
-void flushRetryBuffer() {
-    if (retryCount == 0) return;
-    
-    Serial.printf("[Server] Flushing buffer (%d packets)...\n", retryCount);
-    
+// A new request only starts before the cycle's deadline (millis())
+static bool beforeDeadline(unsigned long deadline) {
+    return (long)(deadline - millis()) > 0;
+}
+
+// Send up to `maxPackets` of the oldest queued packets, one request per
+// SERVER_BATCH_MAX, stopping at the first failure or at `deadline`.
+// Returns how many were acknowledged.
+int serverDrainQueue(int maxPackets, unsigned long deadline) {
     int sent = 0;
-    int startIdx = (retryHead - retryCount + RETRY_BUFFER_SIZE) % RETRY_BUFFER_SIZE;
-    
-    for (int i = 0; i < retryCount; i++) {
-        int idx = (startIdx + i) % RETRY_BUFFER_SIZE;
-        if (retryBuffer[idx].valid) {
-            if (sendPacketToServer(retryBuffer[idx].data, retryBuffer[idx].timestamp)) {
-                retryBuffer[idx].valid = false;
-                sent++;
-            } else {
-                break;  // Stop on failure
-            }
+
+    uploadQueueWait(UPQ_STORE_WAIT_MS);
+
+    while (sent < maxPackets && uploadQueuePending() > 0 && WiFi.status() == WL_CONNECTED &&
+           beforeDeadline(deadline) && !stopAsked) {
+        int want = maxPackets - sent < SERVER_BATCH_MAX ? maxPackets - sent : SERVER_BATCH_MAX;
+        int rows;
+        size_t len = buildBatch(want, rows);
+        if (rows == 0) break;
+        if (!postBatch(len, rows)) {
+            lastServerOk = false;
+            break;
         }
+        uploadQueuePop(rows);
+        sent += rows;
+        lastServerOk = true;
+        lastServerSendTime = millis();
     }
-    
-    retryCount -= sent;
-    if (retryCount < 0) retryCount = 0;
-    serverPendingCount = retryCount;
-    
+
+    serverPendingCount = uploadQueuePending();
     if (sent > 0) {
-        Serial.printf("[Server] Flushed %d buffered packets\n", sent);
+        Serial.printf("[Server] Sent %d queued packets, %d pending\n", sent, serverPendingCount);
+    }
+    return sent;
+}
+
+// Upload one batch of records re-read from the SD log. Readings carry
+// their age in seconds; the server turns it into a sample time.
+static bool sendBackfillBatch(const BackfillBatch& batch) {
+    if (WiFi.status() != WL_CONNECTED) return false;
+
+    JsonDocument doc;
+    uint32_t now = clockNowEpoch();
+    JsonArray list = doc["readings"].to<JsonArray>();
+    for (uint8_t i = 0; i < batch.count; i++) {
+        MeteorDataPacket data;
+        binlogPacketFromRecord(batch.records[i], data);
+        JsonObject r = list.add<JsonObject>();
+        packetToJson(r, data);
+        uint32_t age;
+        if (recordAge(now, batch.records[i].epoch, age)) r["ageSec"] = age;
+        else r["ageSec"] = nullptr;
+    }
+    JsonArray missing = doc["unavailable"].to<JsonArray>();
+    for (uint8_t i = 0; i < batch.missingCount; i++) {
+        JsonArray m = missing.add<JsonArray>();
+        m.add(batch.missing[i].first);
+        m.add(batch.missing[i].last);
+    }
+
+    String jsonPayload;
+    serializeJson(doc, jsonPayload);
+
+    String response;
+    int httpCode = uplinkPost("/api/data/backfill", (const uint8_t*)jsonPayload.c_str(),
+                              jsonPayload.length(), &response);
+    if (httpCode != 200) {
+        Serial.printf("[Server] Backfill HTTP Error: %d\n", httpCode);
+        return false;
+    }
+
+    backfillDone(batch);
+    parseBackfillRanges(response);
+    Serial.printf("[Server] Backfill %lu..%lu: %u sent, %u ids not on card\n",
+                  (unsigned long)batch.span.first, (unsigned long)batch.span.last,
+                  batch.count, (unsigned)(batch.span.last - batch.span.first + 1 - batch.count));
+    return true;
+}
+
+int serverBackfill(int maxBatches, unsigned long deadline) {
+    static BackfillBatch batch;  // ~1 KB, off the task stack
+    int sent = 0;
+
+    for (int i = 0; i < maxBatches && backfillRangeCount() > 0 &&
+         beforeDeadline(deadline) && !stopAsked; i++) {
+        if (!backfillCollect(batch)) break;
+        if (!sendBackfillBatch(batch)) {
+            lastServerOk = false;
+            break;
+        }
+        sent += batch.count;
     }
+    return sent;
+}
+
+// ============================================
+// Uplink task
+// ============================================
+
+// All uploads of the interactive mode run here, so a slow or dead server
+// never holds up loop(): it only queues readings and asks for a send.
+// Requests have deadlines, a cycle stops after UPLINK_CYCLE_BUDGET_MS and
+// failures back off (shared/uplink.h). serverClientStop() ends it between
+// requests.
+static void serverTask(void* arg) {
+    unsigned long lastBackfillTime = 0;
+
+    while (true) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERVER_TASK_POLL_MS)) > 0) uploadAsked = true;
+        if (stopAsked) break;
+        uplinkLoop();
+        if (!serverConfigured || WiFi.status() != WL_CONNECTED || !uplinkReady()) continue;
+
+        // Regular send: the whole queue (up to SERVER_UPLOAD_BATCHES
+        // requests). In between, only a backlog of a full batch or more.
+        if (uploadAsked || uploadQueuePending() >= SERVER_BATCH_MAX) {
+            bool asked = uploadAsked;
+            serverDrainQueue(asked ? SERVER_BATCH_MAX * SERVER_UPLOAD_BATCHES : SERVER_BATCH_MAX,
+                             millis() + UPLINK_CYCLE_BUDGET_MS);
+            if (asked && lastServerOk) uploadAsked = false;
+            continue;
+        }
+
+        // Gaps the server asked for go last, one batch per BACKFILL_INTERVAL_MS
+        if (backfillRangeCount() == 0) continue;
+        if (millis() - lastBackfillTime < BACKFILL_INTERVAL_MS) continue;
+        lastBackfillTime = millis();
+        serverBackfill(1, millis() + UPLINK_CYCLE_BUDGET_MS);
+    }
+
+    // Nothing in flight: the caller may close the connection and sleep
+    uplinkTask = NULL;
+    vTaskDelete(NULL);
 }
 
 // ============================================
@@ -130,13 +304,9 @@ void flushRetryBuffer() {
 // ============================================
 
 void serverClientInit() {
-    // Allow insecure connection (skip certificate validation)
-    secureClient.setInsecure();
-    
-    // Initialize retry buffer
-    for (int i = 0; i < RETRY_BUFFER_SIZE; i++) {
-        retryBuffer[i].valid = false;
-    }
+    // Pending packets survive reboots on the SD card
+    uploadQueueBegin();
+    serverPendingCount = uploadQueuePending();
     
     loadServerSettings();
     Serial.println("[Server] Client initialized");
@@ -163,6 +333,8 @@ void loadServerSettings() {
     serverEnabled = prefs.getBool("enabled", true);
 
     prefs.end();
+    uplinkSetServer(serverUrl, apiKey);
+    serverConfigured = serverEnabled && !serverUrl.isEmpty() && !apiKey.isEmpty();
 }
 
 void saveServerSettings(const String& url, const String& key, bool enabled) {
@@ -178,43 +350,62 @@ void saveServerSettings(const String& url, const String& key, bool enabled) {
     serverUrl = url;
     apiKey = key;
     serverEnabled = enabled;
+    uplinkSetServer(serverUrl, apiKey);
+    serverConfigured = serverEnabled && !serverUrl.isEmpty() && !apiKey.isEmpty();
 
     Serial.println("[Server] Settings saved");
 }
 
-bool sendToServer(const MeteorDataPacket& data) {
-    if (!serverEnabled || serverUrl.isEmpty() || apiKey.isEmpty()) {
-        Serial.println("[Server] Not configured");
+void serverQueueReading(const MeteorDataPacket& data) {
+    if (!serverEnabled) return;
+    uploadQueuePush(data, clockNowEpoch());
+    serverPendingCount = uploadQueuePending();
+}
+
+void serverClientStart() {
+    if (uplinkTask) return;
+    stopAsked = false;
+    xTaskCreatePinnedToCore(serverTask, "uplink", SERVER_TASK_STACK, NULL,
+                            SERVER_TASK_PRIORITY, &uplinkTask, SERVER_TASK_CORE);
+}
+
+bool serverClientStop() {
+    if (!uplinkTask) return true;
+
+    stopAsked = true;
+    xTaskNotifyGive(uplinkTask);
+    unsigned long start = millis();
+    while (uplinkTask && millis() - start < SERVER_STOP_WAIT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (uplinkTask) {
+        Serial.println("[Server] Uplink task did not stop");
         return false;
     }
+    return true;
+}
 
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("[Server] WiFi not connected, buffering");
-        bufferPacket(data);
-        lastServerOk = false;
+void serverRequestUpload() {
+    if (uplinkTask) xTaskNotifyGive(uplinkTask);
+}
+
+bool serverUpload(int maxPackets, unsigned long deadline) {
+    if (!serverConfigured) {
+        Serial.println("[Server] Not configured");
         return false;
     }
 
-    String timestamp = rtcGetTimestamp();
-    
-    if (sendPacketToServer(data, timestamp)) {
-        Serial.println("[Server] Data sent OK");
-        lastServerOk = true;
-        lastServerSendTime = millis();
-        
-        // Flush buffered packets
-        if (retryCount > 0) {
-            flushRetryBuffer();
-        }
-        return true;
-    } else {
-        Serial.println("[Server] Send failed, buffering");
-        bufferPacket(data);
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("[Server] WiFi not connected, readings stay queued");
         lastServerOk = false;
         return false;
     }
+
+    lastServerOk = true;
+    serverDrainQueue(maxPackets, deadline);
+    return lastServerOk;
 }
 
 int getPendingCount() {
-    return retryCount;
+    return uploadQueuePending();
 }
@@ -5,6 +5,25 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include "../shared/config.h"
+#include "upload_queue.h"
+#include "../shared/uplink.h"
+
+// Batch upload (POST /api/data/batch): every measurement is queued
+// (upload_queue.h) and goes out with the others as a row of one request,
+// with its age in seconds instead of a timestamp
+#define SERVER_BATCH_MAX        100     // readings per request
+#define SERVER_BATCH_BYTES      16384   // request body buffer
+#define SERVER_ROW_MAX          320     // longest row (four soil probes)
+#define SERVER_UPLOAD_BATCHES   4       // requests per regular send
+
+// Uplink task (interactive mode; the deep-sleep cycle uploads inline)
+#define SERVER_TASK_STACK       8192    // TLS handshake
+#define SERVER_TASK_PRIORITY    1
+#define SERVER_TASK_CORE        0       // with the WiFi stack, off the loop() core
+#define SERVER_TASK_POLL_MS     UPQ_DRAIN_INTERVAL_MS  // backlog and backfill checks
+// serverClientStop(): the request in flight, with its retry on a new
+// connection (shared/uplink.h deadlines)
+#define SERVER_STOP_WAIT_MS     (2 * UPLINK_TIMEOUT_MS + UPLINK_CONNECT_MS + UPLINK_HANDSHAKE_S * 1000)
 
 // Server configuration
 extern String serverUrl;
@@ -23,11 +42,36 @@ extern int serverPendingCount;
 void serverClientInit();
 
 /**
- * Send data to server
- * @param data Sensor data packet
- * @return true if successful
+ * Queue a measurement for upload (every measurement, not only the ones
+ * taken at a send boundary)
+ */
+void serverQueueReading(const MeteorDataPacket& data);
+
+/**
+ * Start the uplink task, which then does every upload (interactive mode)
+ */
+void serverClientStart();
+
+/**
+ * Stop the uplink task before deep sleep: it finishes the request in
+ * flight (and pops what the server acknowledged), starts no other and
+ * exits. Waits up to SERVER_STOP_WAIT_MS.
+ * @return true if the task is not running any more
+ */
+bool serverClientStop();
+
+/**
+ * Ask the uplink task for a regular send; returns at once. The send is
+ * kept pending until it succeeds.
  */
-bool sendToServer(const MeteorDataPacket& data);
+void serverRequestUpload();
+
+/**
+ * Upload up to maxPackets queued readings in the calling task, oldest
+ * first, starting no request after `deadline` (millis(); deep-sleep cycle)
+ * @return true if every request succeeded
+ */
+bool serverUpload(int maxPackets, unsigned long deadline);
 
 /**
  * Save server settings to NVS
@@ -40,7 +84,21 @@ void saveServerSettings(const String& url, const String& key, bool enabled);
 void loadServerSettings();
 
 /**
- * Get number of packets pending in retry buffer
+ * Send up to maxPackets queued packets, oldest first, in batches, starting
+ * no request after `deadline` (millis())
+ * @return number of packets acknowledged
+ */
+int serverDrainQueue(int maxPackets, unsigned long deadline);
+
+/**
+ * Upload up to maxBatches backfill batches requested by the server
+ * (backfill.h), stopping at the first failure or at `deadline`
+ * @return number of records uploaded
+ */
+int serverBackfill(int maxBatches, unsigned long deadline);
+
+/**
+ * Get number of packets pending in the upload queue
  */
 int getPendingCount();
 
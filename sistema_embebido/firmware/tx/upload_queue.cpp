@@ -0,0 +1,404 @@
+/**
+ * Upload Queue Implementation
+ */
+
+#include "upload_queue.h"
+#include "binlog.h"
+#include "sd_logger.h"
+#include "../shared/spsc_ring.h"
+#include <SD.h>
+
+#define UPQ_CURSOR_MAGIC  0x52515055UL  // "UPQR"
+#define UPQ_CURSOR_SIZE   20
+#define UPQ_LEGACY_MAGIC  0x43515055UL  // "UPQC": append-log queue, 16-byte cursor
+#define UPQ_LEGACY_SIZE   16
+#define UPQ_NO_POS        0xFFFFFFFFUL
+
+enum CursorKind { CURSOR_NONE, CURSOR_RING, CURSOR_LEGACY };
+
+// Entries are numbered from 0 for good; entry i lives in slot
+// i % UPQ_MAX_RECORDS, tagged i + 1 (binlog_format.h)
+static File qFile;
+static bool qOpen = false;
+static uint32_t qHead = 0;    // next entry to write
+static uint32_t qCursor = 0;  // first unacknowledged entry
+static uint32_t qSize = 0;    // file size
+static uint32_t qPos = UPQ_NO_POS;  // write position, if known
+static bool qDirty = false;   // appended since the last flush
+static uint32_t qSeq = 0;     // cursor write sequence
+static uint32_t qDropped = 0;
+
+// Measurement loop -> storage task
+struct UpqPush {
+    MeteorDataPacket data;
+    uint32_t epoch;
+};
+
+static SpscRing<UpqPush, UPQ_RING_SIZE> pushRing;
+static volatile uint32_t pushesQueued = 0;   // measurement loop
+static volatile uint32_t pushesStored = 0;   // storage task
+static uint32_t pushDrops = 0;               // ring full (measurement loop)
+
+// Fallback while the card is missing (RTC memory: survives deep sleep,
+// reloaded empty on any other boot)
+RTC_DATA_ATTR static BinlogRecord stage[UPQ_STAGE_SIZE];
+RTC_DATA_ATTR static uint8_t stageHead = 0;
+RTC_DATA_ATTR static uint8_t stageCount = 0;
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// ============================================
+// Cursor file: two copies, newest valid wins
+// ============================================
+
+// Cursor and head of the newest valid copy. A legacy cursor (older
+// firmware) only sets qCursor.
+static CursorKind loadCursor() {
+    qCursor = 0;
+    qHead = 0;
+    qSeq = 0;
+    File f = SD.open(UPQ_CURSOR_PATH, FILE_READ);
+    if (!f) return CURSOR_NONE;
+
+    uint8_t buf[2 * UPQ_CURSOR_SIZE];
+    size_t n = f.read(buf, sizeof(buf));
+    f.close();
+
+    if (n >= UPQ_LEGACY_SIZE && get32(buf) == UPQ_LEGACY_MAGIC) {
+        uint32_t seq = 0;
+        bool found = false;
+        for (size_t off = 0; off + UPQ_LEGACY_SIZE <= n; off += UPQ_LEGACY_SIZE) {
+            const uint8_t* c = buf + off;
+            if (get32(c) != UPQ_LEGACY_MAGIC || get32(c + 12) != binlogCrc32(c, 12)) continue;
+            if (!found || get32(c + 4) > seq) {
+                seq = get32(c + 4);
+                qCursor = get32(c + 8);
+                found = true;
+            }
+        }
+        return found ? CURSOR_LEGACY : CURSOR_NONE;
+    }
+
+    bool found = false;
+    for (size_t off = 0; off + UPQ_CURSOR_SIZE <= n; off += UPQ_CURSOR_SIZE) {
+        const uint8_t* c = buf + off;
+        if (get32(c) != UPQ_CURSOR_MAGIC) continue;
+        if (get32(c + 16) != binlogCrc32(c, 16)) continue;
+        uint32_t seq = get32(c + 4);
+        if (!found || seq > qSeq) {
+            qSeq = seq;
+            qCursor = get32(c + 8);
+            qHead = get32(c + 12);
+            found = true;
+        }
+    }
+    return found ? CURSOR_RING : CURSOR_NONE;
+}
+
+// Durability point: flush the appended slots, then record how far they go
+static void saveCursor() {
+    if (qOpen && qDirty) {
+        qFile.flush();
+        qDirty = false;
+    }
+
+    uint8_t c[UPQ_CURSOR_SIZE];
+    qSeq++;
+    put32(c, UPQ_CURSOR_MAGIC);
+    put32(c + 4, qSeq);
+    put32(c + 8, qCursor);
+    put32(c + 12, qHead);
+    put32(c + 16, binlogCrc32(c, 16));
+
+    // Overwrite the older copy in place; a torn write leaves the other one
+    File f = SD.open(UPQ_CURSOR_PATH, "r+");
+    if (!f) f = SD.open(UPQ_CURSOR_PATH, FILE_WRITE);
+    if (!f) return;
+    f.seek((qSeq & 1) * UPQ_CURSOR_SIZE);
+    f.write(c, sizeof(c));
+    f.close();
+}
+
+// ============================================
+// Queue file: a ring of UPQ_MAX_RECORDS slots
+// ============================================
+
+static bool readSlot(uint32_t slotNo, uint8_t* slot) {
+    uint32_t off = slotNo * BINLOG_SLOT_SIZE;
+    if (off + BINLOG_SLOT_SIZE > qSize) return false;
+    qPos = UPQ_NO_POS;
+    return qFile.seek(off) && qFile.read(slot, BINLOG_SLOT_SIZE) == BINLOG_SLOT_SIZE;
+}
+
+// False if the slot is torn, corrupt or holds another lap's entry
+static bool readEntry(uint32_t index, BinlogRecord& out) {
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    return readSlot(index % UPQ_MAX_RECORDS, slot) && binlogDecodeRecord(slot, out) &&
+           binlogRecordTag(slot) == index + 1;
+}
+
+// Not flushed: the storage task's durability points and every pop call
+// saveCursor()
+static bool appendToFile(const BinlogRecord& rec) {
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    binlogEncodeRecord(rec, slot, qHead + 1);
+    uint32_t off = (qHead % UPQ_MAX_RECORDS) * BINLOG_SLOT_SIZE;
+    if ((qPos != off && !qFile.seek(off)) || qFile.write(slot, sizeof(slot)) != sizeof(slot)) {
+        Serial.println("[UPQ] Write failed, using RAM");
+        qFile.close();
+        qOpen = false;
+        return false;
+    }
+    qPos = off + BINLOG_SLOT_SIZE;
+    if (qPos > qSize) qSize = qPos;
+    qHead++;
+    qDirty = true;
+
+    // Full: the oldest entry's slot was just reused
+    if (qHead - qCursor > UPQ_MAX_RECORDS) {
+        qCursor = qHead - UPQ_MAX_RECORDS;
+        qDropped++;
+    }
+    return true;
+}
+
+static void stagePush(const BinlogRecord& rec) {
+    stage[stageHead] = rec;
+    stageHead = (stageHead + 1) % UPQ_STAGE_SIZE;
+    if (stageCount < UPQ_STAGE_SIZE) stageCount++;
+    else qDropped++;
+}
+
+// Staged packets are older than anything queued after the card came back
+static void moveStageToFile() {
+    uint8_t start = (stageHead + UPQ_STAGE_SIZE - stageCount) % UPQ_STAGE_SIZE;
+    while (stageCount > 0 && qOpen) {
+        if (!appendToFile(stage[start])) return;
+        start = (start + 1) % UPQ_STAGE_SIZE;
+        stageCount--;
+    }
+}
+
+static bool openFile() {
+    qFile = SD.open(UPQ_PATH, "r+");
+    if (!qFile) {
+        File created = SD.open(UPQ_PATH, FILE_WRITE);
+        if (created) created.close();
+        qFile = SD.open(UPQ_PATH, "r+");
+    }
+    qSize = qFile ? qFile.size() : 0;
+    qPos = UPQ_NO_POS;
+    qDirty = false;
+    return qFile;
+}
+
+// Older firmware kept an append-only file: copy its pending entries (the
+// newest UPQ_MAX_RECORDS) into a fresh ring. An interrupted copy is redone
+// from UPQ_LEGACY_PATH on the next boot.
+static void migrateLegacy() {
+    uint32_t from = qCursor;
+    qFile.close();
+    if (!SD.exists(UPQ_LEGACY_PATH)) SD.rename(UPQ_PATH, UPQ_LEGACY_PATH);
+    else SD.remove(UPQ_PATH);
+
+    File old = SD.open(UPQ_LEGACY_PATH, FILE_READ);
+    uint32_t count = old ? old.size() / BINLOG_SLOT_SIZE : 0;
+    if (count > UPQ_MAX_RECORDS && from < count - UPQ_MAX_RECORDS) from = count - UPQ_MAX_RECORDS;
+
+    qHead = 0;
+    qCursor = 0;
+    qOpen = openFile();
+    if (old && qOpen && from < count) {
+        old.seek(from * BINLOG_SLOT_SIZE);
+        uint8_t slot[BINLOG_SLOT_SIZE];
+        BinlogRecord rec;
+        for (uint32_t i = from; i < count && qOpen; i++) {
+            if (old.read(slot, sizeof(slot)) != sizeof(slot)) break;
+            if (binlogDecodeRecord(slot, rec)) appendToFile(rec);
+            else qDropped++;
+        }
+    }
+    if (old) old.close();
+    if (!qOpen) return;
+    saveCursor();
+    SD.remove(UPQ_LEGACY_PATH);
+    Serial.printf("[UPQ] Moved %u entries to the ring file\n", qHead);
+}
+
+static void queueBegin() {
+    if (qOpen) qFile.close();
+    qOpen = false;
+    if (!sdConnected) {
+        Serial.println("[UPQ] No SD card, queue in RAM only");
+        return;
+    }
+
+    if (!openFile()) {
+        Serial.println("[UPQ] Open failed, queue in RAM only");
+        return;
+    }
+    qOpen = true;
+
+    CursorKind kind = loadCursor();
+    if (kind == CURSOR_NONE) {
+        // Cursor lost: slot 0 tells the lap; resend what the file holds
+        uint8_t slot[BINLOG_SLOT_SIZE];
+        BinlogRecord rec;
+        if (readSlot(0, slot) && binlogDecodeRecord(slot, rec)) {
+            uint32_t tag = binlogRecordTag(slot);
+            if (tag == 0) kind = CURSOR_LEGACY;
+            else qHead = tag - 1;
+        }
+    }
+    if (kind == CURSOR_LEGACY) {
+        migrateLegacy();
+        if (!qOpen) return;
+    }
+
+    // Entries written after the last saved head
+    BinlogRecord rec;
+    for (uint32_t i = 0; i < UPQ_MAX_RECORDS && readEntry(qHead, rec); i++) qHead++;
+    if (qCursor > qHead) qCursor = qHead;
+    if (qHead - qCursor > UPQ_MAX_RECORDS) qCursor = qHead - UPQ_MAX_RECORDS;
+
+    moveStageToFile();
+    Serial.printf("[UPQ] %u pending (%u slots on card)\n", uploadQueuePending(),
+                  qSize / BINLOG_SLOT_SIZE);
+}
+
+static void queuePush(const MeteorDataPacket& data, uint32_t epoch) {
+    BinlogRecord rec;
+    binlogRecordFromPacket(data, epoch, rec);
+
+    if (!qOpen && sdConnected) queueBegin();
+    if (qOpen) {
+        moveStageToFile();
+        if (qOpen && appendToFile(rec)) return;
+    }
+    stagePush(rec);
+}
+
+static uint8_t queuePeek(BinlogRecord* out, uint8_t max, uint32_t skip) {
+    uint8_t n = 0;
+
+    if (!qOpen || qCursor >= qHead) {
+        // RAM ring (only holds packets while the card is unavailable)
+        uint8_t start = (stageHead + UPQ_STAGE_SIZE - stageCount) % UPQ_STAGE_SIZE;
+        while (n < max && skip + n < stageCount) {
+            out[n] = stage[(start + skip + n) % UPQ_STAGE_SIZE];
+            n++;
+        }
+        return n;
+    }
+
+    uint32_t skipped = 0;
+    while (n < max && qCursor + skip + skipped + n < qHead) {
+        if (readEntry(qCursor + skip + skipped + n, out[n])) {
+            n++;
+        } else if (n == 0 && skip == 0) {
+            skipped++;  // torn or corrupt entry at the front
+        } else {
+            break;      // dropped once it reaches the front
+        }
+    }
+
+    if (skipped > 0) {
+        qCursor += skipped;
+        qDropped += skipped;
+        saveCursor();
+    }
+    return n;
+}
+
+static void queuePop(uint8_t n) {
+    if (n == 0) return;
+
+    if (!qOpen || qCursor >= qHead) {
+        if (n > stageCount) n = stageCount;
+        stageCount -= n;
+        return;
+    }
+
+    qCursor += n;
+    if (qCursor > qHead) qCursor = qHead;
+    saveCursor();
+}
+
+// ============================================
+// Public API (the storage task shares the card)
+// ============================================
+
+void uploadQueueBegin() {
+    sdLock();
+    queueBegin();
+    sdUnlock();
+}
+
+void uploadQueuePush(const MeteorDataPacket& data, uint32_t epoch) {
+    UpqPush p;
+    p.data = data;
+    p.epoch = epoch;
+    if (!pushRing.push(p)) {
+        pushDrops++;
+        return;
+    }
+    pushesQueued = pushesQueued + 1;
+    sdNotify();
+}
+
+void uploadQueueStore() {
+    UpqPush p;
+    while (pushRing.pop(p)) {
+        sdLock();
+        queuePush(p.data, p.epoch);
+        pushesStored = pushesStored + 1;
+        sdUnlock();
+    }
+}
+
+void uploadQueueWait(uint32_t waitMs) {
+    sdNotify();
+    unsigned long start = millis();
+    while (pushesStored != pushesQueued && millis() - start < waitMs) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+void uploadQueueFlush() {
+    sdLock();
+    if (qOpen && qDirty) saveCursor();
+    sdUnlock();
+}
+
+uint8_t uploadQueuePeek(BinlogRecord* out, uint8_t max, uint32_t skip) {
+    sdLock();
+    uint8_t n = queuePeek(out, max, skip);
+    sdUnlock();
+    return n;
+}
+
+void uploadQueuePop(uint8_t n) {
+    sdLock();
+    queuePop(n);
+    sdUnlock();
+}
+
+uint32_t uploadQueuePending() {
+    return (qOpen ? qHead - qCursor : 0) + stageCount + pushRing.size();
+}
+
+uint32_t uploadQueueDropped() {
+    return qDropped + pushDrops;
+}
+
+bool uploadQueueDurable() {
+    return qOpen;
+}
@@ -0,0 +1,74 @@
+/**
+ * Upload Queue - durable store-and-forward for server uploads
+ *
+ * /upq.dat on the SD card is a ring of UPQ_MAX_RECORDS CRC-checked binlog
+ * record slots (binlog_format.h): entry i goes to slot i % UPQ_MAX_RECORDS,
+ * tagged with i + 1, so the file never grows past the ring and a full
+ * queue overwrites its oldest entry. Uploads take batches from the front.
+ * /upq.cur holds the read cursor (how far the server has acknowledged) and
+ * the head, as two alternating CRC-protected copies.
+ *
+ * Appends are not flushed one by one: the slots and the head reach the card
+ * at the storage task's durability points (uploadQueueFlush()) and on every
+ * pop. Boot recovery reads the cursor and follows the tags past the saved
+ * head. With the card missing, packets wait in a small RTC-memory ring and
+ * move to the card once it is back.
+ *
+ * uploadQueuePush() only puts the packet into a lock-free ring; the
+ * storage task (sd_logger.h) appends it with uploadQueueStore(), so the
+ * measurement loop never takes sdLock(). Peek and pop run in the uplink
+ * task under sdLock().
+ */
+
+#ifndef TX_UPLOAD_QUEUE_H
+#define TX_UPLOAD_QUEUE_H
+
+#include <Arduino.h>
+#include "binlog_format.h"
+#include "../shared/config.h"
+
+#define UPQ_PATH            "/upq.dat"
+#define UPQ_CURSOR_PATH     "/upq.cur"
+#define UPQ_LEGACY_PATH     "/upq.old"  // append-only file of older firmware, while migrating
+#define UPQ_MAX_RECORDS     20160   // 2 weeks at 1 min, 20 weeks at 10 min (2.5 MB file)
+#define UPQ_STAGE_SIZE      16      // RTC ring used while the card is missing
+#define UPQ_RING_SIZE       16      // pushes waiting for the storage task (power of 2)
+#define UPQ_STORE_WAIT_MS   2000    // uploadQueueWait() before a regular send
+
+// Drain rate (one step is one batch request, server_client.h)
+#define UPQ_PEEK_CHUNK        10    // records read from the card at a time
+#define UPQ_DRAIN_INTERVAL_MS 5000  // between drain steps (uplink task)
+#define UPQ_DUTY_DRAIN_MAX    300   // packets per deep-sleep wake
+
+// Open the queue and recover the cursor; call after sdInit()
+void uploadQueueBegin();
+
+// Queue a packet measured at `epoch`. Never blocks: the storage task
+// stores it. Drops the oldest when the queue is full, and the packet
+// itself (counted) when the ring is.
+void uploadQueuePush(const MeteorDataPacket& data, uint32_t epoch);
+
+// Storage task: move pushed packets into the queue (holds sdLock())
+void uploadQueueStore();
+
+// Storage task, at its durability points: write the appended slots to the
+// card and save the head
+void uploadQueueFlush();
+
+// Wait up to `waitMs` until the storage task has stored every push, so a
+// send includes the reading just taken
+void uploadQueueWait(uint32_t waitMs);
+
+// Read up to `max` of the oldest packets, after the first `skip`, without
+// removing them. Entries that fail their CRC at the front are dropped
+// (counted in uploadQueueDropped()); further in, they end the read.
+uint8_t uploadQueuePeek(BinlogRecord* out, uint8_t max, uint32_t skip = 0);
+
+// Drop `n` entries from the front and persist the cursor
+void uploadQueuePop(uint8_t n);
+
+uint32_t uploadQueuePending();
+uint32_t uploadQueueDropped();
+bool uploadQueueDurable();
+
+#endif
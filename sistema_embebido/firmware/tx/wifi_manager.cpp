@@ -9,6 +9,11 @@
 #include "server_client.h"
 #include "sensors.h"
 #include "rtc.h"
+#include "history.h"
+#include "sd_logger.h"
+#include "../shared/loop_stats.h"
+#include "../shared/oled_tiles.h"
+#include <memory>
 
 // Web Server Instance
 AsyncWebServer server(80);
@@ -84,9 +89,37 @@ bool wifiInit() {
     }
 }
 
+bool wifiConnectSta(unsigned long timeoutMs) {
+    Preferences preferences;
+    preferences.begin("wifi-config", true);
+    String ssid = preferences.getString("ssid", "");
+    String pass = preferences.getString("pass", "");
+    preferences.end();
+
+    wifiConnected = false;
+    if (ssid == "") return false;
+
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(ssid.c_str(), pass.c_str());
+
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
+        delay(50);
+    }
+
+    wifiConnected = WiFi.status() == WL_CONNECTED;
+    Serial.printf("[WiFi] %s in %lu ms\n", wifiConnected ? "Connected" : "Connect failed",
+                  millis() - start);
+    return wifiConnected;
+}
+
 // Shared sensor data handler (used by both STA and AP mode)
 static void handleDataRequest(AsyncWebServerRequest *request) {
     extern MeteorDataPacket currentData;
+    LoopStats ls;
+    OledStats os;
+    loopStatsGet(ls);
+    oledGetStats(os);
 
     String json = "{";
     json += "\"tempAire\":"  + String(currentData.tempAire, 1)  + ",";
@@ -96,14 +129,70 @@ static void handleDataRequest(AsyncWebServerRequest *request) {
     json += "\"ecSuelo\":"   + String(currentData.ecSuelo, 0)   + ",";
     json += "\"par\":"       + String(currentData.par, 0)       + ",";
     json += "\"parUV\":"     + String(parSensorUV, 1)           + ",";
+    json += "\"parMin\":"    + String(parMin, 0)                + ",";
+    json += "\"parMax\":"    + String(parMax, 0)                + ",";
+    json += "\"parInt\":"    + String(parIntegral, 0)           + ",";
     json += "\"vBat\":"      + String(currentData.vBat, 2)      + ",";
     json += "\"batPct\":"    + String(currentData.batPercent)   + ",";
     json += "\"wifiRSSI\":"  + String(WiFi.RSSI())              + ",";
-    json += "\"serverOk\":"  + String(lastServerOk ? "true" : "false");
-    json += "}";
+    json += "\"serverOk\":"  + String(lastServerOk ? "true" : "false") + ",";
+    json += "\"loopUs\":"    + String(ls.avgUs)                 + ",";
+    json += "\"loopMaxUs\":" + String(ls.maxUs)                 + ",";
+    json += "\"oledBpm\":"   + String(os.bytesPerMin)           + ",";
+    json += "\"soil\":[";
+    for (uint8_t i = 0; i < currentData.soilCount && i < SOIL_MAX_PROBES; i++) {
+        const SoilProbeReading& p = currentData.soil[i];
+        if (i) json += ",";
+        json += "{\"depth\":" + String(p.depthCm) +
+                ",\"vwc\":"  + String(p.vwc, 1) +
+                ",\"temp\":" + String(p.temp, 1) +
+                ",\"ec\":"   + String(p.ec, 0) + "}";
+    }
+    json += "]}";
     request->send(200, "application/json", json);
 }
 
+// SD history download: /history?from=<epoch>&to=<epoch>&format=csv|bin
+// (history.h). Streams in chunks; the cursor lives as long as the response.
+static void handleHistoryRequest(AsyncWebServerRequest *request) {
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    if (request->hasParam("from")) from = strtoul(request->getParam("from")->value().c_str(), NULL, 10);
+    if (request->hasParam("to")) to = strtoul(request->getParam("to")->value().c_str(), NULL, 10);
+    String format = request->hasParam("format") ? request->getParam("format")->value() : String("csv");
+
+    HistoryFormat fmt;
+    if (format == "csv") {
+        fmt = HISTORY_CSV;
+    } else if (format == "bin") {
+        fmt = HISTORY_DELTA;
+    } else {
+        request->send(400, "text/plain", "format: csv o bin");
+        return;
+    }
+    if (from > to) {
+        request->send(400, "text/plain", "from > to");
+        return;
+    }
+
+    HistoryCursor* c = historyOpen(from, to, fmt);
+    if (!c) {
+        request->send(503, "text/plain", sdConnected ? "Descarga en curso" : "Sin tarjeta SD");
+        return;
+    }
+    std::shared_ptr<HistoryCursor> cursor(c, historyClose);
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        fmt == HISTORY_CSV ? "text/csv" : "application/octet-stream",
+        [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t n = historyRead(cursor.get(), buffer, maxLen);
+            return n == HISTORY_TRY_AGAIN ? RESPONSE_TRY_AGAIN : n;
+        });
+    response->addHeader("Content-Disposition", fmt == HISTORY_CSV ?
+                        "attachment; filename=\"history.csv\"" :
+                        "attachment; filename=\"history.dlt\"");
+    request->send(response);
+}
+
 void webServerInit() {
     if (wifiConnected) {
         // --- STA MODE (Status page) ---
@@ -114,6 +203,10 @@ void webServerInit() {
         server.on("/data", HTTP_GET, [](AsyncWebServerRequest *request) {
             handleDataRequest(request);
         });
+
+        server.on("/history", HTTP_GET, [](AsyncWebServerRequest *request) {
+            handleHistoryRequest(request);
+        });
         
         // Get server config
         server.on("/get_server", HTTP_GET, [](AsyncWebServerRequest *request) {
@@ -147,6 +240,10 @@ void webServerInit() {
         server.on("/data", HTTP_GET, [](AsyncWebServerRequest *request) {
             handleDataRequest(request);
         });
+
+        server.on("/history", HTTP_GET, [](AsyncWebServerRequest *request) {
+            handleHistoryRequest(request);
+        });
         
         server.on("/start_scan", HTTP_GET, [](AsyncWebServerRequest *request) {
             WiFi.scanNetworks(true);
@@ -24,4 +24,8 @@ void wifiReset();
 // Check and maintain WiFi connection
 void wifiLoop();
 
+// Headless STA connect for deep-sleep wakes: no display, no AP fallback.
+// Returns true once connected within `timeoutMs`.
+bool wifiConnectSta(unsigned long timeoutMs);
+
 #endif
@@ -0,0 +1,626 @@
+/**
+ * binlog_tool - host reader/converter for the TX binary log (/data.bin)
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/tx binlog_tool.cpp ../firmware/tx/binlog_format.cpp ../firmware/tx/delta_codec.cpp -o binlog_tool
+ *
+ * Usage:
+ *   binlog_tool info <file>
+ *   binlog_tool csv  <file> [fromEpoch [toEpoch]]
+ *   binlog_tool json <file> [fromEpoch [toEpoch]]
+ *   binlog_tool find-time   <file> <epoch>
+ *   binlog_tool find-packet <file> <packetId>
+ *   binlog_tool roundtrip   <scratchFile> [records]
+ *   binlog_tool dlt-csv     <file.dlt>
+ *   binlog_tool compress    <file.bin> <out.dlt>
+ *   binlog_tool bench       <out.dlt> [records]
+ *
+ * `roundtrip` writes synthetic logs through the same encoder and writer
+ * state the firmware uses, reads them back and checks every field, the
+ * resumed state and the lookups against a linear scan. Exit status 0 = ok.
+ *
+ * `bench` encodes a synthetic day-cycle series with the delta codec
+ * (delta_codec.h), checks the decoded values and keyframe seeks, and
+ * reports bytes per record and encode/decode time against CSV and binlog.
+ */
+
+#include "binlog_format.h"
+#include "delta_codec.h"
+#include "host/check.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+
+static bool readFile(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    FILE* f = (FILE*)ctx;
+    return fseek(f, offset, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+static uint32_t fileSize(FILE* f) {
+    fseek(f, 0, SEEK_END);
+    return (uint32_t)ftell(f);
+}
+
+static bool openLog(const char* path, FILE*& f, BinlogIo& io, BinlogState& st) {
+    f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    io.ctx = f;
+    io.read = readFile;
+    if (!binlogResume(io, fileSize(f), st)) {
+        fprintf(stderr, "%s: bad header or unsupported layout\n", path);
+        fclose(f);
+        return false;
+    }
+    return true;
+}
+
+// Same text as the firmware's clockFormatEpoch()
+static void formatEpoch(uint32_t epoch, char* buf, size_t size) {
+    time_t t = epoch;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+// ============================================
+// Converters
+// ============================================
+
+static void printCsvHeader() {
+    printf("timestamp,epoch,packetId,tempAir,humAir,tempGnd,vwcGnd,ecGnd,par,vBat,batPct");
+    for (int i = 0; i < BINLOG_SOIL_MAX; i++) {
+        printf(",soil%d_addr,soil%d_depthCm,soil%d_vwc,soil%d_temp,soil%d_ec", i, i, i, i, i);
+    }
+    printf("\n");
+}
+
+static void printCsv(const BinlogRecord& r) {
+    char ts[20];
+    formatEpoch(r.epoch, ts, sizeof(ts));
+    printf("%s,%u,%u,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%u", ts, r.epoch, r.packetId,
+           r.tempAire, r.humAire, r.tempSuelo, r.vwcSuelo, r.ecSuelo, r.par, r.vBat,
+           r.batPercent);
+    for (int i = 0; i < BINLOG_SOIL_MAX; i++) {
+        if (i < r.soilCount) {
+            printf(",%c,%u,%.2f,%.2f,%.1f", r.soil[i].addr, r.soil[i].depthCm,
+                   r.soil[i].vwc, r.soil[i].temp, r.soil[i].ec);
+        } else {
+            printf(",,,,,");
+        }
+    }
+    printf("\n");
+}
+
+static void printJson(const BinlogRecord& r, bool first) {
+    char ts[20];
+    formatEpoch(r.epoch, ts, sizeof(ts));
+    printf("%s  {\"timestamp\":\"%s\",\"epoch\":%u,\"packetId\":%u,"
+           "\"tempAire\":%.2f,\"humAire\":%.2f,\"tempSuelo\":%.2f,\"vwcSuelo\":%.2f,"
+           "\"ecSuelo\":%.1f,\"par\":%.1f,\"vBat\":%.2f,\"batPercent\":%u,\"soil\":[",
+           first ? "" : ",\n", ts, r.epoch, r.packetId, r.tempAire, r.humAire,
+           r.tempSuelo, r.vwcSuelo, r.ecSuelo, r.par, r.vBat, r.batPercent);
+    for (int i = 0; i < r.soilCount; i++) {
+        printf("%s{\"addr\":\"%c\",\"depthCm\":%u,\"vwc\":%.2f,\"temp\":%.2f,\"ec\":%.1f}",
+               i ? "," : "", r.soil[i].addr, r.soil[i].depthCm, r.soil[i].vwc,
+               r.soil[i].temp, r.soil[i].ec);
+    }
+    printf("]}");
+}
+
+static int cmdDump(const char* path, bool json, uint32_t from, uint32_t to) {
+    FILE* f;
+    BinlogIo io;
+    BinlogState st;
+    if (!openLog(path, f, io, st)) return 1;
+
+    // Sorted files start at the lookup result and stop past `to`
+    uint32_t start = from ? binlogFindTime(io, st, from) : 0;
+    uint32_t bad = 0;
+    bool first = true;
+
+    if (json) printf("[\n");
+    else printCsvHeader();
+    for (uint32_t i = start; i < st.count; i++) {
+        BinlogRecord r;
+        if (!binlogReadRecord(io, i, r)) {
+            bad++;
+            continue;
+        }
+        if (r.epoch < from) continue;
+        if (r.epoch > to) {
+            if (st.epochSorted) break;
+            continue;
+        }
+        if (json) printJson(r, first);
+        else printCsv(r);
+        first = false;
+    }
+    if (json) printf("\n]\n");
+    if (bad) fprintf(stderr, "%u record(s) failed the CRC check\n", bad);
+    fclose(f);
+    return 0;
+}
+
+static int cmdInfo(const char* path) {
+    FILE* f;
+    BinlogIo io;
+    BinlogState st;
+    if (!openLog(path, f, io, st)) return 1;
+
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    BinlogHeader hdr;
+    readFile(f, 0, slot, sizeof(slot));
+    binlogDecodeHeader(slot, hdr);
+    uint32_t size = fileSize(f);
+
+    char ts[20];
+    formatEpoch(hdr.createdEpoch, ts, sizeof(ts));
+    printf("schema %u, slot %u B, index every %u records, created %s\n",
+           hdr.schema, hdr.slotSize, hdr.indexEvery, ts);
+    printf("%u bytes, %u records (%u indexed groups + %u in the open group)\n",
+           size, st.count, (st.count - st.group.count) / BINLOG_INDEX_EVERY, st.group.count);
+    printf("time %s, packetId %s\n", st.epochSorted ? "sorted" : "unsorted (lookups scan)",
+           st.packetSorted ? "sorted" : "unsorted (lookups scan)");
+    if (size != binlogFileSize(st.count)) printf("trailing bytes: file ends mid-slot or before an index\n");
+    fclose(f);
+    return 0;
+}
+
+static int cmdFind(const char* path, bool byPacket, uint32_t key) {
+    FILE* f;
+    BinlogIo io;
+    BinlogState st;
+    if (!openLog(path, f, io, st)) return 1;
+
+    int64_t i = byPacket ? binlogFindPacket(io, st, key) : binlogFindTime(io, st, key);
+    BinlogRecord r;
+    int rc = 1;
+    if (i >= 0 && i < st.count && binlogReadRecord(io, i, r)) {
+        printf("record %lld\n", (long long)i);
+        printCsvHeader();
+        printCsv(r);
+        rc = 0;
+    } else {
+        printf("not found\n");
+    }
+    fclose(f);
+    return rc;
+}
+
+// ============================================
+// Round trip
+// ============================================
+
+static BinlogRecord synthRecord(uint32_t i, uint32_t epoch, uint32_t packetId) {
+    BinlogRecord r;
+    memset(&r, 0, sizeof(r));
+    r.epoch = epoch;
+    r.packetId = packetId;
+    r.tempAire = 20.0f + (i % 97) * 0.13f;
+    r.humAire = 40.0f + (i % 53) * 0.7f;
+    r.tempSuelo = 15.0f + (i % 31) * 0.21f;
+    r.vwcSuelo = 25.0f + (i % 17) * 0.5f;
+    r.ecSuelo = 300.0f + i % 211;
+    r.par = (i * 37) % 2000;
+    r.vBat = 3.5f + (i % 7) * 0.1f;
+    r.batPercent = i % 101;
+    r.soilCount = i % (BINLOG_SOIL_MAX + 1);
+    for (uint8_t k = 0; k < r.soilCount; k++) {
+        r.soil[k].addr = '0' + k;
+        r.soil[k].depthCm = 10 * (k + 1);
+        r.soil[k].vwc = r.vwcSuelo + k;
+        r.soil[k].temp = r.tempSuelo - k;
+        r.soil[k].ec = r.ecSuelo + 10 * k;
+    }
+    return r;
+}
+
+// Compare through the encoder: struct padding is not part of a record
+static bool sameRecord(const BinlogRecord& a, const BinlogRecord& b) {
+    uint8_t sa[BINLOG_SLOT_SIZE], sb[BINLOG_SLOT_SIZE];
+    binlogEncodeRecord(a, sa);
+    binlogEncodeRecord(b, sb);
+    return memcmp(sa, sb, sizeof(sa)) == 0;
+}
+
+static bool sameGroup(const BinlogIndex& a, const BinlogIndex& b) {
+    if (a.count != b.count) return false;
+    if (a.count == 0) return true;
+    return a.group == b.group && a.minEpoch == b.minEpoch && a.maxEpoch == b.maxEpoch &&
+           a.minPacket == b.minPacket && a.maxPacket == b.maxPacket;
+}
+
+// Write the records the way binlog.cpp does
+static void writeLog(const char* path, const std::vector<BinlogRecord>& recs, BinlogState& st) {
+    FILE* f = fopen(path, "wb");
+    uint8_t slot[BINLOG_SLOT_SIZE];
+    binlogEncodeHeader(1767225600, slot);
+    fwrite(slot, 1, sizeof(slot), f);
+    binlogStateInit(st);
+    for (size_t i = 0; i < recs.size(); i++) {
+        binlogEncodeRecord(recs[i], slot);
+        fwrite(slot, 1, sizeof(slot), f);
+        if (binlogAdd(st, recs[i], slot)) fwrite(slot, 1, sizeof(slot), f);
+    }
+    fclose(f);
+}
+
+static uint32_t linearFindTime(const std::vector<BinlogRecord>& recs, uint32_t epoch) {
+    for (size_t i = 0; i < recs.size(); i++) if (recs[i].epoch >= epoch) return i;
+    return recs.size();
+}
+
+static int32_t linearFindPacket(const std::vector<BinlogRecord>& recs, uint32_t id) {
+    for (size_t i = 0; i < recs.size(); i++) if (recs[i].packetId == id) return i;
+    return -1;
+}
+
+static void roundTrip(const char* path, uint32_t count, bool reset) {
+    std::vector<BinlogRecord> recs;
+    uint32_t epoch = 1767225600;
+    uint32_t packetId = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (reset && i == count / 2) {
+            packetId = 1;        // cold boot
+            epoch -= 3600;       // clock set back
+        }
+        recs.push_back(synthRecord(i, epoch, packetId++));
+        epoch += 600;
+    }
+
+    BinlogState written;
+    writeLog(path, recs, written);
+
+    FILE* f;
+    BinlogIo io;
+    BinlogState st;
+    if (!openLog(path, f, io, st)) {
+        failures++;
+        return;
+    }
+    uint32_t size = fileSize(f);
+    CHECK(size == binlogFileSize(count), "size %u, expected %u", size, binlogFileSize(count));
+    CHECK(st.count == count, "resumed count %u, expected %u", st.count, count);
+    CHECK(sameGroup(st.group, written.group), "resumed open group differs");
+    CHECK(st.epochSorted == written.epochSorted && st.packetSorted == written.packetSorted,
+          "resumed sort flags differ");
+    bool regressed = reset && count >= 2;
+    CHECK(st.epochSorted == !regressed && st.packetSorted == !regressed, "sort flags wrong");
+
+    for (uint32_t i = 0; i < count; i++) {
+        BinlogRecord r;
+        CHECK(binlogReadRecord(io, i, r) && sameRecord(r, recs[i]), "record %u differs", i);
+    }
+
+    // Lookups: every key, plus values between and around them
+    for (uint32_t i = 0; i < count; i++) {
+        for (int d = -1; d <= 1; d++) {
+            uint32_t e = recs[i].epoch + d * 300;
+            uint32_t got = binlogFindTime(io, st, e);
+            CHECK(got == linearFindTime(recs, e), "find-time %u: %u, expected %u", e, got, linearFindTime(recs, e));
+        }
+        int32_t got = binlogFindPacket(io, st, recs[i].packetId);
+        CHECK(got == linearFindPacket(recs, recs[i].packetId), "find-packet %u: %d", recs[i].packetId, got);
+    }
+    CHECK(binlogFindTime(io, st, 0) == 0, "find-time 0");
+    CHECK(binlogFindTime(io, st, UINT32_MAX) == linearFindTime(recs, UINT32_MAX), "find-time max");
+    CHECK(binlogFindPacket(io, st, count + 10) == -1, "find-packet absent");
+    fclose(f);
+
+    // Torn tail: every cut inside the last slot resumes to the records before it
+    if (count > 0) {
+        uint32_t full = binlogFileSize(count);
+        for (uint32_t cut = full - BINLOG_SLOT_SIZE + 1; cut < full; cut += 17) {
+            if (truncate(path, cut) != 0) break;
+            if (!openLog(path, f, io, st)) {
+                failures++;
+                return;
+            }
+            CHECK(st.count == binlogRecordCount(cut), "cut %u: count %u", cut, st.count);
+            fclose(f);
+        }
+    }
+}
+
+static int cmdRoundTrip(const char* path, uint32_t count) {
+    const uint32_t sizes[] = { 0, 1, BINLOG_INDEX_EVERY - 1, BINLOG_INDEX_EVERY,
+                               BINLOG_INDEX_EVERY + 1, 5 * BINLOG_INDEX_EVERY, count };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        roundTrip(path, sizes[i], false);
+        roundTrip(path, sizes[i], true);
+    }
+    remove(path);
+    printf("%s (%d failure%s)\n", failures ? "FAILED" : "OK", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
+
+// ============================================
+// Delta codec
+// ============================================
+
+static int cmdDeltaCsv(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+    std::vector<uint8_t> data(fileSize(f));
+    fseek(f, 0, SEEK_SET);
+    size_t got = fread(data.data(), 1, data.size(), f);
+    fclose(f);
+    data.resize(got);
+
+    printCsvHeader();
+    DeltaState st;
+    deltaReset(st);
+    size_t pos = 0, skipped = 0;
+    while (pos < data.size()) {
+        BinlogRecord r;
+        size_t n = deltaDecode(st, data.data() + pos, data.size() - pos, r);
+        if (n == 0) {
+            // Torn or corrupt frame: resume at the next keyframe
+            size_t next = deltaFindKeyframe(data.data(), data.size(), pos + 1);
+            skipped += next - pos;
+            pos = next;
+            deltaReset(st);
+            continue;
+        }
+        printCsv(r);
+        pos += n;
+    }
+    if (skipped) fprintf(stderr, "%u bytes skipped\n", (unsigned)skipped);
+    return 0;
+}
+
+static int cmdCompress(const char* in, const char* out) {
+    FILE* f;
+    BinlogIo io;
+    BinlogState st;
+    if (!openLog(in, f, io, st)) return 1;
+    FILE* o = fopen(out, "wb");
+    if (!o) {
+        fprintf(stderr, "cannot create %s\n", out);
+        fclose(f);
+        return 1;
+    }
+
+    DeltaState enc;
+    deltaReset(enc);
+    uint8_t frame[DELTA_FRAME_MAX];
+    uint32_t written = 0, bad = 0;
+    for (uint32_t i = 0; i < st.count; i++) {
+        BinlogRecord r;
+        if (!binlogReadRecord(io, i, r)) {
+            bad++;
+            deltaReset(enc);
+            continue;
+        }
+        size_t n = deltaEncode(enc, r, frame, sizeof(frame));
+        fwrite(frame, 1, n, o);
+        written += n;
+    }
+    fclose(o);
+    uint32_t size = fileSize(f);
+    fclose(f);
+    printf("%u records: %u B -> %u B (%.1fx), %.1f B/record%s\n", st.count, size, written,
+           written ? (double)size / written : 0.0, st.count ? (double)written / st.count : 0.0,
+           bad ? " (corrupt records skipped)" : "");
+    return 0;
+}
+
+// Day cycle at a 10-minute interval, one probe, slow drift plus noise
+static std::vector<BinlogRecord> synthSeries(uint32_t count) {
+    std::vector<BinlogRecord> recs;
+    uint32_t seed = 12345;
+    float tempNoise = 0, humNoise = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        float jitter = ((int)((seed >> 16) % 11) - 5) * 0.01f;
+        tempNoise = tempNoise * 0.9f + jitter;
+        humNoise = humNoise * 0.9f + jitter * 4;
+        double day = (i % 144) / 144.0 * 2 * M_PI;
+
+        BinlogRecord r;
+        memset(&r, 0, sizeof(r));
+        r.epoch = 1767225600 + i * 600;
+        r.packetId = i + 1;
+        r.tempAire = 18.0f + 6.0f * sin(day - M_PI / 2) + tempNoise;
+        r.humAire = 65.0f - 15.0f * sin(day - M_PI / 2) + humNoise;
+        r.tempSuelo = 16.0f + 1.5f * sin(day - M_PI / 3);
+        r.vwcSuelo = 31.0f - i * 0.001f;
+        r.ecSuelo = 412.0f + (i / 50) % 3;
+        r.par = sin(day - M_PI / 2) > 0 ? 1900.0f * sin(day - M_PI / 2) : 0.0f;
+        r.vBat = 3.95f - i * 0.00002f + ((seed >> 20) % 3) * 0.001f;
+        r.batPercent = 90 - i / 1000;
+        r.soilCount = 1;
+        r.soil[0].addr = '0';
+        r.soil[0].depthCm = 15;
+        r.soil[0].vwc = r.vwcSuelo;
+        r.soil[0].temp = r.tempSuelo;
+        r.soil[0].ec = r.ecSuelo;
+        if (i % 500 == 250) r.tempAire = NAN;   // failed DHT read
+        recs.push_back(r);
+    }
+    return recs;
+}
+
+static bool sameQuantized(float a, float b, int32_t scale) {
+    float q = deltaQuantize(b, scale);
+    return (isnan(a) && isnan(q)) || a == q;
+}
+
+static bool sameDecoded(const BinlogRecord& d, const BinlogRecord& r) {
+    bool ok = d.epoch == r.epoch && d.packetId == r.packetId &&
+              sameQuantized(d.tempAire, r.tempAire, 100) && sameQuantized(d.humAire, r.humAire, 100) &&
+              sameQuantized(d.tempSuelo, r.tempSuelo, 100) && sameQuantized(d.vwcSuelo, r.vwcSuelo, 100) &&
+              sameQuantized(d.ecSuelo, r.ecSuelo, 10) && sameQuantized(d.par, r.par, 10) &&
+              sameQuantized(d.vBat, r.vBat, 1000) && d.batPercent == r.batPercent &&
+              d.soilCount == r.soilCount;
+    for (uint8_t k = 0; ok && k < r.soilCount; k++) {
+        ok = d.soil[k].addr == r.soil[k].addr && d.soil[k].depthCm == r.soil[k].depthCm &&
+             sameQuantized(d.soil[k].vwc, r.soil[k].vwc, 100) &&
+             sameQuantized(d.soil[k].temp, r.soil[k].temp, 100) &&
+             sameQuantized(d.soil[k].ec, r.soil[k].ec, 10);
+    }
+    return ok;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro> >(steady_clock::now().time_since_epoch()).count();
+}
+
+static int cmdBench(const char* path, uint32_t count) {
+    if (count == 0) count = 1;
+    std::vector<BinlogRecord> recs = synthSeries(count);
+    // Mixed probe layouts and a packetId reset
+    for (uint32_t i = count / 3; i < count / 3 + 10 && i < count; i++) recs[i].soilCount = 0;
+    if (count > 10) recs[count / 2].packetId = 1;
+    for (uint32_t i = count / 2 + 1; i < count; i++) recs[i].packetId = recs[i - 1].packetId + 1;
+    // A delta frame that starts like a keyframe: an epoch 2422 s early with
+    // a packetId jump codes as 0xD7 0x4B
+    uint32_t lookalike = count > 200 ? count / 4 / DELTA_KEYFRAME_EVERY * DELTA_KEYFRAME_EVERY + 5 : count;
+    if (lookalike < count) {
+        recs[lookalike].epoch -= 2422;
+        recs[lookalike].packetId += 5;
+    }
+
+    std::vector<uint8_t> out(count * DELTA_FRAME_MAX);
+    std::vector<size_t> offsets(count);
+    const int reps = 20;
+    size_t total = 0;
+    double t0 = nowUs();
+    for (int rep = 0; rep < reps; rep++) {
+        DeltaState enc;
+        deltaReset(enc);
+        total = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            offsets[i] = total;
+            total += deltaEncode(enc, recs[i], out.data() + total, out.size() - total);
+        }
+    }
+    double encUs = (nowUs() - t0) / reps / count;
+    if (lookalike < count) {
+        CHECK(out[offsets[lookalike]] == DELTA_SYNC0 && out[offsets[lookalike] + 1] == DELTA_SYNC1,
+              "record %u does not start with the sync bytes", lookalike);
+    }
+
+    std::vector<BinlogRecord> dec(count);
+    uint32_t decoded = 0;
+    t0 = nowUs();
+    for (int rep = 0; rep < reps; rep++) {
+        DeltaState st;
+        deltaReset(st);
+        size_t pos = 0;
+        decoded = 0;
+        while (pos < total && decoded < count) {
+            size_t n = deltaDecode(st, out.data() + pos, total - pos, dec[decoded]);
+            if (n == 0) break;
+            pos += n;
+            decoded++;
+        }
+    }
+    double decUs = (nowUs() - t0) / reps / count;
+
+    CHECK(decoded == count, "decoded %u of %u records", decoded, count);
+    for (uint32_t i = 0; i < decoded; i++) {
+        CHECK(sameDecoded(dec[i], recs[i]), "record %u differs after decode", i);
+    }
+
+    // Random access: from any offset the next keyframe decodes on its own
+    for (uint32_t i = 0; i < count; i += 7) {
+        size_t k = deltaFindKeyframe(out.data(), total, offsets[i]);
+        uint32_t first = (i + DELTA_KEYFRAME_EVERY - 1) / DELTA_KEYFRAME_EVERY * DELTA_KEYFRAME_EVERY;
+        if (first >= count) {
+            CHECK(k == total, "seek %u: keyframe found past the last one", i);
+            continue;
+        }
+        CHECK(k == offsets[first], "seek %u: keyframe at %u, expected %u", i, (unsigned)k, (unsigned)offsets[first]);
+        DeltaState st;
+        deltaReset(st);
+        BinlogRecord r;
+        CHECK(deltaDecode(st, out.data() + k, total - k, r) > 0 && sameDecoded(r, recs[first]),
+              "seek %u: keyframe does not decode", i);
+    }
+
+    // Kept for a look with dlt-csv
+    FILE* f = fopen(path, "wb");
+    if (f) {
+        fwrite(out.data(), 1, total, f);
+        fclose(f);
+    }
+
+    // Torn tail: every cut of the last frames decodes the complete ones
+    for (size_t cut = total > 64 ? total - 64 : 0; cut < total; cut++) {
+        DeltaState st;
+        deltaReset(st);
+        size_t pos = 0;
+        uint32_t n = 0;
+        BinlogRecord r;
+        while (size_t used = deltaDecode(st, out.data() + pos, cut - pos, r)) {
+            pos += used;
+            n++;
+        }
+        uint32_t expect = 0;
+        while (expect < count && (expect + 1 < count ? offsets[expect + 1] : total) <= cut) expect++;
+        CHECK(n == expect, "cut %u: %u records, expected %u", (unsigned)cut, n, expect);
+    }
+
+    // CSV line as sd_logger writes it (with the journal frame), binlog slot
+    double csvBytes = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        char line[192];
+        char ts[20];
+        formatEpoch(recs[i].epoch, ts, sizeof(ts));
+        int n = snprintf(line, sizeof(line), "%s,%u,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%u",
+                         ts, recs[i].packetId, recs[i].tempAire, recs[i].humAire,
+                         recs[i].tempSuelo, recs[i].vwcSuelo, recs[i].ecSuelo,
+                         recs[i].par, recs[i].vBat, recs[i].batPercent);
+        csvBytes += n + snprintf(line, sizeof(line), ",%d,%08x\n", n, 0u);
+    }
+    csvBytes /= count;
+    double dltBytes = (double)total / count;
+
+    printf("records:     %u (keyframe every %u)\n", count, DELTA_KEYFRAME_EVERY);
+    printf("delta:       %.1f B/record\n", dltBytes);
+    printf("csv:         %.1f B/record (%.1fx)\n", csvBytes, csvBytes / dltBytes);
+    printf("binlog:      %u B/record (%.1fx)\n", BINLOG_SLOT_SIZE, BINLOG_SLOT_SIZE / dltBytes);
+    printf("encode:      %.3f us/record\n", encUs);
+    printf("decode:      %.3f us/record\n", decUs);
+    printf("%s (%d failure%s)\n", failures ? "FAILED" : "OK", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr,
+                "usage: %s info|csv|json|find-time|find-packet|roundtrip|dlt-csv|compress|bench <file> [args]\n",
+                argv[0]);
+        return 2;
+    }
+    const char* cmd = argv[1];
+    const char* path = argv[2];
+    uint32_t a = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+    uint32_t b = argc > 4 ? strtoul(argv[4], NULL, 10) : UINT32_MAX;
+
+    if (!strcmp(cmd, "info")) return cmdInfo(path);
+    if (!strcmp(cmd, "csv")) return cmdDump(path, false, a, b);
+    if (!strcmp(cmd, "json")) return cmdDump(path, true, a, b);
+    if (!strcmp(cmd, "find-time") && argc > 3) return cmdFind(path, false, a);
+    if (!strcmp(cmd, "find-packet") && argc > 3) return cmdFind(path, true, a);
+    if (!strcmp(cmd, "roundtrip")) return cmdRoundTrip(path, argc > 3 ? a : 5000);
+    if (!strcmp(cmd, "dlt-csv")) return cmdDeltaCsv(path);
+    if (!strcmp(cmd, "compress") && argc > 3) return cmdCompress(path, argv[3]);
+    if (!strcmp(cmd, "bench")) return cmdBench(path, argc > 3 ? a : 20000);
+
+    fprintf(stderr, "unknown command or missing argument\n");
+    return 2;
+}
@@ -0,0 +1,235 @@
+/**
+ * dht22_decode_test - host checks for the DHT22 frame decoder
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/tx dht22_decode_test.cpp ../firmware/tx/dht22_decode.cpp -o dht22_decode_test
+ *
+ * Compiles the same dht22_decode.cpp as the firmware and feeds it RMT item
+ * dumps: the 32-bit rmt_item32_t words dht22Poll() takes from the ring
+ * buffer (1 us ticks, duration0 in bits 0-14, level0 in bit 15, duration1
+ * and level1 above), unpacked into runs the way dht22Poll() does. Pulse
+ * widths vary within what a sensor produces (response 76-86 us, bit LOW
+ * 48-56 us, HIGH 22-29 us for a 0 and 68-74 us for a 1).
+ *
+ *   frames      room, frost, the sensor limits and -0.1 C: humidity,
+ *               temperature and sign
+ *   checksum    one bit misread, a corrupted checksum byte
+ *   short       a capture cut by the idle threshold after 31 bits, and
+ *               every shorter cut of a good frame
+ *   response    no preamble (sensor absent), a stretched bit, a glitch
+ *               that splits a pulse
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include "dht22_decode.h"
+#include "host/check.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// ============================================
+// RMT dumps
+// ============================================
+
+// Each: release edge, response LOW/HIGH, 40 bits, the sensor's final LOW
+// (duration1 = 0: the idle threshold ended the capture)
+
+// 48.3 %RH, 22.7 C
+static const uint32_t FRAME_ROOM[] = {
+    0x80190003, 0x8055004c, 0x80170032, 0x80170035, 0x801a0033, 0x801b0030,
+    0x801c0032, 0x80160030, 0x801a0034, 0x80450036, 0x804a0032, 0x80480031,
+    0x80490038, 0x801b0030, 0x801a0035, 0x801c0032, 0x804a0034, 0x80450038,
+    0x801a0034, 0x801c0032, 0x801b0030, 0x80160038, 0x801a0036, 0x801a0038,
+    0x801c0038, 0x80180036, 0x80480034, 0x80470035, 0x80460030, 0x801c0038,
+    0x801c0038, 0x80170031, 0x80460037, 0x80470031, 0x80440036, 0x80480033,
+    0x801c0033, 0x80170030, 0x80190037, 0x80440032, 0x80470038, 0x80450035,
+    0x80000033,
+};
+
+// 91.6 %RH, -7.4 C (temperature bit 15 set)
+static const uint32_t FRAME_FROST[] = {
+    0x80200004, 0x8055004f, 0x80170030, 0x80180038, 0x80170033, 0x80190030,
+    0x80170036, 0x801d0032, 0x804a0030, 0x80470031, 0x80450038, 0x801d0034,
+    0x80170037, 0x804a0035, 0x801a0031, 0x80440031, 0x801b0032, 0x801b0031,
+    0x80450031, 0x801a0036, 0x80160032, 0x80190031, 0x80170035, 0x801a0033,
+    0x80170037, 0x80160032, 0x80170034, 0x80480037, 0x801c0033, 0x80170035,
+    0x804a0038, 0x80160032, 0x80470033, 0x80190030, 0x801d0033, 0x80440036,
+    0x80470036, 0x80190034, 0x80170033, 0x80170034, 0x80180032, 0x80440035,
+    0x80000031,
+};
+
+// 100.0 %RH, -40.0 C
+static const uint32_t FRAME_LIMITS[] = {
+    0x80180005, 0x804e0050, 0x80160037, 0x80160034, 0x801d0033, 0x801d0033,
+    0x801c0038, 0x801b0032, 0x80460035, 0x80490030, 0x80480036, 0x80450031,
+    0x80490038, 0x801a0035, 0x80460038, 0x801a0033, 0x80180034, 0x801d0035,
+    0x804a0037, 0x80190032, 0x801c0037, 0x80170035, 0x80190036, 0x80170032,
+    0x801c0030, 0x80450035, 0x80480030, 0x80180038, 0x801b0033, 0x80480030,
+    0x80160035, 0x80160031, 0x80170031, 0x80180031, 0x80480034, 0x80460034,
+    0x80480036, 0x80490038, 0x80460038, 0x80490035, 0x80190030, 0x801b0038,
+    0x80000036,
+};
+
+// 63.0 %RH, -0.1 C
+static const uint32_t FRAME_SMALL_NEG[] = {
+    0x80160004, 0x8051004f, 0x80170030, 0x801a0035, 0x801b0030, 0x80170031,
+    0x801b0037, 0x80180032, 0x80460037, 0x801c0036, 0x80180035, 0x80460036,
+    0x80480033, 0x80480033, 0x80160035, 0x80460037, 0x80480038, 0x80170033,
+    0x804a0032, 0x801a0033, 0x80180038, 0x80160037, 0x80190034, 0x80170032,
+    0x801d0038, 0x80180035, 0x801c0038, 0x801b0031, 0x801c0033, 0x801d0032,
+    0x80160036, 0x801d0036, 0x801b0037, 0x80460033, 0x80440030, 0x80450031,
+    0x804a0037, 0x80450031, 0x804a0037, 0x80180034, 0x80180030, 0x80480034,
+    0x80000032,
+};
+
+// The room reading with humidity bit 13 read as a 1 (48.7 %RH): bad checksum
+static const uint32_t FRAME_BAD_SUM[] = {
+    0x80210006, 0x8053004f, 0x801d0036, 0x80180038, 0x801d0036, 0x801c0038,
+    0x80190034, 0x80190033, 0x801a0038, 0x80480034, 0x80480030, 0x80480033,
+    0x80450038, 0x801d0035, 0x80170035, 0x80460033, 0x80460036, 0x80490032,
+    0x80160032, 0x801a0038, 0x80180031, 0x80190038, 0x80180036, 0x801b0031,
+    0x801a0038, 0x80160030, 0x80470032, 0x80450035, 0x80450037, 0x80180038,
+    0x801a0031, 0x80170035, 0x80450037, 0x80490032, 0x80490031, 0x80490038,
+    0x801d0034, 0x801d0038, 0x801b0035, 0x804a0033, 0x80490032, 0x80480030,
+    0x80000031,
+};
+
+// The room reading cut after 31 bits (the last HIGH ran into the idle threshold)
+static const uint32_t FRAME_SHORT[] = {
+    0x80170004, 0x8056004c, 0x801c0038, 0x801c0035, 0x80190031, 0x801a0036,
+    0x801b0030, 0x801a0038, 0x801b0032, 0x80480036, 0x80440031, 0x80480035,
+    0x80450031, 0x80160037, 0x801c0037, 0x80170036, 0x80480035, 0x804a0030,
+    0x801c0037, 0x801a0033, 0x80180031, 0x80170034, 0x801d0030, 0x801b0033,
+    0x80180036, 0x80190037, 0x80440032, 0x80440030, 0x80460033, 0x801d0036,
+    0x801a0034, 0x801a0035, 0x80000035,
+};
+
+// ============================================
+// Helpers
+// ============================================
+
+#define DUMP(a) a, sizeof(a) / sizeof(a[0])
+
+// Unpacks like dht22Poll(): two runs per item, a zero duration ends it
+static std::vector<Dht22Run> unpack(const uint32_t* items, size_t count) {
+    std::vector<Dht22Run> runs;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t d0 = items[i] & 0x7FFF, d1 = (items[i] >> 16) & 0x7FFF;
+        if (d0 == 0) break;
+        runs.push_back({ (uint8_t)((items[i] >> 15) & 1), d0 });
+        if (d1 == 0) break;
+        runs.push_back({ (uint8_t)(items[i] >> 31), d1 });
+    }
+    return runs;
+}
+
+static Dht22Status decode(const std::vector<Dht22Run>& runs, float& t, float& h) {
+    t = h = NAN;
+    return dht22DecodeRuns(runs.data(), runs.size(), t, h);
+}
+
+// ============================================
+// Checks
+// ============================================
+
+static void testFrames() {
+    printf("frames: values and sign\n");
+    struct Case {
+        const uint32_t* items;
+        size_t count;
+        float hum, temp;
+    };
+    const Case cases[] = {
+        { DUMP(FRAME_ROOM), 48.3f, 22.7f },
+        { DUMP(FRAME_FROST), 91.6f, -7.4f },
+        { DUMP(FRAME_LIMITS), 100.0f, -40.0f },
+        { DUMP(FRAME_SMALL_NEG), 63.0f, -0.1f },
+    };
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        const Case& c = cases[k];
+        float t, h;
+        std::vector<Dht22Run> runs = unpack(c.items, c.count);
+        Dht22Status st = decode(runs, t, h);
+        CHECK(runs.size() == 85, "case %u: %u runs", (unsigned)k, (unsigned)runs.size());
+        CHECK(st == DHT22_OK && fabsf(h - c.hum) < 0.01f && fabsf(t - c.temp) < 0.01f,
+              "case %u: status %d, %.1f %%RH %.1f C, want %.1f %.1f", (unsigned)k, st, h, t, c.hum, c.temp);
+        CHECK(signbit(t) == signbit(c.temp), "case %u: sign", (unsigned)k);
+    }
+}
+
+static void testChecksum() {
+    printf("checksum: misread bits\n");
+    float t, h;
+    CHECK(decode(unpack(DUMP(FRAME_BAD_SUM)), t, h) == DHT22_ERR_CHECKSUM, "misread bit");
+    CHECK(isnan(t) && isnan(h), "values written on a failed frame");
+
+    // Any single bit of the room frame turned over: 1 <-> 0 by width
+    std::vector<Dht22Run> good = unpack(DUMP(FRAME_ROOM));
+    int accepted = 0;
+    for (int bit = 0; bit < 40; bit++) {
+        std::vector<Dht22Run> runs = good;
+        Dht22Run& hi = runs[4 + 2 * bit + 1];
+        hi.us = hi.us > 48 ? 26 : 70;
+        if (decode(runs, t, h) != DHT22_ERR_CHECKSUM) accepted++;
+    }
+    CHECK(accepted == 0, "%d single-bit errors accepted", accepted);
+}
+
+static void testShort() {
+    printf("short: truncated captures\n");
+    float t, h;
+    CHECK(decode(unpack(DUMP(FRAME_SHORT)), t, h) == DHT22_ERR_SHORT, "31 bits");
+
+    // Cut anywhere after the preamble: never a reading
+    std::vector<Dht22Run> good = unpack(DUMP(FRAME_ROOM));
+    int wrong = 0;
+    for (size_t n = 4; n < 4 + 80; n++) {
+        std::vector<Dht22Run> runs(good.begin(), good.begin() + n);
+        if (decode(runs, t, h) != DHT22_ERR_SHORT) wrong++;
+    }
+    CHECK(wrong == 0, "%d cuts not reported short", wrong);
+    // The sensor's final LOW is not needed
+    std::vector<Dht22Run> runs(good.begin(), good.begin() + 84);
+    CHECK(decode(runs, t, h) == DHT22_OK, "without the final LOW");
+}
+
+static void testResponse() {
+    printf("response: missing preamble, bad widths\n");
+    float t, h;
+    // Sensor absent: only the release edge, then the pull-up
+    const uint32_t absent[] = { 0x812c0004 };
+    CHECK(decode(unpack(DUMP(absent)), t, h) == DHT22_ERR_NO_RESPONSE, "absent");
+    CHECK(decode(std::vector<Dht22Run>(), t, h) == DHT22_ERR_NO_RESPONSE, "empty");
+
+    std::vector<Dht22Run> good = unpack(DUMP(FRAME_ROOM));
+    std::vector<Dht22Run> runs = good;
+    runs[2].us = 150;   // response LOW far too long
+    // (a '1' bit also looks like a preamble; the frame then comes up short)
+    Dht22Status st = decode(runs, t, h);
+    CHECK((st == DHT22_ERR_NO_RESPONSE || st == DHT22_ERR_SHORT) && isnan(t), "stretched response: %d", st);
+
+    runs = good;
+    runs[4 + 2 * 20 + 1].us = 120;  // HIGH of bit 20
+    CHECK(decode(runs, t, h) == DHT22_ERR_TIMING, "stretched bit");
+
+    // A glitch past the RMT filter splits the LOW of bit 10 in two
+    runs = good;
+    size_t at = 4 + 2 * 10;
+    Dht22Run lo = runs[at];
+    runs[at].us = lo.us / 2;
+    runs.insert(runs.begin() + at + 1, { 1, 2 });
+    runs.insert(runs.begin() + at + 2, { 0, (uint16_t)(lo.us - lo.us / 2 - 2) });
+    CHECK(decode(runs, t, h) == DHT22_ERR_TIMING, "glitch");
+}
+
+int main() {
+    testFrames();
+    testChecksum();
+    testShort();
+    testResponse();
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
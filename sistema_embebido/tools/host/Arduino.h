@@ -0,0 +1,48 @@
+/**
+ * Arduino.h for host builds of firmware modules (tools/)
+ *
+ * Only what the modules tested on the host use: a simulated millis()
+ * clock that delay() advances, and a Serial that prints to stdout when
+ * `hostSerial.enabled` is set. The test program defines hostNowMs and
+ * hostSerial and moves the clock itself.
+ */
+
+#ifndef TOOLS_HOST_ARDUINO_H
+#define TOOLS_HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+#define F(s) (s)
+
+extern unsigned long hostNowMs;
+
+static inline unsigned long millis() { return hostNowMs; }
+static inline void delay(unsigned long ms) { hostNowMs += ms; }
+static inline void delayMicroseconds(unsigned int) {}
+
+struct HostSerial {
+    bool enabled;
+
+    int printf(const char* fmt, ...) {
+        if (!enabled) return 0;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vprintf(fmt, ap);
+        va_end(ap);
+        return n;
+    }
+    void print(const char* s) { if (enabled) fputs(s, stdout); }
+    void println(const char* s = "") { if (enabled) puts(s); }
+};
+
+extern HostSerial hostSerial;
+#define Serial hostSerial
+
+#endif
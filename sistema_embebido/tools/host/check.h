@@ -0,0 +1,18 @@
+/**
+ * CHECK for the host tools (tools/): counts a failed condition and prints
+ * it with its location. Each tool is one translation unit and reports
+ * `failures` at the end (exit status 1 if any).
+ */
+
+#ifndef TOOLS_HOST_CHECK_H
+#define TOOLS_HOST_CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { failures++; printf("  FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * journal_tool - host checker for the journaled CSV segments (/log/AAAAMMDD.csv)
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/tx journal_tool.cpp ../firmware/tx/journal_format.cpp ../firmware/tx/binlog_format.cpp -o journal_tool
+ *
+ * Usage:
+ *   journal_tool check   <file>                 recovery result, file untouched
+ *   journal_tool repair  <file>                 truncate like the firmware does
+ *   journal_tool torture <scratchFile> [records]
+ *
+ * `torture` writes synthetic segments through the same framing the firmware
+ * uses, then truncates the image file at every byte offset (and appends
+ * zeros, 0xFF, random bytes and stale lines of another file after a set of
+ * cuts, also at their original offsets) and checks that recovery keeps
+ * exactly the complete lines before the damage, with a bounded read.
+ * Exit status 0 = ok.
+ */
+
+#include "journal_format.h"
+#include "host/check.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+static bool readFile(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    FILE* f = (FILE*)ctx;
+    return fseek(f, offset, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+static uint32_t fileSize(FILE* f) {
+    fseek(f, 0, SEEK_END);
+    return (uint32_t)ftell(f);
+}
+
+static char window[JNL_SCAN_WINDOW];
+
+static bool recoverFile(const char* path, JournalRecovery& rec, uint32_t& size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    size = fileSize(f);
+    BinlogIo io = { f, readFile };
+    bool ok = journalRecover(io, size, window, rec);
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: read error\n", path);
+    return ok;
+}
+
+static int cmdCheck(const char* path, bool repair) {
+    JournalRecovery rec;
+    uint32_t size;
+    if (!recoverFile(path, rec, size)) return 1;
+
+    if (!rec.journaled) {
+        printf("%s: %u bytes, not journaled (old header)\n", path, size);
+        return 0;
+    }
+    printf("%s: %u bytes, %u valid, %u to cut\n", path, size, rec.validSize, size - rec.validSize);
+    if (rec.recordsKnown) printf("records: %u\n", rec.records);
+    else printf("records: unknown (no commit marker in the last %u bytes)\n", JNL_SCAN_WINDOW);
+    printf("scan: %u bytes from %s\n", rec.scanned, rec.checkpoint ? "a commit marker" : "the header");
+
+    if (repair && rec.validSize < size) {
+        if (truncate(path, rec.validSize) != 0) {
+            perror("truncate");
+            return 1;
+        }
+        printf("truncated to %u bytes\n", rec.validSize);
+    }
+    return 0;
+}
+
+// ============================================
+// Torture test
+// ============================================
+
+struct Image {
+    std::string data;
+    std::vector<uint32_t> lineEnds;     // offset after each '\n'
+    std::vector<uint32_t> recordsAt;    // data lines up to that end
+};
+
+// Same sequence as sd_logger.cpp: header, framed records, a commit marker
+// every `commitEvery` records (0 = none)
+static Image buildImage(uint32_t count, uint32_t commitEvery, uint32_t seed) {
+    Image img;
+    char line[256];
+    img.data = JNL_CSV_HEADER;
+    img.lineEnds.push_back(img.data.size());
+    img.recordsAt.push_back(0);
+
+    uint32_t records = 0, uncommitted = 0, fileId = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t k = i + seed;
+        int n = snprintf(line, sizeof(line), "2026-01-15 %02u:%02u:%02u,%u,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%.2f,%u",
+                         (k / 3600) % 24, (k / 60) % 60, k % 60, k + 1,
+                         20.0 + (k % 97) * 0.13, 40.0 + (k % 53) * 0.7,
+                         15.0 + (k % 31) * 0.21, 25.0 + (k % 17) * 0.5,
+                         300.0 + k % 211, (double)((k * 37) % 2000),
+                         3.5 + (k % 7) * 0.1, k % 101);
+        size_t len = journalFrame(line, n, sizeof(line), fileId, i == 0 ? &fileId : NULL);
+        img.data.append(line, len);
+        records++;
+        img.lineEnds.push_back(img.data.size());
+        img.recordsAt.push_back(records);
+
+        if (commitEvery && ++uncommitted >= commitEvery) {
+            len = journalCommit(records, img.data.size(), fileId, line, sizeof(line));
+            img.data.append(line, len);
+            img.lineEnds.push_back(img.data.size());
+            img.recordsAt.push_back(records);
+            uncommitted = 0;
+        }
+    }
+    return img;
+}
+
+// Last complete line at or before `cut`
+static size_t lastLine(const Image& img, uint32_t cut, uint32_t& end) {
+    size_t i = img.lineEnds.size();
+    while (i > 0 && img.lineEnds[i - 1] > cut) i--;
+    end = i > 0 ? img.lineEnds[i - 1] : 0;
+    return i;
+}
+
+static void writeImage(const char* path, const std::string& data) {
+    FILE* f = fopen(path, "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static void expectRecovery(const char* path, const Image& img, uint32_t cut, const char* what) {
+    JournalRecovery rec;
+    uint32_t size;
+    if (!recoverFile(path, rec, size)) {
+        failures++;
+        return;
+    }
+    uint32_t end;
+    size_t line = lastLine(img, cut, end);
+    CHECK(rec.journaled, "%s cut %u: not recognized as journaled", what, cut);
+    CHECK(rec.validSize == end, "%s cut %u: valid %u, expected %u", what, cut, rec.validSize, end);
+    CHECK(rec.scanned <= JNL_HEAD_READ + JNL_SCAN_WINDOW, "%s cut %u: scanned %u bytes", what, cut, rec.scanned);
+    if (rec.recordsKnown && line > 0) {
+        CHECK(rec.records == img.recordsAt[line - 1], "%s cut %u: %u records, expected %u",
+              what, cut, rec.records, img.recordsAt[line - 1]);
+    }
+}
+
+static void torture(const char* path, uint32_t count, uint32_t commitEvery) {
+    Image img = buildImage(count, commitEvery, 0);
+    Image stale = buildImage(count, commitEvery, 7919);  // deleted file, same layout
+    char what[32];
+    snprintf(what, sizeof(what), "%u rec/commit %u", count, commitEvery);
+
+    // Every byte offset, shrinking the same file
+    writeImage(path, img.data);
+    for (uint32_t cut = img.data.size() + 1; cut-- > 0; ) {
+        if (truncate(path, cut) != 0) {
+            perror("truncate");
+            failures++;
+            return;
+        }
+        expectRecovery(path, img, cut, what);
+    }
+
+    // Garbage after the cut: a torn write that extended the file
+    srand(count + commitEvery);
+    for (uint32_t cut = 0; cut <= img.data.size(); cut += 1 + rand() % 97) {
+        for (int kind = 0; kind < 5; kind++) {
+            std::string data = img.data.substr(0, cut);
+            uint32_t junk = 1 + rand() % 4096;
+            if (kind == 0) {
+                data.append(junk, '\0');
+            } else if (kind == 1) {
+                data.append(junk, '\xFF');
+            } else if (kind == 2) {
+                for (uint32_t i = 0; i < junk; i++) data += (char)(rand() & 0xFF);
+            } else if (kind == 4) {
+                // Reused cluster of an older segment at the same file
+                // offset (clusters never hold the header and first record
+                // of one file and the tail of another)
+                if (img.lineEnds.size() < 2 || cut < img.lineEnds[1] || cut >= stale.data.size()) continue;
+                data += stale.data.substr(cut, junk);
+            } else {
+                // Old cluster contents: lines of another file, from mid-line
+                uint32_t from = rand() % stale.data.size();
+                while (from < stale.data.size() && (stale.data[from] == '\n' ||
+                       (from > 0 && stale.data[from - 1] == '\n'))) {
+                    from++;
+                }
+                data += stale.data.substr(from, junk);
+            }
+            // Junk that happens to repeat the original bytes is not damage
+            uint32_t same = cut;
+            while (same < data.size() && same < img.data.size() && data[same] == img.data[same]) same++;
+            writeImage(path, data);
+            expectRecovery(path, img, same, what);
+        }
+    }
+}
+
+static int cmdTorture(const char* path, uint32_t count) {
+    const uint32_t sizes[] = { 0, 1, JNL_COMMIT_EVERY - 1, JNL_COMMIT_EVERY, count };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        torture(path, sizes[i], JNL_COMMIT_EVERY);
+        torture(path, sizes[i], 0);
+    }
+    remove(path);
+    printf("%s (%d failure%s)\n", failures ? "FAILED" : "OK", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s check|repair|torture <file> [records]\n", argv[0]);
+        return 2;
+    }
+    const char* cmd = argv[1];
+    const char* path = argv[2];
+
+    if (!strcmp(cmd, "check")) return cmdCheck(path, false);
+    if (!strcmp(cmd, "repair")) return cmdCheck(path, true);
+    if (!strcmp(cmd, "torture")) return cmdTorture(path, argc > 3 ? strtoul(argv[3], NULL, 10) : 300);
+
+    fprintf(stderr, "unknown command\n");
+    return 2;
+}
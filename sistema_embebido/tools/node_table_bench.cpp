@@ -0,0 +1,296 @@
+/**
+ * node_table_bench - host checks and timing for the RX per-node table
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/rx node_table_bench.cpp -o node_table_bench
+ *
+ * Usage:
+ *   node_table_bench [nodes [framesPerNode]]
+ *
+ * Builds the same node_table.h the gateway uses and runs:
+ *
+ *   accounting  50 nodes in the firmware-sized table, frames dropped,
+ *               repeated and delivered out of order; received / lost /
+ *               duplicates per node against the generator's ground truth
+ *   reboot      a node whose packetId restarts, from far beyond the
+ *               sequence window and from inside it
+ *   offline     sweep() against the reported interval
+ *   churn       `nodes` different ids passing through the firmware table:
+ *               offline nodes are evicted, online ones are never displaced,
+ *               and every entry stays reachable from its home slot
+ *   timing      the firmware table full, and `nodes` ids (up to 4096) in
+ *               an 8192-slot one; interleaved frames, ns per update and
+ *               longest probe run
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include "node_table.h"
+#include "host/check.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static uint32_t rng = 12345;
+static uint32_t rnd() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+static bool chance(uint32_t percent) { return rnd() % 100 < percent; }
+
+static NodeReading readingFor(uint32_t seq) {
+    NodeReading r = { 20.0f + seq % 10, 60.0f, 15.0f, 30.0f, 250.0f, 800.0f, 3.9f, 80 };
+    return r;
+}
+
+struct Frame {
+    uint16_t id;
+    uint32_t seq;
+};
+
+// Average slots probed to find an entry (1 = in its home slot)
+template <uint32_t N>
+static double meanProbes(const NodeTable<N>& t) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        const NodeState* e = t.at(i);
+        if (e) sum += ((i - NodeTable<N>::home(e->id)) & (N - 1)) + 1;
+    }
+    return t.size() ? (double)sum / t.size() : 0;
+}
+
+// Every id appears in a table lookup from its home slot
+template <uint32_t N>
+static bool reachable(const NodeTable<N>& t) {
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        const NodeState* e = t.at(i);
+        if (!e) continue;
+        if (t.get(e->id) != e) return false;
+        found++;
+    }
+    return found == t.size();
+}
+
+static void testAccounting(uint32_t framesPerNode) {
+    printf("accounting: 50 nodes x %u frames, 5%% lost, 3%% repeated, 5%% late\n", framesPerNode);
+    static NodeTable<NODE_TABLE_CAPACITY> t;
+    t.clear();
+
+    const uint32_t NODES = 50;
+    std::vector<Frame> air;
+    std::vector<uint32_t> sent(NODES, 0), dropped(NODES, 0), repeated(NODES, 0);
+
+    // Per node: seq 1 always arrives first; later frames may be dropped,
+    // repeated, or held back behind up to 3 frames of the same node
+    std::vector<std::vector<Frame> > perNode(NODES);
+    for (uint32_t n = 0; n < NODES; n++) {
+        uint16_t id = (uint16_t)(1000 + n * 7);
+        std::vector<Frame>& q = perNode[n];
+        for (uint32_t seq = 1; seq <= framesPerNode; seq++) {
+            sent[n]++;
+            if (seq > 1 && chance(5)) {
+                dropped[n]++;
+                continue;
+            }
+            Frame f = { id, seq };
+            q.push_back(f);
+            if (seq > 1 && chance(3)) {
+                q.push_back(f);
+                repeated[n]++;
+            }
+        }
+        for (size_t i = 1; i + 1 < q.size(); i++) {
+            if (chance(5)) {
+                size_t j = i + 1 + rnd() % 3;
+                if (j >= q.size()) j = q.size() - 1;
+                Frame held = q[i];
+                for (size_t k = i; k < j; k++) q[k] = q[k + 1];
+                q[j] = held;
+            }
+        }
+    }
+
+    // Interleave the nodes on the air
+    std::vector<size_t> pos(NODES, 0);
+    bool left = true;
+    while (left) {
+        left = false;
+        for (uint32_t n = 0; n < NODES; n++) {
+            if (pos[n] < perNode[n].size()) {
+                air.push_back(perNode[n][pos[n]++]);
+                left = true;
+            }
+        }
+    }
+
+    // 100 ms apart: a node's repeats and late frames follow within seconds
+    uint32_t now = 0;
+    for (size_t i = 0; i < air.size(); i++) {
+        now += 100;
+        t.update(air[i].id, air[i].seq, readingFor(air[i].seq), -90, 5, 60000, now);
+    }
+
+    CHECK(t.size() == NODES, "%u nodes in the table", t.size());
+    for (uint32_t n = 0; n < NODES; n++) {
+        uint16_t id = perNode[n][0].id;
+        const NodeState* e = t.get(id);
+        CHECK(e != NULL, "node %u missing", id);
+        if (!e) continue;
+        uint32_t distinct = sent[n] - dropped[n];
+        // A dropped tail is not known to be lost yet
+        uint32_t tail = 0;
+        for (uint32_t s = framesPerNode; s > e->lastSeq; s--) tail++;
+        CHECK(e->received == distinct, "node %u received %u, expected %u", id, e->received, distinct);
+        CHECK(e->lost == dropped[n] - tail, "node %u lost %u, expected %u", id, e->lost, dropped[n] - tail);
+        CHECK(e->duplicates == repeated[n], "node %u duplicates %u, expected %u",
+              id, e->duplicates, repeated[n]);
+        CHECK(e->resets == 0, "node %u reset %u times", id, e->resets);
+    }
+    CHECK(reachable(t), "entries not reachable");
+}
+
+static void testReboot() {
+    printf("reboot: packetId 1..500, then 1..100 again\n");
+    NodeTable<16> t;
+    uint32_t now = 0;
+    for (uint32_t s = 1; s <= 500; s++) t.update(42, s, readingFor(s), -80, 7, 0, now += 1000);
+    for (uint32_t s = 1; s <= 100; s++) t.update(42, s, readingFor(s), -80, 7, 0, now += 1000);
+    const NodeState* e = t.get(42);
+    CHECK(e && e->resets == 1, "resets %u", e ? e->resets : 0);
+    CHECK(e && e->received == 600 && e->lost == 0 && e->duplicates == 0,
+          "received %u lost %u duplicates %u", e->received, e->lost, e->duplicates);
+    CHECK(e && e->lastSeq == 100, "lastSeq %u", e->lastSeq);
+    CHECK(e && !e->intervalReported && e->intervalMs == 1000, "measured interval %u", e->intervalMs);
+
+    // Reboot at lastSeq 20: the new 1..5 fall inside the window but come a
+    // full interval after the newest frame
+    printf("reboot: packetId 1..20, then 1..5 again (inside the window)\n");
+    t.clear();
+    now = 0;
+    uint32_t dups = 0, resets = 0;
+    for (uint32_t s = 1; s <= 20; s++) t.update(43, s, readingFor(s), -80, 7, 60000, now += 60000);
+    for (uint32_t s = 1; s <= 5; s++) {
+        NodeUpdate u = t.update(43, s, readingFor(s), -80, 7, 60000, now += 60000);
+        if (u == NODE_DUPLICATE) dups++;
+        if (u == NODE_RESET) resets++;
+    }
+    e = t.get(43);
+    CHECK(dups == 0 && resets == 1, "%u duplicates, %u resets", dups, resets);
+    CHECK(e && e->received == 25 && e->lost == 0 && e->lastSeq == 5,
+          "received %u lost %u lastSeq %u", e->received, e->lost, e->lastSeq);
+    // A repeat right after the newest frame is still a duplicate
+    CHECK(t.update(43, 5, readingFor(5), -80, 7, 60000, now += 2000) == NODE_DUPLICATE,
+          "repeat after the reboot");
+}
+
+static void testOffline() {
+    printf("offline: reported interval 60 s\n");
+    NodeTable<16> t;
+    t.update(7, 1, readingFor(1), -80, 7, 60000, 1000);
+    t.update(8, 1, readingFor(1), -80, 7, 10000, 1000);
+    uint32_t limit = 1000 + 3 * 60000 + NODE_OFFLINE_SLACK_MS;
+    CHECK(t.sweep(limit) == 1, "only the 10 s node goes offline first");
+    CHECK(t.get(7)->online && !t.get(8)->online, "online flags");
+    CHECK(t.sweep(limit + 1) == 1 && !t.get(7)->online, "60 s node offline after its limit");
+    t.update(7, 2, readingFor(2), -80, 7, 60000, limit + 2);
+    CHECK(t.get(7)->online, "a frame brings it back");
+}
+
+static void testChurn(uint32_t nodes) {
+    printf("churn: %u ids through the %u-slot table\n", nodes, NODE_TABLE_CAPACITY);
+    static NodeTable<NODE_TABLE_CAPACITY> t;
+    t.clear();
+    const uint32_t MAX = NodeTable<NODE_TABLE_CAPACITY>::MAX_LOAD;
+
+    // Each wave: MAX nodes online, then silent long enough to go offline,
+    // then the next wave replaces them
+    uint32_t now = 0;
+    uint32_t rejectedWhileFull = 0;
+    for (uint32_t base = 0; base < nodes; base += MAX) {
+        for (uint32_t n = base; n < base + MAX && n < nodes; n++) {
+            uint16_t id = (uint16_t)(rnd() % 60000 + 1);
+            while (t.get(id)) id = (uint16_t)(rnd() % 60000 + 1);
+            t.update(id, 1, readingFor(1), -100, 0, 60000, now += 10);
+        }
+        CHECK(t.size() <= MAX, "load %u above %u", t.size(), MAX);
+        CHECK(reachable(t), "entries not reachable after wave at %u", base);
+
+        // While everyone is online a newcomer must not displace anyone
+        NodeTableStats before;
+        t.getStats(before);
+        if (before.online == MAX) {
+            NodeUpdate u = t.update(65535, 1, readingFor(1), -100, 0, 60000, now += 10);
+            if (u == NODE_REJECTED) rejectedWhileFull++;
+            CHECK(u == NODE_REJECTED, "newcomer admitted into a full online table");
+        }
+
+        now += 3 * 60000 + NODE_OFFLINE_SLACK_MS + 1000;
+        t.sweep(now);
+    }
+    NodeTableStats st;
+    t.getStats(st);
+    printf("  %u evictions, %u rejected, %.2f probes/lookup at the end, longest run %u\n",
+           st.evictions, st.rejected, meanProbes(t), st.maxProbe);
+    CHECK(st.evictions + t.size() >= nodes, "evictions %u + %u in table < %u ids",
+          st.evictions, t.size(), nodes);
+    CHECK(rejectedWhileFull > 0, "full-table case not exercised");
+}
+
+template <uint32_t N>
+static void timing(uint32_t nodes, uint32_t framesPerNode) {
+    static NodeTable<N> t;
+    t.clear();
+    // Distinct random ids (a field does not number its stations in order)
+    std::vector<uint16_t> ids(nodes);
+    std::vector<bool> taken(65536, false);
+    for (uint32_t i = 0; i < nodes; i++) {
+        uint16_t id;
+        do id = (uint16_t)(rnd() % 65535 + 1); while (taken[id]);
+        taken[id] = true;
+        ids[i] = id;
+    }
+
+    uint32_t now = 0;
+    uint64_t updates = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t seq = 1; seq <= framesPerNode; seq++) {
+        for (uint32_t i = 0; i < nodes; i++) {
+            t.update(ids[i], seq, readingFor(seq), -95, 3, 60000, now += 10);
+            updates++;
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    NodeTableStats st;
+    t.getStats(st);
+    printf("timing: %5u nodes, %5u slots (load %.2f): %6.1f ns/update, %.2f probes/lookup, "
+           "longest run %u, %u rejected\n",
+           nodes, N, (double)t.size() / N, ns / updates, meanProbes(t), st.maxProbe, st.rejected);
+    CHECK(t.size() == (nodes < NodeTable<N>::MAX_LOAD ? nodes : NodeTable<N>::MAX_LOAD),
+          "%u nodes in table", t.size());
+    CHECK(reachable(t), "entries not reachable");
+}
+
+int main(int argc, char** argv) {
+    uint32_t nodes = argc > 1 ? atoi(argv[1]) : 3000;
+    uint32_t frames = argc > 2 ? atoi(argv[2]) : 200;
+    if (nodes == 0 || nodes > 49000 || frames < 2) {
+        fprintf(stderr, "usage: node_table_bench [nodes (1-49000) [framesPerNode (>= 2)]]\n");
+        return 2;
+    }
+    printf("NodeState %u bytes, firmware table %u bytes\n\n",
+           (unsigned)sizeof(NodeState), (unsigned)sizeof(NodeTable<NODE_TABLE_CAPACITY>));
+
+    testAccounting(frames);
+    testReboot();
+    testOffline();
+    testChurn(nodes);
+    timing<NODE_TABLE_CAPACITY>(NodeTable<NODE_TABLE_CAPACITY>::MAX_LOAD, frames);
+    timing<8192>(nodes < 4096 ? nodes : 4096, frames);
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
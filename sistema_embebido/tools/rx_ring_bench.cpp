@@ -0,0 +1,252 @@
+/**
+ * rx_ring_bench - gateway receive path against a stalled uplink
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -pthread -I../firmware/shared rx_ring_bench.cpp -o rx_ring_bench
+ *
+ * Usage:
+ *   rx_ring_bench [frames [intervalMs [stallMs [bufferSize]]]]
+ *
+ * Feeds `frames` synthetic frames, one every `intervalMs`, to a model of
+ * the SX1262: a frame is only caught while the radio is in receive mode,
+ * and after RxDone it stays out of it until someone calls startReceive().
+ * Every upload takes `stallMs` (a hung server up to the request deadline).
+ *
+ *   inline   the old loop: read, upload, then startReceive()
+ *   task     radio task: read, startReceive(), push into the SpscRing of the
+ *            firmware; loop() decodes and buffers; an uplink thread uploads
+ *            from a `bufferSize`-entry buffer (RETRY_BUFFER_SIZE) that
+ *            overwrites its oldest entry
+ *
+ * Reports frames lost at the radio (the gateway was not listening), ring
+ * drops and upload-buffer overwrites separately; a reading is lost in
+ * any of the three, and their sum is the loss figure. Exit status 0 when
+ * the task mode lost nothing.
+ */
+
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t RING_SIZE = 16;       // RX_RING_SIZE
+static const size_t UPLOAD_BUFFER = 384;    // RETRY_BUFFER_SIZE
+static const int READ_US = 300;             // readData() + metrics over SPI
+
+struct Frame {
+    uint32_t seq;
+    uint32_t rxMs;
+    uint8_t len;
+    uint8_t data[104];                      // sizeof(MeteorDataPacket)
+};
+
+// A one-frame radio: frames arriving outside receive mode are lost
+class Radio {
+public:
+    void deliver(uint32_t seq) {
+        std::lock_guard<std::mutex> lk(m);
+        if (!listening) {
+            lost++;
+            return;
+        }
+        listening = false;                  // RxDone: standby until re-armed
+        fifo = seq;
+        full = true;
+        cv.notify_one();
+    }
+
+    // Wait for a frame (the DIO1 interrupt); false once the feed is over
+    bool wait(uint32_t& seq) {
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [this] { return full || done; });
+        if (!full) return false;
+        full = false;
+        seq = fifo;
+        return true;
+    }
+
+    void startReceive() {
+        std::lock_guard<std::mutex> lk(m);
+        listening = true;
+    }
+
+    void finish() {
+        std::lock_guard<std::mutex> lk(m);
+        done = true;
+        cv.notify_all();
+    }
+
+    uint32_t lost = 0;
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    bool listening = true;
+    bool full = false;
+    bool done = false;
+    uint32_t fifo = 0;
+};
+
+struct Result {
+    uint32_t radioLost;
+    uint32_t ringDrops;
+    uint32_t bufferOverwrites;
+    uint32_t uploaded;
+    uint32_t pending;           // still buffered for upload at the end
+    uint32_t ringHighWater;
+
+    uint32_t lost() const { return radioLost + ringDrops + bufferOverwrites; }
+};
+
+static void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static void readFrame(uint32_t seq, Frame& f, Clock::time_point t0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(READ_US));
+    f.seq = seq;
+    f.rxMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+    f.len = sizeof(f.data);
+    memset(f.data, (uint8_t)seq, sizeof(f.data));
+}
+
+static void feed(Radio& radio, int frames, int intervalMs) {
+    Clock::time_point next = Clock::now();
+    for (int i = 1; i <= frames; i++) {
+        std::this_thread::sleep_until(next);
+        radio.deliver(i);
+        next += std::chrono::milliseconds(intervalMs);
+    }
+    sleepMs(intervalMs);
+    radio.finish();
+}
+
+static Result runInline(int frames, int intervalMs, int stallMs) {
+    Radio radio;
+    Clock::time_point t0 = Clock::now();
+    uint32_t uploaded = 0;
+
+    std::thread loop([&] {
+        uint32_t seq;
+        Frame f;
+        while (radio.wait(seq)) {
+            readFrame(seq, f, t0);
+            sleepMs(stallMs);               // sendToServer() inline
+            uploaded++;
+            radio.startReceive();
+        }
+    });
+    feed(radio, frames, intervalMs);
+    loop.join();
+
+    Result r = { radio.lost, 0, 0, uploaded, 0, 0 };
+    return r;
+}
+
+static Result runTask(int frames, int intervalMs, int stallMs, size_t bufferSize) {
+    Radio radio;
+    SpscRing<Frame, RING_SIZE> ring;
+    Clock::time_point t0 = Clock::now();
+    std::atomic<bool> radioDone(false);
+
+    std::mutex bufLock;
+    std::condition_variable bufCv;
+    std::deque<uint32_t> buffer;
+    uint32_t overwrites = 0;
+    bool loopDone = false;
+    uint32_t uploaded = 0;
+
+    std::thread radioTask([&] {
+        uint32_t seq;
+        Frame f;
+        while (radio.wait(seq)) {
+            readFrame(seq, f, t0);
+            radio.startReceive();           // listening again before anything else
+            ring.push(f);
+        }
+        radioDone = true;
+    });
+
+    std::thread loop([&] {
+        Frame f;
+        while (true) {
+            bool got = ring.pop(f);
+            if (!got) {
+                if (radioDone && ring.empty()) break;
+                sleepMs(1);                 // the rest of loop(): display, button
+                continue;
+            }
+            std::lock_guard<std::mutex> lk(bufLock);
+            if (buffer.size() == bufferSize) {
+                buffer.pop_front();
+                overwrites++;
+            }
+            buffer.push_back(f.seq);
+            bufCv.notify_one();
+        }
+        std::lock_guard<std::mutex> lk(bufLock);
+        loopDone = true;
+        bufCv.notify_one();
+    });
+
+    std::thread uplink([&] {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lk(bufLock);
+                bufCv.wait(lk, [&] { return !buffer.empty() || loopDone; });
+                if (buffer.empty()) break;
+            }
+            sleepMs(stallMs);               // the request, outside the lock
+            std::lock_guard<std::mutex> lk(bufLock);
+            buffer.pop_front();
+            uploaded++;
+            // A stalled server: only what fits in one request per stall
+            // goes out while frames keep coming; stop once the feed ends
+            if (loopDone) break;
+        }
+    });
+
+    feed(radio, frames, intervalMs);
+    radioTask.join();
+    loop.join();
+    uplink.join();
+
+    Result r = { radio.lost, ring.overflowCount(), overwrites, uploaded,
+                  (uint32_t)buffer.size(), ring.highWaterMark() };
+    return r;
+}
+
+static void print(const char* name, int frames, const Result& r) {
+    printf("%-7s  %5d frames  %5u lost (%5.1f%%): %5u at radio, %3u ring drops (high water %2u), "
+           "%4u buffer overwrites  %4u uploaded  %3u pending\n",
+           name, frames, r.lost(), 100.0 * r.lost() / frames, r.radioLost, r.ringDrops,
+           r.ringHighWater, r.bufferOverwrites, r.uploaded, r.pending);
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    int intervalMs = argc > 2 ? atoi(argv[2]) : 20;
+    int stallMs = argc > 3 ? atoi(argv[3]) : 500;
+    int bufferSize = argc > 4 ? atoi(argv[4]) : (int)UPLOAD_BUFFER;
+    if (frames <= 0 || intervalMs <= 0 || stallMs < 0 || bufferSize <= 0) {
+        fprintf(stderr, "usage: rx_ring_bench [frames [intervalMs [stallMs [bufferSize]]]]\n");
+        return 2;
+    }
+
+    printf("%d frames every %d ms, each upload stalls %d ms, %d-entry upload buffer\n\n",
+           frames, intervalMs, stallMs, bufferSize);
+    Result a = runInline(frames, intervalMs, stallMs);
+    print("inline", frames, a);
+    Result b = runTask(frames, intervalMs, stallMs, bufferSize);
+    print("task", frames, b);
+
+    return b.lost() == 0 ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+/**
+ * sdi12_bus_test - host checks for the SDI-12 bus state machine
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -Ihost -I../firmware/tx sdi12_bus_test.cpp ../firmware/tx/sdi12_bus.cpp ../firmware/tx/sdi12_parse.cpp -o sdi12_bus_test
+ *
+ * Usage:
+ *   sdi12_bus_test [-v]      (-v prints the firmware's Serial output)
+ *
+ * Builds the same sdi12_bus.cpp as the firmware against a fake line
+ * (sdi12_port.h implemented here): scripted sensors answer each command
+ * a character at a time, 1200 baud, on a simulated millis() clock
+ * (host/Arduino.h). Checks:
+ *
+ *   discovery   "a!" scan finds the probes in address order, "aI!" for
+ *               each; "?!" for a lone non-numeric address; the fallback
+ *               address when nothing answers; the table kept across sleep
+ *   concurrent  every aC! goes out before the first aD0!, the longest
+ *               announced ttt sets one shared settle window, values parsed
+ *   timeouts    a probe silent on aC! or on aD0! costs its timeout (three
+ *               attempts for data), counted from the end of the command,
+ *               and fails alone
+ *   garbage     replies from another address, too few values, line noise
+ *               and an over-long line are retried, then given up on
+ *   port        sdi12PortBegin() failing leaves no sensors and no traffic
+ *
+ * Sends return at once, as the RMT backend does; the fake reports the
+ * line busy (sdi12PortSending) for break + marking + the characters.
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include "sdi12_bus.h"
+#include "sdi12_port.h"
+#include "host/check.h"
+#include <string>
+#include <vector>
+
+unsigned long hostNowMs = 0;
+HostSerial hostSerial = { false };
+
+// ============================================
+// Fake line and sensors
+// ============================================
+
+#define CHAR_MS          8      // 10 bits at 1200 baud
+#define RESPONSE_MS      10     // last stop bit to first response bit (< 15 ms)
+
+struct FakeSensor {
+    char addr;
+    const char* ident;
+    const char* ack;            // reply to aC! (NULL: silent)
+    const char* data[3];        // reply to the 1st, 2nd, 3rd+ aD0! (NULL: silent)
+    uint32_t dataAsked;
+};
+
+struct Pending {
+    unsigned long atMs;
+    char c;
+};
+
+static std::vector<FakeSensor> sensors;
+static std::vector<Pending> line;           // bytes on their way
+static std::vector<std::string> commands;   // as sent, with send time
+static std::vector<unsigned long> commandStartMs;
+static std::vector<unsigned long> commandMs;    // last stop bit out
+static unsigned long sendEndMs = 0;
+static bool portOk = true;
+
+uint32_t sdi12PortErrorCount = 0;
+
+static void reply(const char* text) {
+    unsigned long t = sendEndMs + RESPONSE_MS;
+    for (const char* p = text; *p; p++, t += CHAR_MS) line.push_back({ t, *p });
+    line.push_back({ t, '\r' });
+    line.push_back({ t + CHAR_MS, '\n' });
+}
+
+static FakeSensor* sensorAt(char addr) {
+    for (size_t i = 0; i < sensors.size(); i++) {
+        if (sensors[i].addr == addr) return &sensors[i];
+    }
+    return NULL;
+}
+
+bool sdi12PortBegin(uint8_t pin) {
+    (void)pin;
+    return portOk;
+}
+
+void sdi12PortSend(const char* cmd) {
+    // Break + marking + the characters go out after this returns
+    sendEndMs = hostNowMs + 21 + CHAR_MS * strlen(cmd);
+    commands.push_back(cmd);
+    commandStartMs.push_back(hostNowMs);
+    commandMs.push_back(sendEndMs);
+    line.clear();
+
+    std::string c(cmd);
+    if (c == "?!") {
+        if (sensors.size() == 1) reply(std::string(1, sensors[0].addr).c_str());
+        return;
+    }
+    FakeSensor* s = sensorAt(c[0]);
+    if (!s) return;
+    std::string op = c.substr(1);
+    if (op == "!") {
+        reply(std::string(1, s->addr).c_str());
+    } else if (op == "I!") {
+        reply(s->ident);
+    } else if (op == "C!") {
+        if (s->ack) reply(s->ack);
+    } else if (op == "D0!") {
+        uint32_t k = s->dataAsked < 3 ? s->dataAsked : 2;
+        s->dataAsked++;
+        if (s->data[k]) reply(s->data[k]);
+    }
+}
+
+bool sdi12PortSending() {
+    return hostNowMs < sendEndMs;
+}
+
+int sdi12PortAvailable() {
+    int n = 0;
+    for (size_t i = 0; i < line.size() && line[i].atMs <= hostNowMs; i++) n++;
+    return n;
+}
+
+int sdi12PortRead() {
+    if (line.empty() || line[0].atMs > hostNowMs) return -1;
+    char c = line[0].c;
+    line.erase(line.begin());
+    return c;
+}
+
+void sdi12PortFlush() {
+    // Drops what has arrived; characters still on the wire keep coming
+    while (!line.empty() && line[0].atMs <= hostNowMs) line.erase(line.begin());
+}
+
+static void reset() {
+    sensors.clear();
+    line.clear();
+    commands.clear();
+    commandStartMs.clear();
+    commandMs.clear();
+    sendEndMs = hostNowMs;
+    portOk = true;
+}
+
+static FakeSensor probe(char addr, const char* ack, const char* d0, const char* d1 = NULL,
+                        const char* d2 = NULL) {
+    FakeSensor s = { addr, "", ack, { d0, d1 ? d1 : d0, d2 ? d2 : (d1 ? d1 : d0) }, 0 };
+    s.ident = "13METER TER12 112";
+    return s;
+}
+
+static bool sent(const char* cmd) {
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (commands[i] == cmd) return true;
+    }
+    return false;
+}
+
+static size_t firstIndex(const char* suffix) {
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (commands[i].size() > 1 && commands[i].substr(1) == suffix) return i;
+    }
+    return commands.size();
+}
+
+static size_t lastIndex(const char* suffix) {
+    size_t last = commands.size();
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (commands[i].size() > 1 && commands[i].substr(1) == suffix) last = i;
+    }
+    return last;
+}
+
+// One acquisition cycle, polled every millisecond like loop(). Returns its
+// duration (ms), or 0 if it did not finish within `limitMs`.
+static unsigned long runCycle(unsigned long limitMs = 20000) {
+    commands.clear();
+    commandStartMs.clear();
+    commandMs.clear();
+    unsigned long start = hostNowMs;
+    sdi12BusStart();
+    CHECK(hostNowMs == start, "sdi12BusStart() blocked %lu ms", hostNowMs - start);
+    while (hostNowMs - start < limitMs) {
+        if (sdi12BusPoll()) return hostNowMs - start;
+        hostNowMs++;
+    }
+    return 0;
+}
+
+static void discover() {
+    sdi12SensorCount = 0;
+    sdi12BusBegin('0', true);
+}
+
+// ============================================
+// Checks
+// ============================================
+
+static void testDiscovery() {
+    printf("discovery: probes at 0, 1 and 3; a lone 'a'; nothing\n");
+    reset();
+    sensors.push_back(probe('0', "000103", "0+31.2+21.5+250"));
+    sensors.push_back(probe('1', "100103", "1+28.0+20.1+310"));
+    sensors.push_back(probe('3', "300103", "3+25.7+19.8+405"));
+    discover();
+    CHECK(sdi12SensorCount == 3, "%u sensors", sdi12SensorCount);
+    CHECK(sdi12Sensors[0].addr == '0' && sdi12Sensors[1].addr == '1' && sdi12Sensors[2].addr == '3',
+          "order %c %c %c", sdi12Sensors[0].addr, sdi12Sensors[1].addr, sdi12Sensors[2].addr);
+    CHECK(sent("0I!") && sent("1I!") && sent("3I!") && !sent("2I!"), "identification");
+    CHECK(!sent("?!"), "?! sent with numeric probes present");
+
+    reset();
+    sensors.push_back(probe('a', "a00103", "a+30.0+20.0+200"));
+    discover();
+    CHECK(sent("?!") && sdi12SensorCount == 1 && sdi12Sensors[0].addr == 'a',
+          "?! fallback: %u sensors", sdi12SensorCount);
+
+    reset();
+    discover();
+    CHECK(sdi12SensorCount == 1 && sdi12Sensors[0].addr == '0', "fallback address");
+
+    // Timer wake: the table from before deep sleep, no traffic
+    reset();
+    sensors.push_back(probe('0', "000103", "0+31.2+21.5+250"));
+    discover();
+    commands.clear();
+    sdi12BusBegin('0', false);
+    CHECK(commands.empty() && sdi12SensorCount == 1, "table not kept (%u commands)",
+          (unsigned)commands.size());
+}
+
+static void testConcurrent() {
+    printf("concurrent: three probes, one announcing 2 s\n");
+    reset();
+    sensors.push_back(probe('0', "000103", "0+31.2+21.5+250"));
+    sensors.push_back(probe('1', "100203", "1+28.04-3.25+310"));
+    sensors.push_back(probe('2', "200103", "2+0.00+0.5+0"));
+    discover();
+
+    unsigned long ms = runCycle();
+    CHECK(ms > 0, "cycle did not finish");
+    CHECK(lastIndex("C!") < firstIndex("D0!"), "aD0! before the last aC!");
+    size_t d0 = firstIndex("D0!");
+    size_t c2 = lastIndex("C!");
+    unsigned long settle = d0 < commands.size() ? commandMs[d0] - commandMs[c2] : 0;
+    // The last ACK and the aD0! characters come on top of the window
+    CHECK(settle >= 2000 && settle < 2200, "settle %lu ms, expected the announced 2 s", settle);
+    // One settle window plus the transactions, not three measurements in a row
+    CHECK(ms < 2000 + 3 * 200 + 3 * 250, "cycle %lu ms", ms);
+    printf("  cycle %lu ms (settle %lu ms)\n", ms, settle);
+
+    const float want[3][3] = { { 31.2f, 21.5f, 250 }, { 28.04f, -3.25f, 310 }, { 0, 0.5f, 0 } };
+    for (int i = 0; i < 3; i++) {
+        const Sdi12Sensor& s = sdi12Sensors[i];
+        CHECK(s.ok && s.valueCount == 3, "'%c' ok %d, %u values", s.addr, s.ok, s.valueCount);
+        for (int v = 0; v < 3; v++) {
+            CHECK(fabsf(s.values[v] - want[i][v]) < 1e-4f, "'%c' value %d = %g", s.addr, v, s.values[v]);
+        }
+    }
+
+    // A second cycle starts from scratch and runs the same way
+    CHECK(runCycle() > 0 && sdi12Sensors[1].ok, "second cycle");
+}
+
+static void testTimeouts() {
+    printf("timeouts: a probe silent on aC!, another silent on aD0!\n");
+    reset();
+    sensors.push_back(probe('0', NULL, "0+31.2+21.5+250"));
+    sensors.push_back(probe('1', "100103", NULL));
+    sensors.push_back(probe('2', "200103", "2+25.0+19.0+400"));
+    discover();
+
+    unsigned long ms = runCycle();
+    CHECK(ms > 0, "cycle did not finish");
+    CHECK(sdi12Sensors[0].ok && sdi12Sensors[0].expected == 3, "silent ack: '0' ok %d", sdi12Sensors[0].ok);
+    CHECK(!sdi12Sensors[1].ok && sdi12Sensors[1].valueCount == 0, "silent data: '1' ok %d",
+          sdi12Sensors[1].ok);
+    CHECK(sensors[1].dataAsked == SDI12_MAX_ATTEMPTS, "'1' asked %u times", sensors[1].dataAsked);
+    CHECK(sdi12Sensors[2].ok, "'2' failed with its neighbour");
+
+    // The ack timeout counts from the last stop bit of "0C!", not from the send
+    unsigned long ackWait = commands.size() > 1 ? commandStartMs[1] - commandMs[0] : 0;
+    CHECK(ackWait >= SDI12_ACK_TIMEOUT && ackWait < SDI12_ACK_TIMEOUT + 5,
+          "'1C!' %lu ms after '0C!' went out", ackWait);
+
+    unsigned long floor = SDI12_ACK_TIMEOUT + SDI12_MIN_SETTLE_MS +
+                          SDI12_MAX_ATTEMPTS * SDI12_DATA_TIMEOUT + (SDI12_MAX_ATTEMPTS - 1) * SDI12_RETRY_DELAY;
+    CHECK(ms >= floor && ms < floor + 1000, "cycle %lu ms, timeouts add up to %lu", ms, floor);
+    printf("  cycle %lu ms (timeouts %lu ms)\n", ms, floor);
+}
+
+static void testGarbage() {
+    printf("garbage: wrong address, short line, noise, over-long line\n");
+    reset();
+    std::string longLine = "2";
+    while (longLine.size() < 120) longLine += "+1.5";
+    sensors.push_back(probe('0', "000103", "7+31.2+21.5+250", "0+31.2", "0+31.2+21.5+250"));
+    sensors.push_back(probe('1', "100103", "#\x7f" "1+28.0+20.1+310", "1+28.0+20.1+310"));
+    sensors.push_back(probe('2', "200103", longLine.c_str()));
+    sensors.push_back(probe('3', "300103", "3x%%!", "3abc", "3"));
+    discover();
+
+    unsigned long ms = runCycle();
+    CHECK(ms > 0, "cycle did not finish");
+    CHECK(sdi12Sensors[0].ok && sensors[0].dataAsked == 3 && sdi12Sensors[0].values[2] == 250,
+          "'0' ok %d after %u requests", sdi12Sensors[0].ok, sensors[0].dataAsked);
+    CHECK(sdi12Sensors[1].ok && sensors[1].dataAsked == 2, "'1' ok %d after %u requests",
+          sdi12Sensors[1].ok, sensors[1].dataAsked);
+    // 80 characters kept, SDI12_MAX_VALUES values parsed from them
+    CHECK(sdi12Sensors[2].ok && sdi12Sensors[2].valueCount == SDI12_MAX_VALUES,
+          "'2' ok %d, %u values", sdi12Sensors[2].ok, sdi12Sensors[2].valueCount);
+    CHECK(!sdi12Sensors[3].ok && sensors[3].dataAsked == SDI12_MAX_ATTEMPTS,
+          "'3' ok %d after %u requests", sdi12Sensors[3].ok, sensors[3].dataAsked);
+}
+
+static void testPortFailure() {
+    printf("port: sdi12PortBegin() fails\n");
+    reset();
+    sensors.push_back(probe('0', "000103", "0+31.2+21.5+250"));
+    portOk = false;
+    sdi12SensorCount = 0;
+    sdi12BusBegin('0', true);
+    CHECK(sdi12SensorCount == 0, "%u sensors without a line", sdi12SensorCount);
+    CHECK(commands.empty(), "%u commands sent", (unsigned)commands.size());
+    sdi12BusStart();
+    CHECK(!sdi12BusBusy() && !sdi12BusPoll() && commands.empty(), "cycle ran without a line");
+
+    // Kept table after sleep, line failing now
+    portOk = true;
+    discover();
+    portOk = false;
+    sdi12BusBegin('0', false);
+    CHECK(sdi12SensorCount == 0, "kept table used without a line");
+}
+
+int main(int argc, char** argv) {
+    hostSerial.enabled = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    testDiscovery();
+    testConcurrent();
+    testTimeouts();
+    testGarbage();
+    testPortFailure();
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+/**
+ * sdi12_frame_test - host checks for the SDI-12 line codec (RMT backend)
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/tx sdi12_frame_test.cpp ../firmware/tx/sdi12_frame.cpp -o sdi12_frame_test
+ *
+ * Compiles the same sdi12_frame.cpp as the firmware. The captures are
+ * synthesized the way the RMT receiver delivers them: level/duration runs,
+ * equal levels merged, the trailing marking cut by the idle threshold.
+ *
+ *   commands    every command the bus sends: break, marking and 7E1
+ *               characters at 1200 baud, decoded back
+ *   charset     all 128 characters, both parities
+ *   clock       a sensor running 3 % fast or slow, inter-character gaps
+ *   parity      a flipped parity bit or a spacing stop bit drops that
+ *               character only, and counts it
+ *   idle split  a pause longer than the RMT idle threshold splits a
+ *               response into two captures; decoded separately they join
+ *               into the same line
+ *   fifo        the 128-byte receive FIFO holds 127 characters, drops the
+ *               rest of an overflowing capture and keeps order
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include "sdi12_frame.h"
+#include "host/check.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define BIT_US        (1000000.0 / 1200)
+#define RX_IDLE_US    10000     // SDI12_RX_IDLE_US in sdi12_port_rmt.cpp
+
+// ============================================
+// Synthetic captures
+// ============================================
+
+struct Capture {
+    std::vector<Sdi12Run> runs;
+    double pending;             // time of the open run
+    int level;                  // -1: nothing yet
+
+    Capture() : pending(0), level(-1) {}
+
+    void add(int lvl, double us) {
+        if (lvl == level) {
+            pending += us;
+            return;
+        }
+        close();
+        level = lvl;
+        pending = us;
+    }
+
+    void close() {
+        if (level >= 0 && pending >= 0.5) runs.push_back({ (uint8_t)level, (uint16_t)(pending + 0.5) });
+        pending = 0;
+    }
+
+    // What the RMT hands over: the idle marking at the end is not a run
+    std::vector<Sdi12Run> finish() {
+        if (level == 0) pending = 0;
+        close();
+        level = -1;
+        return runs;
+    }
+};
+
+static int evenParity(int c) {
+    int p = 0;
+    for (int i = 0; i < 7; i++) p ^= (c >> i) & 1;
+    return p;
+}
+
+// One character: start (spacing, high), 7 data bits LSB first (1 = low),
+// even parity, stop (marking, low). `flip` inverts bit 8 (parity) or 9 (stop).
+static void addChar(Capture& cap, int c, double bitUs, int flip = -1) {
+    int levels[10];
+    levels[0] = 1;
+    for (int i = 0; i < 7; i++) levels[1 + i] = !((c >> i) & 1);
+    levels[8] = !evenParity(c);
+    levels[9] = 0;
+    if (flip >= 0) levels[flip] = !levels[flip];
+    for (int i = 0; i < 10; i++) cap.add(levels[i], bitUs);
+}
+
+// A sensor response: characters at `bitUs`, `gapUs` of marking between them
+static std::vector<Sdi12Run> response(const char* text, double bitUs = BIT_US, double gapUs = 0,
+                                      int flipChar = -1, int flipBit = -1) {
+    Capture cap;
+    for (int i = 0; text[i]; i++) {
+        addChar(cap, text[i], bitUs, i == flipChar ? flipBit : -1);
+        if (gapUs > 0 && text[i + 1]) cap.add(0, gapUs);
+    }
+    return cap.finish();
+}
+
+static std::string decode(const std::vector<Sdi12Run>& runs, uint16_t* errors = NULL) {
+    char out[256];
+    size_t n = sdi12DecodeRuns(runs.data(), runs.size(), out, sizeof(out), errors);
+    return std::string(out, n);
+}
+
+// ============================================
+// Checks
+// ============================================
+
+static void testCommands() {
+    printf("commands: break + marking + characters\n");
+    const char* cmds[] = { "0!", "?!", "3I!", "0C!", "1D0!", "9D0!" };
+    for (size_t k = 0; k < sizeof(cmds) / sizeof(cmds[0]); k++) {
+        Sdi12Run runs[64];
+        size_t n = sdi12EncodeCommand(cmds[k], runs, 64);
+        CHECK(n > 2 && runs[0].level == 1 && runs[0].us == SDI12_BREAK_US &&
+              runs[1].level == 0 && runs[1].us == SDI12_MARKING_US, "'%s' preamble", cmds[k]);
+
+        // Line time is exact: 10 bits of 833.33 us per character
+        uint32_t us = 0;
+        for (size_t i = 2; i < n; i++) us += runs[i].us;
+        uint32_t want = (uint32_t)(strlen(cmds[k]) * 10 * BIT_US + 0.5);
+        CHECK(us + 1 >= want && us <= want + 1, "'%s' %u us, expected %u", cmds[k], us, want);
+
+        uint16_t errors = 0;
+        std::string got = decode(std::vector<Sdi12Run>(runs, runs + n), &errors);
+        CHECK(got == cmds[k] && errors == 0, "'%s' decoded as '%s', %u errors", cmds[k], got.c_str(), errors);
+    }
+    Sdi12Run small[8];
+    CHECK(sdi12EncodeCommand("0D0!", small, 8) == 0, "encoded into too few runs");
+}
+
+static void testCharset() {
+    printf("charset: 128 characters\n");
+    int bad = 0;
+    for (int c = 0; c < 128; c++) {
+        char text[2] = { (char)c, 0 };
+        if (c == 0) continue;   // not in a C string; covered below
+        uint16_t errors = 0;
+        if (decode(response(text), &errors) != text || errors) bad++;
+    }
+    // NUL (all data bits spacing): start + 7 highs merge into one run
+    Capture cap;
+    addChar(cap, 0, BIT_US);
+    addChar(cap, 'A', BIT_US);
+    std::string got = decode(cap.finish());
+    CHECK(got.size() == 2 && got[0] == 0 && got[1] == 'A', "NUL");
+    CHECK(bad == 0, "%d characters wrong", bad);
+}
+
+static void testClock() {
+    printf("clock: +-3 %% baud, inter-character gaps\n");
+    const char* line = "0+1843.44+21.7-0.8\r\n";
+    const double scales[] = { 0.97, 1.0, 1.03 };
+    const double gaps[] = { 0, 300, 1660 };     // SDI-12 allows up to 1.66 ms
+    for (size_t s = 0; s < 3; s++) {
+        for (size_t g = 0; g < 3; g++) {
+            uint16_t errors = 0;
+            std::string got = decode(response(line, BIT_US * scales[s], gaps[g]), &errors);
+            CHECK(got == line && errors == 0, "bit x%.2f gap %.0f us: %u errors", scales[s], gaps[g], errors);
+        }
+    }
+}
+
+static void testParity() {
+    printf("parity: bad parity and stop bits\n");
+    const char* line = "0+31.2+21.5+250\r\n";
+    for (int k = 0; line[k]; k++) {
+        uint16_t errors = 0;
+        std::string got = decode(response(line, BIT_US, 500, k, 8), &errors);
+        std::string want = std::string(line).erase(k, 1);
+        CHECK(got == want && errors == 1, "parity flip at %d: '%s', %u errors", k, got.c_str(), errors);
+    }
+
+    uint16_t errors = 0;
+    std::string got = decode(response("0+31.2\r\n", BIT_US, 1000, 3, 9), &errors);
+    CHECK(errors >= 1 && got.find("0+3") == 0 && got.find("2\r\n") != std::string::npos,
+          "stop bit spacing: '%s', %u errors", got.c_str(), errors);
+}
+
+static void testIdleSplit() {
+    printf("idle split: a pause beyond the idle threshold\n");
+    const char* head = "0+1843.44+2";
+    const char* tail = "1.7+0\r\n";
+    std::vector<Sdi12Run> a = response(head);
+    std::vector<Sdi12Run> b = response(tail);
+
+    // A capture ends after RX_IDLE_US of marking: the RMT drops that run
+    uint16_t errors = 0;
+    std::string got = decode(a, &errors) + decode(b, &errors);
+    CHECK(got == std::string(head) + tail && errors == 0, "'%s', %u errors", got.c_str(), errors);
+
+    // The same pause inside one capture (threshold raised) decodes the same
+    Capture cap;
+    for (const char* p = head; *p; p++) addChar(cap, *p, BIT_US);
+    cap.add(0, RX_IDLE_US + 2000);
+    for (const char* p = tail; *p; p++) addChar(cap, *p, BIT_US);
+    got = decode(cap.finish(), &errors);
+    CHECK(got == std::string(head) + tail && errors == 0, "one capture: '%s'", got.c_str());
+
+    // A capture cut in the middle of a character loses only that character
+    std::vector<Sdi12Run> cut = response("0+12");
+    size_t keep = cut.size() - 2;
+    got = decode(std::vector<Sdi12Run>(cut.begin(), cut.begin() + keep), &errors);
+    CHECK(got.compare(0, 3, "0+1") == 0 && got.size() <= 4, "cut capture: '%s'", got.c_str());
+}
+
+static void testFifo() {
+    printf("fifo: %d bytes\n", SDI12_FIFO_SIZE);
+    Sdi12Fifo f;
+    sdi12FifoClear(f);
+    CHECK(sdi12FifoPop(f) == -1 && sdi12FifoCount(f) == 0, "empty");
+
+    char text[200];
+    for (int i = 0; i < 200; i++) text[i] = (char)('!' + i % 90);
+    CHECK(sdi12FifoPush(f, text, 100) == 0, "first 100 dropped");
+    size_t dropped = sdi12FifoPush(f, text + 100, 100);
+    CHECK(dropped == 100 - (SDI12_FIFO_SIZE - 1 - 100), "%u dropped", (unsigned)dropped);
+    CHECK(sdi12FifoCount(f) == SDI12_FIFO_SIZE - 1, "%u held", (unsigned)sdi12FifoCount(f));
+
+    bool order = true;
+    for (int i = 0; i < SDI12_FIFO_SIZE - 1; i++) order = order && sdi12FifoPop(f) == text[i];
+    CHECK(order && sdi12FifoPop(f) == -1, "order");
+
+    // Wraps around the end of the buffer
+    for (int round = 0; round < 5; round++) {
+        CHECK(sdi12FifoPush(f, text, 90) == 0, "round %d dropped", round);
+        bool ok = true;
+        for (int i = 0; i < 90; i++) ok = ok && sdi12FifoPop(f) == text[i];
+        CHECK(ok && sdi12FifoCount(f) == 0, "round %d", round);
+    }
+
+    sdi12FifoPush(f, text, 10);
+    sdi12FifoClear(f);
+    CHECK(sdi12FifoCount(f) == 0 && sdi12FifoPop(f) == -1, "clear");
+}
+
+int main() {
+    testCommands();
+    testCharset();
+    testClock();
+    testParity();
+    testIdleSplit();
+    testFifo();
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/**
+ * sdi12_parse_bench - host checks and timing for the SDI-12 response parser
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/tx sdi12_parse_bench.cpp ../firmware/tx/sdi12_parse.cpp -o sdi12_parse_bench
+ *
+ * Usage:
+ *   sdi12_parse_bench [responses]
+ *
+ * Compiles the same sdi12_parse.cpp as the firmware and compares it with
+ * the parser it replaced (parseTEROS12(): a String per field,
+ * substring().toFloat(), i.e. float(atof())):
+ *
+ *   recorded    TEROS 12 D0 responses and ACKs, values and fields
+ *   edges       signs and decimal points (".5", "5.", "-0", "+", "1.2.3"),
+ *               separators, 7 to 12 digits around the 9-digit limit
+ *   random      `responses` random D0 lines: in-spec values (up to 7
+ *               digits) must give the same float as strtod; 8-12 digits
+ *               (past what a float holds) within two float steps
+ *
+ * Then times both parsers on the same lines.
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include "sdi12_parse.h"
+#include "host/check.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define SDI12_LINE_VALUES 20    // values compared per line
+
+static uint32_t rng = 7;
+static uint32_t rnd() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// ============================================
+// The replaced parser
+// ============================================
+
+// parseTEROS12() before the in-place parser, with its 3-value limit lifted;
+// std::string stands in for the Arduino String (heap copy per field)
+static uint8_t oldParseValues(const std::string& response, float* values, uint8_t maxValues) {
+    uint8_t count = 0;
+    size_t i = 1; // skip address character
+
+    while (i < response.length() && count < maxValues) {
+        if (response[i] == '+' || response[i] == '-') {
+            size_t start = i++;
+            while (i < response.length() &&
+                   response[i] != '+' && response[i] != '-' &&
+                   response[i] != '\r' && response[i] != '\n') {
+                i++;
+            }
+            values[count++] = (float)atof(response.substr(start, i - start).c_str());
+        } else {
+            i++;
+        }
+    }
+    return count;
+}
+
+// Distance in representable floats (0 = identical)
+static uint32_t ulps(float a, float b) {
+    if (a == b) return 0;
+    if (isnan(a) || isnan(b) || (a < 0) != (b < 0)) return UINT32_MAX;
+    int32_t ia, ib;
+    memcpy(&ia, &a, 4);
+    memcpy(&ib, &b, 4);
+    return (uint32_t)(ia > ib ? ia - ib : ib - ia);
+}
+
+// Both parsers on `line`; false (and a report) if the counts differ or any
+// value is more than `maxUlps` apart
+static bool agree(const char* line, uint32_t maxUlps, bool report = true) {
+    float a[SDI12_LINE_VALUES], b[SDI12_LINE_VALUES];
+    uint8_t na = sdi12ParseValues(line, strlen(line), a, SDI12_LINE_VALUES);
+    uint8_t nb = oldParseValues(line, b, SDI12_LINE_VALUES);
+    bool ok = na == nb;
+    for (uint8_t i = 0; ok && i < na; i++) ok = ulps(a[i], b[i]) <= maxUlps;
+    if (!ok && report) {
+        printf("    '%s': new", line);
+        for (uint8_t i = 0; i < na; i++) printf(" %.9g", a[i]);
+        printf(", old");
+        for (uint8_t i = 0; i < nb; i++) printf(" %.9g", b[i]);
+        printf("\n");
+    }
+    return ok;
+}
+
+
+// ============================================
+// Checks
+// ============================================
+
+static void testRecorded() {
+    printf("recorded: TEROS 12 responses\n");
+    // D0 lines as captured from probes (dry, wet, frozen, in water, 5 values)
+    const char* lines[] = {
+        "0+1843.44+21.7+0", "1+2716.05+19.4+312", "2+3305.91-0.8+1078",
+        "3+1502.60-12.3+0", "0+3865.12+24.9+2544", "0+1843.44+21.7+0+0.5-3",
+    };
+    for (size_t k = 0; k < sizeof(lines) / sizeof(lines[0]); k++) {
+        CHECK(agree(lines[k], 0), "'%s'", lines[k]);
+    }
+
+    float v[3];
+    CHECK(sdi12ParseValues("0+1843.44+21.7+0\r\n", 18, v, 3) == 3 && v[0] == 1843.44f &&
+          v[1] == 21.7f && v[2] == 0, "values");
+    // Stops at the line end and at maxValues
+    CHECK(sdi12ParseValues("0+1+2\r\n+3", 10, v, 3) == 2, "past the line end");
+    CHECK(sdi12ParseValues("0+1+2+3+4", 9, v, 3) == 3 && v[2] == 3, "maxValues");
+
+    // aC! ACK "atttnn"
+    CHECK(sdi12ParseField("000103", 6, 1, 3) == 1 && sdi12ParseField("000103", 6, 4, 2) == 3, "ACK");
+    CHECK(sdi12ParseField("0001", 4, 1, 3) == 1 && sdi12ParseField("0001", 4, 4, 2) == -1, "short ACK");
+    CHECK(sdi12ParseField("00x103", 6, 1, 3) == -1, "non-digit ACK");
+}
+
+static void testEdges() {
+    printf("edges: signs, decimal points, digit limit\n");
+    struct Edge {
+        const char* line;
+        float want;             // new parser, first value
+    };
+    const Edge edges[] = {
+        { "0+.5", 0.5f },           { "0-.5", -0.5f },          { "0+5.", 5.0f },
+        { "0-0", -0.0f },           { "0+0.000", 0.0f },        { "0+", 0.0f },
+        { "0-.", -0.0f },           { "0+1.2.3", 1.2f },        { "0+12 34", 12.0f },
+        { "0+1#5", 1.0f },          { "0+007.50", 7.5f },       { "0+0.0000123", 0.0000123f },
+        { "0+9999999", 9999999.0f },                            { "0-0.000001", -0.000001f },
+        { "0+12345678", 12345678.0f },                          { "0+123456789", 123456789.0f },
+        { "0+1234567891", 1234567891.0f },                      { "0+123456789123", 123456789123.0f },
+        { "0+1.23456789123", 1.23456789123f },                  { "0+0.00000000012345", 1.2345e-10f },
+    };
+    for (size_t k = 0; k < sizeof(edges) / sizeof(edges[0]); k++) {
+        const Edge& e = edges[k];
+        float v[SDI12_LINE_VALUES];
+        uint8_t n = sdi12ParseValues(e.line, strlen(e.line), v, SDI12_LINE_VALUES);
+        CHECK(n == 1 && ulps(v[0], e.want) <= 1 && signbit(v[0]) == signbit(e.want),
+              "'%s' -> %.9g, want %.9g", e.line, n ? v[0] : NAN, e.want);
+        // Within one float step of strtod past 7 digits, identical below
+        size_t digits = strspn(e.line + 2 + (e.line[2] == '.'), "0123456789.");
+        CHECK(agree(e.line, digits > 8 ? 1 : 0), "'%s' differs from the old parser", e.line);
+    }
+}
+
+// A D0 line of random values; `maxDigits` significant digits at most
+static std::string randomLine(int maxDigits) {
+    std::string s(1, (char)('0' + rnd() % 10));
+    int values = 1 + rnd() % 9;
+    for (int v = 0; v < values; v++) {
+        s += rnd() % 2 ? '+' : '-';
+        // Digits (leading zeros included, as SDI-12 counts them) and where
+        // the decimal point goes; -1: none
+        int digits = 1 + rnd() % maxDigits;
+        int lead = rnd() % 8 == 0 ? rnd() % digits : 0;
+        int point = rnd() % 4 == 0 ? -1 : (int)(rnd() % (digits + 1));
+        if (point == 0) s += '.';
+        for (int d = 0; d < digits; d++) {
+            s += d < lead ? '0' : (char)('0' + rnd() % 10);
+            if (d + 1 == point) s += '.';
+        }
+    }
+    s += "\r\n";
+    return s;
+}
+
+static void testRandom(uint32_t count) {
+    printf("random: %u lines in spec, %u with 8-12 digits\n", count, count / 10);
+    uint32_t bad = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        std::string line = randomLine(7);
+        if (!agree(line.c_str(), 0, bad < 5)) bad++;
+    }
+    CHECK(bad == 0, "%u in-spec lines differ from strtod", bad);
+
+    bad = 0;
+    for (uint32_t k = 0; k < count / 10; k++) {
+        std::string line = randomLine(12);
+        if (!agree(line.c_str(), 2, bad < 5)) bad++;
+    }
+    CHECK(bad == 0, "%u long lines more than two float steps off", bad);
+}
+
+// ============================================
+// Timing
+// ============================================
+
+static void timing(uint32_t count) {
+    std::vector<std::string> lines;
+    for (uint32_t k = 0; k < 1000; k++) lines.push_back(randomLine(6));
+    uint32_t rounds = count / 1000 + 1;
+    float v[SDI12_LINE_VALUES];
+    volatile float sink = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t k = 0; k < lines.size(); k++) {
+            sdi12ParseValues(lines[k].c_str(), lines[k].size(), v, SDI12_LINE_VALUES);
+            sink = sink + v[0];
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t k = 0; k < lines.size(); k++) {
+            oldParseValues(lines[k], v, SDI12_LINE_VALUES);
+            sink = sink + v[0];
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double n = (double)rounds * lines.size();
+    double newNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double oldNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+    printf("\nper D0 line (1-9 values, host): in place %.0f ns, substring + atof %.0f ns (%.1fx)\n",
+           newNs, oldNs, oldNs / newNs);
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? atoi(argv[1]) : 200000;
+    if (count == 0) {
+        fprintf(stderr, "usage: sdi12_parse_bench [responses]\n");
+        return 2;
+    }
+
+    testRecorded();
+    testEdges();
+    testRandom(count);
+    timing(count);
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,400 @@
+/**
+ * wire_bench - host checks for the LoRa wire format, payload size and
+ * time on air against the raw MeteorDataPacket
+ *
+ * Build (from sistema_embebido/tools):
+ *   g++ -std=c++11 -O2 -I../firmware/shared wire_bench.cpp ../firmware/shared/wire_format.cpp -o wire_bench
+ *
+ * Usage:
+ *   wire_bench [readings]
+ *
+ * Compiles the same wire_format.cpp as the firmware and checks:
+ *
+ *   golden      a known reading against bytes written out by hand (byte
+ *               order, bitmap, field order) and the CRC-16 check value
+ *   failed probe a TEROS 12 that did not answer (-1 in every value, as
+ *               tx/sensors.cpp reports it) is left out or sent as missing,
+ *               not as 0; a working probe at -1 °C is kept
+ *   legacy      the 40-byte raw struct of firmware before the wire format,
+ *               as that firmware laid it out, decoded field by field
+ *   roundtrip   random readings with failed sensors (NaN), values beyond
+ *               every field's range and 0-4 soil probes; each decoded value
+ *               within half a quantization step, or clamped
+ *   damage      every single-bit flip and every truncation of a frame is
+ *               rejected; another version byte is reported as such
+ *
+ * Then prints frame sizes and LoRa time on air per SF (BW 125 kHz, CR 4/7,
+ * 8-symbol preamble, explicit header, CRC on, as in shared/config.h) for
+ * the raw struct and the wire frame, and encode/decode time.
+ *
+ * Exit status 0 when every check passes.
+ */
+
+#include "wire_format.h"
+#include "host/check.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// sizeof(MeteorDataPacket) on the ESP32 (4-byte unsigned long)
+#define RAW_PACKET_BYTES 108
+
+#define LORA_BW_HZ       125000.0
+#define LORA_CR_DENOM    7       // coding rate 4/7
+#define LORA_PREAMBLE    8
+#define SX1262_TX_MA     118.0   // datasheet, +22 dBm
+
+static uint32_t rng = 2024;
+static uint32_t rnd() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+static float uniform(float lo, float hi) { return lo + (hi - lo) * (rnd() % 1000001) / 1000000.0f; }
+
+// ============================================
+// Time on air (Semtech AN1200.13)
+// ============================================
+
+static double airtimeMs(size_t payload, int sf) {
+    double tsym = (1 << sf) / LORA_BW_HZ * 1000.0;
+    int de = tsym > 16.0 ? 1 : 0;                       // low data rate optimization
+    int cr = LORA_CR_DENOM - 4;
+    double num = 8.0 * payload - 4.0 * sf + 28 + 16;    // CRC on, explicit header
+    double blocks = ceil(num / (4.0 * (sf - 2 * de)));
+    double symbols = 8 + (blocks > 0 ? blocks * (cr + 4) : 0);
+    return (LORA_PREAMBLE + 4.25) * tsym + symbols * tsym;
+}
+
+// ============================================
+// Checks
+// ============================================
+
+static WireReading emptyReading() {
+    WireReading r;
+    memset(&r, 0, sizeof(r));
+    r.tempAire = r.humAire = r.tempSuelo = r.vwcSuelo = NAN;
+    r.ecSuelo = r.par = r.vBat = NAN;
+    r.batPercent = WIRE_BAT_UNKNOWN;
+    return r;
+}
+
+static void testGolden() {
+    printf("golden: byte order and CRC\n");
+    const uint8_t check[] = "123456789";
+    CHECK(wireCrc16(check, 9) == 0x29B1, "CRC-16/CCITT-FALSE check value %04X", wireCrc16(check, 9));
+
+    WireReading r = emptyReading();
+    r.nodeId = 0x1234;
+    r.seq = 0x120A0B0C;                  // only the low 24 bits travel
+    r.tempAire = -21.5f;                 // -2150 = 0xF79A
+    r.vBat = 3.912f;                     // 3912 mV = 0x0F48
+    r.batPercent = 80;
+    r.soilCount = 1;
+    r.soil[0].addr = '1';
+    r.soil[0].depthCm = 10;
+    r.soil[0].vwc = 31.2f;               // 312 = 0x0138
+    r.soil[0].temp = NAN;                // reserved 0x8000
+    r.soil[0].ec = 251.0f;               // 0x00FB
+
+    const uint8_t expect[] = {
+        0x11,                            // version 1, reading
+        0x34, 0x12,                      // nodeId
+        0x0C, 0x0B, 0x0A,                // sequence
+        0xC1, 0x02,                      // tempAire, vBat, batPercent, soil
+        0x9A, 0xF7,
+        0x48, 0x0F,
+        0x50,
+        0x01, '1', 10, 0x38, 0x01, 0x00, 0x80, 0xFB, 0x00
+    };
+    uint8_t frame[WIRE_FRAME_MAX];
+    size_t n = wireEncode(r, frame, sizeof(frame));
+    CHECK(n == sizeof(expect) + WIRE_CRC_BYTES, "size %u", (unsigned)n);
+    CHECK(n == wireFrameSize(r), "wireFrameSize %u", (unsigned)wireFrameSize(r));
+    CHECK(memcmp(frame, expect, sizeof(expect)) == 0, "bytes differ");
+    uint16_t crc = wireCrc16(expect, sizeof(expect));
+    CHECK(frame[n - 2] == (crc & 0xFF) && frame[n - 1] == crc >> 8, "CRC not little-endian");
+    CHECK(wireEncode(r, frame, n - 1) == 0, "encoded into a short buffer");
+
+    WireReading d;
+    CHECK(wireDecode(frame, n, d) == WIRE_OK, "decode");
+    CHECK(d.seq == 0x0A0B0C && d.nodeId == 0x1234, "seq %06X node %04X", d.seq, d.nodeId);
+    CHECK(d.tempAire == -21.5f && isnan(d.humAire) && d.batPercent == 80 && d.intervalMs == 0,
+          "fields");
+    CHECK(d.soilCount == 1 && isnan(d.soil[0].temp) && d.soil[0].ec == 251.0f, "soil");
+}
+
+static void testFailedProbe() {
+    printf("failed probe: TEROS 12 -1 sentinel\n");
+    WireReading r = emptyReading();
+    r.nodeId = 7;
+    r.seq = 1;
+    r.tempAire = 18.0f;
+    r.soilCount = 2;
+    r.soil[0].addr = '0';
+    r.soil[0].depthCm = 10;
+    r.soil[0].vwc = -1;                  // did not answer
+    r.soil[0].temp = -1;
+    r.soil[0].ec = -1;
+    r.soil[1].addr = '1';
+    r.soil[1].depthCm = 30;
+    r.soil[1].vwc = 0;                   // answered: dry soil, -1 °C
+    r.soil[1].temp = -1;
+    r.soil[1].ec = 0;
+    r.vwcSuelo = r.soil[0].vwc;          // legacy fields mirror soil[0]
+    r.tempSuelo = r.soil[0].temp;
+    r.ecSuelo = r.soil[0].ec;
+    wireSoilValues(r.vwcSuelo, r.tempSuelo, r.ecSuelo);
+    for (uint8_t i = 0; i < r.soilCount; i++) {
+        wireSoilValues(r.soil[i].vwc, r.soil[i].temp, r.soil[i].ec);
+    }
+
+    uint8_t frame[WIRE_FRAME_MAX];
+    size_t n = wireEncode(r, frame, sizeof(frame));
+    uint16_t present = frame[6] | frame[7] << 8;
+    CHECK(!(present & (WIRE_F_TEMP_SUELO | WIRE_F_VWC_SUELO | WIRE_F_EC_SUELO)),
+          "legacy soil fields sent, bitmap %04X", present);
+
+    WireReading d;
+    CHECK(wireDecode(frame, n, d) == WIRE_OK, "decode");
+    CHECK(isnan(d.vwcSuelo) && isnan(d.tempSuelo) && isnan(d.ecSuelo), "legacy soil fields not NaN");
+    CHECK(d.soilCount == 2, "soilCount %u", d.soilCount);
+    CHECK(isnan(d.soil[0].vwc) && isnan(d.soil[0].temp) && isnan(d.soil[0].ec),
+          "failed probe decoded as %.1f %% %.2f C %.0f uS/cm", d.soil[0].vwc, d.soil[0].temp, d.soil[0].ec);
+    CHECK(d.soil[1].vwc == 0 && d.soil[1].temp == -1.0f && d.soil[1].ec == 0,
+          "working probe %.1f %% %.2f C %.0f uS/cm", d.soil[1].vwc, d.soil[1].temp, d.soil[1].ec);
+}
+
+// Decoded value matches within half a step, or the clamp limit
+static bool near(float in, float out, float step, float lo, float hi) {
+    if (isnan(in)) return isnan(out);
+    float want = in < lo ? lo : in > hi ? hi : in;
+    return fabsf(out - want) <= step / 2 + fabsf(want) * 1e-6f;
+}
+
+static float maybe(float lo, float hi) {
+    uint32_t k = rnd() % 20;
+    if (k == 0) return NAN;
+    if (k == 1) return lo - uniform(0, 1000);           // clamps
+    if (k == 2) return hi + uniform(0, 1000);
+    return uniform(lo, hi);
+}
+
+static WireReading randomReading() {
+    WireReading r;
+    r.nodeId = rnd();
+    r.seq = rnd() & WIRE_SEQ_MASK;
+    r.tempAire = maybe(-327.67f, 327.67f);
+    r.humAire = maybe(0, 6553.4f);
+    r.tempSuelo = maybe(-327.67f, 327.67f);
+    r.vwcSuelo = maybe(0, 6553.4f);
+    r.ecSuelo = maybe(0, 65534);
+    r.par = maybe(0, 6553.4f);
+    r.vBat = maybe(0, 65.534f);
+    r.batPercent = rnd() % 10 == 0 ? WIRE_BAT_UNKNOWN : rnd() % 101;
+    r.intervalMs = rnd() % 10 == 0 ? 0 : (rnd() % 3600 + 1) * 1000;
+    r.soilCount = rnd() % (WIRE_SOIL_MAX + 1);
+    for (int i = 0; i < WIRE_SOIL_MAX; i++) {
+        r.soil[i].addr = '0' + i;
+        r.soil[i].depthCm = 10 * (i + 1);
+        r.soil[i].vwc = maybe(0, 6553.4f);
+        r.soil[i].temp = maybe(-327.67f, 327.67f);
+        r.soil[i].ec = maybe(0, 65534);
+    }
+    return r;
+}
+
+// MeteorDataPacket before the wire format, with the ESP32's 4-byte
+// unsigned long spelled out
+struct LegacyPacket {
+    float tempAire;
+    float humAire;
+    float tempSuelo;
+    float vwcSuelo;
+    float ecSuelo;
+    float par;
+    uint32_t packetId;
+    uint32_t interval;
+    float vBat;
+    uint8_t batPercent;
+};
+
+static void testLegacy() {
+    printf("legacy: 40-byte raw struct\n");
+    CHECK(sizeof(LegacyPacket) == WIRE_LEGACY_BYTES, "struct is %u bytes", (unsigned)sizeof(LegacyPacket));
+
+    LegacyPacket p;
+    memset(&p, 0xA5, sizeof(p));        // padding as it comes off the stack
+    p.tempAire = 21.5f;
+    p.humAire = 63.2f;
+    p.tempSuelo = 17.25f;
+    p.vwcSuelo = 31.4f;
+    p.ecSuelo = 250;
+    p.par = 812.3f;
+    p.packetId = 0x01234567;            // past the 24 bits of a wire frame
+    p.interval = 600000;
+    p.vBat = 3.91f;
+    p.batPercent = 78;
+    uint8_t raw[WIRE_LEGACY_BYTES];
+    memcpy(raw, &p, sizeof(raw));       // little-endian, like the ESP32
+
+    WireReading d;
+    CHECK(wireDecodeLegacy(raw, sizeof(raw), d) == WIRE_OK, "decode");
+    CHECK(d.nodeId == 0 && d.seq == 0x01234567 && d.soilCount == 0, "node %u seq %lu soil %u",
+          d.nodeId, (unsigned long)d.seq, d.soilCount);
+    CHECK(d.tempAire == 21.5f && d.humAire == 63.2f && d.tempSuelo == 17.25f &&
+          d.vwcSuelo == 31.4f && d.ecSuelo == 250 && d.par == 812.3f, "sensor fields");
+    CHECK(d.intervalMs == 600000 && d.vBat == 3.91f && d.batPercent == 78, "state fields");
+
+    // That firmware reported a silent TEROS 12 as -1 too
+    p.vwcSuelo = p.tempSuelo = p.ecSuelo = -1;
+    memcpy(raw, &p, sizeof(raw));
+    CHECK(wireDecodeLegacy(raw, sizeof(raw), d) == WIRE_OK &&
+          isnan(d.vwcSuelo) && isnan(d.tempSuelo) && isnan(d.ecSuelo), "failed probe not NaN");
+
+    CHECK(wireDecodeLegacy(raw, sizeof(raw) - 1, d) == WIRE_ERR_LENGTH, "short struct accepted");
+}
+
+static void testRoundtrip(uint32_t count) {
+    printf("roundtrip: %u random readings\n", count);
+    uint32_t bad = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        WireReading r = randomReading();
+        uint8_t frame[WIRE_FRAME_MAX];
+        size_t n = wireEncode(r, frame, sizeof(frame));
+        WireReading d;
+        WireStatus st = wireDecode(frame, n, d);
+        bool ok = st == WIRE_OK && n == wireFrameSize(r) && d.nodeId == r.nodeId && d.seq == r.seq &&
+            near(r.tempAire, d.tempAire, 0.01f, -327.67f, 327.67f) &&
+            near(r.humAire, d.humAire, 0.1f, 0, 6553.4f) &&
+            near(r.tempSuelo, d.tempSuelo, 0.01f, -327.67f, 327.67f) &&
+            near(r.vwcSuelo, d.vwcSuelo, 0.1f, 0, 6553.4f) &&
+            near(r.ecSuelo, d.ecSuelo, 1, 0, 65534) &&
+            near(r.par, d.par, 0.1f, 0, 6553.4f) &&
+            near(r.vBat, d.vBat, 0.001f, 0, 65.534f) &&
+            d.batPercent == r.batPercent && d.intervalMs == r.intervalMs &&
+            d.soilCount == r.soilCount;
+        for (uint8_t i = 0; ok && i < r.soilCount; i++) {
+            ok = d.soil[i].addr == r.soil[i].addr && d.soil[i].depthCm == r.soil[i].depthCm &&
+                 near(r.soil[i].vwc, d.soil[i].vwc, 0.1f, 0, 6553.4f) &&
+                 near(r.soil[i].temp, d.soil[i].temp, 0.01f, -327.67f, 327.67f) &&
+                 near(r.soil[i].ec, d.soil[i].ec, 1, 0, 65534);
+        }
+        if (!ok && bad++ < 5) CHECK(false, "reading %u (status %d)", k, st);
+    }
+    CHECK(bad == 0, "%u readings differ", bad);
+}
+
+static void testDamage(uint32_t count) {
+    printf("damage: bit flips and truncations of %u frames\n", count);
+    uint32_t accepted = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        WireReading r = randomReading();
+        uint8_t frame[WIRE_FRAME_MAX];
+        size_t n = wireEncode(r, frame, sizeof(frame));
+        WireReading d;
+        for (size_t bit = 0; bit < n * 8; bit++) {
+            frame[bit / 8] ^= 1 << (bit % 8);
+            if (wireDecode(frame, n, d) == WIRE_OK) accepted++;
+            frame[bit / 8] ^= 1 << (bit % 8);
+        }
+        for (size_t cut = 0; cut < n; cut++) {
+            if (wireDecode(frame, cut, d) == WIRE_OK) accepted++;
+        }
+    }
+    CHECK(accepted == 0, "%u damaged frames accepted", accepted);
+
+    // A frame from a later version, with a valid CRC
+    WireReading r = randomReading();
+    uint8_t frame[WIRE_FRAME_MAX];
+    size_t n = wireEncode(r, frame, sizeof(frame));
+    frame[0] = (WIRE_VERSION + 1) << 4 | WIRE_TYPE_READING;
+    uint16_t crc = wireCrc16(frame, n - 2);
+    frame[n - 2] = crc & 0xFF;
+    frame[n - 1] = crc >> 8;
+    WireReading d;
+    CHECK(wireDecode(frame, n, d) == WIRE_ERR_VERSION, "version not reported");
+}
+
+// ============================================
+// Size, airtime, speed
+// ============================================
+
+static void report(uint32_t count) {
+    WireReading base = emptyReading();
+    base.nodeId = 17;
+    base.seq = 1234;
+    base.tempAire = 15.02f;
+    base.humAire = 60.1f;
+    base.tempSuelo = 12.0f;
+    base.vwcSuelo = 30.1f;
+    base.ecSuelo = 250;
+    base.par = 812.5f;
+    base.vBat = 3.912f;
+    base.batPercent = 80;
+    base.intervalMs = 600000;
+
+    WireReading none = base, one = base, four = base;
+    none.soilCount = 0;
+    one.soilCount = 1;
+    four.soilCount = 4;
+    for (int i = 0; i < 4; i++) {
+        WireSoil s = { (uint8_t)('1' + i), (uint8_t)(10 + 20 * i), 31.2f, 12.1f, 251 };
+        one.soil[i] = four.soil[i] = s;
+    }
+    size_t sizes[4] = { RAW_PACKET_BYTES, wireFrameSize(none), wireFrameSize(one), wireFrameSize(four) };
+    const char* names[4] = { "raw struct", "wire, no probes", "wire, 1 probe", "wire, 4 probes" };
+
+    printf("\nframe bytes:");
+    for (int i = 0; i < 4; i++) printf("  %s %u", names[i], (unsigned)sizes[i]);
+    printf("\n\ntime on air, BW 125 kHz, CR 4/7 (ms; mAs per frame at %.0f mA):\n", SX1262_TX_MA);
+    printf("  SF   %-18s %-18s %-18s %-18s saving (1 probe)\n", names[0], names[1], names[2], names[3]);
+    for (int sf = 7; sf <= 12; sf++) {
+        printf("  %2d  ", sf);
+        double raw = airtimeMs(sizes[0], sf);
+        for (int i = 0; i < 4; i++) {
+            double ms = airtimeMs(sizes[i], sf);
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%7.1f (%5.1f)", ms, ms * SX1262_TX_MA / 1000);
+            printf(" %-18s", cell);
+        }
+        printf(" %4.1f%%\n", 100.0 * (1 - airtimeMs(sizes[2], sf) / raw));
+    }
+
+    uint8_t frame[WIRE_FRAME_MAX];
+    WireReading d;
+    volatile size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t k = 0; k < count; k++) {
+        one.seq = k;
+        sink += wireEncode(one, frame, sizeof(frame));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    size_t n = wireEncode(one, frame, sizeof(frame));
+    for (uint32_t k = 0; k < count; k++) sink += wireDecode(frame, n, d);
+    auto t2 = std::chrono::steady_clock::now();
+    printf("\nencode %.0f ns, decode %.0f ns per frame (1 probe, host)\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / count,
+           std::chrono::duration<double, std::nano>(t2 - t1).count() / count);
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? atoi(argv[1]) : 100000;
+    if (count == 0) {
+        fprintf(stderr, "usage: wire_bench [readings]\n");
+        return 2;
+    }
+
+    testGolden();
+    testFailedProbe();
+    testLegacy();
+    testRoundtrip(count);
+    testDamage(count / 100 + 1);
+    report(count);
+
+    printf("\n%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}